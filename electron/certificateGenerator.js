@@ -1,5 +1,6 @@
 const fs = require('fs');
 const path = require('path');
+const crypto = require('crypto');
 const { v4: uuidv4 } = require('uuid');
 const os = require('os');
 const { app } = require('electron');
@@ -25,7 +26,9 @@ async function generateWipeCertificate({
   postWipeStatus,// 'success' or 'failure'
   logs = [],
   toolVersion = "1.0.0",
-  simulated = false  // Whether this was a dry run
+  simulated = false,  // Whether this was a dry run
+  mediaCoverage = null,  // { badRanges: [{ offset, length }], sanitizedPercent, healthEvents, deviceFlagged } from the native engine
+  evidence = null  // Read-back Merkle evidence from verifyWipe: { merkleRoot, regionSize, leafCount, tree, ... }
 }) {
   // CRITICAL: Block certificate generation if wipe was not successful
   if (postWipeStatus !== 'success') {
@@ -57,10 +60,42 @@ async function generateWipeCertificate({
     logs: logs,
     tool_version: toolVersion
   };
+  if (mediaCoverage && typeof mediaCoverage.sanitizedPercent === 'number') {
+    certificate.media_coverage = {
+      sanitized_percent: mediaCoverage.sanitizedPercent,
+      unwritable_ranges: mediaCoverage.badRanges || [],
+      device_flagged: mediaCoverage.deviceFlagged === true,
+      health_events: mediaCoverage.healthEvents || []
+    };
+  }
 
   // Ensure certificates folder exists (single source of truth)
   const certFolder = ensureCertDir();
 
+  // The evidence tree's leaves go next to the certificate; the certificate
+  // holds the root and the leaves file's digest
+  let treePath = null;
+  if (evidence && evidence.tree) {
+    const treeFilename = `certificate_${certificateId}.merkle`;
+    treePath = path.join(certFolder, treeFilename);
+    fs.writeFileSync(treePath, evidence.tree);
+    certificate.verification = {
+      algorithm: evidence.algorithm,
+      merkle_root: evidence.merkleRoot,
+      region_size: evidence.regionSize,
+      leaf_count: evidence.leafCount,
+      expected_byte: evidence.expectedByte,
+      verified: evidence.verified === true,
+      mismatched_regions: evidence.mismatchedRegions || [],
+      unreadable_regions: evidence.unreadableRegions || [],
+      tree_file: treeFilename,
+      tree_sha256: crypto.createHash('sha256').update(evidence.tree).digest('hex')
+    };
+  }
+  const removeTree = () => {
+    if (treePath) try { fs.unlinkSync(treePath); } catch (e) { /* ignore */ }
+  };
+
   // Use the same UUID for filename consistency
   const certFilename = `certificate_${certificateId}.json`;
   const certPath = path.join(certFolder, certFilename);
@@ -79,15 +114,17 @@ async function generateWipeCertificate({
     pdfPath = await generatePdfCertificate(certPath);
   } catch (pdfError) {
     console.error('[CertGen] PDF generation failed:', pdfError);
-    // Clean up orphaned JSON file
+    // Clean up orphaned JSON and evidence files
     try { fs.unlinkSync(certPath); } catch (e) { /* ignore */ }
+    removeTree();
     throw new Error(`Certificate PDF generation failed: ${pdfError.message}`);
   }
 
   // Verify PDF file was created
   if (!fs.existsSync(pdfPath)) {
-    // Clean up orphaned JSON file
+    // Clean up orphaned JSON and evidence files
     try { fs.unlinkSync(certPath); } catch (e) { /* ignore */ }
+    removeTree();
     throw new Error(`Certificate PDF file was not created at: ${pdfPath}`);
   }
 
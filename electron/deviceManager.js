@@ -1,6 +1,87 @@
 // electron/deviceManager.js
-const drivelist = require('drivelist');
-const disk = require('diskusage');
+const path = require('path');
+const { app } = require('electron');
+
+// Production: resources/native/wipeAddon.node (via extraResources)
+// Development: native/build/Release/wipeAddon.node
+const addonPath = app.isPackaged
+  ? path.join(process.resourcesPath, 'native', 'wipeAddon.node')
+  : path.join(__dirname, '..', 'native', 'build', 'Release', 'wipeAddon.node');
+
+let wipeAddon = null;
+try {
+  wipeAddon = require(addonPath);
+} catch (e) {
+  console.warn('[DeviceManager] Native addon unavailable, using drivelist:', e.message);
+}
+
+// listDevices()/hotplug device -> listDrives() entry
+function toDrive(dev) {
+  return {
+    device: dev.path,
+    description: [dev.vendor, dev.model].filter(Boolean).join(' ') || dev.name,
+    size: dev.size,
+    mountpoints: dev.mountpoints.map(mp => ({
+      path: mp.path,
+      total: mp.total || null,
+      free: mp.free || null,
+    })),
+    isSystem: dev.is_system,
+    isRemovable: dev.removable,
+    isReadOnly: dev.read_only,
+    isCard: dev.is_card,
+    busType: dev.transport.toUpperCase(),
+    serial: dev.serial,
+    model: dev.model,
+    wwn: dev.wwn,
+    rotational: dev.rotational,
+  };
+}
+
+/**
+ * Native enumeration (Linux): one sysfs + mountinfo scan on a worker thread.
+ * Returns null when the addon has no native scan for this platform.
+ */
+async function listDrivesNative() {
+  if (!wipeAddon || typeof wipeAddon.listDevices !== 'function') return null;
+  const devices = await wipeAddon.listDevices();
+  if (!devices) return null;
+  return devices.map(toDrive);
+}
+
+/**
+ * drivelist + diskusage (Windows, macOS, or addon not built).
+ */
+async function listDrivesFallback() {
+  const drivelist = require('drivelist');
+  const disk = require('diskusage');
+  const drives = await drivelist.list();
+  // For each mountpoint, get free space
+  for (const drive of drives) {
+    for (const mp of drive.mountpoints) {
+      try {
+        const { available, free, total } = disk.checkSync(mp.path);
+        mp.total = total;
+        mp.free = free;
+      } catch (e) {
+        mp.total = null;
+        mp.free = null;
+      }
+    }
+  }
+  // Map to return info useful for your UI and backend:
+  return drives.map(drive => ({
+    device: drive.device,                // e.g. '\\\\.\\PhysicalDrive1' (Win), '/dev/sdb' (Linux)
+    description: drive.description,      // e.g. 'SanDisk USB Flash Drive'
+    size: drive.size,                    // in bytes, can format for display
+    mountpoints: drive.mountpoints,      // e.g. [{path: 'E:\\'}] for Windows, or /media/.. for Linux
+    isSystem: drive.isSystem,            // true for system boot partitions
+    isRemovable: drive.isRemovable,      // true for USB sticks and SD cards
+    isReadOnly: drive.isReadOnly,        // can't wipe if true
+    isCard: drive.isCard,                // for SD cards
+    busType: drive.busType,              // USB, SATA, NVMe etc.
+  }));
+}
 
 /**
  * Lists all drives connected to the system.
@@ -8,36 +89,43 @@ const disk = require('diskusage');
  */
 async function listDrives() {
   try {
-    const drives = await drivelist.list();
-    // For each mountpoint, get free space
-    for (const drive of drives) {
-      for (const mp of drive.mountpoints) {
-        try {
-          const { available, free, total } = disk.checkSync(mp.path);
-          mp.total = total;
-          mp.free = free;
-        } catch (e) {
-          mp.total = null;
-          mp.free = null;
-        }
-      }
-    }
-    // Map to return info useful for your UI and backend:
-    return drives.map(drive => ({
-      device: drive.device,                // e.g. '\\\\.\\PhysicalDrive1' (Win), '/dev/sdb' (Linux)
-      description: drive.description,      // e.g. 'SanDisk USB Flash Drive'
-      size: drive.size,                    // in bytes, can format for display
-      mountpoints: drive.mountpoints,      // e.g. [{path: 'E:\\'}] for Windows, or /media/.. for Linux
-      isSystem: drive.isSystem,            // true for system boot partitions
-      isRemovable: drive.isRemovable,      // true for USB sticks and SD cards
-      isReadOnly: drive.isReadOnly,        // can't wipe if true
-      isCard: drive.isCard,                // for SD cards
-      busType: drive.busType,              // USB, SATA, NVMe etc.
-    }));
+    const native = await listDrivesNative();
+    if (native) return native;
+  } catch (error) {
+    console.warn('[DeviceManager] Native enumeration failed, using drivelist:', error);
+  }
+  try {
+    return await listDrivesFallback();
   } catch (error) {
     console.error('[DeviceManager] Error listing drives:', error);
     return [];
   }
 }
 
-module.exports = { listDrives };
+/**
+ * Push drive arrival/removal instead of re-polling listDrives() (Linux).
+ * onEvent({ action: 'add'|'remove'|'change', device, drive, cancelledJobs })
+ * fires once per disk after its uevent burst settles; `drive` is in the
+ * listDrives() shape, null for removals and empty card readers. Running wipes
+ * on a removed disk are cancelled natively before the event arrives.
+ * @returns {boolean} false when native hotplug events are unavailable
+ */
+function watchDrives(onEvent, options = {}) {
+  if (!wipeAddon || typeof wipeAddon.startHotplugWatcher !== 'function') return false;
+  const result = wipeAddon.startHotplugWatcher((event) => {
+    onEvent({
+      action: event.action,
+      device: event.path,
+      drive: event.device ? toDrive(event.device) : null,
+      cancelledJobs: event.cancelled_jobs,
+    });
+  }, options);
+  if (!result.success) console.warn('[DeviceManager] Hotplug events unavailable:', result.error);
+  return result.success;
+}
+
+function stopWatchingDrives() {
+  if (wipeAddon && typeof wipeAddon.stopHotplugWatcher === 'function') wipeAddon.stopHotplugWatcher();
+}
+
+module.exports = { listDrives, watchDrives, stopWatchingDrives };
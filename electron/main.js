@@ -1,9 +1,9 @@
 const { app, BrowserWindow, ipcMain, shell } = require('electron');
 const path = require('path');
-const { listDrives } = require('./deviceManager');
+const { listDrives, watchDrives, stopWatchingDrives } = require('./deviceManager');
 const os = require('os');
 const si = require('systeminformation');
-const { startWipe, cancelWipe, testNativeAddon, executePurge, checkPurgeCapabilities, formatPurgeResult } = require('./wipeController');
+const { startWipe, cancelWipe, setWipeLimits, testNativeAddon, executePurge, checkPurgeCapabilities, formatPurgeResult } = require('./wipeController');
 const { generateWipeCertificate } = require('./certificateGenerator');
 const { checkElevation, getElevationStatus, restartWithElevation } = require('./adminUtils');
 const fs = require('fs');
@@ -130,7 +130,7 @@ ipcMain.handle('test-addon', async () => {
 // Start wipe operation
 // Accepts: devicePath, wipeType ("clear"|"purge"|"destroy"), dryRun, label, deviceInfo
 ipcMain.handle('start-wipe', async (event, wipeParams) => {
-  const { devicePath, wipeType, dryRun, label, deviceInfo } = wipeParams;
+  const { devicePath, wipeType, dryRun, label, deviceInfo, limits } = wipeParams;
   const wipeId = `wipe_${Date.now()}_${Math.random().toString(36).substr(2, 9)}`;
 
   console.log(`[Main] Starting wipe operation ${wipeId}:`, { devicePath, wipeType, dryRun });
@@ -159,7 +159,7 @@ ipcMain.handle('start-wipe', async (event, wipeParams) => {
     event.sender.send('wipe-started', { wipeId, devicePath, wipeType, dryRun, label });
 
     // Start the wipe operation
-    const result = await startWipe({ devicePath, wipeType, dryRun, label, deviceInfo, wipeId }, onProgress);
+    const result = await startWipe({ devicePath, wipeType, dryRun, label, deviceInfo, wipeId, limits }, onProgress);
 
     // Determine overall success from structured response
     const isSuccess = result.status === 'success' || result.status === 'simulated';
@@ -295,6 +295,30 @@ ipcMain.handle('get-wipe-status', async (event, wipeId) => {
   return Object.fromEntries(activeWipes);
 });
 
+// Latency histograms and throughput series of a wipe (the addon's job
+// registry is shared with the worker threads that run the wipes)
+ipcMain.handle('get-wipe-stats', async (event, wipeId) => {
+  try {
+    if (!fs.existsSync(addonPath)) {
+      throw new Error('Native addon file not found at: ' + addonPath);
+    }
+    const addon = require(addonPath);
+    return addon.getStats(wipeId);
+  } catch (error) {
+    return { error: error.message };
+  }
+});
+
+// Throttle a running wipe, or all wipes when wipeId is null:
+// limits = { bandwidthMBps, burstMB, ioPriority: 'default'|'best-effort'|'idle', ioPriorityLevel }
+ipcMain.handle('set-wipe-limits', async (event, wipeId, limits) => {
+  try {
+    return setWipeLimits(wipeId, limits);
+  } catch (error) {
+    return { error: error.message };
+  }
+});
+
 // Stop/cancel a wipe operation
 ipcMain.handle('stop-wipe', async (event, wipeId) => {
   const wipeOperation = activeWipes.get(wipeId);
@@ -544,6 +568,15 @@ app.whenReady().then(() => {
   }
 
   createWindow();
+
+  // Drive arrival/removal pushed to the UI (Linux); the UI keeps polling elsewhere
+  watchDrives((event) => {
+    console.log(`[Main] Drive ${event.action}: ${event.device}`);
+    if (event.cancelledJobs.length > 0) {
+      console.warn(`[Main] ${event.device} removed during wipe; cancelled: ${event.cancelledJobs.join(', ')}`);
+    }
+    BrowserWindow.getAllWindows().forEach(win => win.webContents.send('drive-hotplug', event));
+  });
 });
 
 app.on('window-all-closed', () => {
@@ -566,6 +599,7 @@ app.on('before-quit', () => {
   // Ensure all wipe operations are properly cleaned up
   console.log('App quitting, active wipes:', activeWipes.size);
   activeWipes.clear();
+  stopWatchingDrives();
 
   // Close database connection
   closeDatabase();
@@ -17,11 +17,14 @@ contextBridge.exposeInMainWorld('api', {
 
   // Wipe Operations
   // startWipe accepts user intent, returns structured response:
-  // Params: { devicePath: string, wipeType: "clear"|"purge"|"destroy", dryRun: boolean, label?: string, deviceInfo?: object }
+  // Params: { devicePath: string, wipeType: "clear"|"purge"|"destroy", dryRun: boolean, label?: string, deviceInfo?: object,
+  //          limits?: { bandwidthMBps, burstMB, ioPriority: "default"|"best-effort"|"idle", ioPriorityLevel } }
   // Returns: { status: "success"|"unsupported"|"simulated"|"failed", executed: boolean, methodUsed: string, message: string, fallbackSuggested?: object }
   startWipe: (wipeParams) => ipcRenderer.invoke('start-wipe', wipeParams),
   stopWipe: (wipeId) => ipcRenderer.invoke('stop-wipe', wipeId),
   getWipeStatus: (wipeId) => ipcRenderer.invoke('get-wipe-status', wipeId),
+  getWipeStats: (wipeId) => ipcRenderer.invoke('get-wipe-stats', wipeId),
+  setWipeLimits: (wipeId, limits) => ipcRenderer.invoke('set-wipe-limits', wipeId, limits),
   cleanupWipeHistory: () => ipcRenderer.invoke('cleanup-wipe-history'),
 
   // Certificate Management
@@ -63,6 +66,12 @@ contextBridge.exposeInMainWorld('api', {
     return () => ipcRenderer.removeAllListeners('wipe-cancelled');
   },
 
+  // { action: 'add'|'remove'|'change', device, drive, cancelledJobs }
+  onDriveHotplug: (callback) => {
+    ipcRenderer.on('drive-hotplug', (event, data) => callback(data));
+    return () => ipcRenderer.removeAllListeners('drive-hotplug');
+  },
+
   onPurgeProgress: (callback) => {
     ipcRenderer.on('purge-progress', (event, data) => callback(data));
     return () => ipcRenderer.removeAllListeners('purge-progress');
@@ -88,21 +88,32 @@ async function executePurge(devicePath, options = {}) {
         };
     }
 
+    // One native session for the whole cascade so the device is probed once.
+    // The addon accepts the plain path wherever a session is accepted.
+    let device = devicePath;
+    if (typeof wipeAddon.openDeviceSession === 'function') {
+        try {
+            device = wipeAddon.openDeviceSession(devicePath);
+        } catch (error) {
+            log(`Device session unavailable, probing per method: ${error.message}`);
+        }
+    }
+
     // Method execution order: Crypto Erase → NVMe Sanitize → ATA Secure Erase
     const methodsToAttempt = [
         {
             name: 'cryptoErase',
-            execute: () => wipeAddon.cryptoErase(devicePath, dryRun),
+            execute: () => wipeAddon.cryptoErase(device, dryRun),
             description: 'Crypto Erase (Self-Encrypting Drive)'
         },
         {
             name: 'nvmeSanitize',
-            execute: () => wipeAddon.nvmeSanitize(devicePath, 'crypto', dryRun),
+            execute: () => wipeAddon.nvmeSanitize(device, 'crypto', dryRun),
             description: 'NVMe Sanitize (NVMe SSD)'
         },
         {
             name: 'ataSecureErase',
-            execute: () => wipeAddon.ataSecureErase(devicePath, false, dryRun),
+            execute: () => wipeAddon.ataSecureErase(device, false, dryRun),
             description: 'ATA Secure Erase (SATA HDD/SSD)'
         }
     ];
@@ -200,6 +211,10 @@ async function executePurge(devicePath, options = {}) {
         log(`  → ${method.name}: UNEXPECTED STATE (supported=${result.supported}, executed=${result.executed})`);
     }
 
+    if (typeof device !== 'string') {
+        wipeAddon.closeDeviceSession(device);
+    }
+
     // Build final result
     const finalResult = {
         purgeSucceeded,
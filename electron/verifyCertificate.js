@@ -2,12 +2,48 @@
 
 const fs = require('fs');
 const path = require('path');
+const crypto = require('crypto');
 
 // Validate ISO 8601 UTC
 function isIsoUtc(s) {
   return /^\d{4}-\d{2}-\d{2}T\d{2}:\d{2}:\d{2}(\.\d{3,})?Z$/.test(s);
 }
 
+// Root of a Merkle evidence leaves file (native/wipeMethods/merkleEvidence.h):
+// "WIPEMRK1", device size, region size, leaf count (u64 LE), then 32-byte
+// leaves; node = SHA-256(0x01 || left || right), an unpaired node carries up.
+// Returns null for a malformed file.
+function evidenceRoot(tree) {
+  if (tree.length < 32 || tree.toString('latin1', 0, 8) !== 'WIPEMRK1') return null;
+  const count = Number(tree.readBigUInt64LE(24));
+  if (count < 1 || tree.length !== 32 + count * 32) return null;
+  let level = [];
+  for (let i = 0; i < count; i++) level.push(tree.subarray(32 + i * 32, 64 + i * 32));
+  while (level.length > 1) {
+    const up = [];
+    for (let i = 0; i < level.length; i += 2) {
+      up.push(i + 1 < level.length
+        ? crypto.createHash('sha256').update(Buffer.from([1])).update(level[i]).update(level[i + 1]).digest()
+        : level[i]);
+    }
+    level = up;
+  }
+  return level[0].toString('hex');
+}
+
+// The evidence file must be the one certified and hash to the certified root.
+// Re-reading regions of the device itself is checkWipeEvidence (wipeController).
+function verifyEvidence(jsonPath, verification) {
+  const treePath = path.join(path.dirname(jsonPath), verification.tree_file || '');
+  if (!verification.tree_file || !fs.existsSync(treePath)) return 'Evidence file missing';
+  const tree = fs.readFileSync(treePath);
+  if (crypto.createHash('sha256').update(tree).digest('hex') !== verification.tree_sha256) {
+    return 'Evidence file digest does not match';
+  }
+  if (evidenceRoot(tree) !== verification.merkle_root) return 'Evidence leaves do not hash to merkle_root';
+  return null;
+}
+
 function verifyOne(jsonPath) {
   let cert, passed = true;
   let messages = [];
@@ -58,6 +94,14 @@ function verifyOne(jsonPath) {
     return { passed: false, messages };
   }
 
+  if (cert.verification) {
+    const problem = verifyEvidence(jsonPath, cert.verification);
+    if (problem) {
+      messages.push(`FAIL: ${path.basename(jsonPath)} --- ${problem}`);
+      return { passed: false, messages };
+    }
+  }
+
   messages.push(`PASS: ${path.basename(jsonPath)}`);
   return { passed: true, messages };
 }
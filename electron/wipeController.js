@@ -29,11 +29,79 @@ try {
   wipeAddon = null;
 }
 
+// Forward native log lines and engine events to wipeLogger. The addon's ring is
+// process-wide, so this also collects what the wipe worker threads log.
+const TELEMETRY_POLL_MS = 250;
+const TELEMETRY_BATCH = 1024;
+
+function drainNativeTelemetry() {
+  try {
+    let batch;
+    do {
+      batch = wipeAddon.drainTelemetry(TELEMETRY_BATCH);
+      wipeLogger.nativeRecords(batch.records, batch.dropped);
+    } while (batch.records.length === TELEMETRY_BATCH);
+  } catch (error) {
+    console.error('[WipeController] Failed to drain native telemetry:', error.message);
+  }
+}
+
+if (wipeAddon && typeof wipeAddon.drainTelemetry === 'function') {
+  drainNativeTelemetry();
+  setInterval(drainNativeTelemetry, TELEMETRY_POLL_MS).unref();
+  app.on('will-quit', drainNativeTelemetry);
+}
+
+// Prometheus textfile-collector export, enabled by WIPE_METRICS_TEXTFILE
+if (wipeAddon && process.env.WIPE_METRICS_TEXTFILE && typeof wipeAddon.startMetricsExporter === 'function') {
+  const intervalMs = Number(process.env.WIPE_METRICS_INTERVAL_MS) || undefined;
+  const exporter = wipeAddon.startMetricsExporter(process.env.WIPE_METRICS_TEXTFILE, intervalMs);
+  if (exporter.success) {
+    wipeLogger.info('METRICS', 'Prometheus textfile export enabled', { path: exporter.path });
+    app.on('will-quit', () => wipeAddon.stopMetricsExporter());
+  } else {
+    wipeLogger.warn('METRICS', 'Prometheus textfile export disabled', { error: exporter.error });
+  }
+}
+
+// Capabilities and write tuning remembered per drive model/unit; WIPE_DEVICE_CACHE=0 turns it off
+if (wipeAddon && process.env.WIPE_DEVICE_CACHE !== '0' && typeof wipeAddon.setDeviceCache === 'function') {
+  const cachePath = process.env.WIPE_DEVICE_CACHE || path.join(app.getPath('userData'), 'device-cache.tsv');
+  wipeAddon.setDeviceCache(cachePath);
+  wipeLogger.info('CACHE', 'Device capability cache enabled', { path: cachePath });
+}
+
+// Global write bandwidth cap for every wipe, e.g. when retiring disks on a live server
+if (wipeAddon && Number(process.env.WIPE_BANDWIDTH_MBPS) > 0 && typeof wipeAddon.setWipeLimits === 'function') {
+  const limits = { bandwidthMBps: Number(process.env.WIPE_BANDWIDTH_MBPS) };
+  if (Number(process.env.WIPE_BURST_MB) > 0) limits.burstMB = Number(process.env.WIPE_BURST_MB);
+  wipeAddon.setWipeLimits(limits);
+  wipeLogger.info('THROTTLE', 'Global wipe bandwidth limit set', limits);
+}
+
 const wipeController = new EventEmitter();
 
 // Track active wipe tasks for cancellation
 const activeTasks = new Map();
 
+// Per-wipe throttling ({ bandwidthMBps, burstMB, ioPriority, ioPriorityLevel }),
+// handed to the native job when its worker starts
+const wipeLimits = new Map();
+
+/**
+ * Change a wipe's bandwidth limit / I/O priority, before or while it runs.
+ * Without a wipeId the bandwidth limit applies to all wipes together.
+ * @returns {object|null} limits now in force, or null if the addon is unavailable
+ */
+function setWipeLimits(wipeId, limits) {
+  if (wipeId) wipeLimits.set(wipeId, { ...wipeLimits.get(wipeId), ...limits });
+  if (!wipeAddon || typeof wipeAddon.setWipeLimits !== 'function') return null;
+  const applied = wipeAddon.setWipeLimits(wipeId ? { jobId: wipeId, ...limits } : limits);
+  wipeLogger.info('THROTTLE', 'Wipe limits changed', { wipeId: wipeId || 'global', ...limits });
+  // null: the native job has not started yet; the worker passes the limits on
+  return applied || wipeLimits.get(wipeId) || null;
+}
+
 /**
  * PRE-FLIGHT VALIDATION: Ensure device is ready for wiping
  * Checks performed:
@@ -123,6 +191,8 @@ async function validateDeviceForWipe(devicePath) {
 function cancelWipe(wipeId) {
   if (activeTasks.has(wipeId)) {
     console.log(`[WipeController] Cancelling wipe ${wipeId}`);
+    // terminate() cannot interrupt a native call; the native job stops at its next write
+    if (wipeAddon && typeof wipeAddon.cancelJob === 'function') wipeAddon.cancelJob(wipeId, 'Cancelled by user');
     try { activeTasks.get(wipeId).cancel(); } catch (e) { console.error(e); }
     activeTasks.delete(wipeId);
     return true;
@@ -147,8 +217,8 @@ function runWorkerTask(wipeId, operation, devicePath, wipeType, dryRun, onProgre
       activeTasks.set(wipeId, { cancel: () => { cleanup(); worker.terminate(); reject(new Error('Operation cancelled by user')); } });
     }
 
-    // Send the task
-    worker.postMessage({ operation, devicePath, wipeType, dryRun });
+    // Send the task; the wipeId doubles as the native job id (getArenaStats)
+    worker.postMessage({ operation, devicePath, wipeType, dryRun, jobId: wipeId, limits: wipeLimits.get(wipeId) });
 
     // Fake progress/heartbeat timer
     const heartbeatParams = { progress: 30, direction: 1 };
@@ -182,6 +252,7 @@ function runWorkerTask(wipeId, operation, devicePath, wipeType, dryRun, onProgre
 
     worker.on('exit', (code) => {
       clearInterval(progressInterval);
+      if (wipeId) wipeLimits.delete(wipeId);
       if (code !== 0) {
         reject(new Error(`Worker stopped with exit code ${code}`));
       }
@@ -295,10 +366,11 @@ online disk
 // Main wipe function - accepts user intent, routes to appropriate handler
 // Frontend sends: devicePath, wipeType ("clear"|"purge"|"destroy"), dryRun, label, deviceInfo
 // Backend decides: actual method to use, returns structured response
-async function startWipe({ devicePath, wipeType, dryRun = true, label, deviceInfo, wipeId }, onProgress) {
+async function startWipe({ devicePath, wipeType, dryRun = true, label, deviceInfo, wipeId, limits }, onProgress) {
   // Support legacy 'device' parameter for backward compatibility
   const device = devicePath || arguments[0]?.device;
   const type = wipeType || 'clear';
+  if (wipeId && limits) wipeLimits.set(wipeId, limits);
 
   console.log(`[WipeController] Starting ${type} on ${device} (dryRun: ${dryRun})`);
 
@@ -462,7 +534,14 @@ async function startWipe({ devicePath, wipeType, dryRun = true, label, deviceInf
             postWipeStatus: result.status,
             logs: logs,
             toolVersion: "2.1.0",
-            simulated: false  // Explicitly false - we only reach here for real wipes
+            simulated: false,  // Explicitly false - we only reach here for real wipes
+            mediaCoverage: {
+              badRanges: result.badRanges,
+              sanitizedPercent: result.sanitizedPercent,
+              healthEvents: result.healthEvents,
+              deviceFlagged: result.deviceFlagged
+            },
+            evidence: result.evidence
           });
           logs.push(`Certificate generated: ${certificateResult?.certificateId || 'unknown'}`);
         } catch (certError) {
@@ -587,7 +666,12 @@ async function executeClear(device, wipeId, dryRun, logs, onProgress) {
       status: success ? 'success' : 'failed',
       executed: true,
       methodUsed: 'wipeFile',
-      message: result.message || (success ? 'Clear completed' : 'Clear failed')
+      message: result.message || (success ? 'Clear completed' : 'Clear failed'),
+      badRanges: result.badRanges || [],
+      sanitizedPercent: result.sanitizedPercent,
+      healthEvents: result.healthEvents || [],
+      deviceFlagged: result.deviceFlagged === true,
+      evidence: result.evidence || null
     };
   } catch (error) {
     logs.push(`Clear error: ${error.message}`);
@@ -689,7 +773,11 @@ async function executeDestroy(device, wipeId, dryRun, logs, onProgress) {
       status: success ? 'success' : 'failed',
       executed: true,
       methodUsed: 'destroyDrive',
-      message: result.message || (success ? 'Destroy completed' : 'Destroy failed')
+      message: result.message || (success ? 'Destroy completed' : 'Destroy failed'),
+      badRanges: result.badRanges || [],
+      sanitizedPercent: result.sanitizedPercent,
+      healthEvents: result.healthEvents || [],
+      deviceFlagged: result.deviceFlagged === true
     };
   } catch (error) {
     logs.push(`Destroy error: ${error.message}`);
@@ -767,9 +855,37 @@ function testNativeAddon() {
   }
 }
 
+/**
+ * Re-check a certified device: the certificate's evidence leaves must hash to
+ * its Merkle root, then `sample` random regions (default 256) are read back
+ * and compared with their leaves.
+ * @param {string} devicePath
+ * @param {string} certPath - certificate JSON; its .merkle file sits next to it
+ * @param {{ sample?: number, regions?: number[], threads?: number }} options
+ * @returns {object} checkWipeEvidence result ({ valid, root_matches, mismatched_regions, ... })
+ */
+function checkWipeEvidence(devicePath, certPath, options = {}) {
+  if (!wipeAddon || typeof wipeAddon.checkWipeEvidence !== 'function') {
+    throw new Error('Native wipe addon not available');
+  }
+  const cert = JSON.parse(fs.readFileSync(certPath, 'utf-8'));
+  if (!cert.verification) throw new Error('Certificate carries no verification evidence');
+  const tree = fs.readFileSync(path.join(path.dirname(certPath), cert.verification.tree_file));
+  const result = wipeAddon.checkWipeEvidence(devicePath, tree, { ...options, root: cert.verification.merkle_root });
+  wipeLogger.info('VERIFY', 'Evidence re-check', {
+    devicePath,
+    certificateId: cert.certificate_id,
+    valid: result.valid,
+    regionsChecked: result.regions_checked
+  });
+  return result;
+}
+
 module.exports = {
   startWipe,
   cancelWipe, // Exported cancellation
+  setWipeLimits,
+  checkWipeEvidence,
   wipeController,
   testNativeAddon,
   USBManager,
@@ -48,6 +48,40 @@ function writeLog(level, category, message, data = null) {
     }
 }
 
+// Append a batch of native telemetry records (addon drainTelemetry) in one write.
+// Records keep their native timestamp; engine event fields go under data.
+function writeNativeRecords(records) {
+    try {
+        ensureLogsDir();
+        let lines = '';
+        for (const record of records) {
+            const { time_ms, level, category, message, ...fields } = record;
+            const entry = {
+                timestamp: new Date(time_ms).toISOString(),
+                level,
+                category: `NATIVE:${category.toUpperCase()}`,
+                message,
+                data: fields
+            };
+            lines += JSON.stringify(entry) + '\n';
+
+            const consoleMsg = `[${level}][NATIVE:${category}]${fields.job_id ? ` [${fields.job_id}]` : ''} ${message}`;
+            if (level === 'ERROR') {
+                console.error(consoleMsg);
+            } else if (level === 'WARN') {
+                console.warn(consoleMsg);
+            } else if (level !== 'DEBUG') {
+                console.log(consoleMsg);
+            }
+        }
+        fs.appendFileSync(WIPE_LOG_FILE, lines, 'utf8');
+    } catch (error) {
+        console.error('[WipeLogger] Failed to write native records:', error);
+    }
+}
+
+let nativeDroppedReported = 0;
+
 // Public logging functions
 const wipeLogger = {
     // Addon load status
@@ -108,6 +142,18 @@ const wipeLogger = {
         });
     },
 
+    // Native addon telemetry; `dropped` is the addon's running count of records
+    // lost because the ring was full
+    nativeRecords: (records, dropped = 0) => {
+        if (records.length > 0) writeNativeRecords(records);
+        if (dropped > nativeDroppedReported) {
+            writeLog('WARN', 'ADDON', 'Native telemetry records dropped (ring full)', {
+                dropped: dropped - nativeDroppedReported
+            });
+            nativeDroppedReported = dropped;
+        }
+    },
+
     // Security logging
     securityWarning: (message, data) => {
         writeLog('WARN', 'SECURITY', message, data);
@@ -40,11 +40,122 @@ if (addonPath) {
     }
 }
 
+// Open a native device session (one handle + cached probes for the whole operation).
+// Falls back to the plain path, which the addon accepts everywhere a session is accepted.
+function openSession(devicePath, logs) {
+    if (typeof wipeAddon.openDeviceSession !== 'function') return devicePath;
+    try {
+        return wipeAddon.openDeviceSession(devicePath);
+    } catch (e) {
+        if (logs) logs.push(`Device session unavailable, using path: ${e.message}`);
+        return devicePath;
+    }
+}
+
+// Release the handle immediately so the drive can be remounted
+function closeSession(device) {
+    if (typeof device !== 'string') wipeAddon.closeDeviceSession(device);
+}
+
+// Media coverage of a finished native job: unwritable ranges the engine
+// skipped, the share of the device every pass reached, any degradation the
+// writer reacted to, and why it stopped early if it was cancelled
+function mediaCoverage(jobId) {
+    if (!jobId || typeof wipeAddon.getJob !== 'function') return {};
+    const job = wipeAddon.getJob(jobId);
+    if (!job) return {};
+    return {
+        badRanges: job.bad_ranges,
+        sanitizedPercent: job.sanitized_percent,
+        healthEvents: job.health_events,
+        deviceFlagged: job.device_flagged,
+        cancelReason: job.cancelled ? job.cancel_reason : undefined
+    };
+}
+
+// WIPE_STRIPES overrides the concurrent write streams of a clear:
+// 0 picks them from the device type, 1 writes a single stream
+const stripeOption = process.env.WIPE_STRIPES ? { stripes: Number(process.env.WIPE_STRIPES) } : {};
+
+// Read-back verification after a clear, with Merkle evidence for the
+// certificate; WIPE_VERIFY=0 skips it
+const verifyAfterClear = process.env.WIPE_VERIFY !== '0';
+
+// WIPE_VERIFY_LAG_MB: how far the read-back of a flash device trails the
+// writer when the two overlap (the addon defaults to 256)
+const verifyLagOption = process.env.WIPE_VERIFY_LAG_MB ? { verifyLagMB: Number(process.env.WIPE_VERIFY_LAG_MB) } : {};
+
+// WIPE_IO_TRACE: directory to record a binary trace of every I/O of each
+// clear and destroy into (<jobId>.iotrace), for replay with test/replayTrace.js
+function traceOption(jobId) {
+    const dir = process.env.WIPE_IO_TRACE;
+    if (!dir) return {};
+    return { ioTrace: path.join(dir, `${jobId || `job-${Date.now()}`}.iotrace`) };
+}
+
+// Evidence fields of an addon read-back result
+function evidenceOf(v) {
+    log(`Verification ${v.verified ? 'passed' : 'FAILED'}: root ${v.merkle_root}, ${v.mismatched_regions.length} mismatched regions`);
+    return {
+        algorithm: v.algorithm,
+        merkleRoot: v.merkle_root,
+        regionSize: v.region_size,
+        leafCount: v.leaf_count,
+        tree: v.tree,
+        expectedByte: v.expected_byte,
+        verified: v.verified,
+        mismatchedRegions: v.mismatched_regions,
+        unreadableRegions: v.unreadable_regions
+    };
+}
+
+// Read the device back and hash it into the evidence tree the certificate
+// carries. Null when the addon predates verifyWipe.
+function verifyClear(device, jobId) {
+    if (!verifyAfterClear || typeof wipeAddon.verifyWipe !== 'function') return null;
+    log('Verifying: reading the device back');
+    return evidenceOf(wipeAddon.verifyWipe(device, { jobId, method: 'zero' }));
+}
+
+// Clear with verification: overlapped with the last pass when the addon has
+// wipeAndVerify, else the wipe and then a separate read-back
+function clearAndVerify(device, jobId, limits) {
+    const options = { jobId, ...stripeOption, ...traceOption(jobId), ...limits };
+    if (!verifyAfterClear || typeof wipeAddon.wipeAndVerify !== 'function') {
+        const message = wipeAddon.wipeFile(device, 'zero', options);
+        log(`Native wipeFile returned: ${message}`);
+        const evidence = message && !message.toLowerCase().includes('fail') ? verifyClear(device, jobId) : null;
+        return { message, evidence };
+    }
+    log('Wiping with the read-back overlapped');
+    const r = wipeAddon.wipeAndVerify(device, 'zero', { ...options, ...verifyLagOption });
+    log(`Native wipeAndVerify returned: ${r.message}`);
+    return { message: r.message, evidence: r.verification ? evidenceOf(r.verification) : null };
+}
+
+// Run a hardware purge through the addon's sanitize monitor when it has one:
+// the call returns once the command is issued, this worker's thread is free
+// while the drive works, and progress is logged as the monitor reports it.
+// Resolves with the final purge result; falls back to the blocking call.
+function runSanitize(device, options, blocking) {
+    if (typeof wipeAddon.startSanitize !== 'function') return Promise.resolve(blocking());
+    return new Promise((resolve) => {
+        const started = wipeAddon.startSanitize(device, options, (event) => {
+            if (event.result) {
+                resolve(event.result);
+            } else if (event.progress !== null) {
+                log(`${event.method}: ${Math.floor(event.progress * 100)}%${event.estimated ? ' (estimated)' : ''}`);
+            }
+        });
+        if (started.status !== 'started') resolve(started);
+    });
+}
+
 // Main worker logic - handle wipe operations
 if (parentPort && wipeAddon) {
     parentPort.on('message', async (task) => {
         try {
-            const { operation, devicePath, wipeType, dryRun } = task;
+            const { operation, devicePath, wipeType, dryRun, jobId, limits } = task;
 
             log(`Worker starting ${operation} on ${devicePath} (DryRun: ${dryRun})`);
 
@@ -52,39 +163,56 @@ if (parentPort && wipeAddon) {
 
             switch (operation) {
                 case 'clear':
-                    // wipeFile(path, method, confirm)
+                    // wipeAndVerify / wipeFile(path, method, { jobId, stripes, ...limits })
                     // method is usually 'zero' or 'random' for clear. 'zero' is standard.
                     if (dryRun) {
                         result = "Simulation: Clear operation successful";
                         parentPort.postMessage({ type: 'done', result: { status: 'simulated', message: result } });
                     } else {
                         log(`Calling native wipeFile on: ${devicePath}`);
-                        result = wipeAddon.wipeFile(devicePath, 'zero', true);
-                        log(`Native wipeFile returned: ${result}`);
+                        const device = openSession(devicePath);
+                        let evidence = null;
+                        try {
+                            ({ message: result, evidence } = clearAndVerify(device, jobId, limits));
+                        } finally {
+                            closeSession(device);
+                        }
 
-                        // CRITICAL: Check if addon reported failure
-                        const isSuccess = result && !result.toLowerCase().includes('fail');
+                        // CRITICAL: Check if addon reported failure, or the read-back
+                        // found bytes the wipe did not leave behind
+                        let isSuccess = result && !result.toLowerCase().includes('fail');
+                        if (isSuccess && evidence && evidence.mismatchedRegions.length > 0) {
+                            isSuccess = false;
+                            result = `Verification failed: ${evidence.mismatchedRegions.length} regions do not hold the wipe pattern`;
+                        }
                         parentPort.postMessage({
                             type: 'done',
                             result: {
                                 status: isSuccess ? 'success' : 'failed',
                                 message: result,
-                                executed: true
+                                executed: true,
+                                evidence,
+                                ...mediaCoverage(jobId)
                             }
                         });
                     }
                     break;
 
                 case 'destroy':
-                    // destroyDrive(path, confirm)
+                    // destroyDrive(path, confirm, { jobId, ...limits })
                     if (dryRun) {
                         result = true;
                         parentPort.postMessage({ type: 'done', result: { status: 'simulated', message: 'Simulation: Destroy would execute' } });
                     } else {
                         log(`Calling native destroyDrive on: ${devicePath}`);
-                        result = wipeAddon.destroyDrive(devicePath, true);
+                        const device = openSession(devicePath);
+                        try {
+                            result = wipeAddon.destroyDrive(device, true, { jobId, ...traceOption(jobId), ...limits });
+                        } finally {
+                            closeSession(device);
+                        }
                         log(`Native destroyDrive returned: ${result}`);
-                        parentPort.postMessage({ type: 'done', result: { status: result ? 'success' : 'failed', message: result ? 'Destroy executed' : 'Destroy failed', executed: true } });
+                        parentPort.postMessage({ type: 'done', result: { status: result ? 'success' : 'failed', message: result ? 'Destroy executed' : 'Destroy failed', executed: true, ...mediaCoverage(jobId) } });
                     }
                     break;
 
@@ -124,11 +252,15 @@ if (parentPort && wipeAddon) {
                         let successfulMethod = null;
                         const logs = [];
 
+                        // One native session for the whole cascade: the device is opened and
+                        // probed once instead of once per method
+                        const device = openSession(devicePath, logs);
+
                         // Try Crypto Erase
                         if (typeof wipeAddon.cryptoErase === 'function') {
                             try {
                                 log('Attempting Crypto Erase...');
-                                const cryptoResult = wipeAddon.cryptoErase(devicePath, false);
+                                const cryptoResult = wipeAddon.cryptoErase(device, false);
                                 if (cryptoResult && cryptoResult.success) {
                                     purgeSucceeded = true;
                                     successfulMethod = 'cryptoErase';
@@ -143,7 +275,8 @@ if (parentPort && wipeAddon) {
                         if (!purgeSucceeded && typeof wipeAddon.nvmeSanitize === 'function') {
                             try {
                                 log('Attempting NVMe Sanitize...');
-                                const nvmeResult = wipeAddon.nvmeSanitize(devicePath, 'crypto', false);
+                                const nvmeResult = await runSanitize(device, { type: 'nvme', action: 'crypto', jobId },
+                                    () => wipeAddon.nvmeSanitize(device, 'crypto', false));
                                 if (nvmeResult && nvmeResult.success) {
                                     purgeSucceeded = true;
                                     successfulMethod = 'nvmeSanitize';
@@ -158,7 +291,8 @@ if (parentPort && wipeAddon) {
                         if (!purgeSucceeded && typeof wipeAddon.ataSecureErase === 'function') {
                             try {
                                 log('Attempting ATA Secure Erase...');
-                                const ataResult = wipeAddon.ataSecureErase(devicePath, false, false);
+                                const ataResult = await runSanitize(device, { type: 'ata', enhanced: false, jobId },
+                                    () => wipeAddon.ataSecureErase(device, false, false));
                                 if (ataResult && ataResult.success) {
                                     purgeSucceeded = true;
                                     successfulMethod = 'ataSecureErase';
@@ -169,6 +303,8 @@ if (parentPort && wipeAddon) {
                             }
                         }
 
+                        closeSession(device);
+
                         parentPort.postMessage({
                             type: 'done',
                             result: {
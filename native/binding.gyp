@@ -7,7 +7,29 @@
         "wipeMethods/purge/ataSecureErase.cpp",
         "wipeMethods/purge/nvmeSanitize.cpp",
         "wipeMethods/purge/cryptoErase.cpp",
-        "wipeMethods/destroy.cpp"
+        "wipeMethods/destroy.cpp",
+        "wipeMethods/deviceSession.cpp",
+        "wipeMethods/deviceEnum.cpp",
+        "wipeMethods/hotplugWatcher.cpp",
+        "wipeMethods/sanitizeMonitor.cpp",
+        "wipeMethods/deviceCache.cpp",
+        "wipeMethods/patternLibrary.cpp",
+        "wipeMethods/passEngine.cpp",
+        "wipeMethods/quickInvalidate.cpp",
+        "wipeMethods/fileShred.cpp",
+        "wipeMethods/treeShred.cpp",
+        "wipeMethods/wipeJob.cpp",
+        "wipeMethods/numaPlacement.cpp",
+        "wipeMethods/ioStats.cpp",
+        "wipeMethods/ioTrace.cpp",
+        "wipeMethods/probes.cpp",
+        "wipeMethods/telemetry.cpp",
+        "wipeMethods/metricsExporter.cpp",
+        "wipeMethods/healthMonitor.cpp",
+        "wipeMethods/zonedWriter.cpp",
+        "wipeMethods/stripedWriter.cpp",
+        "wipeMethods/merkleEvidence.cpp",
+        "wipeMethods/ioThrottle.cpp"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")"
@@ -1,17 +1,46 @@
 #include <napi.h>
 #include <string>
 #include <vector>
-#include <iostream>
 #include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 
 // Forward declarations for purge and destroy methods (with PurgeResult)
 #include "wipeMethods/purge/purgeCommon.h"
+#include "wipeMethods/deviceSession.h"
+#include "wipeMethods/deviceEnum.h"
+#include "wipeMethods/deviceCache.h"
+#include "wipeMethods/hotplugWatcher.h"
+#include "wipeMethods/patternLibrary.h"
+#include "wipeMethods/passEngine.h"
+#include "wipeMethods/zonedWriter.h"
+#include "wipeMethods/stripedWriter.h"
+#include "wipeMethods/quickInvalidate.h"
+#include "wipeMethods/merkleEvidence.h"
+#include "wipeMethods/fileShred.h"
+#include "wipeMethods/treeShred.h"
+#include "wipeMethods/wipeJob.h"
+#include "wipeMethods/ioThrottle.h"
+#include "wipeMethods/ioTrace.h"
+#include "wipeMethods/numaPlacement.h"
+#include "wipeMethods/telemetry.h"
+#include "wipeMethods/metricsExporter.h"
+#include "wipeMethods/probes.h"
 
-extern PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool dryRun);
-extern PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action, bool dryRun);
-extern PurgeResult cryptoErase(const std::string& drivePath, bool dryRun);
-extern bool destroyDrive(const std::string& drivePath, bool confirmDestroy);
+extern PurgeResult ataSecureErase(DeviceSession& session, bool useEnhanced, bool dryRun);
+extern PurgeResult nvmeSanitize(DeviceSession& session, const std::string& action, bool dryRun);
+extern PurgeResult cryptoErase(DeviceSession& session, bool dryRun);
+extern PurgeResult startAtaSecureErase(std::shared_ptr<DeviceSession> session, bool useEnhanced,
+                                       PurgeListener listener, uint64_t* operation);
+extern PurgeResult startNvmeSanitize(std::shared_ptr<DeviceSession> session, const std::string& action,
+                                     PurgeListener listener, uint64_t* operation);
+extern bool destroyDrive(DeviceSession& session, bool confirmDestroy);
 
 #ifdef _WIN32
     #include <windows.h>
@@ -27,299 +56,688 @@ extern bool destroyDrive(const std::string& drivePath, bool confirmDestroy);
 #endif
 
 // CRITICAL: These must be powers of 2 and sector-aligned
-constexpr size_t SECTOR_SIZE = 4096;  // Use 4KB sectors (safe for all drives)
 constexpr size_t BUFFER_SIZE = 128 * 1024 * 1024;  // 128MB for maximum throughput
 constexpr size_t NUM_BUFFERS = 2;  // Reduced to 2 for stability
-constexpr size_t PROGRESS_INTERVAL = 500 * 1024 * 1024; // Report every 500MB
 
-static uint64_t getDeviceSize(const std::string& path) {
-#ifdef _WIN32
-    HANDLE hDevice = CreateFileA(path.c_str(), GENERIC_READ, 
-                                 FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
-    
-    if (hDevice != INVALID_HANDLE_VALUE) {
-        GET_LENGTH_INFORMATION lengthInfo;
-        DWORD bytesReturned;
-        
-        if (DeviceIoControl(hDevice, IOCTL_DISK_GET_LENGTH_INFO, NULL, 0, 
-                           &lengthInfo, sizeof(lengthInfo), &bytesReturned, NULL)) {
-            CloseHandle(hDevice);
-            return static_cast<uint64_t>(lengthInfo.Length.QuadPart);
-        }
-        CloseHandle(hDevice);
-    }
-#else
-    struct stat st;
-    if (stat(path.c_str(), &st) == 0) {
-        if (S_ISBLK(st.st_mode)) {
-            int fd = open(path.c_str(), O_RDONLY);
-            if (fd != -1) {
-                uint64_t size = 0;
-#ifdef __linux__
-                if (ioctl(fd, BLKGETSIZE64, &size) == 0) {
-                    close(fd);
-                    return size;
-                }
-#endif
-                close(fd);
-            }
-        }
-        return st.st_size;
+// Run the named scheme, or one pass of `pattern`, over any pass-engine sink
+template <typename Sink>
+static bool writeMethod(Sink& sink, const std::string& method, PatternRef pattern, size_t maxChunk = BUFFER_SIZE) {
+    if (pattern) return runPatternPass(sink, pattern);
+    bool found = false;
+    bool result = runSchemeByName(sink, method, maxChunk, &found);
+    if (!found) {
+        logInfo("wipe") << "Unknown method '" << method << "', using single zero pass";
+        result = runScheme<ZeroScheme>(sink, maxChunk);
     }
-#endif
-    return 0;
+    return result;
 }
 
-bool optimizedWipe(const std::string& path) {
-    std::cout << "\n========================================" << std::endl;
-    std::cout << "HIGH-PERFORMANCE Wipe Starting" << std::endl;
-    std::cout << "Path: " << path << std::endl;
+// Overwrite the whole target with the named scheme (wipeSchemes.h), or with a
+// single pass of `pattern` when one is given. Unknown method names fall back
+// to a single zero pass. `stripes` 0 picks the concurrent write streams from
+// the device cache or the device type (deviceCache.h, stripedWriter.h); 1
+// forces a single stream. A failed quick-invalidate pre-pass does not stop the
+// wipe (the passes overwrite the same sectors); it is reported in `warning`.
+bool optimizedWipe(DeviceSession& session, const std::string& method, PatternRef pattern, unsigned stripes = 0,
+                   std::string* warning = nullptr) {
+    const std::string& path = session.path;
+    logInfo("wipe") << "HIGH-PERFORMANCE Wipe Starting";
+    logInfo("wipe") << "Path: " << path;
     
-    uint64_t totalSize = getDeviceSize(path);
+    uint64_t totalSize = session.size;
     if (totalSize == 0) {
-        std::cout << "ERROR: Could not determine device size" << std::endl;
+        logError("wipe") << "Could not determine device size";
         return false;
     }
     
-    std::cout << "Device size: " << (totalSize / 1024.0 / 1024.0 / 1024.0) << " GB" << std::endl;
-    std::cout << "Buffer: " << (BUFFER_SIZE / 1024 / 1024) << " MB per operation" << std::endl;
-    std::cout << "========================================\n" << std::endl;
+    logInfo("wipe") << "Device size: " << (totalSize / 1024.0 / 1024.0 / 1024.0) << " GB";
+    if (pattern) {
+        logInfo("wipe") << "Method: custom pattern (period " << pattern->period << ")";
+    } else {
+        logInfo("wipe") << "Method: " << method;
+    }
+
+    // Start where earlier wipes of this unit or model ended up instead of
+    // re-learning the stream count and write size
+    TuningPlan tuning = planTuning(session, stripes, BUFFER_SIZE);
+    unsigned streams = tuning.stripes ? tuning.stripes : stripeCount(session);
+    size_t maxChunk = tuning.chunk;
+    if (streams > 1 && maxChunk > STRIPE_MAX_CHUNK) {
+        maxChunk = STRIPE_MAX_CHUNK;    // Random passes fill a buffer per writer: keep their chunks small
+    }
+    logInfo("wipe") << "Buffer: " << (maxChunk / 1024 / 1024) << " MB per operation"
+                    << (tuning.cached ? " (cached tuning)" : "");
 
 #ifdef _WIN32
     // CRITICAL: On Windows, we must dismount all volumes on the physical drive
     // BEFORE we can write to it, even with admin rights.
+    dismountVolumes(session);
     
-    // Step 1: Extract drive number from path (e.g., "\\.\PhysicalDrive1" -> 1)
-    int driveNumber = -1;
-    if (path.find("PhysicalDrive") != std::string::npos) {
-        size_t pos = path.find("PhysicalDrive");
-        driveNumber = std::stoi(path.substr(pos + 13));
-    }
-    
-    // Step 2: Enumerate and dismount all volumes on this physical drive
-    if (driveNumber >= 0) {
-        std::cout << "Dismounting volumes on drive " << driveNumber << "..." << std::endl;
-        
-        // Try common drive letters (C: through Z:)
-        for (char letter = 'A'; letter <= 'Z'; letter++) {
-            std::string volumePath = std::string("\\\\.\\") + letter + ":";
-            
-            HANDLE hVolume = CreateFileA(
-                volumePath.c_str(),
-                GENERIC_READ | GENERIC_WRITE,
-                FILE_SHARE_READ | FILE_SHARE_WRITE,
-                NULL,
-                OPEN_EXISTING,
-                0,
-                NULL
-            );
-            
-            if (hVolume == INVALID_HANDLE_VALUE) {
-                continue; // Volume doesn't exist
-            }
-            
-            // Check if this volume is on our target drive
-            VOLUME_DISK_EXTENTS diskExtents;
-            DWORD bytesReturned;
-            if (DeviceIoControl(hVolume, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS,
-                               NULL, 0, &diskExtents, sizeof(diskExtents),
-                               &bytesReturned, NULL)) {
-                
-                if (diskExtents.NumberOfDiskExtents > 0 &&
-                    diskExtents.Extents[0].DiskNumber == (DWORD)driveNumber) {
-                    
-                    std::cout << "  Found volume " << letter << ": on target drive" << std::endl;
-                    
-                    // Lock the volume
-                    if (DeviceIoControl(hVolume, FSCTL_LOCK_VOLUME, NULL, 0, NULL, 0, &bytesReturned, NULL)) {
-                        std::cout << "    Locked volume " << letter << ":" << std::endl;
-                        
-                        // Dismount the volume
-                        if (DeviceIoControl(hVolume, FSCTL_DISMOUNT_VOLUME, NULL, 0, NULL, 0, &bytesReturned, NULL)) {
-                            std::cout << "    Dismounted volume " << letter << ":" << std::endl;
-                        } else {
-                            std::cout << "    Warning: Could not dismount " << letter << ": (error " << GetLastError() << ")" << std::endl;
-                        }
-                    } else {
-                        std::cout << "    Warning: Could not lock " << letter << ": (error " << GetLastError() << ")" << std::endl;
-                    }
-                }
-            }
-            
-            CloseHandle(hVolume);
+    // The session already holds the physical drive with NO_BUFFERING |
+    // WRITE_THROUGH (direct writes, bypass cache); it must have opened read-write
+    if (!session.writable) {
+        DWORD error = session.openError;
+        logError("wipe") << "Cannot open device. Error code: " << error;
+        if (error == 5) {
+            logInfo("wipe") << "  This is ACCESS_DENIED. Possible causes:";
+            logInfo("wipe") << "  1. Not running as Administrator";
+            logInfo("wipe") << "  2. Drive is in use by another program";
+            logInfo("wipe") << "  3. Antivirus is blocking access";
         }
+        return false;
+    }
+#else
+    // Linux: session fd is O_RDWR | O_SYNC
+    if (!session.writable) {
+        logError("wipe") << "Cannot open device";
+        return false;
     }
+#endif
     
-    // Step 3: Now open the physical drive for writing with NO_BUFFERING for maximum speed
-    HANDLE hDevice = CreateFileA(
-        path.c_str(),
-        GENERIC_WRITE,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH,  // Direct writes, bypass cache
-        NULL
-    );
+    logInfo("wipe") << "Device opened successfully";
     
-    if (hDevice == INVALID_HANDLE_VALUE) {
-        DWORD error = GetLastError();
-        std::cout << "ERROR: Cannot open device. Error code: " << error << std::endl;
-        if (error == 5) {
-            std::cout << "  This is ACCESS_DENIED. Possible causes:" << std::endl;
-            std::cout << "  1. Not running as Administrator" << std::endl;
-            std::cout << "  2. Drive is in use by another program" << std::endl;
-            std::cout << "  3. Antivirus is blocking access" << std::endl;
+    // Make the drive unmountable before the long passes begin. Zoned devices
+    // reject those scattered writes; the zone reset of the first pass
+    // discards their contents at once instead.
+    if (session.isBlockDevice && session.zoned == ZonedModel::None) {
+        InvalidateResult invalidated = quickInvalidate(session, false);
+        if (!invalidated.success) {
+            logWarn("wipe") << "Quick invalidate failed: " << invalidated.message
+                            << "; the drive stays mountable until the first pass reaches its metadata";
+            if (warning) *warning = "quick invalidate failed: " + invalidated.message;
         }
-        return false;
     }
     
-    std::cout << "Device opened successfully" << std::endl;
+    logInfo("wipe") << "Starting write operations...";
+    WIPE_PROBE(wipe__start, probeJobId(), path.c_str(), totalSize);
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    // Pattern buffers are page-aligned as FILE_FLAG_NO_BUFFERING requires,
+    // immutable and cached, so consecutive passes and jobs reuse the same fill
+    bool result;
+    uint64_t bytesWritten;
+    BadRangeList bad;
+    size_t endChunk = 0;        // Write size the health monitor still allowed at the end; 0 = not tuned
+    if (session.zoned != ZonedModel::None) {
+        ZonedSink sink(session);
+        result = writeMethod(sink, method, pattern);
+        bytesWritten = sink.bytesWritten();
+        bad = sink.badRanges();
+    } else if (streams > 1) {
+        StripedSink sink(session, streams);
+        result = writeMethod(sink, method, pattern, maxChunk);
+        bytesWritten = sink.bytesWritten();
+        bad = sink.badRanges();
+        streams = sink.stripes();
+        endChunk = std::min(sink.writeSize(), maxChunk);
+    } else {
+        DeviceSink sink(session);
+        result = writeMethod(sink, method, pattern, maxChunk);
+        bytesWritten = sink.bytesWritten();
+        bad = sink.badRanges();
+        endChunk = std::min(sink.healthMonitor().writeSize(), maxChunk);
+    }
+    WIPE_PROBE(wipe__end, probeJobId(), result ? 1 : 0, bytesWritten);
     
-    // Declare bytesReturned for later DeviceIoControl calls
+#ifdef _WIN32
+    // Unlock volume
     DWORD bytesReturned;
-
+    DeviceIoControl(session.handle, FSCTL_UNLOCK_VOLUME, NULL, 0, NULL, 0, &bytesReturned, NULL);
+#endif
     
-    // Allocate aligned buffer for FILE_FLAG_NO_BUFFERING (requires sector alignment)
-    void* rawBuffer = _aligned_malloc(BUFFER_SIZE, SECTOR_SIZE);
-    if (!rawBuffer) {
-        std::cout << "ERROR: Memory allocation failed" << std::endl;
-        CloseHandle(hDevice);
+    if (!result) {
         return false;
     }
-    char* buffer = static_cast<char*>(rawBuffer);
-    memset(buffer, 0, BUFFER_SIZE);  // Zero-fill the buffer
     
-    uint64_t written = 0;
-    auto startTime = std::chrono::high_resolution_clock::now();
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto totalTime = std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime).count();
+    double avgSpeed = (bytesWritten / 1024.0 / 1024.0) / (totalTime > 0 ? totalTime : 1);
     
-    std::cout << "Starting write operations..." << std::endl;
-
+    logInfo("wipe") << "WIPE COMPLETED SUCCESSFULLY!";
+    logInfo("wipe") << "Total time: " << totalTime << " seconds (" << (totalTime / 60) << " minutes)";
+    logInfo("wipe") << "Average speed: " << static_cast<int>(avgSpeed) << " MB/s";
+    if (endChunk) recordWipeTuning(session, streams, endChunk, avgSpeed);
+    if (!bad.empty()) {
+        logWarn("wipe") << "Unwritable: " << bad.ranges().size() << " ranges, " << bad.bytes() << " bytes ("
+                        << std::fixed << std::setprecision(6) << 100.0 * (totalSize - bad.bytes()) / totalSize
+                        << "% sanitized)";
+    }
     
-    while (written < totalSize) {
-        DWORD toWrite = static_cast<DWORD>(
-            std::min(static_cast<uint64_t>(BUFFER_SIZE), totalSize - written)
-        );
-        
-        // FILE_FLAG_NO_BUFFERING requires sector-aligned write sizes
-        if (toWrite % SECTOR_SIZE != 0) {
-            toWrite = ((toWrite / SECTOR_SIZE) + 1) * SECTOR_SIZE;
-            // Don't exceed total size
-            if (written + toWrite > totalSize) {
-                toWrite = static_cast<DWORD>((totalSize - written + SECTOR_SIZE - 1) & ~(SECTOR_SIZE - 1));
-            }
+    return true;
+}
+
+bool optimizedWipe(const std::string& path) {
+    std::shared_ptr<DeviceSession> session = openDeviceSession(path);
+    return optimizedWipe(*session, "zero", nullptr);
+}
+
+// Device sessions cross into JS as tagged externals (opaque handles)
+static const napi_type_tag DEVICE_SESSION_TAG = {
+    0x6a1f3c9e52d84b07ULL, 0x9d2e7b41c0f5a863ULL
+};
+
+using SessionRef = std::shared_ptr<DeviceSession>;
+
+static bool isDeviceSession(const Napi::Value& value) {
+    return value.IsExternal() && value.As<Napi::External<SessionRef>>().CheckTypeTag(&DEVICE_SESSION_TAG);
+}
+
+// First argument of every device call: a path string or a session from openDeviceSession().
+// A path opens a one-shot session that is closed when the call returns.
+static SessionRef sessionFromArg(const Napi::Value& value) {
+    if (isDeviceSession(value)) {
+        return *value.As<Napi::External<SessionRef>>().Data();
+    }
+    return openDeviceSession(value.As<Napi::String>());
+}
+
+static bool isDeviceArg(const Napi::Value& value) {
+    return value.IsString() || isDeviceSession(value);
+}
+
+static std::string devicePathFromArg(const Napi::Value& value) {
+    if (isDeviceSession(value)) {
+        return (*value.As<Napi::External<SessionRef>>().Data())->path;
+    }
+    return value.As<Napi::String>();
+}
+
+// Optional { jobId } in the options argument names the job in getArenaStats().
+// Without one the job is numbered automatically.
+static std::string jobIdFromOptions(const Napi::CallbackInfo& info, size_t index) {
+    if (info.Length() > index && info[index].IsObject()) {
+        Napi::Object options = info[index].As<Napi::Object>();
+        if (options.Has("jobId") && options.Get("jobId").IsString()) {
+            return options.Get("jobId").As<Napi::String>();
         }
-        DWORD bytesWritten = 0;
-        
-        // Simple synchronous write - but with LARGE buffers
-        if (!WriteFile(hDevice, buffer, toWrite, &bytesWritten, NULL)) {
-            DWORD error = GetLastError();
-            std::cout << "\nERROR: WriteFile failed with error: " << error << std::endl;
-            CloseHandle(hDevice);
-            return false;
+    }
+    return "";
+}
+
+// Throttling options of every job-starting call and of setWipeLimits():
+// { bandwidthMBps (0 = unlimited), burstMB, ioPriority: "default" |
+// "best-effort" | "idle", ioPriorityLevel (0-7, best-effort only) }
+struct LimitOptions {
+    bool hasBandwidth = false;
+    double bandwidthMBps = 0;
+    double burstMB = -1;            // Unset: keep the bucket's burst
+    bool hasPriority = false;
+    IoPriority priority{IoPriorityClass::Default, 0};
+};
+
+// Absent, undefined and null are the same: JS callers spread optional
+// settings and clear them with either
+static bool hasOption(const Napi::Object& options, const char* key) {
+    if (!options.Has(key)) return false;
+    Napi::Value value = options.Get(key);
+    return !value.IsUndefined() && !value.IsNull();
+}
+
+// Parsed before the job starts, so a bad option cannot leave a job behind
+static LimitOptions parseLimits(const Napi::Object& options) {
+    LimitOptions limits;
+    if (hasOption(options, "bandwidthMBps")) {
+        Napi::Value rate = options.Get("bandwidthMBps");
+        if (!rate.IsNumber() || !(rate.As<Napi::Number>().DoubleValue() >= 0)) {
+            throw std::invalid_argument("bandwidthMBps must be a non-negative number");
         }
-        
-        if (bytesWritten != toWrite) {
-            std::cout << "\nWARNING: Partial write - " << bytesWritten << " of " << toWrite << " bytes" << std::endl;
+        limits.hasBandwidth = true;
+        limits.bandwidthMBps = rate.As<Napi::Number>().DoubleValue();
+    }
+    if (hasOption(options, "burstMB")) {
+        Napi::Value burst = options.Get("burstMB");
+        if (!burst.IsNumber() || !(burst.As<Napi::Number>().DoubleValue() >= 0)) {
+            throw std::invalid_argument("burstMB must be a non-negative number");
         }
-        
-        written += bytesWritten;
-        
-        // Progress reporting - only every 1GB to minimize overhead
-        if (written % (1024ULL * 1024 * 1024) < BUFFER_SIZE || written >= totalSize) {
-            auto now = std::chrono::high_resolution_clock::now();
-            auto totalElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count();
-            double totalElapsedSec = totalElapsed / 1000.0;
-            double writtenMB = written / 1024.0 / 1024.0;
-            double currentSpeed = writtenMB / totalElapsedSec;
-            int progressPercent = static_cast<int>((written * 100) / totalSize);
-            
-            std::cout << "Progress: " << progressPercent << "% (" 
-                      << static_cast<int>(writtenMB) << " MB) - Speed: " 
-                      << static_cast<int>(currentSpeed) << " MB/s" << std::endl;
+        limits.burstMB = burst.As<Napi::Number>().DoubleValue();
+    }
+    if (hasOption(options, "ioPriority")) {
+        Napi::Value name = options.Get("ioPriority");
+        if (!name.IsString() || !parseIoPriorityClass(name.As<Napi::String>().Utf8Value().c_str(), limits.priority.ioClass)) {
+            throw std::invalid_argument("ioPriority must be \"default\", \"best-effort\" or \"idle\"");
+        }
+        limits.hasPriority = true;
+        limits.priority.level = 4;
+        if (hasOption(options, "ioPriorityLevel") && options.Get("ioPriorityLevel").IsNumber()) {
+            uint32_t level = options.Get("ioPriorityLevel").As<Napi::Number>().Uint32Value();
+            limits.priority.level = static_cast<uint8_t>(level > 7 ? 7 : level);
         }
     }
+    return limits;
+}
+
+static void applyLimits(const LimitOptions& limits, TokenBucket& bucket, WipeJob* job) {
+    if (limits.hasBandwidth || limits.burstMB >= 0) {
+        uint64_t rate = limits.hasBandwidth ? static_cast<uint64_t>(limits.bandwidthMBps * 1048576.0) : bucket.rate();
+        uint64_t burst = limits.burstMB >= 0 ? static_cast<uint64_t>(limits.burstMB * 1048576.0) : bucket.burst();
+        bucket.setLimit(rate, burst);
+    }
+    if (limits.hasPriority && job) job->setIoPriority(limits.priority);
+}
+
+static Napi::Object limitsToNapi(Napi::Env env, const TokenBucket& bucket, const WipeJob* job) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("bandwidth_mbps", Napi::Number::New(env, bucket.rate() / 1048576.0));
+    result.Set("burst_mb", Napi::Number::New(env, bucket.burst() / 1048576.0));
+    if (job) {
+        IoPriority priority = job->ioPriority();
+        result.Set("io_priority", Napi::String::New(env, ioPriorityClassName(priority.ioClass)));
+        result.Set("io_priority_level", Napi::Number::New(env, priority.level));
+    }
+    return result;
+}
+
+// Start the job named by options.jobId with the options' limits in force.
+// options.ioTrace names a file to record every I/O of the job to (ioTrace.h);
+// the device size and sector go into its header for replay.
+static JobRef startJobFromOptions(const Napi::CallbackInfo& info, size_t index, const std::string& target,
+                                  uint64_t deviceSize = 0, uint32_t logicalSector = 0) {
+    LimitOptions limits;
+    std::string tracePath;
+    if (info.Length() > index && info[index].IsObject()) {
+        Napi::Object options = info[index].As<Napi::Object>();
+        limits = parseLimits(options);
+        if (hasOption(options, "ioTrace")) {
+            if (!options.Get("ioTrace").IsString()) throw std::runtime_error("ioTrace must be a file path");
+            tracePath = options.Get("ioTrace").As<Napi::String>();
+        }
+    }
+    JobRef job = startJob(jobIdFromOptions(info, index), target);
+    applyLimits(limits, job->bandwidth(), job.get());
+    if (!tracePath.empty()) {
+        IoTraceRef trace = std::make_shared<IoTrace>(tracePath, target, job->id, deviceSize, logicalSector);
+        if (!trace->ok()) {
+            job->finish();
+            throw std::runtime_error(trace->error());
+        }
+        job->setTrace(trace);
+    }
+    return job;
+}
+
+static Napi::Object jobMemoryToNapi(Napi::Env env, const WipeJob& job) {
+    JobMemory memory = job.memory();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("shared_bytes", Napi::Number::New(env, static_cast<double>(memory.sharedBytes)));
+    result.Set("private_bytes", Napi::Number::New(env, static_cast<double>(memory.privateBytes)));
+    result.Set("peak_shared_bytes", Napi::Number::New(env, static_cast<double>(memory.peakSharedBytes)));
+    result.Set("peak_private_bytes", Napi::Number::New(env, static_cast<double>(memory.peakPrivateBytes)));
+    return result;
+}
+
+static Napi::Object jobToNapi(Napi::Env env, const WipeJob& job) {
+    BadRangeList bad = job.badRanges();
+    Napi::Array badRanges = Napi::Array::New(env, bad.ranges().size());
+    for (size_t i = 0; i < bad.ranges().size(); i++) {
+        Napi::Object range = Napi::Object::New(env);
+        range.Set("offset", Napi::Number::New(env, static_cast<double>(bad.ranges()[i].offset)));
+        range.Set("length", Napi::Number::New(env, static_cast<double>(bad.ranges()[i].length)));
+        badRanges.Set(static_cast<uint32_t>(i), range);
+    }
     
-    std::cout << "\nFlushing buffers..." << std::endl;
-    FlushFileBuffers(hDevice);
-    
-    // Unlock volume
-    DeviceIoControl(hDevice, FSCTL_UNLOCK_VOLUME, NULL, 0, NULL, 0, &bytesReturned, NULL);
-    
-    // Free aligned buffer
-    _aligned_free(rawBuffer);
+    // Written so far by the current pass: the resume point of a striped wipe
+    BadRangeList written = job.writtenRanges();
+    Napi::Array writtenRanges = Napi::Array::New(env, written.ranges().size());
+    for (size_t i = 0; i < written.ranges().size(); i++) {
+        Napi::Object range = Napi::Object::New(env);
+        range.Set("offset", Napi::Number::New(env, static_cast<double>(written.ranges()[i].offset)));
+        range.Set("length", Napi::Number::New(env, static_cast<double>(written.ranges()[i].length)));
+        writtenRanges.Set(static_cast<uint32_t>(i), range);
+    }
     
-    CloseHandle(hDevice);
+    std::vector<HealthEvent> health = job.healthEvents();
+    Napi::Array healthEvents = Napi::Array::New(env, health.size());
+    for (size_t i = 0; i < health.size(); i++) {
+        const HealthEvent& e = health[i];
+        Napi::Object event = Napi::Object::New(env);
+        event.Set("kind", Napi::String::New(env, healthEventName(e.kind)));
+        event.Set("at_s", Napi::Number::New(env, e.atSeconds));
+        event.Set("offset", Napi::Number::New(env, static_cast<double>(e.offset)));
+        event.Set("mbps", Napi::Number::New(env, e.mbps));
+        event.Set("baseline_mbps", Napi::Number::New(env, e.baselineMBps));
+        event.Set("latency_ms", Napi::Number::New(env, e.latencyMs));
+        // 0 while writes are not split
+        event.Set("write_size", Napi::Number::New(env, e.writeSize == SIZE_MAX ? 0.0 : static_cast<double>(e.writeSize)));
+        event.Set("detail", Napi::String::New(env, e.detail));
+        healthEvents.Set(static_cast<uint32_t>(i), event);
+    }
     
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto totalTime = std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime).count();
-    double avgSpeed = (totalSize / 1024.0 / 1024.0) / totalTime;
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("id", Napi::String::New(env, job.id));
+    result.Set("target", Napi::String::New(env, job.target));
+    result.Set("running", Napi::Boolean::New(env, job.running()));
+    result.Set("duration_ms", Napi::Number::New(env, job.elapsedMs()));
+    result.Set("memory", jobMemoryToNapi(env, job));
+    result.Set("target_bytes", Napi::Number::New(env, static_cast<double>(job.targetBytes())));
+    result.Set("bad_ranges", badRanges);
+    result.Set("bad_bytes", Napi::Number::New(env, static_cast<double>(bad.bytes())));
+    result.Set("written_ranges", writtenRanges);
+    result.Set("sanitized_percent", Napi::Number::New(env, job.sanitizedPercent()));
+    result.Set("health_events", healthEvents);
+    result.Set("device_flagged", Napi::Boolean::New(env, job.deviceFlagged()));
+    result.Set("cancelled", Napi::Boolean::New(env, job.cancelled()));
+    result.Set("cancel_reason", Napi::String::New(env, job.cancelReason()));
+    result.Set("limits", limitsToNapi(env, job.bandwidth(), &job));
+    return result;
+}
+
+// Result line of a wipe, as wipeFile returns it
+static std::string wipeMessage(bool result, const WipeJob& job) {
+    // Unwritable sectors were skipped, not fatal; details via getJob(jobId)
+    BadRangeList bad = job.badRanges();
+    if (result && !bad.empty()) {
+        std::ostringstream message;
+        message << "Wipe completed with " << bad.ranges().size() << " unwritable ranges ("
+                << std::fixed << std::setprecision(4) << job.sanitizedPercent() << "% sanitized)";
+        return message.str();
+    } else if (result && job.deviceFlagged()) {
+        return "Wipe completed; device flagged as degraded";
+    } else if (result) {
+        return "Wipe completed successfully";
+    } else if (job.cancelled()) {
+        return "Wipe failed: " + job.cancelReason();
+    }
+    return "Wipe failed";
+}
+
+// Byte value every region holds after the last pass of `method`, or of a
+// custom pattern; -1 when that pass is random or multi-byte
+static int expectedByteOf(const std::string& method, const std::string& patternBytes) {
+    if (!patternBytes.empty()) {
+        bool uniform = patternBytes.find_first_not_of(patternBytes[0]) == std::string::npos;
+        return uniform ? static_cast<uint8_t>(patternBytes[0]) : -1;
+    }
+    // Unknown methods were written as a single zero pass (optimizedWipe)
+    PassSpec last = ZeroScheme::passes[0];
+    finalPassOf(method, last);
+    return last.kind == PassKind::Pattern && last.period == 1 ? last.bytes[0] : -1;
+}
+
+// Regions an evidence check reads when the caller names none
+constexpr size_t EVIDENCE_SAMPLE = 256;
+
+static Napi::Array regionsToNapi(Napi::Env env, const std::vector<uint64_t>& regions) {
+    Napi::Array array = Napi::Array::New(env, regions.size());
+    for (size_t i = 0; i < regions.size(); i++) {
+        array.Set(static_cast<uint32_t>(i), Napi::Number::New(env, static_cast<double>(regions[i])));
+    }
+    return array;
+}
+
+// Reader threads: options.threads (1-MAX_STRIPES), else one per stripe the
+// writer would use, so rotational devices are read in a single stream
+static unsigned evidenceThreads(const Napi::Object* options, const DeviceSession& session) {
+    if (options && hasOption(*options, "threads") && options->Get("threads").IsNumber()) {
+        double threads = options->Get("threads").As<Napi::Number>().DoubleValue();
+        if (threads >= 1 && threads <= MAX_STRIPES) return static_cast<unsigned>(threads);
+    }
+    return stripeCount(session);
+}
+
+// Read-back result as verifyWipe returns it
+static Napi::Object evidenceToNapi(Napi::Env env, const MerkleEvidence& evidence, const EvidenceResult& er,
+                                   int expectedByte, unsigned threads, double durationMs) {
+    std::vector<uint8_t> tree = serializeEvidence(evidence);
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("completed", Napi::Boolean::New(env, er.completed));
+    // Every byte read back holds the last pass's value
+    result.Set("verified", Napi::Boolean::New(env, er.completed && expectedByte >= 0 && er.mismatched.empty() &&
+                                                    er.unreadable.empty()));
+    result.Set("expected_byte", expectedByte >= 0 ? Napi::Number::New(env, expectedByte) : env.Null());
+    result.Set("algorithm", Napi::String::New(env, "sha256-merkle"));
+    result.Set("merkle_root", Napi::String::New(env, digestHex(evidence.root)));
+    result.Set("region_size", Napi::Number::New(env, static_cast<double>(evidence.regionSize)));
+    result.Set("leaf_count", Napi::Number::New(env, static_cast<double>(evidence.leaves.size())));
+    result.Set("tree", Napi::Buffer<uint8_t>::Copy(env, tree.data(), tree.size()));
+    result.Set("mismatched_regions", regionsToNapi(env, er.mismatched));
+    result.Set("unreadable_regions", regionsToNapi(env, er.unreadable));
+    result.Set("bytes_read", Napi::Number::New(env, static_cast<double>(er.bytesRead)));
+    result.Set("threads", Napi::Number::New(env, threads));
+    result.Set("duration_ms", Napi::Number::New(env, durationMs));
+    result.Set("error_code", Napi::Number::New(env, er.error));
+    return result;
+}
+
+// wipeFile, and wipeAndVerify when `verify` is set
+static Napi::Value runWipe(const Napi::CallbackInfo& info, bool verify) {
+    Napi::Env env = info.Env();
     
-    std::cout << "\n========================================" << std::endl;
-    std::cout << "WIPE COMPLETED SUCCESSFULLY!" << std::endl;
-    std::cout << "Total time: " << totalTime << " seconds (" << (totalTime / 60) << " minutes)" << std::endl;
-    std::cout << "Average speed: " << static_cast<int>(avgSpeed) << " MB/s" << std::endl;
-    std::cout << "========================================\n" << std::endl;
+    if (info.Length() < 2 || !isDeviceArg(info[0]) || !info[1].IsString()) {
+        Napi::TypeError::New(env, "Path and method required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
     
-    return true;
+    std::string method = info[1].As<Napi::String>();
     
-#else
-    // Linux implementation
-    int fd = open(path.c_str(), O_WRONLY | O_SYNC);
-    if (fd == -1) {
-        std::cout << "ERROR: Cannot open device" << std::endl;
-        return false;
+    // Optional { pattern: Buffer|Uint8Array, jobId, stripes } - user-supplied overwrite bytes.
+    // They are copied once into a cached pattern buffer, never per chunk.
+    std::string patternBytes;
+    unsigned stripes = 0;
+    uint64_t verifyLag = VERIFY_DEFAULT_LAG;
+    Napi::Object options = info.Length() >= 3 && info[2].IsObject() ? info[2].As<Napi::Object>() : Napi::Object::New(env);
+    if (hasOption(options, "stripes")) {
+        Napi::Value stripesValue = options.Get("stripes");
+        double value = stripesValue.IsNumber() ? stripesValue.As<Napi::Number>().DoubleValue() : -1;
+        if (value < 0 || value > MAX_STRIPES || value != static_cast<unsigned>(value)) {
+            Napi::RangeError::New(env, "stripes must be an integer 0-" + std::to_string(MAX_STRIPES))
+                .ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        stripes = static_cast<unsigned>(value);
+    }
+    if (hasOption(options, "pattern")) {
+        Napi::Value patternValue = options.Get("pattern");
+        if (!patternValue.IsTypedArray()) {
+            Napi::TypeError::New(env, "pattern must be a Buffer or Uint8Array").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        Napi::Uint8Array bytes = patternValue.As<Napi::Uint8Array>();
+        if (bytes.ByteLength() == 0 || bytes.ByteLength() > MAX_PATTERN_PERIOD) {
+            Napi::RangeError::New(env, "pattern must be 1-" + std::to_string(MAX_PATTERN_PERIOD) + " bytes")
+                .ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        patternBytes.assign(reinterpret_cast<const char*>(bytes.Data()), bytes.ByteLength());
+    }
+    if (verify && hasOption(options, "verifyLagMB")) {
+        Napi::Value lagValue = options.Get("verifyLagMB");
+        double value = lagValue.IsNumber() ? lagValue.As<Napi::Number>().DoubleValue() : -1;
+        if (value < 0) {
+            Napi::RangeError::New(env, "verifyLagMB must be a non-negative number").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        verifyLag = static_cast<uint64_t>(value * 1024 * 1024);
     }
     
-    std::vector<char> buffer(BUFFER_SIZE, 0);
-    uint64_t written = 0;
-    auto startTime = std::chrono::high_resolution_clock::now();
-    
-    while (written < totalSize) {
-        size_t toWrite = std::min(static_cast<uint64_t>(BUFFER_SIZE), totalSize - written);
-        ssize_t result = write(fd, buffer.data(), toWrite);
+    try {
+        SessionRef session = sessionFromArg(info[0]);
+        JobRef job = startJobFromOptions(info, 2, session->path, session->size, session->logicalSectorSize);
+        JobScope scope(job, true);
+        NumaScope numa(session->numaNode);
         
-        if (result <= 0) {
-            std::cout << "Write failed" << std::endl;
-            close(fd);
-            return false;
+        // Built after pinning so the buffer lands on the device's node
+        PatternRef pattern;
+        if (!patternBytes.empty()) {
+            pattern = acquirePattern(reinterpret_cast<const uint8_t*>(patternBytes.data()), patternBytes.size(),
+                                     BUFFER_SIZE, session->numaNode);
         }
         
-        written += result;
+        // Flash devices are read back while the last pass is still writing;
+        // a rotational device would seek between the two, so it is read after
+        int expectedByte = expectedByteOf(method, patternBytes);
+        unsigned threads = evidenceThreads(&options, *session);
+        std::unique_ptr<OverlappedEvidence> overlapped;
+        if (verify && !session->rotational) {
+            overlapped.reset(new OverlappedEvidence(*session, expectedByte, threads, verifyLag));
+        }
+        
+        std::string warning;
+        bool result = optimizedWipe(*session, method, pattern, stripes, &warning);
+        std::string message = wipeMessage(result, *job);
+        if (!warning.empty()) message += " (" + warning + ")";
+        if (!verify) return Napi::String::New(env, message);
         
-        if (written % PROGRESS_INTERVAL == 0) {
-            auto now = std::chrono::high_resolution_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - startTime).count();
-            double speed = (written / 1024.0 / 1024.0) / elapsed;
-            std::cout << "Progress: " << (written * 100 / totalSize) << "% - Speed: " 
-                      << speed << " MB/s" << std::endl;
+        Napi::Object output = Napi::Object::New(env);
+        output.Set("message", Napi::String::New(env, message));
+        output.Set("wiped", Napi::Boolean::New(env, result));
+        if (!result) {
+            overlapped.reset();     // Abandons the read-back
+            output.Set("verification", env.Null());
+            return output;
         }
+        
+        auto start = std::chrono::steady_clock::now();
+        MerkleEvidence evidence;
+        EvidenceResult er = overlapped ? overlapped->finish(evidence)
+                                       : buildEvidence(*session, evidence, expectedByte, threads);
+        double durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        Napi::Object verification = evidenceToNapi(env, evidence, er, expectedByte, threads, durationMs);
+        verification.Set("overlapped_bytes",
+                         Napi::Number::New(env, overlapped ? static_cast<double>(overlapped->overlappedBytes()) : 0));
+        output.Set("verification", verification);
+        return output;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
     }
-    
-    fsync(fd);
-    close(fd);
-    return true;
-#endif
 }
 
 Napi::Value WipeFile(const Napi::CallbackInfo& info) {
+    return runWipe(info, false);
+}
+
+// Wipe and read back in one call: wipeAndVerify(device, method, { ...wipeFile
+// options, threads, verifyLagMB = 256 }). On flash devices the read-back
+// trails the last pass by verifyLagMB (merkleEvidence.h OverlappedEvidence)
+// instead of starting after it. Returns { message, wiped, verification },
+// verification as verifyWipe returns it plus overlapped_bytes, with
+// duration_ms the time it added after the write; null when the wipe failed.
+Napi::Value WipeAndVerify(const Napi::CallbackInfo& info) {
+    return runWipe(info, true);
+}
+
+// Read the device back and build its Merkle evidence (merkleEvidence.h):
+// verifyWipe(device, { jobId, method, pattern, threads }). When the last pass
+// of `method` (or `pattern`) writes one byte value, every region is also
+// compared against it. Returns the root and the leaves file as a Buffer.
+Napi::Value VerifyWipe(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
-        Napi::TypeError::New(env, "Path and method required").ThrowAsJavaScriptException();
+    if (info.Length() < 1 || !isDeviceArg(info[0])) {
+        Napi::TypeError::New(env, "Device path required").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string path = info[0].As<Napi::String>();
-    std::string method = info[1].As<Napi::String>();
+    Napi::Object options = info.Length() >= 2 && info[1].IsObject() ? info[1].As<Napi::Object>() : Napi::Object::New(env);
+    JobRef job;
+    if (hasOption(options, "jobId") && options.Get("jobId").IsString()) {
+        job = findJob(options.Get("jobId").As<Napi::String>());
+    }
+    std::string patternBytes;
+    if (hasOption(options, "pattern") && options.Get("pattern").IsTypedArray()) {
+        Napi::Uint8Array bytes = options.Get("pattern").As<Napi::Uint8Array>();
+        patternBytes.assign(reinterpret_cast<const char*>(bytes.Data()), bytes.ByteLength());
+    }
+    std::string method = hasOption(options, "method") && options.Get("method").IsString()
+                             ? options.Get("method").As<Napi::String>().Utf8Value() : "zero";
+    int expectedByte = expectedByteOf(method, patternBytes);
     
     try {
-        bool result = optimizedWipe(path);
+        SessionRef session = sessionFromArg(info[0]);
+        unsigned threads = evidenceThreads(&options, *session);
+        JobScope scope(job);
+        NumaScope numa(session->numaNode);
         
-        if (result) {
-            return Napi::String::New(env, "Wipe completed successfully");
-        } else {
-            return Napi::String::New(env, "Wipe failed");
+        auto start = std::chrono::steady_clock::now();
+        MerkleEvidence evidence;
+        EvidenceResult er = buildEvidence(*session, evidence, expectedByte, threads);
+        double durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return evidenceToNapi(env, evidence, er, expectedByte, threads, durationMs);
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// Re-check a certified device against its evidence:
+// checkWipeEvidence(device, tree, { root, regions, sample = 256, threads }).
+// The leaves must hash to `root`; then `regions` (indices), or `sample`
+// regions picked at random, are read back and compared with their leaves.
+Napi::Value CheckWipeEvidence(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 3 || !isDeviceArg(info[0]) || !info[1].IsTypedArray() || !info[2].IsObject()) {
+        Napi::TypeError::New(env, "Device, evidence tree and { root } required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Uint8Array treeBytes = info[1].As<Napi::Uint8Array>();
+    MerkleEvidence evidence;
+    if (!parseEvidence(treeBytes.Data(), treeBytes.ByteLength(), evidence)) {
+        Napi::TypeError::New(env, "Not a wipe evidence tree").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Object options = info[2].As<Napi::Object>();
+    Digest root;
+    if (!hasOption(options, "root") || !options.Get("root").IsString() ||
+        !parseDigestHex(options.Get("root").As<Napi::String>(), root)) {
+        Napi::TypeError::New(env, "root must be a SHA-256 hex digest").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::vector<uint64_t> regions;
+    if (hasOption(options, "regions") && options.Get("regions").IsArray()) {
+        Napi::Array list = options.Get("regions").As<Napi::Array>();
+        for (uint32_t i = 0; i < list.Length(); i++) {
+            if (list.Get(i).IsNumber()) regions.push_back(static_cast<uint64_t>(list.Get(i).As<Napi::Number>().Int64Value()));
         }
+    } else {
+        size_t sample = EVIDENCE_SAMPLE;
+        if (hasOption(options, "sample") && options.Get("sample").IsNumber()) {
+            sample = static_cast<size_t>(std::max(1.0, options.Get("sample").As<Napi::Number>().DoubleValue()));
+        }
+        for (uint64_t i = 0; i < evidence.leaves.size(); i++) regions.push_back(i);
+        if (sample < regions.size()) {
+            // Partial Fisher-Yates: the first `sample` entries are a uniform pick
+            std::mt19937_64 rng(std::random_device{}());
+            for (size_t i = 0; i < sample; i++) {
+                std::uniform_int_distribution<size_t> pick(i, regions.size() - 1);
+                std::swap(regions[i], regions[pick(rng)]);
+            }
+            regions.resize(sample);
+            std::sort(regions.begin(), regions.end());
+        }
+    }
+    
+    try {
+        SessionRef session = sessionFromArg(info[0]);
+        Napi::Object result = Napi::Object::New(env);
+        bool rootMatches = evidence.root == root;
+        result.Set("root_matches", Napi::Boolean::New(env, rootMatches));
+        if (!rootMatches) {
+            // The leaves are not the ones certified: reading the device proves nothing
+            result.Set("valid", Napi::Boolean::New(env, false));
+            result.Set("regions_checked", Napi::Number::New(env, 0));
+            return result;
+        }
+        
+        unsigned threads = evidenceThreads(&options, *session);
+        NumaScope numa(session->numaNode);
+        auto start = std::chrono::steady_clock::now();
+        EvidenceResult er = checkEvidence(*session, evidence, regions, threads);
+        double durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        
+        result.Set("valid", Napi::Boolean::New(env, er.completed && er.regionsChecked > 0 && er.mismatched.empty() &&
+                                                     er.unreadable.empty()));
+        result.Set("regions_checked", Napi::Number::New(env, static_cast<double>(er.regionsChecked)));
+        result.Set("leaf_count", Napi::Number::New(env, static_cast<double>(evidence.leaves.size())));
+        result.Set("mismatched_regions", regionsToNapi(env, er.mismatched));
+        result.Set("unreadable_regions", regionsToNapi(env, er.unreadable));
+        result.Set("bytes_read", Napi::Number::New(env, static_cast<double>(er.bytesRead)));
+        result.Set("threads", Napi::Number::New(env, threads));
+        result.Set("duration_ms", Napi::Number::New(env, durationMs));
+        result.Set("error_code", Napi::Number::New(env, er.error));
+        return result;
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
@@ -328,31 +746,220 @@ Napi::Value WipeFile(const Napi::CallbackInfo& info) {
 
 Napi::Value TestAddon(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    std::cout << "=== HIGH-PERFORMANCE Wipe Addon ===" << std::endl;
-    std::cout << "Buffer Size: " << (BUFFER_SIZE / 1024 / 1024) << " MB" << std::endl;
-    std::cout << "Expected speed: 50-150 MB/s (depending on USB interface)" << std::endl;
+    logInfo("wipe") << "=== HIGH-PERFORMANCE Wipe Addon ===";
+    logInfo("wipe") << "Buffer Size: " << (BUFFER_SIZE / 1024 / 1024) << " MB";
+    logInfo("wipe") << "Expected speed: 50-150 MB/s (depending on USB interface)";
     return Napi::String::New(env, "Addon ready - 32MB buffer size");
 }
 
+static const char* probeOutcomeName(ProbeOutcome outcome) {
+    switch (outcome) {
+        case ProbeOutcome::Supported:   return "supported";
+        case ProbeOutcome::Unsupported: return "unsupported";
+        default:                        return "unknown";
+    }
+}
+
+static Napi::Object deviceRecordToNapi(Napi::Env env, const DeviceRecord& r) {
+    Napi::Object record = Napi::Object::New(env);
+    record.Set("model", r.model);
+    record.Set("firmware", r.firmware);
+    record.Set("unit", r.unit);
+    record.Set("updated", static_cast<double>(r.updated));
+    record.Set("device_type", deviceTypeToString(r.deviceType));
+    record.Set("ata_security", probeOutcomeName(r.ataSecurity));
+    record.Set("ata_enhanced_erase", r.ataEnhancedErase);
+    record.Set("nvme_identify", probeOutcomeName(r.nvmeIdentify));
+    if (r.nvmeIdentify == ProbeOutcome::Supported) {
+        Napi::Object sanitize = Napi::Object::New(env);
+        sanitize.Set("crypto", r.nvmeCaps.cryptoSupported);
+        sanitize.Set("block", r.nvmeCaps.blockSupported);
+        sanitize.Set("overwrite", r.nvmeCaps.overwriteSupported);
+        record.Set("nvme_sanitize", sanitize);
+    }
+    Napi::Array unsupported = Napi::Array::New(env);
+    for (int m = 0; m < static_cast<int>(PurgeMethod::NOT_APPLICABLE); m++) {
+        if (r.unsupportedPurge & (1u << m)) {
+            unsupported.Set(unsupported.Length(), purgeMethodToString(static_cast<PurgeMethod>(m)));
+        }
+    }
+    record.Set("unsupported_purge", unsupported);
+    record.Set("stripes", r.stripes);
+    record.Set("chunk_size", static_cast<double>(r.chunkSize));
+    record.Set("best_mbps", r.bestMBps);
+    record.Set("last_mbps", r.lastMBps);
+    record.Set("jobs", r.jobs);
+    return record;
+}
+
 Napi::Value GetDeviceInfo(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 1 || !info[0].IsString()) {
+    if (info.Length() < 1 || !isDeviceArg(info[0])) {
         Napi::TypeError::New(env, "Device path required").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string path = info[0].As<Napi::String>();
+    SessionRef session = sessionFromArg(info[0]);
     Napi::Object deviceInfo = Napi::Object::New(env);
     
-    uint64_t size = getDeviceSize(path);
-    deviceInfo.Set("path", path);
+    uint64_t size = session->size;
+    deviceInfo.Set("path", session->path);
     deviceInfo.Set("size", static_cast<double>(size));
     deviceInfo.Set("sizeGB", size / 1024.0 / 1024.0 / 1024.0);
+    deviceInfo.Set("device_type", deviceTypeToString(session->deviceType));
+    deviceInfo.Set("model", session->model);
+    deviceInfo.Set("serial", session->serial);
+    deviceInfo.Set("firmware", session->firmware);
+    deviceInfo.Set("wwn", session->wwn);
+    deviceInfo.Set("logical_sector_size", session->logicalSectorSize);
+    deviceInfo.Set("physical_sector_size", session->physicalSectorSize);
+    deviceInfo.Set("rotational", session->rotational);
+    deviceInfo.Set("writable", session->writable);
+    deviceInfo.Set("numa_node", session->numaNode);
+    // Concurrent write streams an automatic wipe would use
+    deviceInfo.Set("stripes", session->zoned == ZonedModel::None ? stripeCount(*session) : 1);
+    deviceInfo.Set("zoned", zonedModelName(session->zoned));
+    if (session->zoned != ZonedModel::None) {
+        deviceInfo.Set("zone_size", static_cast<double>(session->zoneSize));
+        deviceInfo.Set("zone_count", session->zoneCount);
+        deviceInfo.Set("max_open_zones", session->maxOpenZones);
+        deviceInfo.Set("max_active_zones", session->maxActiveZones);
+    }
+    // What earlier jobs learned about this unit, or another of its model
+    DeviceRecord cached;
+    bool exact = false;
+    if (lookupDevice(*session, cached, &exact)) {
+        Napi::Object record = deviceRecordToNapi(env, cached);
+        record.Set("exact", exact);
+        deviceInfo.Set("cached", record);
+    } else {
+        deviceInfo.Set("cached", env.Null());
+    }
     
     return deviceInfo;
 }
 
+static Napi::Object blockDeviceToNapi(Napi::Env env, const BlockDeviceInfo& d) {
+    Napi::Object device = Napi::Object::New(env);
+    device.Set("name", d.name);
+    device.Set("path", d.path);
+    device.Set("vendor", d.vendor);
+    device.Set("model", d.model);
+    device.Set("serial", d.serial);
+    device.Set("firmware", d.firmware);
+    device.Set("wwn", d.wwn);
+    device.Set("transport", d.transport);
+    device.Set("device_type", deviceTypeToString(d.deviceType));
+    device.Set("size", static_cast<double>(d.size));
+    device.Set("logical_sector_size", d.logicalSectorSize);
+    device.Set("physical_sector_size", d.physicalSectorSize);
+    device.Set("rotational", d.rotational);
+    device.Set("removable", d.removable);
+    device.Set("read_only", d.readOnly);
+    device.Set("is_card", d.isCard);
+    device.Set("is_system", d.isSystem);
+
+    Napi::Array partitions = Napi::Array::New(env, d.partitions.size());
+    for (size_t p = 0; p < d.partitions.size(); p++) partitions.Set(p, d.partitions[p]);
+    device.Set("partitions", partitions);
+
+    Napi::Array mountpoints = Napi::Array::New(env, d.mountpoints.size());
+    for (size_t m = 0; m < d.mountpoints.size(); m++) {
+        const MountEntry& entry = d.mountpoints[m];
+        Napi::Object mount = Napi::Object::New(env);
+        mount.Set("path", entry.path);
+        mount.Set("fs_type", entry.fsType);
+        mount.Set("source", entry.source);
+        mount.Set("total", static_cast<double>(entry.total));
+        mount.Set("free", static_cast<double>(entry.free));
+        mount.Set("available", static_cast<double>(entry.available));
+        mountpoints.Set(m, mount);
+    }
+    device.Set("mountpoints", mountpoints);
+    return device;
+}
+
+// Enumerates block devices on the libuv pool; resolves null where the native
+// scan is not implemented so the caller falls back to drivelist.
+class ListDevicesWorker : public Napi::AsyncWorker {
+public:
+    explicit ListDevicesWorker(Napi::Env env)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)) {}
+
+    Napi::Promise promise() { return deferred.Promise(); }
+
+    void Execute() override {
+        supported = listBlockDevices(devices);
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        if (!supported) {
+            deferred.Resolve(env.Null());
+            return;
+        }
+        Napi::Array list = Napi::Array::New(env, devices.size());
+        for (size_t i = 0; i < devices.size(); i++) list.Set(i, blockDeviceToNapi(env, devices[i]));
+        deferred.Resolve(list);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(error.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    std::vector<BlockDeviceInfo> devices;
+    bool supported = false;
+};
+
+// listDevices() -> Promise<Array|null>: every physical disk with its mounts,
+// from one sysfs/mountinfo scan off the main thread (Linux; null elsewhere)
+Napi::Value ListDevices(const Napi::CallbackInfo& info) {
+    ListDevicesWorker* worker = new ListDevicesWorker(info.Env());
+    Napi::Promise promise = worker->promise();
+    worker->Queue();
+    return promise;
+}
+
+// Open a device once; the returned opaque handle can be passed in place of the
+// path to every wipe/purge/destroy call so a cascade shares one set of probes.
+Napi::Value OpenDeviceSession(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Device path required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string path = info[0].As<Napi::String>();
+    SessionRef session = openDeviceSession(path);
+    if (!session->isOpen()) {
+        Napi::Error::New(env, "Cannot open device " + path + " (error " + std::to_string(session->openError) + ")")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::External<SessionRef> handle = Napi::External<SessionRef>::New(
+        env, new SessionRef(session), [](Napi::Env, SessionRef* ref) { delete ref; });
+    handle.TypeTag(&DEVICE_SESSION_TAG);
+    return handle;
+}
+
+// Release the device handle now instead of at garbage collection (needed before remount)
+Napi::Value CloseDeviceSession(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !isDeviceSession(info[0])) {
+        Napi::TypeError::New(env, "Device session required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    (*info[0].As<Napi::External<SessionRef>>().Data())->close();
+    return env.Undefined();
+}
+
 // Helper to convert PurgeResult to Napi::Object
 static Napi::Object purgeResultToNapi(Napi::Env env, const PurgeResult& pr) {
     Napi::Object result = Napi::Object::New(env);
@@ -369,11 +976,34 @@ static Napi::Object purgeResultToNapi(Napi::Env env, const PurgeResult& pr) {
     return result;
 }
 
+// Run a purge routine unless the device cache (deviceCache.h) knows this
+// model reports `method` unsupported; a fresh "unsupported" is remembered for
+// the next unit. NOT_APPLICABLE bypasses the cache.
+template <typename Purge>
+static PurgeResult cachedPurge(DeviceSession& session, PurgeMethod method, Purge purge) {
+    if (method != PurgeMethod::NOT_APPLICABLE && purgeKnownUnsupported(session, method)) {
+        PurgeResult pr;
+        pr.devicePath = session.path;
+        pr.deviceType = session.deviceType;
+        pr.method = method;
+        pr.success = false;
+        pr.supported = false;
+        pr.executed = false;
+        pr.status = "unsupported";
+        pr.message = purgeMethodToString(method) + " is not supported by this device";
+        pr.reason = "Reported unsupported by this model before (device cache), not probed again";
+        return pr;
+    }
+    PurgeResult pr = purge();
+    if (method != PurgeMethod::NOT_APPLICABLE && pr.status == "unsupported") recordPurgeUnsupported(session, method);
+    return pr;
+}
+
 // N-API wrapper for ATA Secure Erase - returns structured object
 Napi::Value ATASecureErase(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 1 || !info[0].IsString()) {
+    if (info.Length() < 1 || !isDeviceArg(info[0])) {
         PurgeResult pr;
         pr.success = false;
         pr.supported = false;
@@ -384,12 +1014,14 @@ Napi::Value ATASecureErase(const Napi::CallbackInfo& info) {
         return purgeResultToNapi(env, pr);
     }
     
-    std::string path = info[0].As<Napi::String>();
+    std::string path = devicePathFromArg(info[0]);
     bool enhanced = (info.Length() >= 2 && info[1].IsBoolean()) ? info[1].As<Napi::Boolean>().Value() : false;
     bool dryRun = (info.Length() >= 3 && info[2].IsBoolean()) ? info[2].As<Napi::Boolean>().Value() : true;
     
     try {
-        PurgeResult pr = ataSecureErase(path, enhanced, dryRun);
+        SessionRef session = sessionFromArg(info[0]);
+        PurgeMethod method = enhanced ? PurgeMethod::ATA_SECURE_ERASE_ENHANCED : PurgeMethod::ATA_SECURE_ERASE;
+        PurgeResult pr = cachedPurge(*session, method, [&]() { return ataSecureErase(*session, enhanced, dryRun); });
         return purgeResultToNapi(env, pr);
     } catch (const std::exception& e) {
         PurgeResult pr;
@@ -408,7 +1040,7 @@ Napi::Value ATASecureErase(const Napi::CallbackInfo& info) {
 Napi::Value NVMeSanitize(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString()) {
+    if (info.Length() < 2 || !isDeviceArg(info[0]) || !info[1].IsString()) {
         PurgeResult pr;
         pr.success = false;
         pr.supported = false;
@@ -419,12 +1051,17 @@ Napi::Value NVMeSanitize(const Napi::CallbackInfo& info) {
         return purgeResultToNapi(env, pr);
     }
     
-    std::string path = info[0].As<Napi::String>();
+    std::string path = devicePathFromArg(info[0]);
     std::string action = info[1].As<Napi::String>();
     bool dryRun = (info.Length() >= 3 && info[2].IsBoolean()) ? info[2].As<Napi::Boolean>().Value() : true;
     
     try {
-        PurgeResult pr = nvmeSanitize(path, action, dryRun);
+        SessionRef session = sessionFromArg(info[0]);
+        PurgeMethod method = action == "crypto" ? PurgeMethod::NVME_SANITIZE_CRYPTO
+                           : action == "block" ? PurgeMethod::NVME_SANITIZE_BLOCK
+                           : action == "overwrite" ? PurgeMethod::NVME_SANITIZE_OVERWRITE
+                           : PurgeMethod::NOT_APPLICABLE;
+        PurgeResult pr = cachedPurge(*session, method, [&]() { return nvmeSanitize(*session, action, dryRun); });
         return purgeResultToNapi(env, pr);
     } catch (const std::exception& e) {
         PurgeResult pr;
@@ -443,7 +1080,7 @@ Napi::Value NVMeSanitize(const Napi::CallbackInfo& info) {
 Napi::Value CryptoErase(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 1 || !info[0].IsString()) {
+    if (info.Length() < 1 || !isDeviceArg(info[0])) {
         PurgeResult pr;
         pr.success = false;
         pr.supported = false;
@@ -454,11 +1091,12 @@ Napi::Value CryptoErase(const Napi::CallbackInfo& info) {
         return purgeResultToNapi(env, pr);
     }
     
-    std::string path = info[0].As<Napi::String>();
+    std::string path = devicePathFromArg(info[0]);
     bool dryRun = (info.Length() >= 2 && info[1].IsBoolean()) ? info[1].As<Napi::Boolean>().Value() : true;
     
     try {
-        PurgeResult pr = cryptoErase(path, dryRun);
+        SessionRef session = sessionFromArg(info[0]);
+        PurgeResult pr = cachedPurge(*session, PurgeMethod::CRYPTO_ERASE, [&]() { return cryptoErase(*session, dryRun); });
         return purgeResultToNapi(env, pr);
     } catch (const std::exception& e) {
         PurgeResult pr;
@@ -474,20 +1112,119 @@ Napi::Value CryptoErase(const Napi::CallbackInfo& info) {
 }
 
 
+static Napi::Object sanitizeProgressToNapi(Napi::Env env, const SanitizeProgress& p) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("id", Napi::Number::New(env, static_cast<double>(p.id)));
+    result.Set("path", Napi::String::New(env, p.path));
+    result.Set("method", Napi::String::New(env, p.method));
+    result.Set("job_id", Napi::String::New(env, p.job));
+    result.Set("state", Napi::String::New(env, sanitizeStateName(p.state)));
+    result.Set("progress", p.progress >= 0 ? Napi::Number::New(env, p.progress) : env.Null());
+    result.Set("estimated", Napi::Boolean::New(env, p.estimated));
+    result.Set("elapsed_ms", Napi::Number::New(env, static_cast<double>(p.elapsedMs)));
+    result.Set("remaining_ms", p.remainingMs ? Napi::Number::New(env, static_cast<double>(p.remainingMs)) : env.Null());
+    result.Set("polls", Napi::Number::New(env, p.polls));
+    result.Set("message", Napi::String::New(env, p.message));
+    return result;
+}
+
+// Start a hardware purge and return without waiting for it:
+// startSanitize(device, { type: 'nvme'|'ata', action, enhanced, jobId }, onEvent).
+// The sanitize monitor (sanitizeMonitor.h) follows it on its own thread and
+// calls onEvent with { id, state, progress, remaining_ms, ... } as progress
+// is made, and once more with `result` (the purge result nvmeSanitize or
+// ataSecureErase would have returned) when it is over. Returns the purge
+// result of the start: status "started" and operation_id, or why it did not.
+Napi::Value StartSanitize(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 3 || !isDeviceArg(info[0]) || !info[1].IsObject() || !info[2].IsFunction()) {
+        Napi::TypeError::New(env, "Device, options and callback required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Object options = info[1].As<Napi::Object>();
+    std::string type = hasOption(options, "type") && options.Get("type").IsString()
+                           ? options.Get("type").As<Napi::String>().Utf8Value() : "nvme";
+    std::string action = hasOption(options, "action") && options.Get("action").IsString()
+                             ? options.Get("action").As<Napi::String>().Utf8Value() : "crypto";
+    bool enhanced = hasOption(options, "enhanced") && options.Get("enhanced").IsBoolean() &&
+                    options.Get("enhanced").As<Napi::Boolean>().Value();
+    if (type != "nvme" && type != "ata") {
+        Napi::TypeError::New(env, "type must be 'nvme' or 'ata'").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    try {
+        SessionRef session = sessionFromArg(info[0]);
+        JobRef job = startJobFromOptions(info, 1, session->path);
+        JobScope scope(job);
+        
+        // Keeps the event loop alive until the final event is delivered
+        Napi::ThreadSafeFunction tsfn = Napi::ThreadSafeFunction::New(env, info[2].As<Napi::Function>(), "sanitizeMonitor", 0, 1);
+        PurgeListener listener = [tsfn](const SanitizeProgress& progress, const PurgeResult& final) mutable {
+            bool done = progress.state != SanitizeState::Running;
+            tsfn.NonBlockingCall([progress, final, done](Napi::Env env, Napi::Function callback) {
+                Napi::Object event = sanitizeProgressToNapi(env, progress);
+                if (done) event.Set("result", purgeResultToNapi(env, final));
+                callback.Call({event});
+            });
+            if (done) tsfn.Release();
+        };
+        
+        uint64_t operation = 0;
+        PurgeResult pr;
+        if (type == "ata") {
+            PurgeMethod method = enhanced ? PurgeMethod::ATA_SECURE_ERASE_ENHANCED : PurgeMethod::ATA_SECURE_ERASE;
+            pr = cachedPurge(*session, method, [&]() { return startAtaSecureErase(session, enhanced, listener, &operation); });
+        } else {
+            PurgeMethod method = action == "crypto" ? PurgeMethod::NVME_SANITIZE_CRYPTO
+                               : action == "block" ? PurgeMethod::NVME_SANITIZE_BLOCK
+                               : action == "overwrite" ? PurgeMethod::NVME_SANITIZE_OVERWRITE
+                               : PurgeMethod::NOT_APPLICABLE;
+            pr = cachedPurge(*session, method, [&]() { return startNvmeSanitize(session, action, listener, &operation); });
+        }
+        if (!operation) {
+            tsfn.Release();
+            job->finish();
+        }
+        
+        Napi::Object result = purgeResultToNapi(env, pr);
+        result.Set("operation_id", operation ? Napi::Number::New(env, static_cast<double>(operation)) : env.Null());
+        return result;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// Purges the sanitize monitor is following, then recently finished ones
+Napi::Value GetSanitizeOperations(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<SanitizeProgress> operations = sanitizeOperations();
+    Napi::Array result = Napi::Array::New(env, operations.size());
+    for (size_t i = 0; i < operations.size(); i++) {
+        result.Set(static_cast<uint32_t>(i), sanitizeProgressToNapi(env, operations[i]));
+    }
+    return result;
+}
+
 // N-API wrapper for Destroy Drive
 Napi::Value DestroyDrive(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
-    if (info.Length() < 1 || !info[0].IsString()) {
+    if (info.Length() < 1 || !isDeviceArg(info[0])) {
         Napi::TypeError::New(env, "Device path required").ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    std::string path = info[0].As<Napi::String>();
     bool confirm = (info.Length() >= 2 && info[1].IsBoolean()) ? info[1].As<Napi::Boolean>().Value() : false;
     
     try {
-        bool result = destroyDrive(path, confirm);
+        SessionRef session = sessionFromArg(info[0]);
+        JobScope job(startJobFromOptions(info, 2, session->path, session->size, session->logicalSectorSize), true);
+        NumaScope numa(session->numaNode);
+        bool result = destroyDrive(*session, confirm);
         return Napi::Boolean::New(env, result);
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
@@ -495,21 +1232,700 @@ Napi::Value DestroyDrive(const Napi::CallbackInfo& info) {
     }
 }
 
+// N-API wrapper for the quick-invalidate pre-pass: quickInvalidate(device, dryRun = true)
+Napi::Value QuickInvalidate(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !isDeviceArg(info[0])) {
+        Napi::TypeError::New(env, "Device path required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    bool dryRun = (info.Length() >= 2 && info[1].IsBoolean()) ? info[1].As<Napi::Boolean>().Value() : true;
+    
+    try {
+        SessionRef session = sessionFromArg(info[0]);
+        InvalidateResult ir = quickInvalidate(*session, dryRun);
+        
+        Napi::Array regions = Napi::Array::New(env, ir.regions.size());
+        for (size_t i = 0; i < ir.regions.size(); i++) {
+            Napi::Object region = Napi::Object::New(env);
+            region.Set("offset", Napi::Number::New(env, static_cast<double>(ir.regions[i].offset)));
+            region.Set("length", Napi::Number::New(env, static_cast<double>(ir.regions[i].length)));
+            region.Set("label", Napi::String::New(env, ir.regions[i].label));
+            regions.Set(static_cast<uint32_t>(i), region);
+        }
+        
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("success", Napi::Boolean::New(env, ir.success));
+        result.Set("executed", Napi::Boolean::New(env, ir.executed));
+        result.Set("device_path", Napi::String::New(env, session->path));
+        result.Set("regions", regions);
+        result.Set("bytes_written", Napi::Number::New(env, static_cast<double>(ir.bytesWritten)));
+        result.Set("duration_ms", Napi::Number::New(env, ir.durationMs));
+        result.Set("message", Napi::String::New(env, ir.message));
+        result.Set("error_code", Napi::Number::New(env, ir.errorCode));
+        return result;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// N-API wrapper for extent-aware file shredding: shredFile(path, method = "zero", { remove, jobId })
+Napi::Value ShredFile(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "File path required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string path = info[0].As<Napi::String>();
+    std::string method = (info.Length() >= 2 && info[1].IsString()) ? info[1].As<Napi::String>().Utf8Value() : "zero";
+    bool removeAfter = false;
+    if (info.Length() >= 3 && info[2].IsObject()) {
+        Napi::Object options = info[2].As<Napi::Object>();
+        removeAfter = options.Has("remove") && options.Get("remove").IsBoolean() && options.Get("remove").As<Napi::Boolean>().Value();
+    }
+    
+    try {
+        JobRef job = startJobFromOptions(info, 2, path);
+        ShredResult sr;
+        {
+            JobScope scope(job, true);
+            sr = shredFile(path, method, removeAfter);
+        }
+        
+        Napi::Array extents = Napi::Array::New(env, sr.extents.size());
+        for (size_t i = 0; i < sr.extents.size(); i++) {
+            const FileExtent& e = sr.extents[i];
+            Napi::Object extent = Napi::Object::New(env);
+            extent.Set("logical", Napi::Number::New(env, static_cast<double>(e.logical)));
+            extent.Set("physical", Napi::Number::New(env, static_cast<double>(e.physical)));
+            extent.Set("length", Napi::Number::New(env, static_cast<double>(e.length)));
+            extent.Set("unwritten", Napi::Boolean::New(env, e.unwritten));
+            extent.Set("shared", Napi::Boolean::New(env, e.shared));
+            extents.Set(static_cast<uint32_t>(i), extent);
+        }
+        
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("success", Napi::Boolean::New(env, sr.success));
+        result.Set("path", Napi::String::New(env, sr.path));
+        result.Set("method", Napi::String::New(env, sr.method));
+        result.Set("file_size", Napi::Number::New(env, static_cast<double>(sr.fileSize)));
+        result.Set("bytes_written", Napi::Number::New(env, static_cast<double>(sr.bytesWritten)));
+        result.Set("hole_bytes", Napi::Number::New(env, static_cast<double>(sr.holeBytes)));
+        result.Set("extents", extents);
+        result.Set("extent_source", Napi::String::New(env, sr.extentSource));
+        result.Set("removed", Napi::Boolean::New(env, sr.removed));
+        result.Set("duration_ms", Napi::Number::New(env, sr.durationMs));
+        result.Set("message", Napi::String::New(env, sr.message));
+        result.Set("error_code", Napi::Number::New(env, sr.errorCode));
+        result.Set("job_id", Napi::String::New(env, job->id));
+        result.Set("memory", jobMemoryToNapi(env, *job));
+        return result;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// N-API wrapper for parallel directory shredding: shredTree(dir, method = "zero", { threads, remove, jobId })
+Napi::Value ShredTree(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Directory path required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string root = info[0].As<Napi::String>();
+    std::string method = (info.Length() >= 2 && info[1].IsString()) ? info[1].As<Napi::String>().Utf8Value() : "zero";
+    unsigned threads = 0;
+    bool removeAfter = false;
+    if (info.Length() >= 3 && info[2].IsObject()) {
+        Napi::Object options = info[2].As<Napi::Object>();
+        if (options.Has("threads") && options.Get("threads").IsNumber()) {
+            threads = options.Get("threads").As<Napi::Number>().Uint32Value();
+        }
+        removeAfter = options.Has("remove") && options.Get("remove").IsBoolean() && options.Get("remove").As<Napi::Boolean>().Value();
+    }
+    
+    try {
+        JobRef job = startJobFromOptions(info, 2, root);
+        TreeShredResult tr;
+        {
+            JobScope scope(job, true);
+            tr = shredTree(root, method, threads, removeAfter);
+        }
+        
+        Napi::Array failures = Napi::Array::New(env, tr.failures.size());
+        for (size_t i = 0; i < tr.failures.size(); i++) {
+            failures.Set(static_cast<uint32_t>(i), Napi::String::New(env, tr.failures[i]));
+        }
+        
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("success", Napi::Boolean::New(env, tr.success));
+        result.Set("root", Napi::String::New(env, tr.root));
+        result.Set("method", Napi::String::New(env, tr.method));
+        result.Set("files", Napi::Number::New(env, static_cast<double>(tr.files)));
+        result.Set("directories", Napi::Number::New(env, static_cast<double>(tr.directories)));
+        result.Set("bytes_written", Napi::Number::New(env, static_cast<double>(tr.bytesWritten)));
+        result.Set("hole_bytes", Napi::Number::New(env, static_cast<double>(tr.holeBytes)));
+        result.Set("threads", Napi::Number::New(env, tr.threads));
+        result.Set("tasks", Napi::Number::New(env, static_cast<double>(tr.tasks)));
+        result.Set("steals", Napi::Number::New(env, static_cast<double>(tr.steals)));
+        result.Set("removed", Napi::Boolean::New(env, tr.removed));
+        result.Set("duration_ms", Napi::Number::New(env, tr.durationMs));
+        result.Set("throughput_mbps", Napi::Number::New(env, tr.throughputMBps));
+        result.Set("failures", failures);
+        result.Set("message", Napi::String::New(env, tr.message));
+        result.Set("job_id", Napi::String::New(env, job->id));
+        result.Set("memory", jobMemoryToNapi(env, *job));
+        return result;
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+// Shared pattern arena and per-job memory: getArenaStats()
+Napi::Value GetArenaStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    PatternArenaStats stats = patternArenaStats();
+    
+    std::vector<JobRef> jobList = listJobs();
+    Napi::Array jobs = Napi::Array::New(env, jobList.size());
+    for (size_t i = 0; i < jobList.size(); i++) {
+        jobs.Set(static_cast<uint32_t>(i), jobToNapi(env, *jobList[i]));
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("patterns", Napi::Number::New(env, static_cast<double>(stats.patterns)));
+    result.Set("pattern_bytes", Napi::Number::New(env, static_cast<double>(stats.patternBytes)));
+    result.Set("in_use_patterns", Napi::Number::New(env, static_cast<double>(stats.inUsePatterns)));
+    result.Set("in_use_pattern_bytes", Napi::Number::New(env, static_cast<double>(stats.inUsePatternBytes)));
+    result.Set("repeated_pattern_bytes", Napi::Number::New(env, static_cast<double>(stats.repeatedBytes)));
+    result.Set("scratch_buffers", Napi::Number::New(env, static_cast<double>(stats.scratchBuffers)));
+    result.Set("scratch_bytes", Napi::Number::New(env, static_cast<double>(stats.scratchBytes)));
+    result.Set("idle_scratch_bytes", Napi::Number::New(env, static_cast<double>(stats.idleScratchBytes)));
+    result.Set("huge_page_bytes", Napi::Number::New(env, static_cast<double>(stats.hugePageBytes)));
+    result.Set("transparent_huge_page_bytes", Napi::Number::New(env, static_cast<double>(stats.transparentBytes)));
+    result.Set("total_bytes", Napi::Number::New(env, static_cast<double>(stats.totalBytes)));
+    result.Set("jobs", jobs);
+    return result;
+}
+
+// One job's state and media coverage (bad ranges, % sanitized): getJob(jobId)
+Napi::Value GetJob(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Job id required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    JobRef job = findJob(info[0].As<Napi::String>());
+    if (!job) return env.Null();
+    return jobToNapi(env, *job);
+}
+
+// setWipeLimits({ jobId, bandwidthMBps, burstMB, ioPriority, ioPriorityLevel }):
+// change a job's limits while it runs, or without jobId the global bandwidth
+// limit shared by all jobs. Returns the limits now in force, or null for an
+// unknown job.
+Napi::Value SetWipeLimits(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Limits object required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    try {
+        LimitOptions limits = parseLimits(info[0].As<Napi::Object>());
+        std::string jobId = jobIdFromOptions(info, 0);
+        if (jobId.empty()) {
+            if (limits.hasPriority) throw std::invalid_argument("ioPriority applies to one job; pass jobId");
+            applyLimits(limits, globalBandwidth(), nullptr);
+            return limitsToNapi(env, globalBandwidth(), nullptr);
+        }
+        JobRef job = findJob(jobId);
+        if (!job) return env.Null();
+        applyLimits(limits, job->bandwidth(), job.get());
+        return limitsToNapi(env, job->bandwidth(), job.get());
+    } catch (const std::exception& e) {
+        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+}
+
+static Napi::Object ioDirectionToNapi(Napi::Env env, const IoDirectionStats& io) {
+    const LatencyHistogram& latency = io.latency;
+    std::vector<LatencyHistogram::Bucket> buckets = latency.nonEmptyBuckets();
+    Napi::Array histogram = Napi::Array::New(env, buckets.size());
+    for (size_t i = 0; i < buckets.size(); i++) {
+        Napi::Object bucket = Napi::Object::New(env);
+        bucket.Set("low_us", Napi::Number::New(env, buckets[i].lowNs / 1000.0));
+        bucket.Set("high_us", Napi::Number::New(env, buckets[i].highNs / 1000.0));
+        bucket.Set("count", Napi::Number::New(env, static_cast<double>(buckets[i].count)));
+        histogram.Set(static_cast<uint32_t>(i), bucket);
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("count", Napi::Number::New(env, static_cast<double>(latency.count())));
+    result.Set("bytes", Napi::Number::New(env, static_cast<double>(io.bytes.load())));
+    result.Set("errors", Napi::Number::New(env, static_cast<double>(io.errors.load())));
+    result.Set("min_us", Napi::Number::New(env, latency.minNs() / 1000.0));
+    result.Set("mean_us", Napi::Number::New(env, latency.meanNs() / 1000.0));
+    result.Set("p50_us", Napi::Number::New(env, latency.percentileNs(0.50) / 1000.0));
+    result.Set("p90_us", Napi::Number::New(env, latency.percentileNs(0.90) / 1000.0));
+    result.Set("p99_us", Napi::Number::New(env, latency.percentileNs(0.99) / 1000.0));
+    result.Set("p999_us", Napi::Number::New(env, latency.percentileNs(0.999) / 1000.0));
+    result.Set("max_us", Napi::Number::New(env, latency.maxNs() / 1000.0));
+    result.Set("histogram", histogram);
+    return result;
+}
+
+// Latency histograms and throughput series of one job: getStats(jobId)
+Napi::Value GetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Job id required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    JobRef job = findJob(info[0].As<Napi::String>());
+    if (!job) return env.Null();
+    
+    const ThroughputSeries& series = job->io().throughput();
+    double interval = series.intervalSeconds();
+    std::vector<uint64_t> bytes = series.bytesPerInterval();
+    Napi::Array mbps = Napi::Array::New(env, bytes.size());
+    for (size_t i = 0; i < bytes.size(); i++) {
+        mbps.Set(static_cast<uint32_t>(i), Napi::Number::New(env, bytes[i] / 1024.0 / 1024.0 / interval));
+    }
+    Napi::Object throughput = Napi::Object::New(env);
+    throughput.Set("interval_s", Napi::Number::New(env, interval));
+    throughput.Set("mbps", mbps);
+    
+    Napi::Object result = jobToNapi(env, *job);
+    result.Set("write", ioDirectionToNapi(env, job->io().writes()));
+    result.Set("read", ioDirectionToNapi(env, job->io().reads()));
+    result.Set("throughput", throughput);
+    return result;
+}
+
+static Napi::Object replayLatencyToNapi(Napi::Env env, const ReplayLatency& recorded, const ReplayLatency& replayed) {
+    auto side = [&](const ReplayLatency& latency) {
+        Napi::Object o = Napi::Object::New(env);
+        o.Set("p50_us", Napi::Number::New(env, latency.p50Ns / 1000.0));
+        o.Set("p99_us", Napi::Number::New(env, latency.p99Ns / 1000.0));
+        o.Set("max_us", Napi::Number::New(env, latency.maxNs / 1000.0));
+        return o;
+    };
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("recorded", side(recorded));
+    result.Set("replayed", side(replayed));
+    return result;
+}
+
+// Replay a trace recorded with the ioTrace option (ioTrace.h):
+// replayIoTrace(tracePath, { target, speed = 1, direct = true, output }).
+// Without target the I/O goes to an emulated device that answers with the
+// recorded latencies and errors; speed 0 issues each stream back to back.
+// output saves the replay as a trace. Returns the recording and the replay
+// side by side.
+Napi::Value ReplayIoTrace(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Trace path required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    ReplayOptions options;
+    std::string output;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object o = info[1].As<Napi::Object>();
+        if (hasOption(o, "target") && o.Get("target").IsString()) options.target = o.Get("target").As<Napi::String>();
+        if (hasOption(o, "output") && o.Get("output").IsString()) output = o.Get("output").As<Napi::String>();
+        if (hasOption(o, "direct") && o.Get("direct").IsBoolean()) options.direct = o.Get("direct").As<Napi::Boolean>().Value();
+        if (hasOption(o, "speed")) {
+            double speed = o.Get("speed").IsNumber() ? o.Get("speed").As<Napi::Number>().DoubleValue() : -1;
+            if (!(speed >= 0)) {
+                Napi::RangeError::New(env, "speed must be a non-negative number").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            options.speed = speed;
+        }
+    }
+    
+    IoTraceHeader header;
+    std::vector<IoTraceRecord> records;
+    std::string error;
+    if (!readIoTrace(info[0].As<Napi::String>(), header, records, &error)) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    ReplayResult r = replayIoTrace(header, records, options);
+    if (r.completed && !output.empty() && !writeIoTrace(output, header, r.replayed, &error)) r.error = error;
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("completed", Napi::Boolean::New(env, r.completed));
+    result.Set("error", r.error.empty() ? env.Null() : Napi::String::New(env, r.error));
+    result.Set("recorded_target", Napi::String::New(env, std::string(header.target, strnlen(header.target, sizeof(header.target)))));
+    result.Set("recorded_job", Napi::String::New(env, std::string(header.job, strnlen(header.job, sizeof(header.job)))));
+    result.Set("target", options.target.empty() ? env.Null() : Napi::String::New(env, options.target));
+    result.Set("ops", Napi::Number::New(env, static_cast<double>(r.ops)));
+    result.Set("bytes", Napi::Number::New(env, static_cast<double>(r.bytes)));
+    result.Set("streams", Napi::Number::New(env, r.streams));
+    result.Set("recorded_failures", Napi::Number::New(env, static_cast<double>(r.recordedFailures)));
+    result.Set("failures", Napi::Number::New(env, static_cast<double>(r.failures)));
+    result.Set("recorded_ms", Napi::Number::New(env, r.recordedNs / 1e6));
+    result.Set("replayed_ms", Napi::Number::New(env, r.replayedNs / 1e6));
+    result.Set("recorded_mbps", Napi::Number::New(env, r.recordedNs ? r.bytes / 1048576.0 / (r.recordedNs / 1e9) : 0));
+    result.Set("replayed_mbps", Napi::Number::New(env, r.replayedNs ? r.bytes / 1048576.0 / (r.replayedNs / 1e9) : 0));
+    result.Set("write", replayLatencyToNapi(env, r.recordedWrite, r.replayedWrite));
+    result.Set("read", replayLatencyToNapi(env, r.recordedRead, r.replayedRead));
+    return result;
+}
+
+// Per-NUMA-node write bandwidth: getNumaStats()
+Napi::Value GetNumaStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<NumaNodeStats> stats = numaNodeStats();
+    
+    Napi::Array nodes = Napi::Array::New(env, stats.size());
+    for (size_t i = 0; i < stats.size(); i++) {
+        const NumaNodeStats& s = stats[i];
+        Napi::Array cpus = Napi::Array::New(env, s.cpus.size());
+        for (size_t c = 0; c < s.cpus.size(); c++) {
+            cpus.Set(static_cast<uint32_t>(c), Napi::Number::New(env, s.cpus[c]));
+        }
+        Napi::Object node = Napi::Object::New(env);
+        node.Set("node", Napi::Number::New(env, s.node));
+        node.Set("cpus", cpus);
+        node.Set("bytes_written", Napi::Number::New(env, static_cast<double>(s.bytesWritten)));
+        node.Set("active_threads", Napi::Number::New(env, s.activeThreads));
+        node.Set("busy_ms", Napi::Number::New(env, s.busyMs));
+        node.Set("average_mbps", Napi::Number::New(env, s.averageMBps));
+        nodes.Set(static_cast<uint32_t>(i), node);
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("node_count", Napi::Number::New(env, numaNodeCount()));
+    result.Set("nodes", nodes);
+    return result;
+}
+
+// Field names of TelemetryRecord::values per event (telemetry.h)
+static void setEventValues(Napi::Env env, Napi::Object& record, const TelemetryRecord& r) {
+    static const char* const none[3] = {nullptr, nullptr, nullptr};
+    static const char* const jobFinished[3] = {"elapsed_ms", nullptr, nullptr};
+    static const char* const passStarted[3] = {"pass", "passes", "bytes"};
+    static const char* const passFinished[3] = {"pass", "passes", "elapsed_ms"};
+    static const char* const progress[3] = {"bytes", "total_bytes", "mbps"};
+    static const char* const badRange[3] = {"offset", "length", "error"};
+    static const char* const deviceHealth[3] = {"kind", "mbps", "baseline_mbps"};
+    static const char* const sanitizeProgress[3] = {"progress_bp", "elapsed_ms", "remaining_ms"};
+    static const char* const sanitizeFinished[3] = {"state", "elapsed_ms", "polls"};
+
+    const char* const* names = none;
+    switch (r.event) {
+        case TelemetryEvent::JobFinished: names = jobFinished; break;
+        case TelemetryEvent::PassStarted: names = passStarted; break;
+        case TelemetryEvent::PassFinished: names = passFinished; break;
+        case TelemetryEvent::Progress: names = progress; break;
+        case TelemetryEvent::BadRange: names = badRange; break;
+        case TelemetryEvent::DeviceHealth: names = deviceHealth; break;
+        case TelemetryEvent::SanitizeProgress: names = sanitizeProgress; break;
+        case TelemetryEvent::SanitizeFinished: names = sanitizeFinished; break;
+        default: break;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (names[i]) record.Set(names[i], Napi::Number::New(env, static_cast<double>(r.values[i])));
+    }
+}
+
+// Take up to `max` (default 1024) queued native log lines and events
+Napi::Value DrainTelemetry(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    size_t max = 1024;
+    if (info.Length() >= 1 && info[0].IsNumber()) {
+        max = static_cast<size_t>(std::max(1.0, info[0].As<Napi::Number>().DoubleValue()));
+    }
+    
+    std::vector<TelemetryRecord> drained;
+    drained.reserve(std::min(max, TELEMETRY_CAPACITY));
+    drainTelemetry(drained, max);
+    
+    Napi::Array records = Napi::Array::New(env, drained.size());
+    for (size_t i = 0; i < drained.size(); i++) {
+        const TelemetryRecord& r = drained[i];
+        Napi::Object record = Napi::Object::New(env);
+        record.Set("time_ms", Napi::Number::New(env, r.timeUs / 1000.0));
+        record.Set("level", Napi::String::New(env, logLevelName(r.level)));
+        record.Set("category", Napi::String::New(env, r.category));
+        record.Set("event", Napi::String::New(env, telemetryEventName(r.event)));
+        record.Set("job_id", Napi::String::New(env, r.job));
+        record.Set("thread", Napi::Number::New(env, r.thread));
+        record.Set("message", Napi::String::New(env, std::string(r.text, r.textLength)));
+        setEventValues(env, record, r);
+        records.Set(static_cast<uint32_t>(i), record);
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("records", records);
+    result.Set("dropped", Napi::Number::New(env, static_cast<double>(telemetryDropped())));
+    return result;
+}
+
+// Write a Prometheus textfile-collector file every intervalMs (default 5000)
+Napi::Value StartMetricsExporter(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Metrics file path required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string path = info[0].As<Napi::String>();
+    unsigned intervalMs = METRICS_DEFAULT_INTERVAL_MS;
+    if (info.Length() >= 2 && info[1].IsNumber()) {
+        intervalMs = static_cast<unsigned>(std::max(0.0, info[1].As<Napi::Number>().DoubleValue()));
+    }
+    
+    std::string error;
+    bool started = startMetricsExporter(path, intervalMs, &error);
+    if (started) {
+        // Stop the thread (and write a final file) when this environment exits
+        static std::atomic<bool> hooked{false};
+        if (!hooked.exchange(true)) {
+            napi_add_env_cleanup_hook(env, [](void*) { stopMetricsExporter(); }, nullptr);
+        }
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("success", Napi::Boolean::New(env, started));
+    result.Set("path", Napi::String::New(env, path));
+    if (!started) result.Set("error", Napi::String::New(env, error));
+    return result;
+}
+
+Napi::Value StopMetricsExporter(const Napi::CallbackInfo& info) {
+    stopMetricsExporter();
+    return info.Env().Undefined();
+}
+
+// setDeviceCache(path | null, { clear }): persist probed capabilities and
+// write tuning per device model/unit in `path`; null turns the cache off
+Napi::Value SetDeviceCache(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !(info[0].IsString() || info[0].IsNull())) {
+        Napi::TypeError::New(env, "Cache file path or null required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    setDeviceCachePath(info[0].IsString() ? info[0].As<Napi::String>().Utf8Value() : "");
+    std::string error;
+    bool success = true;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("clear") && options.Get("clear").IsBoolean() && options.Get("clear").As<Napi::Boolean>().Value()) {
+            success = clearDeviceCache(&error);
+        }
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("success", Napi::Boolean::New(env, success));
+    result.Set("path", Napi::String::New(env, deviceCachePath()));
+    if (!success) result.Set("error", Napi::String::New(env, error));
+    return result;
+}
+
+// getDeviceCache(): { path, records } with the most recently updated first
+Napi::Value GetDeviceCache(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<DeviceRecord> list = deviceCacheRecords();
+    Napi::Array records = Napi::Array::New(env, list.size());
+    for (size_t i = 0; i < list.size(); i++) records.Set(static_cast<uint32_t>(i), deviceRecordToNapi(env, list[i]));
+    
+    std::string path = deviceCachePath();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("path", path.empty() ? env.Null() : Napi::String::New(env, path));
+    result.Set("records", records);
+    return result;
+}
+
+// cancelJob(jobId, reason?): stop a running job before its next write. The
+// wipe call returns failure with the job's cancel_reason; false when no such
+// job is running.
+Napi::Value CancelJob(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsString()) {
+        Napi::TypeError::New(env, "Job id required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    std::string reason = info.Length() >= 2 && info[1].IsString() ? info[1].As<Napi::String>().Utf8Value()
+                                                                   : "Cancelled by user";
+    return Napi::Boolean::New(env, cancelJob(info[0].As<Napi::String>(), reason));
+}
+
+// Hotplug events reach JS through this function; one watcher per process,
+// owned by the env (main thread or worker) that started it
+static std::mutex hotplugMutex;
+static Napi::ThreadSafeFunction hotplugFunction;       // Guarded by hotplugMutex
+static napi_env hotplugEnv = nullptr;                 // Owner; guarded by hotplugMutex
+
+static Napi::Object hotplugEventToNapi(Napi::Env env, const HotplugEvent& event) {
+    Napi::Array cancelled = Napi::Array::New(env, event.cancelledJobs.size());
+    for (size_t i = 0; i < event.cancelledJobs.size(); i++) cancelled.Set(i, event.cancelledJobs[i]);
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("action", Napi::String::New(env, hotplugActionName(event.action)));
+    result.Set("name", Napi::String::New(env, event.name));
+    result.Set("path", Napi::String::New(env, event.path));
+    result.Set("uevents", Napi::Number::New(env, event.uevents));
+    result.Set("cancelled_jobs", cancelled);
+    result.Set("device", event.hasDevice ? Napi::Value(blockDeviceToNapi(env, event.device)) : env.Null());
+    return result;
+}
+
+// Caller holds hotplugMutex
+static void releaseHotplugWatcherLocked() {
+    stopHotplugWatcher();
+    if (hotplugEnv) {
+        hotplugFunction.Release();
+        hotplugEnv = nullptr;
+    }
+}
+
+// Cleanup hook of the owning env, registered with that env as its argument
+static void releaseHotplugWatcherOf(void* env) {
+    std::lock_guard<std::mutex> lock(hotplugMutex);
+    if (hotplugEnv == env) releaseHotplugWatcherLocked();
+}
+
+// startHotplugWatcher(callback, { debounceMs }): call back with
+// { action: 'add'|'remove'|'change', name, path, uevents, cancelled_jobs,
+// device } as disks come and go. Jobs on a removed disk are cancelled before
+// the event is delivered. Starting again replaces the callback; a watcher
+// started in another thread (worker) throws until that thread stops it.
+Napi::Value StartHotplugWatcher(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsFunction()) {
+        Napi::TypeError::New(env, "Callback function required").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    unsigned debounceMs = HOTPLUG_DEFAULT_DEBOUNCE_MS;
+    if (info.Length() >= 2 && info[1].IsObject() && hasOption(info[1].As<Napi::Object>(), "debounceMs")) {
+        Napi::Value value = info[1].As<Napi::Object>().Get("debounceMs");
+        if (!value.IsNumber() || value.As<Napi::Number>().DoubleValue() < 0) {
+            Napi::TypeError::New(env, "debounceMs must be a non-negative number").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        debounceMs = static_cast<unsigned>(std::min<double>(value.As<Napi::Number>().DoubleValue(), HOTPLUG_MAX_DEBOUNCE_MS));
+    }
+    
+    std::lock_guard<std::mutex> lock(hotplugMutex);
+    if (hotplugEnv && hotplugEnv != napi_env(env)) {
+        Napi::Error::New(env, "The hotplug watcher is running in another thread; stop it there first")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    const bool hooked = hotplugEnv != nullptr;
+    releaseHotplugWatcherLocked();
+    Napi::ThreadSafeFunction tsfn = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "hotplugWatcher", 0, 1);
+    // Watching must not keep the process alive on its own
+    tsfn.Unref(env);
+    
+    std::string error;
+    bool started = startHotplugWatcher([tsfn](const HotplugEvent& event) {
+        tsfn.NonBlockingCall([event](Napi::Env env, Napi::Function callback) {
+            callback.Call({hotplugEventToNapi(env, event)});
+        });
+    }, debounceMs, &error);
+    if (started) {
+        hotplugFunction = tsfn;
+        hotplugEnv = env;
+        // The watcher must not outlive its env: stop it when the env goes away
+        if (!hooked) napi_add_env_cleanup_hook(env, releaseHotplugWatcherOf, env);
+    } else {
+        tsfn.Release();
+        if (hooked) napi_remove_env_cleanup_hook(env, releaseHotplugWatcherOf, env);
+    }
+    
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("success", Napi::Boolean::New(env, started));
+    result.Set("debounce_ms", Napi::Number::New(env, debounceMs));
+    if (!started) result.Set("error", Napi::String::New(env, error));
+    return result;
+}
+
+Napi::Value StopHotplugWatcher(const Napi::CallbackInfo& info) {
+    napi_env env = info.Env();
+    std::lock_guard<std::mutex> lock(hotplugMutex);
+    // Only the owning env stops the watcher, and drops its cleanup hook
+    if (hotplugEnv == env) {
+        releaseHotplugWatcherLocked();
+        napi_remove_env_cleanup_hook(env, releaseHotplugWatcherOf, env);
+    }
+    return info.Env().Undefined();
+}
+
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
-    std::cout << "Initializing HIGH-PERFORMANCE Wipe Addon with NIST 800-88 Purge/Destroy" << std::endl;
+    logInfo("wipe") << "Initializing HIGH-PERFORMANCE Wipe Addon with NIST 800-88 Purge/Destroy";
     
     // Clear methods (existing)
     exports.Set("wipeFile", Napi::Function::New(env, WipeFile));
+    exports.Set("wipeAndVerify", Napi::Function::New(env, WipeAndVerify));
     exports.Set("testAddon", Napi::Function::New(env, TestAddon));
     exports.Set("getDeviceInfo", Napi::Function::New(env, GetDeviceInfo));
+    exports.Set("listDevices", Napi::Function::New(env, ListDevices));
+    exports.Set("startHotplugWatcher", Napi::Function::New(env, StartHotplugWatcher));
+    exports.Set("stopHotplugWatcher", Napi::Function::New(env, StopHotplugWatcher));
+    exports.Set("shredFile", Napi::Function::New(env, ShredFile));
+    exports.Set("shredTree", Napi::Function::New(env, ShredTree));
+    exports.Set("verifyWipe", Napi::Function::New(env, VerifyWipe));
+    exports.Set("checkWipeEvidence", Napi::Function::New(env, CheckWipeEvidence));
+    
+    // Device sessions (one open handle + cached probes per job)
+    exports.Set("openDeviceSession", Napi::Function::New(env, OpenDeviceSession));
+    exports.Set("closeDeviceSession", Napi::Function::New(env, CloseDeviceSession));
     
     // Purge methods (new)
     exports.Set("ataSecureErase", Napi::Function::New(env, ATASecureErase));
     exports.Set("nvmeSanitize", Napi::Function::New(env, NVMeSanitize));
     exports.Set("cryptoErase", Napi::Function::New(env, CryptoErase));
+    exports.Set("startSanitize", Napi::Function::New(env, StartSanitize));
+    exports.Set("getSanitizeOperations", Napi::Function::New(env, GetSanitizeOperations));
     
     // Destroy method (new)
     exports.Set("destroyDrive", Napi::Function::New(env, DestroyDrive));
+    exports.Set("quickInvalidate", Napi::Function::New(env, QuickInvalidate));
+    
+    // Diagnostics
+    exports.Set("getArenaStats", Napi::Function::New(env, GetArenaStats));
+    exports.Set("getJob", Napi::Function::New(env, GetJob));
+    exports.Set("cancelJob", Napi::Function::New(env, CancelJob));
+    exports.Set("getStats", Napi::Function::New(env, GetStats));
+    exports.Set("replayIoTrace", Napi::Function::New(env, ReplayIoTrace));
+    exports.Set("setWipeLimits", Napi::Function::New(env, SetWipeLimits));
+    exports.Set("getNumaStats", Napi::Function::New(env, GetNumaStats));
+    exports.Set("drainTelemetry", Napi::Function::New(env, DrainTelemetry));
+    exports.Set("startMetricsExporter", Napi::Function::New(env, StartMetricsExporter));
+    exports.Set("stopMetricsExporter", Napi::Function::New(env, StopMetricsExporter));
+    exports.Set("setDeviceCache", Napi::Function::New(env, SetDeviceCache));
+    exports.Set("getDeviceCache", Napi::Function::New(env, GetDeviceCache));
     
     return exports;
 }
@@ -0,0 +1,416 @@
+#include "deviceCache.h"
+#include "telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+namespace {
+
+const char* const CACHE_HEADER = "# wipe device cache v1";
+constexpr size_t RECORD_FIELDS = 16;
+
+struct Cache {
+    std::mutex mutex;
+    std::string path;
+    std::vector<DeviceRecord> records;
+    int64_t loadedMtime = -1;       // File mtime the records were read at; -1 = not loaded
+};
+
+// Never destroyed, like the other process-wide registries
+Cache& cache() {
+    static Cache* instance = new Cache();
+    return *instance;
+}
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t fileMtime(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<int64_t>(st.st_mtime) : -1;
+}
+
+// Fields are tab-separated, one record per line
+std::string field(const std::string& value) {
+    std::string clean = value;
+    std::replace_if(clean.begin(), clean.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+    return clean;
+}
+
+// The session's key as stored in the file
+struct Key {
+    std::string model;
+    std::string firmware;
+    std::string unit;
+
+    explicit Key(const DeviceSession& session) :
+        model(field(session.model)),
+        firmware(field(session.firmware)),
+        unit(field(session.wwn.empty() ? session.serial : session.wwn)) {}
+
+    bool sameModel(const DeviceRecord& r) const { return r.model == model && r.firmware == firmware; }
+    bool sameUnit(const DeviceRecord& r) const { return sameModel(r) && r.unit == unit; }
+};
+
+std::vector<std::string> splitTabs(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (size_t tab; (tab = line.find('\t', start)) != std::string::npos; start = tab + 1) {
+        fields.push_back(line.substr(start, tab - start));
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+}
+
+ProbeOutcome outcomeOf(const std::string& text) {
+    long value = std::strtol(text.c_str(), nullptr, 10);
+    return value == 1 ? ProbeOutcome::Supported : value == 2 ? ProbeOutcome::Unsupported : ProbeOutcome::Unknown;
+}
+
+DeviceRecord emptyRecord() {
+    DeviceRecord record = DeviceRecord();
+    record.deviceType = DeviceType::UNKNOWN;
+    record.ataSecurity = ProbeOutcome::Unknown;
+    record.nvmeIdentify = ProbeOutcome::Unknown;
+    return record;
+}
+
+bool parseRecord(const std::string& line, DeviceRecord& record) {
+    std::vector<std::string> f = splitTabs(line);
+    if (f.size() != RECORD_FIELDS) return false;
+    record = emptyRecord();
+    record.model = f[0];
+    record.firmware = f[1];
+    record.unit = f[2];
+    record.updated = std::strtoll(f[3].c_str(), nullptr, 10);
+    record.probed = std::strtoll(f[4].c_str(), nullptr, 10);
+    record.deviceType = static_cast<DeviceType>(std::strtol(f[5].c_str(), nullptr, 10));
+    record.ataSecurity = outcomeOf(f[6]);
+    record.ataEnhancedErase = f[7] == "1";
+    record.nvmeIdentify = outcomeOf(f[8]);
+    unsigned long sanicap = std::strtoul(f[9].c_str(), nullptr, 10);
+    record.nvmeCaps.queried = record.nvmeIdentify == ProbeOutcome::Supported;
+    record.nvmeCaps.cryptoSupported = (sanicap & 1) != 0;
+    record.nvmeCaps.blockSupported = (sanicap & 2) != 0;
+    record.nvmeCaps.overwriteSupported = (sanicap & 4) != 0;
+    record.unsupportedPurge = static_cast<uint32_t>(std::strtoul(f[10].c_str(), nullptr, 10));
+    record.stripes = static_cast<uint32_t>(std::strtoul(f[11].c_str(), nullptr, 10));
+    record.chunkSize = std::strtoull(f[12].c_str(), nullptr, 10);
+    record.bestMBps = std::strtod(f[13].c_str(), nullptr);
+    record.lastMBps = std::strtod(f[14].c_str(), nullptr);
+    record.jobs = static_cast<uint32_t>(std::strtoul(f[15].c_str(), nullptr, 10));
+    return !record.model.empty();
+}
+
+void writeRecord(std::ostream& out, const DeviceRecord& r) {
+    unsigned sanicap = (r.nvmeCaps.cryptoSupported ? 1 : 0) | (r.nvmeCaps.blockSupported ? 2 : 0) |
+                       (r.nvmeCaps.overwriteSupported ? 4 : 0);
+    out << field(r.model) << '\t' << field(r.firmware) << '\t' << field(r.unit) << '\t'
+        << r.updated << '\t' << r.probed << '\t' << static_cast<int>(r.deviceType) << '\t'
+        << static_cast<int>(r.ataSecurity) << '\t' << (r.ataEnhancedErase ? 1 : 0) << '\t'
+        << static_cast<int>(r.nvmeIdentify) << '\t' << sanicap << '\t' << r.unsupportedPurge << '\t'
+        << r.stripes << '\t' << r.chunkSize << '\t' << r.bestMBps << '\t' << r.lastMBps << '\t' << r.jobs << '\n';
+}
+
+// Re-read the file if it changed since it was loaded (another process, or
+// a first use). Caller holds the mutex.
+void refresh(Cache& c) {
+    int64_t mtime = fileMtime(c.path);
+    if (mtime == c.loadedMtime && c.loadedMtime != -1) return;
+    c.records.clear();
+    c.loadedMtime = mtime;
+    std::ifstream in(c.path);
+    std::string line;
+    if (!std::getline(in, line) || line != CACHE_HEADER) return;      // Missing, or another format
+    while (std::getline(in, line)) {
+        DeviceRecord record;
+        if (parseRecord(line, record)) c.records.push_back(std::move(record));
+    }
+}
+
+bool save(Cache& c, std::string* error) {
+    std::sort(c.records.begin(), c.records.end(),
+              [](const DeviceRecord& a, const DeviceRecord& b) { return a.updated > b.updated; });
+    if (c.records.size() > DEVICE_CACHE_MAX_RECORDS) c.records.resize(DEVICE_CACHE_MAX_RECORDS);
+
+    // Same directory, so the rename cannot cross filesystems
+    std::string temp = c.path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out << std::setprecision(6) << CACHE_HEADER << '\n';
+        for (const DeviceRecord& record : c.records) writeRecord(out, record);
+        if (!out || !out.flush()) {
+            if (error) *error = "Cannot write device cache " + temp;
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    bool renamed = MoveFileExA(temp.c_str(), c.path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = std::rename(temp.c_str(), c.path.c_str()) == 0;
+#endif
+    if (!renamed) {
+        if (error) *error = "Cannot replace device cache " + c.path;
+        std::remove(temp.c_str());
+        return false;
+    }
+    c.loadedMtime = fileMtime(c.path);
+    return true;
+}
+
+// The unit's own record, else the newest of its model and firmware attached
+// the same way, else the newest of its model and firmware at all. Caller
+// holds the mutex.
+const DeviceRecord* find(const Cache& c, const DeviceSession& session, bool* exact) {
+    const Key key(session);
+    const DeviceRecord* sibling = nullptr;
+    const DeviceRecord* otherTransport = nullptr;
+    for (const DeviceRecord& record : c.records) {
+        if (!key.sameModel(record)) continue;
+        if (key.sameUnit(record)) {
+            if (exact) *exact = !key.unit.empty();
+            return &record;
+        }
+        const DeviceRecord*& best = record.deviceType == session.deviceType ? sibling : otherTransport;
+        if (!best || record.updated > best->updated) best = &record;
+    }
+    if (exact) *exact = false;
+    return sibling ? sibling : otherTransport;
+}
+
+// Apply `change` to the unit's record (created if new) and write the file
+template <typename Change>
+void update(const DeviceSession& session, Change change) {
+    if (session.model.empty()) return;          // No identity to key on
+    Cache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (c.path.empty()) return;
+    refresh(c);
+
+    const Key key(session);
+    auto it = std::find_if(c.records.begin(), c.records.end(), [&](const DeviceRecord& r) { return key.sameUnit(r); });
+    if (it == c.records.end()) {
+        DeviceRecord record = emptyRecord();
+        record.model = key.model;
+        record.firmware = key.firmware;
+        record.unit = key.unit;
+        c.records.push_back(std::move(record));
+        it = c.records.end() - 1;
+    }
+    it->deviceType = session.deviceType;
+    it->updated = now();
+    change(*it);
+
+    std::string error;
+    if (!save(c, &error)) logWarn("cache") << error;
+}
+
+uint32_t purgeBit(PurgeMethod method) {
+    return 1u << static_cast<unsigned>(method);
+}
+
+}
+
+void setDeviceCachePath(const std::string& path) {
+    Cache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (path == c.path) return;
+    c.path = path;
+    c.records.clear();
+    c.loadedMtime = -1;
+    if (!path.empty()) logInfo("cache") << "Device capability cache: " << path;
+}
+
+std::string deviceCachePath() {
+    Cache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    return c.path;
+}
+
+bool lookupDevice(const DeviceSession& session, DeviceRecord& record, bool* exact) {
+    if (session.model.empty()) return false;
+    Cache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (c.path.empty()) return false;
+    refresh(c);
+    const DeviceRecord* found = find(c, session, exact);
+    if (!found) return false;
+
+    record = *found;
+    // A probe rejected through a USB bridge says nothing about the same model
+    // attached directly, or the other way round
+    if (now() - record.probed > DEVICE_CACHE_NEGATIVE_TTL || record.deviceType != session.deviceType) {
+        // Firmware updates and bridge swaps happen; ask again
+        if (record.ataSecurity == ProbeOutcome::Unsupported) record.ataSecurity = ProbeOutcome::Unknown;
+        if (record.nvmeIdentify == ProbeOutcome::Unsupported) record.nvmeIdentify = ProbeOutcome::Unknown;
+        record.unsupportedPurge = 0;
+    }
+    return true;
+}
+
+std::vector<DeviceRecord> deviceCacheRecords() {
+    Cache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    if (c.path.empty()) return {};
+    refresh(c);
+    std::vector<DeviceRecord> records = c.records;
+    std::sort(records.begin(), records.end(),
+              [](const DeviceRecord& a, const DeviceRecord& b) { return a.updated > b.updated; });
+    return records;
+}
+
+void recordAtaSecurity(const DeviceSession& session, const ATASecurityInfo& info) {
+    update(session, [&](DeviceRecord& r) {
+        r.ataSecurity = info.supported ? ProbeOutcome::Supported : ProbeOutcome::Unsupported;
+        r.ataEnhancedErase = info.enhancedEraseSupported;
+        if (!info.supported) r.probed = r.updated;
+    });
+}
+
+void recordNvmeIdentify(const DeviceSession& session, const NVMeSanitizeCaps& caps) {
+    update(session, [&](DeviceRecord& r) {
+        r.nvmeIdentify = caps.queried ? ProbeOutcome::Supported : ProbeOutcome::Unsupported;
+        r.nvmeCaps = caps;
+        if (!caps.queried) r.probed = r.updated;
+    });
+}
+
+bool purgeKnownUnsupported(const DeviceSession& session, PurgeMethod method) {
+    DeviceRecord record;
+    return lookupDevice(session, record) && (record.unsupportedPurge & purgeBit(method)) != 0;
+}
+
+void recordPurgeUnsupported(const DeviceSession& session, PurgeMethod method) {
+    update(session, [&](DeviceRecord& r) {
+        r.unsupportedPurge |= purgeBit(method);
+        r.probed = r.updated;
+    });
+}
+
+TuningPlan planTuning(const DeviceSession& session, unsigned requested, size_t defaultChunk) {
+    TuningPlan plan = {requested, defaultChunk, false};
+    DeviceRecord record;
+    if (!lookupDevice(session, record)) return plan;
+    if (requested == 0 && record.stripes > 0) {
+        plan.stripes = record.stripes;
+        plan.cached = true;
+    }
+    if (record.chunkSize > 0 && record.chunkSize < defaultChunk &&
+        record.chunkSize % session.logicalSectorSize == 0) {
+        plan.chunk = static_cast<size_t>(record.chunkSize);
+        plan.cached = true;
+    }
+    return plan;
+}
+
+void recordWipeTuning(const DeviceSession& session, unsigned stripes, size_t chunk, double mbps) {
+    if (mbps <= 0) return;
+    update(session, [&](DeviceRecord& r) {
+        r.lastMBps = mbps;
+        r.jobs++;
+        // Keep the fastest settings, unless the health monitor had to shrink
+        // the writes below what is cached: then the device cannot take them
+        if (mbps > r.bestMBps || r.stripes == 0 || (chunk > 0 && chunk < r.chunkSize)) {
+            r.bestMBps = mbps;
+            r.stripes = stripes;
+            r.chunkSize = chunk;
+        }
+    });
+}
+
+bool clearDeviceCache(std::string* error) {
+    Cache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.records.clear();
+    if (c.path.empty()) return true;
+    return save(c, error);
+}
+
+// Export for testing: record two units of one model and read them back
+#ifdef TEST_STANDALONE
+#include <iostream>
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "wipe_test_device_cache.tsv";
+    std::remove(path.c_str());
+    setDeviceCachePath(path);
+
+    DeviceSession a;
+    a.model = "Example SSD\t960GB";
+    a.firmware = "FW1.0";
+    a.serial = "SERIAL-A";
+    a.wwn = "eui.0001";
+    a.deviceType = DeviceType::SATA_SSD;
+    a.logicalSectorSize = 512;
+
+    ATASecurityInfo noSecurity = ATASecurityInfo();
+    recordAtaSecurity(a, noSecurity);
+    recordPurgeUnsupported(a, PurgeMethod::ATA_SECURE_ERASE);
+    recordWipeTuning(a, 4, 16 * 1024 * 1024, 480.5);
+    recordWipeTuning(a, 2, 16 * 1024 * 1024, 300);          // Slower: best settings kept
+    recordWipeTuning(a, 4, 4 * 1024 * 1024, 250);           // Health monitor shrank the writes
+
+    // A sibling unit of the same model and firmware inherits everything
+    DeviceSession b;
+    b.model = a.model;
+    b.firmware = a.firmware;
+    b.serial = "SERIAL-B";
+    b.deviceType = DeviceType::SATA_SSD;
+    b.logicalSectorSize = 512;
+
+    setDeviceCachePath("");
+    setDeviceCachePath(path);       // Forces a re-read from the file
+    DeviceRecord record;
+    bool exact = true;
+    bool ok = lookupDevice(b, record, &exact) && !exact;
+    ok = ok && record.ataSecurity == ProbeOutcome::Unsupported && record.jobs == 3 && record.stripes == 4 &&
+         record.chunkSize == 4 * 1024 * 1024 && record.lastMBps == 250;
+    ok = ok && purgeKnownUnsupported(b, PurgeMethod::ATA_SECURE_ERASE) &&
+         !purgeKnownUnsupported(b, PurgeMethod::CRYPTO_ERASE);
+
+    TuningPlan plan = planTuning(b, 0, 16 * 1024 * 1024);
+    ok = ok && plan.cached && plan.stripes == 4 && plan.chunk == 4 * 1024 * 1024;
+    plan = planTuning(b, 1, 1024 * 1024);
+    ok = ok && !plan.cached && plan.stripes == 1 && plan.chunk == 1024 * 1024;
+
+    // Behind a USB bridge the sibling's negative probe results do not apply
+    DeviceSession bridged;
+    bridged.model = a.model;
+    bridged.firmware = a.firmware;
+    bridged.serial = "SERIAL-C";
+    bridged.deviceType = DeviceType::USB;
+    bridged.logicalSectorSize = 512;
+    ok = ok && lookupDevice(bridged, record, &exact) && !exact && record.ataSecurity == ProbeOutcome::Unknown &&
+         record.stripes == 4 && !purgeKnownUnsupported(bridged, PurgeMethod::ATA_SECURE_ERASE);
+    recordPurgeUnsupported(bridged, PurgeMethod::ATA_SECURE_ERASE);
+    ok = ok && purgeKnownUnsupported(bridged, PurgeMethod::ATA_SECURE_ERASE) &&
+         purgeKnownUnsupported(b, PurgeMethod::ATA_SECURE_ERASE);
+
+    recordWipeTuning(b, 8, 16 * 1024 * 1024, 900);
+    ok = ok && lookupDevice(b, record, &exact) && exact && record.jobs == 1 && deviceCacheRecords().size() == 3;
+
+    DeviceSession other;
+    other.model = "Other";
+    ok = ok && !lookupDevice(other, record);
+
+    std::ifstream in(path);
+    std::cout << in.rdbuf();
+    ok = ok && clearDeviceCache(nullptr) && deviceCacheRecords().empty();
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "deviceSession.h"
+
+// Persistent capability and tuning cache.
+//
+// A station wiping hundreds of identical drives used to re-learn every one
+// of them: the security/sanitize IOCTLs were re-issued (including the ones a
+// USB bridge always rejects), and the writer started from default chunk sizes
+// and stream counts until the health monitor (healthMonitor.h) retuned it.
+// This cache remembers, per unit, what the probes found and how the last
+// wipes went, in one small text file.
+//
+// Records are keyed by model, firmware and unit id (WWN, else serial). A
+// lookup returns the unit's own record, else the most recently updated record
+// of the same model and firmware, preferring one attached the same way
+// (device type): capabilities and tuning carry over to every unit of a model,
+// and a sibling's throughput is a good first estimate. Negative results of a
+// sibling attached differently (a USB bridge rejects what a direct SATA or
+// NVMe link accepts) read back as Unknown.
+// Probes that found a capability unsupported are trusted for
+// DEVICE_CACHE_NEGATIVE_TTL seconds and then asked again; supported results
+// that are state rather than capability (ATA frozen/locked) are never cached.
+//
+// The file is shared by every job in the process and rewritten atomically
+// (temporary file + rename) after each update; it is re-read when another
+// process has changed it. Without setDeviceCachePath() the cache is off and
+// every call is a no-op.
+
+constexpr size_t DEVICE_CACHE_MAX_RECORDS = 4096;                  // Least recently updated are dropped
+constexpr int64_t DEVICE_CACHE_NEGATIVE_TTL = 30LL * 24 * 3600;
+
+enum class ProbeOutcome : uint8_t {
+    Unknown,
+    Supported,
+    Unsupported
+};
+
+struct DeviceRecord {
+    std::string model;
+    std::string firmware;
+    std::string unit;               // WWN, else serial
+    int64_t updated;                // Unix seconds
+    int64_t probed;                 // When the negative results below were found
+    DeviceType deviceType;
+
+    // Capabilities
+    ProbeOutcome ataSecurity;       // IDENTIFY DEVICE reports the security feature set
+    bool ataEnhancedErase;
+    ProbeOutcome nvmeIdentify;      // IDENTIFY CONTROLLER readable (false behind most USB bridges)
+    NVMeSanitizeCaps nvmeCaps;      // Valid when nvmeIdentify is Supported
+    uint32_t unsupportedPurge;      // Bit per PurgeMethod the device reported unsupported
+
+    // Tuning: the settings of the fastest wipe seen, and the last one's speed
+    uint32_t stripes;               // Concurrent write streams, 0 = unknown
+    uint64_t chunkSize;             // Largest write the device handled well, 0 = unknown
+    double bestMBps;
+    double lastMBps;
+    uint32_t jobs;                  // Wipes recorded
+};
+
+// Cache file; empty turns the cache off (the default)
+void setDeviceCachePath(const std::string& path);
+std::string deviceCachePath();
+
+// The session's record (see above). `exact` tells the unit's own record from
+// a sibling's. False when the cache is off, the session has no identity, or
+// nothing is known. Expired negative results read back as Unknown.
+bool lookupDevice(const DeviceSession& session, DeviceRecord& record, bool* exact = nullptr);
+
+// Every record, most recently updated first
+std::vector<DeviceRecord> deviceCacheRecords();
+
+// Capability probe results (DeviceSession::ataSecurity/nvmeSanitizeCaps)
+void recordAtaSecurity(const DeviceSession& session, const ATASecurityInfo& info);
+void recordNvmeIdentify(const DeviceSession& session, const NVMeSanitizeCaps& caps);
+
+// Purge routines: skip a method the model reported unsupported
+bool purgeKnownUnsupported(const DeviceSession& session, PurgeMethod method);
+void recordPurgeUnsupported(const DeviceSession& session, PurgeMethod method);
+
+// Writer settings for a new job: the cached stream count when the caller did
+// not ask for one (`requested` 0), and `defaultChunk` capped at the cached
+// chunk size
+struct TuningPlan {
+    unsigned stripes;               // 0 = let stripeCount() decide
+    size_t chunk;
+    bool cached;                    // Either value came from the cache
+};
+TuningPlan planTuning(const DeviceSession& session, unsigned requested, size_t defaultChunk);
+
+// A finished wipe: the settings it ran with (chunk = largest write the health
+// monitor still allowed at the end) and its average speed
+void recordWipeTuning(const DeviceSession& session, unsigned stripes, size_t chunk, double mbps);
+
+// Drop every record (e.g. after a firmware-independent behaviour change)
+bool clearDeviceCache(std::string* error);
@@ -0,0 +1,276 @@
+#include "deviceEnum.h"
+#include "deviceSession.h"
+#include <algorithm>
+#include <map>
+
+#ifdef __linux__
+    #include <climits>
+    #include <cstdlib>
+    #include <dirent.h>
+    #include <fstream>
+    #include <sstream>
+    #include <sys/stat.h>
+    #include <sys/statvfs.h>
+#endif
+
+#ifdef __linux__
+
+namespace {
+
+// Holders are followed this deep (partition -> LUKS -> LVM -> ...)
+constexpr int MAX_HOLDER_DEPTH = 4;
+
+// Mount points that make a disk the system disk
+const char* const SYSTEM_MOUNTS[] = {"/", "/boot", "/boot/efi", "/efi", "/usr", "/var"};
+
+std::string trimmed(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+std::string readLine(const std::string& file) {
+    std::ifstream in(file);
+    std::string value;
+    if (in.is_open()) std::getline(in, value);
+    return trimmed(value);
+}
+
+uint64_t readNumber(const std::string& file) {
+    return strtoull(readLine(file).c_str(), nullptr, 10);
+}
+
+bool exists(const std::string& p) {
+    struct stat st;
+    return stat(p.c_str(), &st) == 0;
+}
+
+std::string resolved(const std::string& p) {
+    char buffer[PATH_MAX];
+    return realpath(p.c_str(), buffer) ? std::string(buffer) : "";
+}
+
+std::vector<std::string> listDir(const std::string& dir) {
+    std::vector<std::string> names;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(d)) {
+            if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+        }
+        closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+// mountinfo escapes space, tab, newline and backslash as \ooo
+std::string unescapeMount(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        bool octal = s[i] == '\\' && i + 3 < s.size();
+        for (size_t j = 1; octal && j <= 3; j++) octal = s[i + j] >= '0' && s[i + j] <= '7';
+        if (octal) {
+            out += static_cast<char>((s[i + 1] - '0') * 64 + (s[i + 2] - '0') * 8 + (s[i + 3] - '0'));
+            i += 3;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+// "major:minor" -> mounts of that device, from one read of mountinfo and swaps
+std::map<std::string, std::vector<MountEntry>> readMounts() {
+    std::map<std::string, std::vector<MountEntry>> mounts;
+    std::ifstream info("/proc/self/mountinfo");
+    std::string line;
+    while (std::getline(info, line)) {
+        // id parent major:minor root mountpoint options [optional...] - fstype source superoptions
+        std::istringstream fields(line);
+        std::string id, parent, dev, root, mountPoint, field;
+        fields >> id >> parent >> dev >> root >> mountPoint;
+        while (fields >> field && field != "-") {}
+        MountEntry mount = MountEntry();
+        fields >> mount.fsType >> mount.source;
+        mount.path = unescapeMount(mountPoint);
+        mount.source = unescapeMount(mount.source);
+        if (!dev.empty() && dev.compare(0, 2, "0:") != 0) mounts[dev].push_back(mount);
+    }
+
+    std::ifstream swaps("/proc/swaps");
+    std::getline(swaps, line);      // Header
+    while (std::getline(swaps, line)) {
+        std::istringstream fields(line);
+        std::string file, type;
+        fields >> file >> type;
+        if (type != "partition") continue;
+        std::string node = resolved(unescapeMount(file));
+        std::string dev = readLine("/sys/class/block/" + node.substr(node.find_last_of('/') + 1) + "/dev");
+        if (dev.empty()) continue;
+        MountEntry swap = MountEntry();
+        swap.path = "[SWAP]";
+        swap.fsType = "swap";
+        swap.source = node;
+        mounts[dev].push_back(swap);
+    }
+    return mounts;
+}
+
+// KEY=value properties udev recorded for a block device ("E:" lines)
+std::map<std::string, std::string> readUdev(const std::string& dev) {
+    std::map<std::string, std::string> properties;
+    std::ifstream in("/run/udev/data/b" + dev);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 2, "E:") != 0) continue;
+        size_t eq = line.find('=');
+        if (eq != std::string::npos) properties[line.substr(2, eq - 2)] = line.substr(eq + 1);
+    }
+    return properties;
+}
+
+std::string transportOf(const std::string& name, const std::string& diskDir, DeviceType type) {
+    if (name.compare(0, 4, "nvme") == 0) return "nvme";
+    if (name.compare(0, 6, "mmcblk") == 0) return "mmc";
+    if (diskDir.find("/usb") != std::string::npos) return "usb";
+    if (diskDir.find("/virtio") != std::string::npos) return "virtio";
+    if (type == DeviceType::SATA_HDD || type == DeviceType::SATA_SSD) return "sata";
+    if (diskDir.find("/end_device-") != std::string::npos) return "sas";
+    return "scsi";
+}
+
+// Mounts of the block device in `dir` and, recursively, of its holders
+void collectMounts(const std::string& dir, const std::map<std::string, std::vector<MountEntry>>& mounts,
+                   std::vector<MountEntry>& out, int depth) {
+    auto it = mounts.find(readLine(dir + "/dev"));
+    if (it != mounts.end()) out.insert(out.end(), it->second.begin(), it->second.end());
+    if (depth >= MAX_HOLDER_DEPTH) return;
+    for (const std::string& holder : listDir(dir + "/holders")) {
+        collectMounts("/sys/class/block/" + holder, mounts, out, depth + 1);
+    }
+}
+
+bool probeDisk(const std::string& name, const std::map<std::string, std::vector<MountEntry>>& mounts,
+               BlockDeviceInfo& disk) {
+    const std::string sysDir = "/sys/block/" + name;
+    if (!exists(sysDir + "/device")) return false;          // loop, dm, md, zram, ram
+    disk.size = readNumber(sysDir + "/size") * 512;         // Always 512-byte units
+    if (disk.size == 0) return false;                       // Empty card reader, ejected media
+
+    const std::string diskDir = resolved(sysDir);
+    const std::string dev = readLine(sysDir + "/dev");
+    disk.name = name;
+    disk.path = "/dev/" + name;
+    disk.logicalSectorSize = static_cast<uint32_t>(readNumber(sysDir + "/queue/logical_block_size"));
+    disk.physicalSectorSize = static_cast<uint32_t>(readNumber(sysDir + "/queue/physical_block_size"));
+    disk.rotational = readLine(sysDir + "/queue/rotational") == "1";
+    disk.readOnly = readLine(sysDir + "/ro") == "1";
+    disk.deviceType = probeDeviceTypeSysfs(diskDir, disk.rotational);
+    disk.transport = transportOf(name, diskDir, disk.deviceType);
+    disk.isCard = disk.transport == "mmc";
+    disk.removable = readLine(sysDir + "/removable") == "1" || disk.transport == "usb" || disk.isCard;
+
+    disk.vendor = readLine(sysDir + "/device/vendor");
+    disk.model = readLine(sysDir + "/device/model");
+    disk.serial = readLine(sysDir + "/device/serial");
+    if (disk.serial.empty()) {
+        // SCSI/SATA expose the unit serial through VPD page 0x80 (binary header + ASCII)
+        std::string vpd = readLine(sysDir + "/device/vpd_pg80");
+        if (vpd.size() > 4) disk.serial = trimmed(vpd.substr(4));
+    }
+    disk.firmware = readLine(sysDir + "/device/firmware_rev");
+    if (disk.firmware.empty()) disk.firmware = readLine(sysDir + "/device/rev");
+    disk.wwn = readLine(sysDir + "/wwid");
+    if (disk.wwn.empty()) disk.wwn = readLine(sysDir + "/device/wwid");
+
+    // USB bridges hide the serial from SCSI; udev reads it from the USB descriptor
+    if (disk.serial.empty() || disk.wwn.empty() || disk.model.empty()) {
+        std::map<std::string, std::string> udev = readUdev(dev);
+        if (disk.serial.empty()) disk.serial = udev["ID_SERIAL_SHORT"];
+        if (disk.wwn.empty()) disk.wwn = udev["ID_WWN"];
+        if (disk.model.empty()) disk.model = udev["ID_MODEL"];
+    }
+
+    collectMounts(sysDir, mounts, disk.mountpoints, 0);
+    for (const std::string& entry : listDir(sysDir)) {
+        if (!exists(sysDir + "/" + entry + "/partition")) continue;
+        disk.partitions.push_back("/dev/" + entry);
+        collectMounts(sysDir + "/" + entry, mounts, disk.mountpoints, 1);
+    }
+
+    disk.isSystem = false;
+    for (MountEntry& mount : disk.mountpoints) {
+        bool system = mount.path == "[SWAP]";
+        for (const char* systemMount : SYSTEM_MOUNTS) system = system || mount.path == systemMount;
+        disk.isSystem = disk.isSystem || system;
+
+        struct statvfs fs;
+        if (mount.path != "[SWAP]" && statvfs(mount.path.c_str(), &fs) == 0) {
+            mount.total = static_cast<uint64_t>(fs.f_blocks) * fs.f_frsize;
+            mount.free = static_cast<uint64_t>(fs.f_bfree) * fs.f_frsize;
+            mount.available = static_cast<uint64_t>(fs.f_bavail) * fs.f_frsize;
+        }
+    }
+    return true;
+}
+
+}
+
+bool listBlockDevices(std::vector<BlockDeviceInfo>& devices) {
+    devices.clear();
+    std::map<std::string, std::vector<MountEntry>> mounts = readMounts();
+    for (const std::string& name : listDir("/sys/block")) {
+        BlockDeviceInfo disk = BlockDeviceInfo();
+        if (probeDisk(name, mounts, disk)) devices.push_back(std::move(disk));
+    }
+    return true;
+}
+
+bool probeBlockDevice(const std::string& name, BlockDeviceInfo& device) {
+    device = BlockDeviceInfo();
+    return name.find('/') == std::string::npos && probeDisk(name, readMounts(), device);
+}
+
+#else
+
+bool listBlockDevices(std::vector<BlockDeviceInfo>& devices) {
+    devices.clear();
+    return false;
+}
+
+bool probeBlockDevice(const std::string&, BlockDeviceInfo& device) {
+    device = BlockDeviceInfo();
+    return false;
+}
+
+#endif
+
+// Export for testing: list devices with timing
+#ifdef TEST_STANDALONE
+#include <chrono>
+#include <iostream>
+
+int main() {
+    std::vector<BlockDeviceInfo> devices;
+    auto start = std::chrono::steady_clock::now();
+    bool supported = listBlockDevices(devices);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!supported) {
+        std::cout << "Not supported on this platform" << std::endl;
+        return 1;
+    }
+    for (const BlockDeviceInfo& d : devices) {
+        std::cout << d.path << "  " << (d.size >> 20) << " MB  " << d.transport << "  " << deviceTypeToString(d.deviceType)
+                  << "  model '" << d.model << "' serial '" << d.serial << "' wwn '" << d.wwn << "'"
+                  << (d.rotational ? " rotational" : "") << (d.removable ? " removable" : "")
+                  << (d.readOnly ? " ro" : "") << (d.isSystem ? " SYSTEM" : "") << std::endl;
+        for (const std::string& p : d.partitions) std::cout << "    partition " << p << std::endl;
+        for (const MountEntry& m : d.mountpoints) {
+            std::cout << "    " << m.path << " (" << m.fsType << " from " << m.source << ", "
+                      << (m.available >> 20) << " of " << (m.total >> 20) << " MB free)" << std::endl;
+        }
+    }
+    std::cout << devices.size() << " devices in " << ms << " ms" << std::endl;
+    return 0;
+}
+#endif
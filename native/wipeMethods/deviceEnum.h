@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <vector>
+#include "purge/purgeCommon.h"
+
+// Block device enumeration without opening any device.
+//
+// drivelist spawns lsblk/udevadm (or PowerShell) and diskusage then stats
+// every mountpoint on the calling thread; with many disks attached that takes
+// seconds. On Linux everything needed is already in sysfs and one read of
+// /proc/self/mountinfo (plus /proc/swaps), so a full scan costs a few hundred
+// small file reads and finishes in milliseconds. Only whole physical disks
+// are listed (entries with a sysfs device/ link: no loop, dm, md or zram);
+// mounts of their partitions and of the dm/md devices stacked on them count
+// as the disk's mountpoints, so a disk holding an LVM root is a system disk.
+//
+// Elsewhere listBlockDevices() returns false and callers keep using
+// drivelist (electron/deviceManager.js).
+
+struct MountEntry {
+    std::string path;           // "[SWAP]" for an active swap area
+    std::string fsType;
+    std::string source;         // Device node the filesystem was mounted from
+    uint64_t total;             // statvfs sizes in bytes; 0 when not stat-able
+    uint64_t free;
+    uint64_t available;         // Free to unprivileged users
+};
+
+struct BlockDeviceInfo {
+    std::string name;           // "sda", "nvme0n1"
+    std::string path;           // "/dev/sda"
+    std::string vendor;
+    std::string model;
+    std::string serial;
+    std::string firmware;
+    std::string wwn;            // World wide name / EUI, empty if not reported
+    std::string transport;      // "nvme", "sata", "sas", "scsi", "usb", "mmc", "virtio"
+    DeviceType deviceType;
+    uint64_t size;
+    uint32_t logicalSectorSize;
+    uint32_t physicalSectorSize;
+    bool rotational;
+    bool removable;             // Removable media or hot-pluggable bus (USB, MMC)
+    bool readOnly;
+    bool isCard;                // SD/MMC card
+    bool isSystem;              // Holds /, /boot, /usr, /var or active swap
+    std::vector<std::string> partitions;    // "/dev/sda1", ...
+    std::vector<MountEntry> mountpoints;
+};
+
+// Every physical block device, sorted by name. False where enumeration is not
+// implemented (non-Linux).
+bool listBlockDevices(std::vector<BlockDeviceInfo>& devices);
+
+// One disk by kernel name ("sdb"); false when it is not a physical disk with
+// media (or not on Linux)
+bool probeBlockDevice(const std::string& name, BlockDeviceInfo& device);
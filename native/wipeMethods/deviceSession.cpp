@@ -0,0 +1,777 @@
+#include "deviceSession.h"
+#include "deviceCache.h"
+#include "numaPlacement.h"
+#include "ioStats.h"
+#include "telemetry.h"
+#include <string>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+    #include <winioctl.h>
+    #include <ntddscsi.h>
+    #include <nvme.h>
+#else
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+    #include <cerrno>
+    #include <climits>
+    #include <cstdlib>
+    #include <fstream>
+    #ifdef __linux__
+        #include <linux/fs.h>
+        #include <linux/hdreg.h>
+        #include <linux/nvme_ioctl.h>
+        #include <linux/blkzoned.h>
+    #endif
+#endif
+
+// ATA IDENTIFY DEVICE
+#define ATA_CMD_IDENTIFY_DEVICE       0xEC
+#define ATA_ID_ERASE_TIME             89   // Words 89/90: normal/enhanced erase time
+#define ATA_ID_ENHANCED_ERASE_TIME    90
+#define ATA_ID_SECURITY_STATUS        128  // Word 128: Security status
+
+// Security status bits
+#define ATA_SECURITY_SUPPORTED        0x0001
+#define ATA_SECURITY_ENABLED          0x0002
+#define ATA_SECURITY_LOCKED           0x0004
+#define ATA_SECURITY_FROZEN           0x0008
+#define ATA_SECURITY_ENHANCED_ERASE   0x0020
+
+// NVMe IDENTIFY CONTROLLER
+#define NVME_ADMIN_CMD_IDENTIFY       0x06
+#define NVME_IDENTIFY_CNS_CTRL        0x01
+#define NVME_ID_CTRL_SANICAP_OFFSET   328   // Bytes 331:328
+#define NVME_ID_CTRL_SIZE             4096
+
+// SANICAP bits
+#define NVME_SANICAP_CRYPTO_ERASE     0x00000001
+#define NVME_SANICAP_BLOCK_ERASE      0x00000002
+#define NVME_SANICAP_OVERWRITE        0x00000004
+
+// Erase time words count 2-minute units: bits 7:0, or bits 14:0 when bit 15
+// flags the extended format
+static uint16_t eraseTimeMinutes(uint16_t word) {
+    return static_cast<uint16_t>(((word & 0x8000) ? (word & 0x7FFF) : (word & 0x00FF)) * 2);
+}
+
+static ATASecurityInfo decodeATASecurity(const uint16_t* identify) {
+    ATASecurityInfo info;
+    uint16_t word = identify ? identify[ATA_ID_SECURITY_STATUS] : 0;
+    info.securityWord = word;
+    info.eraseMinutes = identify ? eraseTimeMinutes(identify[ATA_ID_ERASE_TIME]) : 0;
+    info.enhancedEraseMinutes = identify ? eraseTimeMinutes(identify[ATA_ID_ENHANCED_ERASE_TIME]) : 0;
+    info.supported = (word & ATA_SECURITY_SUPPORTED) != 0;
+    info.enabled = (word & ATA_SECURITY_ENABLED) != 0;
+    info.locked = (word & ATA_SECURITY_LOCKED) != 0;
+    info.frozen = (word & ATA_SECURITY_FROZEN) != 0;
+    info.enhancedEraseSupported = (word & ATA_SECURITY_ENHANCED_ERASE) != 0;
+    return info;
+}
+
+static NVMeSanitizeCaps decodeSanicap(const uint8_t* identifyController) {
+    uint32_t sanicap = 0;
+    memcpy(&sanicap, identifyController + NVME_ID_CTRL_SANICAP_OFFSET, sizeof(sanicap));
+
+    NVMeSanitizeCaps caps;
+    caps.queried = true;
+    caps.cryptoSupported = (sanicap & NVME_SANICAP_CRYPTO_ERASE) != 0;
+    caps.blockSupported = (sanicap & NVME_SANICAP_BLOCK_ERASE) != 0;
+    caps.overwriteSupported = (sanicap & NVME_SANICAP_OVERWRITE) != 0;
+    return caps;
+}
+
+// Some controllers (and USB/NVMe bridges) refuse IDENTIFY pass-through.
+// Most NVMe SSDs support crypto erase at minimum, so keep the old assumption.
+static NVMeSanitizeCaps assumedSanitizeCaps() {
+    NVMeSanitizeCaps caps;
+    caps.queried = false;
+    caps.cryptoSupported = true;
+    caps.blockSupported = true;
+    caps.overwriteSupported = true;
+    return caps;
+}
+
+static std::string trimCopy(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+static bool productIndicatesEncryption(const std::string& product) {
+    return product.find("SED") != std::string::npos ||
+           product.find("Opal") != std::string::npos ||
+           product.find("TCG") != std::string::npos ||
+           product.find("Encrypted") != std::string::npos;
+}
+
+DeviceSession::DeviceSession() :
+#ifdef _WIN32
+    handle(INVALID_HANDLE_VALUE),
+#else
+    fd(-1),
+#endif
+    writable(false),
+    openError(0),
+    size(0),
+    logicalSectorSize(512),
+    physicalSectorSize(512),
+    isBlockDevice(false),
+    rotational(true),
+    numaNode(-1),
+    zoned(ZonedModel::None),
+    zoneSize(0),
+    zoneCount(0),
+    maxOpenZones(0),
+    maxActiveZones(0),
+    deviceType(DeviceType::UNKNOWN),
+    hardwareEncryption(false),
+    probeCount(0),
+    ioError(0),
+    ataSecurityProbed(false),
+    nvmeCapsProbed(false),
+    ataSecurityInfo(decodeATASecurity(nullptr)),
+    nvmeCaps(assumedSanitizeCaps()) {}
+
+DeviceSession::~DeviceSession() {
+    close();
+}
+
+bool DeviceSession::isOpen() const {
+#ifdef _WIN32
+    return handle != INVALID_HANDLE_VALUE;
+#else
+    return fd != -1;
+#endif
+}
+
+void DeviceSession::close() {
+#ifdef _WIN32
+    if (handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd != -1) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+// Every device I/O is timed into the current job's histograms (ioStats.h)
+bool DeviceSession::readAt(uint64_t offset, uint8_t* data, size_t len) {
+    IoTimer timer(offset, len);
+    bool ok = readRaw(offset, data, len);
+    timer.read(ok, ok ? 0 : ioError);
+    return ok;
+}
+
+bool DeviceSession::writeAt(uint64_t offset, const uint8_t* data, size_t len) {
+    IoTimer timer(offset, len);
+    bool ok = writeRaw(offset, data, len);
+    timer.write(ok, ok ? 0 : ioError);
+    return ok;
+}
+
+bool DeviceSession::readRaw(uint64_t offset, uint8_t* data, size_t len) {
+#ifdef _WIN32
+    // The handle is synchronous; OVERLAPPED only carries the offset
+    OVERLAPPED ov = {};
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD bytesRead = 0;
+    if (!ReadFile(handle, data, static_cast<DWORD>(len), &bytesRead, &ov)) {
+        ioError = GetLastError();
+        return false;
+    }
+    if (bytesRead != len) {
+        ioError = ERROR_HANDLE_EOF;
+        return false;
+    }
+#else
+    size_t done = 0;
+    while (done < len) {
+        ssize_t result = pread(fd, data + done, len - done, static_cast<off_t>(offset + done));
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            ioError = result < 0 ? errno : EIO;
+            return false;
+        }
+        done += static_cast<size_t>(result);
+    }
+#endif
+    return true;
+}
+
+bool DeviceSession::writeRaw(uint64_t offset, const uint8_t* data, size_t len) {
+#ifdef _WIN32
+    OVERLAPPED ov = {};
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD bytesWritten = 0;
+    if (!WriteFile(handle, data, static_cast<DWORD>(len), &bytesWritten, &ov)) {
+        ioError = GetLastError();
+        return false;
+    }
+    if (bytesWritten != len) {
+        ioError = ERROR_WRITE_FAULT;
+        return false;
+    }
+#else
+    size_t done = 0;
+    while (done < len) {
+        ssize_t result = pwrite(fd, data + done, len - done, static_cast<off_t>(offset + done));
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            ioError = result < 0 ? errno : EIO;
+            return false;
+        }
+        done += static_cast<size_t>(result);
+    }
+#endif
+    return true;
+}
+
+bool isMediaError(uint32_t error) {
+#ifdef _WIN32
+    switch (error) {
+        case ERROR_CRC:
+        case ERROR_SEEK:
+        case ERROR_SECTOR_NOT_FOUND:
+        case ERROR_WRITE_FAULT:
+        case ERROR_IO_DEVICE:
+        case ERROR_DEVICE_HARDWARE_ERROR:
+            return true;
+        default:
+            return false;
+    }
+#else
+    // EIO: generic I/O error; ENODATA: medium error; EILSEQ: protection
+    // information mismatch; EREMOTEIO: target (drive) reported failure
+    return error == EIO || error == ENODATA || error == EILSEQ || error == EREMOTEIO;
+#endif
+}
+
+#ifdef _WIN32
+void dismountVolumes(DeviceSession& session) {
+    const std::string& path = session.path;
+    // Step 1: Extract drive number from path (e.g., "\\.\PhysicalDrive1" -> 1)
+    int driveNumber = -1;
+    if (path.find("PhysicalDrive") != std::string::npos) {
+        size_t pos = path.find("PhysicalDrive");
+        driveNumber = std::stoi(path.substr(pos + 13));
+    }
+    
+    // Step 2: Enumerate and dismount all volumes on this physical drive
+    if (driveNumber >= 0) {
+        logInfo("session") << "Dismounting volumes on drive " << driveNumber << "...";
+        
+        // Try common drive letters (C: through Z:)
+        for (char letter = 'A'; letter <= 'Z'; letter++) {
+            std::string volumePath = std::string("\\\\.\\") + letter + ":";
+            
+            HANDLE hVolume = CreateFileA(
+                volumePath.c_str(),
+                GENERIC_READ | GENERIC_WRITE,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                NULL,
+                OPEN_EXISTING,
+                0,
+                NULL
+            );
+            
+            if (hVolume == INVALID_HANDLE_VALUE) {
+                continue; // Volume doesn't exist
+            }
+            
+            // Check if this volume is on our target drive
+            VOLUME_DISK_EXTENTS diskExtents;
+            DWORD bytesReturned;
+            if (DeviceIoControl(hVolume, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS,
+                               NULL, 0, &diskExtents, sizeof(diskExtents),
+                               &bytesReturned, NULL)) {
+                
+                if (diskExtents.NumberOfDiskExtents > 0 &&
+                    diskExtents.Extents[0].DiskNumber == (DWORD)driveNumber) {
+                    
+                    logInfo("session") << "  Found volume " << letter << ": on target drive";
+                    
+                    // Lock the volume
+                    if (DeviceIoControl(hVolume, FSCTL_LOCK_VOLUME, NULL, 0, NULL, 0, &bytesReturned, NULL)) {
+                        logInfo("session") << "    Locked volume " << letter << ":";
+                        
+                        // Dismount the volume
+                        if (DeviceIoControl(hVolume, FSCTL_DISMOUNT_VOLUME, NULL, 0, NULL, 0, &bytesReturned, NULL)) {
+                            logInfo("session") << "    Dismounted volume " << letter << ":";
+                        } else {
+                            logWarn("session") << "    Could not dismount " << letter << ": (error " << GetLastError() << ")";
+                        }
+                    } else {
+                        logWarn("session") << "    Could not lock " << letter << ": (error " << GetLastError() << ")";
+                    }
+                }
+            }
+            
+            CloseHandle(hVolume);
+        }
+    }
+}
+#else
+// Linux lets root write under a mounted filesystem; nothing to release
+void dismountVolumes(DeviceSession&) {}
+#endif
+
+#ifdef _WIN32
+
+// Bus type + seek penalty -> DeviceType
+static DeviceType probeDeviceType(HANDLE hDevice, bool& rotational, uint32_t& probeCount) {
+    DeviceType result = DeviceType::UNKNOWN;
+
+    STORAGE_PROPERTY_QUERY query;
+    ZeroMemory(&query, sizeof(query));
+    query.PropertyId = StorageAdapterProperty;
+    query.QueryType = PropertyStandardQuery;
+
+    BYTE adapterBuffer[1024];
+    DWORD bytesReturned = 0;
+
+    probeCount++;
+    if (DeviceIoControl(hDevice,
+                        IOCTL_STORAGE_QUERY_PROPERTY,
+                        &query,
+                        sizeof(query),
+                        adapterBuffer,
+                        sizeof(adapterBuffer),
+                        &bytesReturned,
+                        NULL)) {
+        STORAGE_ADAPTER_DESCRIPTOR* adapter = (STORAGE_ADAPTER_DESCRIPTOR*)adapterBuffer;
+
+        switch (adapter->BusType) {
+            case BusTypeUsb:
+                result = DeviceType::USB;
+                break;
+            case BusTypeNvme:
+                result = DeviceType::NVME;
+                break;
+            case BusTypeAta:
+            case BusTypeSata:
+            case BusTypeAtapi:
+                result = DeviceType::SATA_HDD;  // Refined below
+                break;
+            case BusTypeScsi:
+            case BusTypeSas:
+                result = DeviceType::SCSI;
+                break;
+            default:
+                result = DeviceType::UNKNOWN;
+                break;
+        }
+    }
+
+    // Seek penalty tells SSD from HDD (and is the rotational flag for everything else)
+    ZeroMemory(&query, sizeof(query));
+    query.PropertyId = StorageDeviceSeekPenaltyProperty;
+    query.QueryType = PropertyStandardQuery;
+
+    DEVICE_SEEK_PENALTY_DESCRIPTOR seekPenalty;
+    probeCount++;
+    if (DeviceIoControl(hDevice,
+                        IOCTL_STORAGE_QUERY_PROPERTY,
+                        &query,
+                        sizeof(query),
+                        &seekPenalty,
+                        sizeof(seekPenalty),
+                        &bytesReturned,
+                        NULL)) {
+        rotational = seekPenalty.IncursSeekPenalty != FALSE;
+        if (result == DeviceType::SATA_HDD && !rotational) {
+            result = DeviceType::SATA_SSD;
+        }
+    } else if (result == DeviceType::NVME) {
+        rotational = false;
+    }
+
+    return result;
+}
+
+static std::string descriptorString(const BYTE* buffer, DWORD offset, DWORD length) {
+    if (offset == 0 || offset >= length) return "";
+    return trimCopy(std::string((const char*)(buffer + offset), strnlen((const char*)(buffer + offset), length - offset)));
+}
+
+static void probeIdentity(DeviceSession& session) {
+    STORAGE_PROPERTY_QUERY query;
+    ZeroMemory(&query, sizeof(query));
+    query.PropertyId = StorageDeviceProperty;
+    query.QueryType = PropertyStandardQuery;
+
+    BYTE buffer[4096];
+    DWORD bytesReturned = 0;
+
+    session.probeCount++;
+    if (DeviceIoControl(session.handle,
+                        IOCTL_STORAGE_QUERY_PROPERTY,
+                        &query,
+                        sizeof(query),
+                        buffer,
+                        sizeof(buffer),
+                        &bytesReturned,
+                        NULL)) {
+        STORAGE_DEVICE_DESCRIPTOR* descriptor = (STORAGE_DEVICE_DESCRIPTOR*)buffer;
+
+        std::string vendor = descriptorString(buffer, descriptor->VendorIdOffset, bytesReturned);
+        std::string product = descriptorString(buffer, descriptor->ProductIdOffset, bytesReturned);
+        session.model = vendor.empty() ? product : trimCopy(vendor + " " + product);
+        session.serial = descriptorString(buffer, descriptor->SerialNumberOffset, bytesReturned);
+        session.firmware = descriptorString(buffer, descriptor->ProductRevisionOffset, bytesReturned);
+        session.hardwareEncryption = productIndicatesEncryption(product);
+    }
+}
+
+static void probeGeometry(DeviceSession& session) {
+    DWORD bytesReturned = 0;
+
+    GET_LENGTH_INFORMATION lengthInfo;
+    session.probeCount++;
+    if (DeviceIoControl(session.handle, IOCTL_DISK_GET_LENGTH_INFO, NULL, 0,
+                        &lengthInfo, sizeof(lengthInfo), &bytesReturned, NULL)) {
+        session.size = static_cast<uint64_t>(lengthInfo.Length.QuadPart);
+        session.isBlockDevice = true;
+    } else {
+        // Regular file target
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(session.handle, &fileSize)) {
+            session.size = static_cast<uint64_t>(fileSize.QuadPart);
+        }
+        return;
+    }
+
+    STORAGE_PROPERTY_QUERY query;
+    ZeroMemory(&query, sizeof(query));
+    query.PropertyId = StorageAccessAlignmentProperty;
+    query.QueryType = PropertyStandardQuery;
+
+    STORAGE_ACCESS_ALIGNMENT_DESCRIPTOR alignment;
+    ZeroMemory(&alignment, sizeof(alignment));
+    session.probeCount++;
+    if (DeviceIoControl(session.handle, IOCTL_STORAGE_QUERY_PROPERTY,
+                        &query, sizeof(query), &alignment, sizeof(alignment),
+                        &bytesReturned, NULL)) {
+        if (alignment.BytesPerLogicalSector) session.logicalSectorSize = alignment.BytesPerLogicalSector;
+        if (alignment.BytesPerPhysicalSector) session.physicalSectorSize = alignment.BytesPerPhysicalSector;
+    }
+}
+
+static ATASecurityInfo probeATASecurity(DeviceSession& session) {
+    // ATA IDENTIFY DEVICE (read-only query)
+    struct {
+        ATA_PASS_THROUGH_EX apt;
+        BYTE buffer[512];
+    } identifyData;
+
+    ZeroMemory(&identifyData, sizeof(identifyData));
+    identifyData.apt.Length = sizeof(ATA_PASS_THROUGH_EX);
+    identifyData.apt.AtaFlags = ATA_FLAGS_DATA_IN;
+    identifyData.apt.DataTransferLength = 512;
+    identifyData.apt.TimeOutValue = 10;
+    identifyData.apt.DataBufferOffset = sizeof(ATA_PASS_THROUGH_EX);
+    identifyData.apt.CurrentTaskFile[6] = ATA_CMD_IDENTIFY_DEVICE;
+
+    DWORD bytesReturned = 0;
+    session.probeCount++;
+    if (DeviceIoControl(session.handle,
+                        IOCTL_ATA_PASS_THROUGH,
+                        &identifyData,
+                        sizeof(identifyData),
+                        &identifyData,
+                        sizeof(identifyData),
+                        &bytesReturned,
+                        NULL)) {
+        uint16_t* identifyWords = (uint16_t*)identifyData.buffer;
+        return decodeATASecurity(identifyWords);
+    }
+
+    logError("session") << "ATA IDENTIFY failed: " << GetLastError();
+    return decodeATASecurity(nullptr);
+}
+
+static NVMeSanitizeCaps probeNVMeSanitizeCaps(DeviceSession& session) {
+    const DWORD bufferLength = FIELD_OFFSET(STORAGE_PROPERTY_QUERY, AdditionalParameters) +
+                               sizeof(STORAGE_PROTOCOL_SPECIFIC_DATA) + NVME_ID_CTRL_SIZE;
+    std::vector<BYTE> buffer(bufferLength, 0);
+
+    STORAGE_PROPERTY_QUERY* query = (STORAGE_PROPERTY_QUERY*)buffer.data();
+    STORAGE_PROTOCOL_SPECIFIC_DATA* protocolData = (STORAGE_PROTOCOL_SPECIFIC_DATA*)query->AdditionalParameters;
+
+    query->PropertyId = StorageAdapterProtocolSpecificProperty;
+    query->QueryType = PropertyStandardQuery;
+    protocolData->ProtocolType = ProtocolTypeNvme;
+    protocolData->DataType = NVMeDataTypeIdentify;
+    protocolData->ProtocolDataRequestValue = NVME_IDENTIFY_CNS_CTRL;
+    protocolData->ProtocolDataRequestSubValue = 0;
+    protocolData->ProtocolDataOffset = sizeof(STORAGE_PROTOCOL_SPECIFIC_DATA);
+    protocolData->ProtocolDataLength = NVME_ID_CTRL_SIZE;
+
+    DWORD bytesReturned = 0;
+    session.probeCount++;
+    if (!DeviceIoControl(session.handle, IOCTL_STORAGE_QUERY_PROPERTY,
+                         buffer.data(), bufferLength, buffer.data(), bufferLength,
+                         &bytesReturned, NULL)) {
+        return assumedSanitizeCaps();
+    }
+
+    STORAGE_PROTOCOL_DATA_DESCRIPTOR* descriptor = (STORAGE_PROTOCOL_DATA_DESCRIPTOR*)buffer.data();
+    protocolData = &descriptor->ProtocolSpecificData;
+    if (protocolData->ProtocolDataOffset < sizeof(STORAGE_PROTOCOL_SPECIFIC_DATA) ||
+        protocolData->ProtocolDataLength < NVME_ID_CTRL_SIZE) {
+        return assumedSanitizeCaps();
+    }
+
+    const uint8_t* identify = (const uint8_t*)protocolData + protocolData->ProtocolDataOffset;
+    return decodeSanicap(identify);
+}
+
+std::shared_ptr<DeviceSession> openDeviceSession(const std::string& path) {
+    std::shared_ptr<DeviceSession> session = std::make_shared<DeviceSession>();
+    session->path = path;
+
+    // Direct, write-through access: the same handle serves IOCTL probes,
+    // pass-through commands and unbuffered overwrite passes.
+    session->handle = CreateFileA(
+        path.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL,
+        OPEN_EXISTING,
+        FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH,
+        NULL
+    );
+    session->probeCount++;
+
+    if (session->handle != INVALID_HANDLE_VALUE) {
+        session->writable = true;
+    } else {
+        // Not elevated: a read-only handle is still enough for dry-run probes
+        session->openError = GetLastError();
+        session->handle = CreateFileA(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL,
+            OPEN_EXISTING,
+            0,
+            NULL
+        );
+        session->probeCount++;
+        if (session->handle == INVALID_HANDLE_VALUE) {
+            return session;
+        }
+    }
+
+    probeGeometry(*session);
+    if (session->isBlockDevice) {
+        session->deviceType = probeDeviceType(session->handle, session->rotational, session->probeCount);
+        probeIdentity(*session);
+    }
+    return session;
+}
+
+#else
+
+#ifdef __linux__
+static std::string readSysfs(const std::string& file) {
+    std::ifstream in(file);
+    if (!in.is_open()) return "";
+    std::string value;
+    std::getline(in, value);
+    return trimCopy(value);
+}
+
+static bool pathExists(const std::string& p) {
+    struct stat st;
+    return stat(p.c_str(), &st) == 0;
+}
+
+// /sys/class/block/<name> of the whole disk (partitions resolve to their parent)
+static std::string sysfsDiskDir(const std::string& devicePath) {
+    char resolved[PATH_MAX];
+    if (!realpath(devicePath.c_str(), resolved)) return "";
+
+    std::string name(resolved);
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos) name = name.substr(slash + 1);
+
+    std::string classDir = "/sys/class/block/" + name;
+    if (!realpath(classDir.c_str(), resolved)) return "";
+
+    std::string dir(resolved);
+    if (pathExists(dir + "/partition")) {
+        dir = dir.substr(0, dir.find_last_of('/'));
+    }
+    return dir;
+}
+
+DeviceType probeDeviceTypeSysfs(const std::string& diskDir, bool rotational) {
+    std::string name = diskDir.substr(diskDir.find_last_of('/') + 1);
+
+    if (diskDir.find("/usb") != std::string::npos) return DeviceType::USB;
+    if (name.compare(0, 4, "nvme") == 0) return DeviceType::NVME;
+    if (!pathExists(diskDir + "/device")) return DeviceType::UNKNOWN;  // loop, dm, md, zram...
+
+    if (readSysfs(diskDir + "/device/vendor") == "ATA") {
+        return rotational ? DeviceType::SATA_HDD : DeviceType::SATA_SSD;
+    }
+    return DeviceType::SCSI;
+}
+
+static void probeIdentitySysfs(DeviceSession& session, const std::string& diskDir) {
+    session.model = readSysfs(diskDir + "/device/model");
+    session.serial = readSysfs(diskDir + "/device/serial");
+    if (session.serial.empty()) {
+        // SCSI/SATA expose the unit serial through VPD page 0x80 (binary header + ASCII)
+        std::string vpd = readSysfs(diskDir + "/device/vpd_pg80");
+        if (vpd.size() > 4) session.serial = trimCopy(vpd.substr(4));
+    }
+    session.firmware = readSysfs(diskDir + "/device/firmware_rev");
+    if (session.firmware.empty()) session.firmware = readSysfs(diskDir + "/device/rev");
+    session.wwn = readSysfs(diskDir + "/wwid");
+    if (session.wwn.empty()) session.wwn = readSysfs(diskDir + "/device/wwid");
+    session.hardwareEncryption = productIndicatesEncryption(session.model);
+}
+#endif
+
+static ATASecurityInfo probeATASecurity(DeviceSession& session) {
+#ifdef __linux__
+    uint16_t identify[256];
+    memset(identify, 0, sizeof(identify));
+    session.probeCount++;
+    if (ioctl(session.fd, HDIO_GET_IDENTITY, identify) == 0) {
+        return decodeATASecurity(identify);
+    }
+#endif
+    return decodeATASecurity(nullptr);
+}
+
+static NVMeSanitizeCaps probeNVMeSanitizeCaps(DeviceSession& session) {
+#ifdef __linux__
+    std::vector<uint8_t> identify(NVME_ID_CTRL_SIZE, 0);
+
+    struct nvme_admin_cmd cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_ADMIN_CMD_IDENTIFY;
+    cmd.addr = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(identify.data()));
+    cmd.data_len = NVME_ID_CTRL_SIZE;
+    cmd.cdw10 = NVME_IDENTIFY_CNS_CTRL;
+
+    session.probeCount++;
+    if (ioctl(session.fd, NVME_IOCTL_ADMIN_CMD, &cmd) == 0) {
+        return decodeSanicap(identify.data());
+    }
+#endif
+    return assumedSanitizeCaps();
+}
+
+std::shared_ptr<DeviceSession> openDeviceSession(const std::string& path) {
+    std::shared_ptr<DeviceSession> session = std::make_shared<DeviceSession>();
+    session->path = path;
+
+    session->fd = open(path.c_str(), O_RDWR | O_SYNC);
+    session->probeCount++;
+    if (session->fd != -1) {
+        session->writable = true;
+    } else {
+        session->openError = errno;
+        session->fd = open(path.c_str(), O_RDONLY);
+        session->probeCount++;
+        if (session->fd == -1) {
+            return session;
+        }
+    }
+
+    struct stat st;
+    if (fstat(session->fd, &st) != 0) {
+        return session;
+    }
+
+    if (!S_ISBLK(st.st_mode)) {
+        session->size = static_cast<uint64_t>(st.st_size);
+        return session;
+    }
+
+    session->isBlockDevice = true;
+#ifdef __linux__
+    uint64_t size = 0;
+    int logical = 0;
+    unsigned int physical = 0;
+    session->probeCount++;
+    if (ioctl(session->fd, BLKGETSIZE64, &size) == 0) session->size = size;
+    session->probeCount++;
+    if (ioctl(session->fd, BLKSSZGET, &logical) == 0 && logical > 0) session->logicalSectorSize = logical;
+    session->probeCount++;
+    if (ioctl(session->fd, BLKPBSZGET, &physical) == 0 && physical > 0) session->physicalSectorSize = physical;
+
+    std::string diskDir = sysfsDiskDir(path);
+    if (!diskDir.empty()) {
+        session->rotational = readSysfs(diskDir + "/queue/rotational") != "0";
+        session->deviceType = probeDeviceTypeSysfs(diskDir, session->rotational);
+        probeIdentitySysfs(*session, diskDir);
+    }
+#ifdef BLKGETZONESZ
+    // A non-zero zone size is the zoned test; sysfs tells the two models apart
+    uint32_t zoneSectors = 0;
+    uint32_t zones = 0;
+    session->probeCount++;
+    if (ioctl(session->fd, BLKGETZONESZ, &zoneSectors) == 0 && zoneSectors > 0) {
+        session->zoneSize = static_cast<uint64_t>(zoneSectors) << 9;
+        session->probeCount++;
+        if (ioctl(session->fd, BLKGETNRZONES, &zones) == 0) session->zoneCount = zones;
+        session->zoned = readSysfs(diskDir + "/queue/zoned") == "host-aware" ? ZonedModel::HostAware
+                                                                             : ZonedModel::HostManaged;
+        session->maxOpenZones = static_cast<uint32_t>(std::strtoul(readSysfs(diskDir + "/queue/max_open_zones").c_str(), nullptr, 10));
+        session->maxActiveZones = static_cast<uint32_t>(std::strtoul(readSysfs(diskDir + "/queue/max_active_zones").c_str(), nullptr, 10));
+    }
+#endif
+    session->numaNode = deviceNumaNode(path);
+#endif
+    return session;
+}
+
+#endif
+
+const ATASecurityInfo& DeviceSession::ataSecurity() {
+    if (!ataSecurityProbed && isOpen()) {
+        // Frozen/locked change with power cycles, so a supported feature set
+        // is probed every time; an absent one is not
+        DeviceRecord cached;
+        if (lookupDevice(*this, cached) && cached.ataSecurity == ProbeOutcome::Unsupported) {
+            ataSecurityInfo = decodeATASecurity(nullptr);
+        } else {
+            ataSecurityInfo = probeATASecurity(*this);
+            recordAtaSecurity(*this, ataSecurityInfo);
+        }
+        ataSecurityProbed = true;
+    }
+    return ataSecurityInfo;
+}
+
+const NVMeSanitizeCaps& DeviceSession::nvmeSanitizeCaps() {
+    if (!nvmeCapsProbed && isOpen()) {
+        DeviceRecord cached;
+        bool known = lookupDevice(*this, cached);
+        if (known && cached.nvmeIdentify == ProbeOutcome::Unsupported) {
+            nvmeCaps = assumedSanitizeCaps();
+        } else if (known && cached.nvmeIdentify == ProbeOutcome::Supported) {
+            nvmeCaps = cached.nvmeCaps;
+        } else {
+            nvmeCaps = probeNVMeSanitizeCaps(*this);
+            recordNvmeIdentify(*this, nvmeCaps);
+        }
+        nvmeCapsProbed = true;
+    }
+    return nvmeCaps;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <memory>
+#include "purge/purgeCommon.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+// ATA IDENTIFY DEVICE word 128 (security status), decoded
+struct ATASecurityInfo {
+    bool supported;
+    bool enabled;
+    bool locked;
+    bool frozen;
+    bool enhancedEraseSupported;
+    uint16_t securityWord;
+    uint16_t eraseMinutes;          // IDENTIFY words 89/90: the drive's time estimate, 0 = not reported
+    uint16_t enhancedEraseMinutes;
+};
+
+// NVMe IDENTIFY CONTROLLER SANICAP bits
+struct NVMeSanitizeCaps {
+    bool queried;           // false if IDENTIFY could not be read (caps are assumed)
+    bool cryptoSupported;
+    bool blockSupported;
+    bool overwriteSupported;
+};
+
+// Zoned block device model (Linux queue/zoned). Host-managed drives reject
+// writes that are not at a sequential zone's write pointer; host-aware ones
+// accept them but fall back to slow internal remapping.
+enum class ZonedModel : uint8_t {
+    None,
+    HostAware,
+    HostManaged
+};
+
+// One open handle plus every probe result for a device.
+//
+// A purge cascade (crypto -> NVMe sanitize -> ATA secure erase) or a destroy
+// sequence used to re-open the drive and re-run the same IOCTLs for every
+// step. A session opens the device once, probes type/geometry/identity at
+// open time and caches the protocol-specific capabilities on first use, so
+// every routine that takes a DeviceSession& shares the same round-trips.
+//
+// A session is not thread-safe; it belongs to the job that opened it.
+struct DeviceSession {
+    std::string path;
+
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+#endif
+    bool writable;          // false if only a read-only handle could be obtained
+    uint32_t openError;     // GetLastError()/errno of the failed read-write open
+
+    // Geometry (probed at open)
+    uint64_t size;
+    uint32_t logicalSectorSize;
+    uint32_t physicalSectorSize;
+    bool isBlockDevice;     // false for regular files (test targets)
+    bool rotational;
+    int numaNode;           // NUMA node of the controller, -1 if unknown
+
+    // Zone geometry (probed at open; zonedWriter.h)
+    ZonedModel zoned;
+    uint64_t zoneSize;          // Bytes; 0 when not zoned
+    uint32_t zoneCount;
+    uint32_t maxOpenZones;      // 0 = no limit reported
+    uint32_t maxActiveZones;    // 0 = no limit reported
+
+    // Identity (probed at open)
+    DeviceType deviceType;
+    std::string model;
+    std::string serial;
+    std::string firmware;
+    std::string wwn;            // World wide name, empty if not reported (Linux)
+    bool hardwareEncryption;    // SED/Opal/TCG indicated by the product id
+
+    // Number of device round-trips issued by this session (open + probes)
+    uint32_t probeCount;
+
+    DeviceSession();
+    ~DeviceSession();
+    DeviceSession(const DeviceSession&) = delete;
+    DeviceSession& operator=(const DeviceSession&) = delete;
+
+    bool isOpen() const;
+    void close();
+
+    // Positional I/O of exactly `len` bytes. With an unbuffered handle the
+    // offset, length and buffer must be sector-aligned. On failure ioError
+    // holds GetLastError()/errno.
+    bool readAt(uint64_t offset, uint8_t* data, size_t len);
+    bool writeAt(uint64_t offset, const uint8_t* data, size_t len);
+    uint32_t ioError;
+
+    // Lazily probed, cached capabilities. Results the device cache
+    // (deviceCache.h) already knows to be unsupported are not probed again.
+    const ATASecurityInfo& ataSecurity();
+    const NVMeSanitizeCaps& nvmeSanitizeCaps();
+
+private:
+    bool readRaw(uint64_t offset, uint8_t* data, size_t len);
+    bool writeRaw(uint64_t offset, const uint8_t* data, size_t len);
+
+    bool ataSecurityProbed;
+    bool nvmeCapsProbed;
+    ATASecurityInfo ataSecurityInfo;
+    NVMeSanitizeCaps nvmeCaps;
+};
+
+// Open a device (or regular file) once and probe it. Never returns null;
+// check isOpen() and openError on the result.
+std::shared_ptr<DeviceSession> openDeviceSession(const std::string& path);
+
+#ifdef __linux__
+// Device type of a whole disk from its sysfs directory (/sys/block/<name>);
+// also used by the device enumerator (deviceEnum.h)
+DeviceType probeDeviceTypeSysfs(const std::string& diskDir, bool rotational);
+#endif
+
+// True for errors that point at bad media under the written range (worth
+// retrying sector by sector), false for a lost, read-only or busy device
+bool isMediaError(uint32_t error);
+
+// Windows: lock and dismount every volume on the session's physical drive so
+// raw writes inside them are allowed. No-op elsewhere.
+void dismountVolumes(DeviceSession& session);
@@ -0,0 +1,393 @@
+#include "fileShred.h"
+#include "ioStats.h"
+#include "ioThrottle.h"
+#include "wipeJob.h"
+#include "telemetry.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <winioctl.h>
+#else
+    #include <sys/stat.h>
+    #include <sys/ioctl.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #ifdef __linux__
+        #include <linux/fs.h>
+        #include <linux/fiemap.h>
+    #endif
+#endif
+
+// Extents fetched per FIEMAP / FSCTL round-trip
+constexpr size_t EXTENT_BATCH = 256;
+
+ExtentSink::ExtentSink() :
+#ifdef _WIN32
+    handle(INVALID_HANDLE_VALUE),
+#else
+    fd(-1),
+    pendingOffset(0),
+    pendingLength(0),
+#endif
+    length(0),
+    mappedBytes(0),
+    rangeBegin(0),
+    rangeEnd(0),
+    written(0),
+    source("none"),
+    error(0) {}
+
+ExtentSink::~ExtentSink() {
+    close();
+}
+
+void ExtentSink::close() {
+#ifdef _WIN32
+    if (handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd != -1) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+bool ExtentSink::open(const std::string& path) {
+#ifdef _WIN32
+    handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        error = GetLastError();
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize)) {
+        error = GetLastError();
+        return false;
+    }
+    length = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd == -1) {
+        error = errno;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        error = errno ? errno : EINVAL;
+        return false;
+    }
+    length = static_cast<uint64_t>(st.st_size);
+#endif
+    return mapExtents();
+}
+
+#ifdef _WIN32
+
+// Allocated (non-sparse) ranges; NTFS does not expose physical offsets here
+bool ExtentSink::mapExtents() {
+    FILE_ALLOCATED_RANGE_BUFFER query;
+    query.FileOffset.QuadPart = 0;
+    query.Length.QuadPart = static_cast<LONGLONG>(length);
+    std::vector<FILE_ALLOCATED_RANGE_BUFFER> ranges(EXTENT_BATCH);
+
+    for (;;) {
+        DWORD bytesReturned = 0;
+        BOOL ok = DeviceIoControl(handle, FSCTL_QUERY_ALLOCATED_RANGES, &query, sizeof(query),
+                                  ranges.data(), static_cast<DWORD>(ranges.size() * sizeof(ranges[0])),
+                                  &bytesReturned, NULL);
+        DWORD lastError = ok ? 0 : GetLastError();
+        if (!ok && lastError != ERROR_MORE_DATA) {
+            // Not supported (e.g. FAT): treat the file as fully allocated
+            extentList.assign(1, FileExtent{0, 0, length, false, false});
+            source = "none";
+            break;
+        }
+        size_t count = bytesReturned / sizeof(ranges[0]);
+        for (size_t i = 0; i < count; i++) {
+            uint64_t start = static_cast<uint64_t>(ranges[i].FileOffset.QuadPart);
+            uint64_t len = static_cast<uint64_t>(ranges[i].Length.QuadPart);
+            extentList.push_back(FileExtent{start, 0, len, false, false});
+        }
+        source = "allocated_ranges";
+        if (ok || count == 0) break;
+        const FILE_ALLOCATED_RANGE_BUFFER& last = ranges[count - 1];
+        uint64_t next = static_cast<uint64_t>(last.FileOffset.QuadPart + last.Length.QuadPart);
+        query.FileOffset.QuadPart = static_cast<LONGLONG>(next);
+        query.Length.QuadPart = static_cast<LONGLONG>(length - next);
+    }
+
+    for (const FileExtent& e : extentList) {
+        mappedBytes += e.length;
+        extentEnds.push_back(mappedBytes);
+    }
+    rangeEnd = mappedBytes;
+    return true;
+}
+
+bool ExtentSink::writeAt(uint64_t fileOffset, const uint8_t* data, size_t len) {
+    OVERLAPPED ov = {};
+    ov.Offset = static_cast<DWORD>(fileOffset);
+    ov.OffsetHigh = static_cast<DWORD>(fileOffset >> 32);
+    DWORD bytesWritten = 0;
+    if (!WriteFile(handle, data, static_cast<DWORD>(len), &bytesWritten, &ov) || bytesWritten != len) {
+        error = GetLastError();
+        return false;
+    }
+    return true;
+}
+
+bool ExtentSink::endPass() {
+    if (!FlushFileBuffers(handle)) {
+        error = GetLastError();
+        return false;
+    }
+    return true;
+}
+
+#else
+
+#ifdef __linux__
+// FIEMAP with FIEMAP_FLAG_SYNC so delayed allocations get real blocks first
+static bool fiemapExtents(int fd, uint64_t length, std::vector<FileExtent>& extents) {
+    std::vector<uint8_t> buffer(sizeof(struct fiemap) + EXTENT_BATCH * sizeof(struct fiemap_extent));
+    struct fiemap* fm = reinterpret_cast<struct fiemap*>(buffer.data());
+    uint64_t start = 0;
+    bool done = length == 0;
+
+    while (!done) {
+        memset(buffer.data(), 0, buffer.size());
+        fm->fm_start = start;
+        fm->fm_length = FIEMAP_MAX_OFFSET - start;
+        fm->fm_flags = FIEMAP_FLAG_SYNC;
+        fm->fm_extent_count = EXTENT_BATCH;
+        if (ioctl(fd, FS_IOC_FIEMAP, fm) != 0) return false;
+        if (fm->fm_mapped_extents == 0) break;
+
+        for (uint32_t i = 0; i < fm->fm_mapped_extents; i++) {
+            const struct fiemap_extent& fe = fm->fm_extents[i];
+            // Extents are whole blocks; never write past EOF
+            if (fe.fe_logical < length) {
+                bool unknownPhysical = (fe.fe_flags & (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DATA_INLINE)) != 0;
+                extents.push_back(FileExtent{
+                    fe.fe_logical,
+                    unknownPhysical ? 0 : fe.fe_physical,
+                    std::min<uint64_t>(fe.fe_length, length - fe.fe_logical),
+                    (fe.fe_flags & FIEMAP_EXTENT_UNWRITTEN) != 0,
+                    (fe.fe_flags & FIEMAP_EXTENT_SHARED) != 0
+                });
+            }
+            start = fe.fe_logical + fe.fe_length;
+            if (fe.fe_flags & FIEMAP_EXTENT_LAST) done = true;
+        }
+        if (start >= length) done = true;
+    }
+    return true;
+}
+#endif
+
+// SEEK_DATA/SEEK_HOLE still skips holes where FIEMAP is missing (tmpfs, NFS, ...)
+static bool seekDataExtents(int fd, uint64_t length, std::vector<FileExtent>& extents) {
+    off_t pos = 0;
+    while (static_cast<uint64_t>(pos) < length) {
+        off_t data = lseek(fd, pos, SEEK_DATA);
+        if (data < 0) return errno == ENXIO;    // No data after pos
+        off_t hole = lseek(fd, data, SEEK_HOLE);
+        if (hole < 0) return false;
+        extents.push_back(FileExtent{static_cast<uint64_t>(data), 0, static_cast<uint64_t>(hole - data), false, false});
+        pos = hole;
+    }
+    return true;
+}
+
+bool ExtentSink::mapExtents() {
+    bool mapped = false;
+#ifdef __linux__
+    if (fiemapExtents(fd, length, extentList)) {
+        source = "fiemap";
+        mapped = true;
+    }
+#endif
+    if (!mapped) {
+        extentList.clear();
+        if (seekDataExtents(fd, length, extentList)) {
+            source = "seek_data";
+        } else {
+            extentList.assign(1, FileExtent{0, 0, length, false, false});
+            source = "none";
+        }
+    }
+
+    for (const FileExtent& e : extentList) {
+        mappedBytes += e.length;
+        extentEnds.push_back(mappedBytes);
+    }
+    rangeEnd = mappedBytes;
+    return true;
+}
+
+bool ExtentSink::writeAt(uint64_t fileOffset, const uint8_t* data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t result = pwrite(fd, data + done, len - done, static_cast<off_t>(fileOffset + done));
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            error = result < 0 ? errno : EIO;
+            return false;
+        }
+        done += static_cast<size_t>(result);
+    }
+
+#ifdef __linux__
+    // Start writeback of this chunk, then wait for the previous one and drop
+    // its pages: dirty data stays bounded and the page cache is not polluted
+    sync_file_range(fd, static_cast<off_t>(fileOffset), static_cast<off_t>(len), SYNC_FILE_RANGE_WRITE);
+    if (pendingLength) {
+        sync_file_range(fd, static_cast<off_t>(pendingOffset), static_cast<off_t>(pendingLength),
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fd, static_cast<off_t>(pendingOffset), static_cast<off_t>(pendingLength), POSIX_FADV_DONTNEED);
+    }
+    pendingOffset = fileOffset;
+    pendingLength = len;
+#endif
+    return true;
+}
+
+bool ExtentSink::endPass() {
+    // One flush per pass: each pass must reach the media before the next
+    // overwrites it in the page cache
+    if (fdatasync(fd) != 0) {
+        error = errno;
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    pendingLength = 0;
+    return true;
+}
+
+#endif
+
+void ExtentSink::setRange(uint64_t begin, uint64_t end) {
+    rangeEnd = std::min(end, mappedBytes);
+    rangeBegin = std::min(begin, rangeEnd);
+}
+
+bool ExtentSink::beginPass(size_t pass, size_t passCount, const PassSpec&) {
+    if (WipeJob* job = currentJob()) job->setPass(static_cast<uint32_t>(pass), static_cast<uint32_t>(passCount));
+    return true;
+}
+
+bool ExtentSink::writeExtent(uint64_t fileOffset, const uint8_t* data, size_t len) {
+    throttleWrite(len);
+    IoTimer timer(fileOffset, len);
+    bool ok = writeAt(fileOffset, data, len);
+    timer.write(ok, error);
+    if (!ok) return false;
+    written += len;
+    recordNumaWrite(len);
+    return true;
+}
+
+ShredResult shredFile(const std::string& path, const std::string& method, bool removeAfter) {
+    ShredResult result;
+    result.success = false;
+    result.path = path;
+    result.method = method;
+    result.fileSize = 0;
+    result.bytesWritten = 0;
+    result.holeBytes = 0;
+    result.removed = false;
+    result.durationMs = 0;
+    result.errorCode = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        ExtentSink sink;
+        if (!sink.open(path)) {
+            result.errorCode = sink.lastError();
+            result.message = "Cannot open file for writing";
+            return result;
+        }
+
+        result.fileSize = sink.fileSize();
+        result.extents = sink.extents();
+        result.extentSource = sink.extentSource();
+        result.holeBytes = sink.fileSize() - sink.mappedSize();
+
+        bool found = false;
+        bool ok = sink.size() == 0 || runSchemeByName(sink, method, SHRED_CHUNK_SIZE, &found);
+        if (sink.size() != 0 && !found) {
+            result.message = "Unknown method: " + method;
+            return result;
+        }
+        result.bytesWritten = sink.bytesWritten();
+        if (!ok) {
+            result.errorCode = sink.lastError();
+            result.message = "Write failed";
+            return result;
+        }
+    }
+
+    size_t shared = std::count_if(result.extents.begin(), result.extents.end(),
+                                  [](const FileExtent& e) { return e.shared; });
+    result.success = true;
+    result.message = "Overwrote " + std::to_string(result.extents.size()) + " extents";
+    if (shared) {
+        result.message += " (" + std::to_string(shared) + " shared/CoW extents could not be overwritten in place)";
+    }
+
+    if (removeAfter) {
+        result.removed = removeShreddedFile(path);
+        if (!result.removed) result.message += "; file could not be removed";
+    }
+
+    result.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    logInfo("shred") << "Shredded " << path << " (" << method << "): " << result.extents.size() << " extents via "
+                     << result.extentSource << ", " << result.bytesWritten << " bytes written, "
+                     << result.holeBytes << " hole bytes skipped, " << result.durationMs << " ms";
+    return result;
+}
+
+bool removeShreddedFile(const std::string& path) {
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, TRUNCATE_EXISTING, 0, NULL);
+    if (h != INVALID_HANDLE_VALUE) CloseHandle(h);
+    return DeleteFileA(path.c_str()) != 0;
+#else
+    if (truncate(path.c_str(), 0) != 0) return false;
+    return unlink(path.c_str()) == 0;
+#endif
+}
+
+// Export for testing
+#ifdef TEST_STANDALONE
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: fileShred <file> [method]" << std::endl;
+        return 1;
+    }
+    ShredResult result = shredFile(argv[1], argc > 2 ? argv[2] : "zero", false);
+    for (const FileExtent& e : result.extents) {
+        std::cout << "  logical " << e.logical << " physical " << e.physical << " length " << e.length
+                  << (e.unwritten ? " unwritten" : "") << (e.shared ? " shared" : "") << std::endl;
+    }
+    std::cout << result.message << std::endl;
+
+    // Extents and holes are not a multiple of a 3-byte period
+    ExtentSink sink;
+    std::vector<BadRange> extents;
+    bool phased = sink.open(argv[1]);
+    for (const FileExtent& e : sink.extents()) extents.push_back(BadRange{e.logical, e.length});
+    phased = phased && checkPatternPhase(sink, argv[1], extents, SHRED_CHUNK_SIZE);
+    return result.success && phased ? 0 : 1;
+}
+#endif
@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "wipeSchemes.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+// Extent-aware single-file shredding.
+//
+// The file's allocated extents are read from the filesystem (FIEMAP on Linux,
+// SEEK_DATA/SEEK_HOLE as a fallback, FSCTL_QUERY_ALLOCATED_RANGES on Windows)
+// and each pass overwrites exactly those ranges in place with large aligned
+// positional writes, so holes are skipped and the original blocks are
+// rewritten rather than re-allocated. Written pages are dropped from the page
+// cache as writeback completes and the file is flushed once per pass.
+//
+// Copy-on-write filesystems (btrfs, ZFS, APFS) and reflinked extents cannot be
+// overwritten in place; such extents are flagged `shared` in the report.
+
+constexpr size_t SHRED_CHUNK_SIZE = 8 * 1024 * 1024;
+
+struct FileExtent {
+    uint64_t logical;       // Offset in the file
+    uint64_t physical;      // Byte offset on the device (0 if unknown)
+    uint64_t length;
+    bool unwritten;         // Preallocated, never written
+    bool shared;            // Reflinked/CoW: overwrite will not reach these blocks
+};
+
+// Scheme sink over a file's extents. Scheme offsets are positions in the
+// concatenation of the extents; writePass() walks them extent by extent and
+// asks the source for each chunk at its file offset, so periodic patterns
+// keep their phase across holes and worker ranges.
+class ExtentSink {
+public:
+    static constexpr bool writesOwnPass = true;
+
+    ExtentSink();
+    ~ExtentSink();
+    ExtentSink(const ExtentSink&) = delete;
+    ExtentSink& operator=(const ExtentSink&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    // Restrict the sink to mapped bytes [begin, end) so one large file can be
+    // split across workers (each with its own sink/handle)
+    void setRange(uint64_t begin, uint64_t end);
+
+    uint64_t size() const { return rangeEnd - rangeBegin; }
+    bool beginPass(size_t pass, size_t passCount, const PassSpec& spec);
+    template <typename Source>
+    bool writePass(Source& source);
+    bool endPass();
+
+    uint64_t fileSize() const { return length; }
+    uint64_t mappedSize() const { return mappedBytes; }
+    uint64_t bytesWritten() const { return written; }
+    const std::vector<FileExtent>& extents() const { return extentList; }
+    const char* extentSource() const { return source; }   // "fiemap", "seek_data", "allocated_ranges", "none"
+    uint32_t lastError() const { return error; }
+
+private:
+    bool mapExtents();
+    bool writeExtent(uint64_t fileOffset, const uint8_t* data, size_t len);
+    bool writeAt(uint64_t fileOffset, const uint8_t* data, size_t len);
+
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int fd;
+    uint64_t pendingOffset;     // Last write whose writeback has been started
+    uint64_t pendingLength;
+#endif
+    uint64_t length;
+    uint64_t mappedBytes;
+    uint64_t rangeBegin;
+    uint64_t rangeEnd;
+    uint64_t written;
+    std::vector<FileExtent> extentList;
+    std::vector<uint64_t> extentEnds;    // Cumulative mapped bytes at the end of each extent
+    const char* source;
+    uint32_t error;
+};
+
+template <typename Source>
+bool ExtentSink::writePass(Source& source) {
+    const size_t chunk = source.chunkSize();
+    // Extent holding mapped offset `rangeBegin`, then walk forward across extents
+    size_t index = std::upper_bound(extentEnds.begin(), extentEnds.end(), rangeBegin) - extentEnds.begin();
+    for (uint64_t offset = rangeBegin; offset < rangeEnd && index < extentList.size(); index++) {
+        const FileExtent& e = extentList[index];
+        const uint64_t extentStart = extentEnds[index] - e.length;
+        const uint64_t end = extentEnds[index] < rangeEnd ? extentEnds[index] : rangeEnd;
+        while (offset < end) {
+            uint64_t fileOffset = e.logical + (offset - extentStart);
+            size_t n = static_cast<size_t>(end - offset < chunk ? end - offset : chunk);
+            if (!writeExtent(fileOffset, source.next(fileOffset, n), n)) return false;
+            offset += n;
+        }
+    }
+    return true;
+}
+
+struct ShredResult {
+    bool success;
+    std::string path;
+    std::string method;
+    uint64_t fileSize;
+    uint64_t bytesWritten;      // All passes
+    uint64_t holeBytes;         // Skipped per pass (not allocated)
+    std::vector<FileExtent> extents;
+    std::string extentSource;
+    bool removed;
+    double durationMs;
+    std::string message;
+    uint32_t errorCode;
+};
+
+// Overwrite a regular file with the named scheme (wipeSchemes.h) and
+// optionally truncate + unlink it afterwards.
+ShredResult shredFile(const std::string& path, const std::string& method, bool removeAfter);
+
+// Truncate then unlink, so neither the size nor the name survives the data
+bool removeShreddedFile(const std::string& path);
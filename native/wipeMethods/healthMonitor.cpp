@@ -0,0 +1,203 @@
+#include "healthMonitor.h"
+#include "wipeJob.h"
+#include "telemetry.h"
+#include <algorithm>
+#include <sstream>
+
+// Baseline follows healthy windows with this weight
+constexpr double BASELINE_ALPHA = 0.1;
+// Degraded episodes end once windows are back above this share of the baseline
+constexpr double RECOVERY_FRACTION = 0.7;
+
+const char* healthEventName(HealthEventKind kind) {
+    switch (kind) {
+        case HealthEventKind::Degraded: return "degraded";
+        case HealthEventKind::LatencySpike: return "latency_spike";
+        case HealthEventKind::Stall: return "stall";
+        case HealthEventKind::Retuned: return "retuned";
+        case HealthEventKind::Paused: return "paused";
+        case HealthEventKind::Flagged: return "flagged";
+        case HealthEventKind::Recovered: return "recovered";
+    }
+    return "degraded";
+}
+
+HealthMonitor::HealthMonitor() :
+    currentWriteSize(SIZE_MAX),
+    started(std::chrono::steady_clock::now()),
+    windowStart(started),
+    lastRecord(started) {}
+
+uint32_t HealthMonitor::record(uint64_t offset, size_t bytes, uint64_t latencyNs,
+                               std::chrono::steady_clock::time_point now) {
+    lastRecord = now;
+    largestWrite = std::max(largestWrite, bytes);
+    windowBytes += bytes;
+    windowMaxNs = std::max(windowMaxNs, latencyNs);
+    double seconds = latencyNs / 1e9;
+
+    if (seconds >= STALL_SECONDS && !windowStall) {
+        windowStall = true;
+        // Back-to-back stalls are reported once; the degraded episode covers the rest
+        if (!stallReported) {
+            stallReported = true;
+            std::ostringstream detail;
+            detail << "Write of " << bytes << " bytes at offset " << offset << " blocked for " << seconds << " s";
+            addEvent(HealthEventKind::Stall, offset, 0, seconds * 1000, detail.str());
+        }
+    }
+    // Far slower than the baseline rate predicts for a write this size; the
+    // 100 ms floor keeps scheduler noise on small writes out
+    if (windows >= HEALTH_WARMUP_WINDOWS && baseline > 0) {
+        double expected = bytes / (baseline * 1048576.0);
+        if (seconds > std::max(expected * LATENCY_SPIKE_FACTOR, 0.1)) windowSpike = true;
+    }
+
+    if (std::chrono::duration<double>(now - windowStart).count() >= HEALTH_WINDOW_SECONDS) {
+        return closeWindow(offset, now);
+    }
+    return 0;
+}
+
+void HealthMonitor::resume(std::chrono::steady_clock::time_point now) {
+    // The pause is not write time: start a fresh window
+    windowStart = now;
+    windowBytes = 0;
+    windowMaxNs = 0;
+    windowSpike = false;
+    windowStall = false;
+}
+
+uint32_t HealthMonitor::closeWindow(uint64_t offset, std::chrono::steady_clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - windowStart).count();
+    double mbps = windowBytes / 1048576.0 / elapsed;
+    double latencyMs = windowMaxNs / 1e6;
+    bool spike = windowSpike;
+    bool stall = windowStall;
+    resume(now);
+
+    if (++windows <= HEALTH_WARMUP_WINDOWS) {
+        baseline += (mbps - baseline) / windows;
+        return 0;
+    }
+
+    bool collapsed = mbps < baseline * COLLAPSE_FRACTION;
+    if (collapsed || spike || stall) {
+        healthyRun = 0;
+        if (++degradedRun < DEGRADED_WINDOWS) return 0;
+        degradedRun = 0;
+        if (!degraded) {
+            degraded = true;
+            std::ostringstream detail;
+            if (collapsed) {
+                detail << "Throughput " << static_cast<int>(mbps) << " MB/s against a baseline of "
+                       << static_cast<int>(baseline) << " MB/s in " << DEGRADED_WINDOWS << " consecutive windows";
+            } else {
+                detail << "Writes up to " << static_cast<int>(latencyMs) << " ms in " << DEGRADED_WINDOWS
+                       << " consecutive windows (baseline " << static_cast<int>(baseline) << " MB/s)";
+            }
+            addEvent(collapsed ? HealthEventKind::Degraded : HealthEventKind::LatencySpike, offset, mbps, latencyMs,
+                     detail.str());
+        }
+        return react(offset, mbps, latencyMs);
+    }
+
+    degradedRun = 0;
+    if (!degraded) {
+        baseline += BASELINE_ALPHA * (mbps - baseline);
+        stallReported = false;
+        return 0;
+    }
+    healthyRun = mbps >= baseline * RECOVERY_FRACTION ? healthyRun + 1 : 0;
+    if (healthyRun >= RECOVERY_WINDOWS) {
+        degraded = false;
+        healthyRun = 0;
+        ladderStep = 0;
+        stallReported = false;
+        currentWriteSize = SIZE_MAX;
+        addEvent(HealthEventKind::Recovered, offset, mbps, latencyMs,
+                 "Throughput back to " + std::to_string(static_cast<int>(mbps)) + " MB/s");
+    }
+    return 0;
+}
+
+uint32_t HealthMonitor::react(uint64_t offset, double mbps, double latencyMs) {
+    if (isFlagged) return 0;
+
+    if (ladderStep == 0) {
+        ladderStep++;
+        size_t size = std::min(currentWriteSize, largestWrite);
+        if (size > MIN_RETUNED_WRITE) {
+            currentWriteSize = std::max(MIN_RETUNED_WRITE, size / 4);
+            addEvent(HealthEventKind::Retuned, offset, mbps, latencyMs,
+                     "Write size reduced to " + std::to_string(currentWriteSize >> 10) + " KB");
+            return 0;
+        }
+    }
+    if (ladderStep <= 2) {
+        uint32_t pause = THERMAL_PAUSE_SECONDS << (ladderStep - 1);
+        ladderStep++;
+        addEvent(HealthEventKind::Paused, offset, mbps, latencyMs,
+                 "Pausing " + std::to_string(pause) + " s for thermal recovery");
+        return pause * 1000;
+    }
+
+    isFlagged = true;
+    addEvent(HealthEventKind::Flagged, offset, mbps, latencyMs,
+             "Device still degraded after retuning and pauses; continuing at reduced speed");
+    return 0;
+}
+
+void HealthMonitor::addEvent(HealthEventKind kind, uint64_t offset, double mbps, double latencyMs,
+                             const std::string& detail) {
+    HealthEvent event{kind, std::chrono::duration<double>(lastRecord - started).count(), offset, mbps, baseline,
+                      latencyMs, currentWriteSize, detail};
+    eventList.push_back(event);
+    if (WipeJob* job = currentJob()) job->recordHealthEvent(event);
+    emitEvent(TelemetryEvent::DeviceHealth, "health", std::string(healthEventName(kind)) + ": " + detail,
+              static_cast<uint64_t>(kind), static_cast<uint64_t>(mbps), static_cast<uint64_t>(baseline));
+}
+
+// Export for testing: a drive that collapses from 200 to 5 MB/s mid-pass and
+// later recovers, on a simulated clock
+#ifdef TEST_STANDALONE
+#include <iostream>
+
+int main() {
+    const size_t chunk = 32 * 1024 * 1024;
+    HealthMonitor monitor;
+    auto now = std::chrono::steady_clock::now();
+    uint64_t offset = 0;
+
+    auto writeFor = [&](double seconds, double mbps) {
+        auto end = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+        while (now < end) {
+            size_t len = std::min(chunk, monitor.writeSize());
+            auto took = std::chrono::duration<double>(len / (mbps * 1048576.0));
+            now += std::chrono::duration_cast<std::chrono::steady_clock::duration>(took);
+            uint32_t pauseMs = monitor.record(offset, len, static_cast<uint64_t>(took.count() * 1e9), now);
+            offset += len;
+            if (pauseMs) {
+                now += std::chrono::milliseconds(pauseMs);
+                monitor.resume(now);
+            }
+        }
+    };
+
+    writeFor(20, 200);      // Healthy: baseline ~200 MB/s
+    writeFor(120, 5);       // SMR cache exhausted / throttled
+    writeFor(20, 180);      // Recovers
+
+    bool retuned = false, paused = false, flagged = false, recovered = false;
+    for (const HealthEvent& e : monitor.events()) {
+        std::cout << e.atSeconds << " s  " << healthEventName(e.kind) << ": " << e.detail << std::endl;
+        retuned |= e.kind == HealthEventKind::Retuned;
+        paused |= e.kind == HealthEventKind::Paused;
+        flagged |= e.kind == HealthEventKind::Flagged;
+        recovered |= e.kind == HealthEventKind::Recovered;
+    }
+    bool ok = retuned && paused && flagged && recovered && monitor.writeSize() == SIZE_MAX;
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Device health monitor: stall and degradation detection for a pass writer.
+//
+// Write completions are folded into one-second windows. After a warm-up the
+// monitor keeps a rolling baseline (EWMA of healthy windows only, so slow
+// drift such as an HDD moving to inner tracks is followed but a collapse is
+// not). A window is degraded when its throughput falls below
+// COLLAPSE_FRACTION of the baseline, its writes take LATENCY_SPIKE_FACTOR
+// times longer than the baseline predicts, or a single write stalls for
+// STALL_SECONDS. DEGRADED_WINDOWS degraded windows in a row trigger the next
+// step of the reaction ladder:
+//
+//   1. Retune: split writes into smaller pieces (SMR caches and USB bridges
+//      often recover with shorter commands)
+//   2. Pause THERMAL_PAUSE_SECONDS for thermal recovery, then twice as long
+//   3. Flag the device as degraded and carry on at the reduced settings
+//
+// RECOVERY_WINDOWS healthy windows restore the full write size and reset the
+// ladder. Every step is recorded as a HealthEvent on the job.
+
+constexpr double HEALTH_WINDOW_SECONDS = 1.0;
+constexpr size_t HEALTH_WARMUP_WINDOWS = 5;
+constexpr double COLLAPSE_FRACTION = 0.3;
+constexpr double LATENCY_SPIKE_FACTOR = 8.0;
+constexpr double STALL_SECONDS = 5.0;
+constexpr size_t DEGRADED_WINDOWS = 5;
+constexpr size_t RECOVERY_WINDOWS = 3;
+constexpr uint32_t THERMAL_PAUSE_SECONDS = 15;
+constexpr size_t MIN_RETUNED_WRITE = 1024 * 1024;
+
+enum class HealthEventKind : uint8_t {
+    Degraded,       // Sustained throughput collapse against the baseline
+    LatencySpike,   // Writes far slower than the baseline predicts
+    Stall,          // A single write blocked for STALL_SECONDS or more
+    Retuned,        // Write size reduced
+    Paused,         // Writer paused for thermal recovery
+    Flagged,        // Device marked degraded; no further reactions
+    Recovered       // Back near the baseline; write size restored
+};
+
+struct HealthEvent {
+    HealthEventKind kind;
+    double atSeconds;           // Since monitoring started
+    uint64_t offset;            // Device offset of the write that closed the window
+    double mbps;                // Window throughput
+    double baselineMBps;
+    double latencyMs;           // Slowest write in the window
+    size_t writeSize;           // Write size in effect after the event
+    std::string detail;
+};
+
+const char* healthEventName(HealthEventKind kind);
+
+class HealthMonitor {
+public:
+    HealthMonitor();
+
+    // Account one completed write. Returns how long the writer should pause
+    // before the next write (0 for no pause); call resume() after pausing.
+    uint32_t record(uint64_t offset, size_t bytes, uint64_t latencyNs,
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    void resume(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+    // Largest write the sink should issue at once; SIZE_MAX until retuned
+    size_t writeSize() const { return currentWriteSize; }
+    bool flagged() const { return isFlagged; }
+    double baselineMBps() const { return baseline; }
+    const std::vector<HealthEvent>& events() const { return eventList; }
+
+private:
+    uint32_t closeWindow(uint64_t offset, std::chrono::steady_clock::time_point now);
+    uint32_t react(uint64_t offset, double mbps, double latencyMs);
+    void addEvent(HealthEventKind kind, uint64_t offset, double mbps, double latencyMs, const std::string& detail);
+
+    size_t currentWriteSize;
+    size_t largestWrite = 0;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point windowStart;
+    std::chrono::steady_clock::time_point lastRecord;
+    uint64_t windowBytes = 0;
+    uint64_t windowMaxNs = 0;
+    bool windowSpike = false;
+    bool windowStall = false;
+    bool stallReported = false;
+    size_t windows = 0;
+    double baseline = 0;            // MB/s
+    size_t degradedRun = 0;
+    size_t healthyRun = 0;
+    size_t ladderStep = 0;
+    bool degraded = false;
+    bool isFlagged = false;
+    std::vector<HealthEvent> eventList;
+};
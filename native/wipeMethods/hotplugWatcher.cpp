@@ -0,0 +1,411 @@
+#include "hotplugWatcher.h"
+#include "wipeJob.h"
+#include "telemetry.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <cstring>
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <linux/netlink.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+const char* hotplugActionName(HotplugAction action) {
+    switch (action) {
+        case HotplugAction::Add: return "add";
+        case HotplugAction::Remove: return "remove";
+        case HotplugAction::Change: return "change";
+    }
+    return "unknown";
+}
+
+#ifdef __linux__
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// An enclosure or hub enumerating many disks can overflow the default socket
+// buffer; ask for more (SO_RCVBUFFORCE needs CAP_NET_ADMIN, SO_RCVBUF is capped
+// by rmem_max) and rescan if it overflows anyway
+constexpr int UEVENT_RECEIVE_BUFFER = 1 << 20;
+constexpr size_t UEVENT_MAX_SIZE = 8192;
+
+struct Uevent {
+    std::string action;         // "add", "remove", "change", "bind", ...
+    std::string subsystem;
+    std::string devName;        // "sdb1"
+    std::string devType;        // "disk" or "partition"
+    std::string devPath;        // "/devices/.../block/sdb/sdb1"
+};
+
+struct Pending {
+    HotplugEvent event;
+    Clock::time_point last;
+};
+
+struct Watcher {
+    std::mutex mutex;
+    std::thread thread;
+    HotplugCallback callback;
+    unsigned debounceMs = HOTPLUG_DEFAULT_DEBOUNCE_MS;
+    int socketFd = -1;
+    int wakeFds[2] = {-1, -1};
+    bool running = false;
+    bool stopping = false;
+
+    // Watcher thread only (set up before it starts)
+    std::set<std::string> known;            // Physical disks present
+    std::map<std::string, Pending> pending; // By disk name
+};
+
+// Never destroyed: a still-running thread must not meet its std::thread's
+// destructor during static teardown
+Watcher& watcher() {
+    static Watcher* instance = new Watcher();
+    return *instance;
+}
+
+// "action@devpath" header, then NUL-separated KEY=value fields
+bool parseUevent(const char* data, size_t len, Uevent& ev) {
+    for (size_t i = 0; i < len; ) {
+        size_t n = strnlen(data + i, len - i);
+        const char* field = data + i;
+        i += n + 1;
+        const char* eq = static_cast<const char*>(memchr(field, '=', n));
+        if (!eq) continue;
+        std::string key(field, eq - field);
+        std::string value(eq + 1, field + n - (eq + 1));
+        if (key == "ACTION") ev.action = value;
+        else if (key == "SUBSYSTEM") ev.subsystem = value;
+        else if (key == "DEVNAME") ev.devName = value.substr(value.find_last_of('/') + 1);
+        else if (key == "DEVTYPE") ev.devType = value;
+        else if (key == "DEVPATH") ev.devPath = value;
+    }
+    return ev.subsystem == "block" && !ev.action.empty() && !ev.devName.empty();
+}
+
+// Disk a partition belongs to: the path component above it
+std::string parentDisk(const std::string& devPath) {
+    size_t last = devPath.find_last_of('/');
+    if (last == std::string::npos || last == 0) return "";
+    size_t previous = devPath.find_last_of('/', last - 1);
+    return devPath.substr(previous + 1, last - previous - 1);
+}
+
+bool isPhysicalDisk(const std::string& name) {
+    struct stat st;
+    return stat(("/sys/block/" + name + "/device").c_str(), &st) == 0;
+}
+
+// Whether a job target ("/dev/sdb1") is the block device `node` or, for a
+// whole disk, one of its partitions: "sdb" + digits, or "nvme0n1" + "p" + digits
+bool targetOn(const std::string& target, const std::string& node, bool wholeDisk) {
+    std::string name = target.compare(0, 5, "/dev/") == 0 ? target.substr(5) : target;
+    if (name == node) return true;
+    if (!wholeDisk || name.compare(0, node.size(), node) != 0) return false;
+    size_t i = node.size();
+    if (!node.empty() && node.back() >= '0' && node.back() <= '9') {
+        if (i >= name.size() || name[i] != 'p') return false;
+        i++;
+    }
+    if (i >= name.size()) return false;
+    for (; i < name.size(); i++) {
+        if (name[i] < '0' || name[i] > '9') return false;
+    }
+    return true;
+}
+
+std::vector<std::string> cancelJobsOn(const std::string& node, bool wholeDisk) {
+    std::vector<std::string> cancelled;
+    for (const JobRef& job : listJobs()) {
+        if (!job->running() || job->cancelled() || !targetOn(job->target, node, wholeDisk)) continue;
+        job->cancel("Device /dev/" + node + " was removed");
+        cancelled.push_back(job->id);
+    }
+    return cancelled;
+}
+
+// An arrival or removal outranks the change events around it; between the
+// two the later one wins (pulled and re-plugged inside the window is an add)
+void queue(Watcher& w, const std::string& disk, HotplugAction action, const std::vector<std::string>& cancelled) {
+    auto it = w.pending.find(disk);
+    if (it == w.pending.end()) {
+        Pending p = Pending();
+        p.event.action = action;
+        p.event.name = disk;
+        p.event.path = "/dev/" + disk;
+        it = w.pending.emplace(disk, std::move(p)).first;
+    } else if (action != HotplugAction::Change) {
+        it->second.event.action = action;
+    }
+    HotplugEvent& event = it->second.event;
+    event.uevents++;
+    event.cancelledJobs.insert(event.cancelledJobs.end(), cancelled.begin(), cancelled.end());
+    it->second.last = Clock::now();
+}
+
+void handle(Watcher& w, const Uevent& ev) {
+    const bool partition = ev.devType == "partition";
+    const std::string disk = partition ? parentDisk(ev.devPath) : ev.devName;
+    if (disk.empty()) return;
+
+    std::vector<std::string> cancelled;
+    HotplugAction action;
+    if (ev.action == "add" && !partition) {
+        if (!isPhysicalDisk(disk)) return;      // loop, dm, md, zram, nbd
+        w.known.insert(disk);
+        action = HotplugAction::Add;
+    } else if (ev.action == "add" || ev.action == "change") {
+        if (!w.known.count(disk)) return;
+        action = HotplugAction::Change;
+    } else if (ev.action == "remove") {
+        if (!w.known.count(disk)) return;
+        cancelled = cancelJobsOn(ev.devName, !partition);
+        if (partition) {
+            action = HotplugAction::Change;
+        } else {
+            w.known.erase(disk);
+            action = HotplugAction::Remove;
+        }
+    } else {
+        return;         // bind, unbind, move, online, offline
+    }
+    queue(w, disk, action, cancelled);
+}
+
+// Every disk with a sysfs device/ link, media or not (an empty card reader
+// reports its card as a change)
+std::set<std::string> physicalDisks() {
+    std::set<std::string> disks;
+    if (DIR* d = opendir("/sys/block")) {
+        while (dirent* entry = readdir(d)) {
+            if (entry->d_name[0] != '.' && isPhysicalDisk(entry->d_name)) disks.insert(entry->d_name);
+        }
+        closedir(d);
+    }
+    return disks;
+}
+
+// Uevents were lost: diff sysfs against the disks we believe are present
+void resync(Watcher& w) {
+    std::set<std::string> present = physicalDisks();
+    for (const std::string& name : present) {
+        if (!w.known.count(name)) queue(w, name, HotplugAction::Add, {});
+    }
+    for (const std::string& name : w.known) {
+        if (!present.count(name)) queue(w, name, HotplugAction::Remove, cancelJobsOn(name, true));
+    }
+    w.known = present;
+    logWarn("hotplug") << "uevent socket overflowed; rescanned " << present.size() << " disks";
+}
+
+void receive(Watcher& w) {
+    char buffer[UEVENT_MAX_SIZE];
+    for (;;) {
+        sockaddr_nl sender = sockaddr_nl();
+        iovec iov = {buffer, sizeof(buffer)};
+        msghdr msg = msghdr();
+        msg.msg_name = &sender;
+        msg.msg_namelen = sizeof(sender);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        ssize_t n = recvmsg(w.socketFd, &msg, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                resync(w);
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) logWarn("hotplug") << "uevent receive failed (error " << errno << ")";
+            return;
+        }
+        if (sender.nl_pid != 0) continue;       // Only the kernel, not another process
+        Uevent ev;
+        if (parseUevent(buffer, static_cast<size_t>(n), ev)) handle(w, ev);
+    }
+}
+
+// Milliseconds until the next pending disk has been quiet for the window; -1 for none
+int nextTimeout(const Watcher& w, unsigned debounceMs) {
+    if (w.pending.empty()) return -1;
+    Clock::time_point now = Clock::now();
+    int64_t soonest = INT32_MAX;
+    for (const auto& entry : w.pending) {
+        auto due = entry.second.last + std::chrono::milliseconds(debounceMs);
+        int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count() + 1;
+        if (ms < soonest) soonest = ms;
+    }
+    return soonest < 0 ? 0 : static_cast<int>(soonest);
+}
+
+void deliverDue(Watcher& w, unsigned debounceMs, const HotplugCallback& callback) {
+    Clock::time_point now = Clock::now();
+    for (auto it = w.pending.begin(); it != w.pending.end(); ) {
+        if (now - it->second.last < std::chrono::milliseconds(debounceMs)) {
+            ++it;
+            continue;
+        }
+        HotplugEvent event = std::move(it->second.event);
+        it = w.pending.erase(it);
+        if (event.action != HotplugAction::Remove) event.hasDevice = probeBlockDevice(event.name, event.device);
+        logInfo("hotplug") << "Device " << event.path << " " << hotplugActionName(event.action) << " ("
+                           << event.uevents << " uevents)";
+        if (callback) callback(event);
+    }
+}
+
+void watcherLoop() {
+    Watcher& w = watcher();
+    for (;;) {
+        unsigned debounceMs;
+        HotplugCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if (w.stopping) break;
+            debounceMs = w.debounceMs;
+            callback = w.callback;
+        }
+        deliverDue(w, debounceMs, callback);
+
+        pollfd fds[2] = {{w.socketFd, POLLIN, 0}, {w.wakeFds[0], POLLIN, 0}};
+        if (poll(fds, 2, nextTimeout(w, debounceMs)) < 0 && errno != EINTR) {
+            logError("hotplug") << "poll failed (error " << errno << "); watcher stopped";
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (read(w.wakeFds[0], drain, sizeof(drain)) > 0) {}
+        }
+        if (fds[0].revents & POLLIN) receive(w);
+    }
+}
+
+void closeFds(Watcher& w) {
+    for (int* fd : {&w.socketFd, &w.wakeFds[0], &w.wakeFds[1]}) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+}
+
+}
+
+bool startHotplugWatcher(HotplugCallback callback, unsigned debounceMs, std::string* error) {
+    Watcher& w = watcher();
+    std::lock_guard<std::mutex> lock(w.mutex);
+    w.callback = std::move(callback);
+    w.debounceMs = debounceMs > HOTPLUG_MAX_DEBOUNCE_MS ? HOTPLUG_MAX_DEBOUNCE_MS : debounceMs;
+    if (w.running) return true;
+
+    w.socketFd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    sockaddr_nl address = sockaddr_nl();
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1;          // Kernel uevents (udev rebroadcasts on group 2)
+    if (w.socketFd < 0 || bind(w.socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        pipe2(w.wakeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        if (error) *error = "Cannot listen for block device uevents (error " + std::to_string(errno) + ")";
+        closeFds(w);
+        w.callback = nullptr;
+        return false;
+    }
+    int size = UEVENT_RECEIVE_BUFFER;
+    if (setsockopt(w.socketFd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0) {
+        setsockopt(w.socketFd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    w.known = physicalDisks();
+    w.pending.clear();
+    w.running = true;
+    w.stopping = false;
+    w.thread = std::thread(watcherLoop);
+    logInfo("hotplug") << "Watching block device uevents (" << w.known.size() << " disks present, debounce "
+                       << w.debounceMs << " ms)";
+    return true;
+}
+
+void stopHotplugWatcher() {
+    Watcher& w = watcher();
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (!w.running) return;
+        w.stopping = true;
+    }
+    ssize_t woken = write(w.wakeFds[1], "x", 1);
+    (void)woken;
+    w.thread.join();
+
+    std::lock_guard<std::mutex> lock(w.mutex);
+    closeFds(w);
+    w.callback = nullptr;
+    w.running = false;
+}
+
+#else
+
+bool startHotplugWatcher(HotplugCallback, unsigned, std::string* error) {
+    if (error) *error = "Block device hotplug notifications are not supported on this platform";
+    return false;
+}
+
+void stopHotplugWatcher() {}
+
+#endif
+
+// Export for testing: parse synthetic uevents, match job targets, then watch
+// for real events for argv[1] seconds (plug a USB stick in and out)
+#ifdef TEST_STANDALONE
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv) {
+#ifdef __linux__
+    const char message[] = "remove@/devices/pci0000:00/usb1/1-1/host6/target6:0:0/6:0:0:0/block/sdb/sdb1\0"
+                           "ACTION=remove\0DEVPATH=/devices/pci0000:00/usb1/1-1/host6/target6:0:0/6:0:0:0/block/sdb/sdb1\0"
+                           "SUBSYSTEM=block\0DEVNAME=sdb1\0DEVTYPE=partition\0SEQNUM=4711\0MAJOR=8\0MINOR=17";
+    Uevent ev;
+    bool ok = parseUevent(message, sizeof(message), ev) && ev.action == "remove" && ev.devName == "sdb1" &&
+              ev.devType == "partition" && parentDisk(ev.devPath) == "sdb";
+    ok = ok && targetOn("/dev/sdb", "sdb", true) && targetOn("/dev/sdb12", "sdb", true) &&
+         !targetOn("/dev/sdba", "sdb", true) && !targetOn("/dev/sdb1", "sdb", false) &&
+         targetOn("/dev/nvme0n1p2", "nvme0n1", true) && !targetOn("/dev/nvme0n10", "nvme0n1", true);
+
+    JobRef job = startJob("usb-wipe", "/dev/sdb");
+    JobRef other = startJob("other-wipe", "/dev/sdc");
+    {
+        JobScope scope(job);
+        ok = ok && !currentJobCancelled();
+        ok = ok && cancelJobsOn("sdb", true) == std::vector<std::string>{"usb-wipe"};
+        ok = ok && currentJobCancelled() && job->cancelReason() == "Device /dev/sdb was removed" && !other->cancelled();
+    }
+    std::cout << "Parse/match/cancel: " << (ok ? "OK" : "FAIL") << std::endl;
+    if (!ok) return 1;
+#endif
+
+    int seconds = argc > 1 ? std::atoi(argv[1]) : 0;
+    if (seconds <= 0) return 0;
+    std::string error;
+    bool started = startHotplugWatcher([](const HotplugEvent& e) {
+        std::cout << hotplugActionName(e.action) << " " << e.path << " (" << e.uevents << " uevents)";
+        if (e.hasDevice) std::cout << " " << (e.device.size >> 20) << " MB " << e.device.model << " " << e.device.serial;
+        for (const std::string& id : e.cancelledJobs) std::cout << " cancelled " << id;
+        std::cout << std::endl;
+    }, HOTPLUG_DEFAULT_DEBOUNCE_MS, &error);
+    if (!started) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stopHotplugWatcher();
+    return 0;
+}
+#endif
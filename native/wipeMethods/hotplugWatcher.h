@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "deviceEnum.h"
+
+// Block device arrival and removal notifications.
+//
+// On Linux one background thread listens on a NETLINK_KOBJECT_UEVENT socket
+// for the kernel's block-subsystem uevents: no udev dependency and no polling,
+// the thread sleeps in poll() until the kernel sends something. Plugging in a
+// disk produces a burst (the disk, each partition, change events while the
+// partition table is read and udev settles), so events are coalesced per disk
+// and delivered once the disk has been quiet for the debounce window; an
+// arrival carries the disk's BlockDeviceInfo (deviceEnum.h). Partition events
+// count as a change of their disk.
+//
+// Removal is acted on at once, not after the debounce: every running job
+// whose target is the removed disk or one of its partitions is cancelled
+// (wipeJob.h), so the wipe stops before its next write instead of bisecting
+// failed writes against a device that is gone. Job targets are matched by
+// /dev name as the job was started with.
+//
+// If the socket buffer overflows during a large burst the watcher rescans
+// sysfs and synthesizes the arrivals and removals it missed.
+//
+// Elsewhere startHotplugWatcher() fails and callers keep re-listing devices.
+
+constexpr unsigned HOTPLUG_DEFAULT_DEBOUNCE_MS = 500;
+constexpr unsigned HOTPLUG_MAX_DEBOUNCE_MS = 10000;
+
+enum class HotplugAction : uint8_t {
+    Add,
+    Remove,
+    Change          // Media change, partition table change, resize
+};
+
+const char* hotplugActionName(HotplugAction action);
+
+struct HotplugEvent {
+    HotplugAction action;
+    std::string name;                       // Whole disk: "sdb", "nvme1n1"
+    std::string path;                       // "/dev/sdb"
+    uint32_t uevents;                       // Kernel uevents coalesced into this event
+    std::vector<std::string> cancelledJobs; // Jobs stopped because the device went away
+    bool hasDevice;                         // Add/Change: `device` was probed (false for empty media)
+    BlockDeviceInfo device;
+};
+
+// Runs on the watcher thread; must not call stopHotplugWatcher()
+using HotplugCallback = std::function<void(const HotplugEvent&)>;
+
+// Start the watcher, or replace the callback and debounce of the running
+// one. False with `error` set when uevents cannot be received.
+bool startHotplugWatcher(HotplugCallback callback, unsigned debounceMs, std::string* error);
+
+// Stop the thread; events still inside their debounce window are dropped.
+// No-op when not running.
+void stopHotplugWatcher();
@@ -0,0 +1,228 @@
+#include "ioStats.h"
+#include "wipeJob.h"
+#include "probes.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+// Index of the highest set bit (v != 0)
+static unsigned highestBit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return static_cast<unsigned>(index);
+#else
+    return 63 - static_cast<unsigned>(__builtin_clzll(v));
+#endif
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t ns) {
+    if (ns < SUB_BUCKETS) return static_cast<size_t>(ns);
+    unsigned exponent = highestBit(ns);
+    if (exponent > MAX_EXPONENT) return BUCKETS - 1;
+    unsigned shift = exponent - SUB_BUCKET_BITS;
+    size_t sub = static_cast<size_t>((ns >> shift) & (SUB_BUCKETS - 1));
+    return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketLow(size_t index) {
+    if (index < SUB_BUCKETS) return index;
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    return (static_cast<uint64_t>(SUB_BUCKETS) + index % SUB_BUCKETS) << shift;
+}
+
+uint64_t LatencyHistogram::bucketHigh(size_t index) {
+    if (index < SUB_BUCKETS) return index + 1;
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    return bucketLow(index) + (1ULL << shift);
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    counts[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t seen = minimum.load(std::memory_order_relaxed);
+    while (ns < seen && !minimum.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    seen = maximum.load(std::memory_order_relaxed);
+    while (ns > seen && !maximum.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+}
+
+uint64_t LatencyHistogram::minNs() const {
+    uint64_t value = minimum.load(std::memory_order_relaxed);
+    return value == UINT64_MAX ? 0 : value;
+}
+
+double LatencyHistogram::meanNs() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0;
+}
+
+uint64_t LatencyHistogram::percentileNs(double q) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * n));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Highest value the bucket can hold, clamped to what was observed
+            return std::min(bucketHigh(i) - 1, maxNs());
+        }
+    }
+    return maxNs();
+}
+
+std::vector<LatencyHistogram::Bucket> LatencyHistogram::nonEmptyBuckets() const {
+    std::vector<Bucket> buckets;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        uint64_t c = counts[i].load(std::memory_order_relaxed);
+        if (c) buckets.push_back(Bucket{bucketLow(i), bucketHigh(i), c});
+    }
+    return buckets;
+}
+
+ThroughputSeries::ThroughputSeries() :
+    start(std::chrono::steady_clock::now()),
+    intervalNs(1000000000ULL) {}
+
+void ThroughputSeries::record(uint64_t bytes) {
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    uint64_t index = elapsed / intervalNs.load(std::memory_order_relaxed);
+    if (index >= SERIES_SLOTS) {
+        fold(index);
+        index = elapsed / intervalNs.load(std::memory_order_relaxed);
+    }
+    slots[std::min<uint64_t>(index, SERIES_SLOTS - 1)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// Halve the resolution until `neededIndex` (at the old interval) fits
+void ThroughputSeries::fold(uint64_t neededIndex) {
+    std::lock_guard<std::mutex> lock(foldMutex);
+    uint64_t elapsed = neededIndex * intervalNs.load();
+    while (elapsed / intervalNs.load() >= SERIES_SLOTS) {
+        for (size_t i = 0; i < SERIES_SLOTS / 2; i++) {
+            uint64_t merged = slots[2 * i].exchange(0, std::memory_order_relaxed) +
+                              slots[2 * i + 1].exchange(0, std::memory_order_relaxed);
+            slots[i].fetch_add(merged, std::memory_order_relaxed);
+        }
+        intervalNs.store(intervalNs.load() * 2);
+    }
+}
+
+double ThroughputSeries::intervalSeconds() const {
+    return intervalNs.load(std::memory_order_relaxed) / 1e9;
+}
+
+std::vector<uint64_t> ThroughputSeries::bytesPerInterval() const {
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    size_t used = static_cast<size_t>(std::min<uint64_t>(elapsed / intervalNs.load(std::memory_order_relaxed) + 1, SERIES_SLOTS));
+    std::vector<uint64_t> series(used);
+    for (size_t i = 0; i < used; i++) series[i] = slots[i].load(std::memory_order_relaxed);
+    return series;
+}
+
+double ThroughputSeries::recentMBps(double windowSeconds) const {
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    uint64_t interval = intervalNs.load(std::memory_order_relaxed);
+    uint64_t current = std::min<uint64_t>(elapsed / interval, SERIES_SLOTS - 1);
+    if (current == 0) {
+        // Still inside the first interval: rate so far
+        return elapsed ? slots[0].load(std::memory_order_relaxed) / 1048576.0 / (elapsed / 1e9) : 0;
+    }
+    uint64_t window = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(windowSeconds * 1e9 / interval)));
+    window = std::min(window, current);
+    uint64_t bytes = 0;
+    for (uint64_t i = current - window; i < current; i++) bytes += slots[i].load(std::memory_order_relaxed);
+    return bytes / 1048576.0 / (window * interval / 1e9);
+}
+
+void IoStats::recordWrite(uint64_t ns, uint64_t bytes, bool ok) {
+    writeStats.latency.record(ns);
+    if (ok) {
+        writeStats.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        series.record(bytes);
+    } else {
+        writeStats.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void IoStats::recordRead(uint64_t ns, uint64_t bytes, bool ok) {
+    readStats.latency.record(ns);
+    if (ok) {
+        readStats.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    } else {
+        readStats.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+IoTimer::IoTimer(uint64_t offset, uint64_t bytes) :
+    offset(offset), bytes(bytes), start(std::chrono::steady_clock::now()) {
+    WIPE_PROBE(chunk__submit, probeJobId(), offset, bytes);
+}
+
+void IoTimer::complete(bool read, bool ok, uint32_t error) {
+    WipeJob* job = currentJob();
+    if (!job && !WIPE_PROBE_ENABLED(chunk__complete)) return;
+    auto now = std::chrono::steady_clock::now();
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+    WIPE_PROBE(chunk__complete, probeJobId(), offset, bytes, ok ? 0 : error, ns, read ? 1 : 0);
+    if (!job) return;
+    if (read) {
+        job->io().recordRead(ns, bytes, ok);
+    } else {
+        job->io().recordWrite(ns, bytes, ok);
+    }
+    if (IoTrace* trace = job->trace()) {
+        trace->record(read ? IoTraceOp::Read : IoTraceOp::Write, offset, bytes, ok, error, start, now);
+    }
+}
+
+void IoTimer::write(bool ok, uint32_t error) {
+    complete(false, ok, error);
+}
+
+void IoTimer::read(bool ok, uint32_t error) {
+    complete(true, ok, error);
+}
+
+// Export for testing: quantiles against the exact values of a known sample
+#ifdef TEST_STANDALONE
+#include <iostream>
+#include <random>
+#include <thread>
+
+int main() {
+    LatencyHistogram histogram;
+    std::vector<uint64_t> values;
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> latency(std::log(2e6), 0.8);     // ~2 ms median
+    for (int i = 0; i < 1000000; i++) values.push_back(static_cast<uint64_t>(latency(rng)));
+
+    // Four writers, as with concurrent jobs/stripes
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&, t] {
+            for (size_t i = t; i < values.size(); i += 4) histogram.record(values[i]);
+        });
+    }
+    for (std::thread& w : writers) w.join();
+
+    std::sort(values.begin(), values.end());
+    bool ok = histogram.count() == values.size();
+    for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        uint64_t exact = values[static_cast<size_t>(std::ceil(q * values.size())) - 1];
+        uint64_t estimate = histogram.percentileNs(q);
+        double error = std::abs(static_cast<double>(estimate) - exact) / exact;
+        ok = ok && error < 0.035;
+        std::cout << "p" << q * 100 << ": exact " << exact / 1000.0 << " us, histogram " << estimate / 1000.0
+                  << " us (" << error * 100 << "% off)" << std::endl;
+    }
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Per-job I/O statistics: latency histograms of every read and write
+// submission and a bytes-per-second throughput series.
+//
+// Recording is a handful of relaxed atomic adds, with no lock on the I/O path,
+// so it is always on. DeviceSession::readAt/writeAt and the file sinks record
+// against the thread's current job (wipeJob.h); retries and bisection writes
+// are counted individually.
+
+// Log-linear (HDR-style) histogram of nanosecond latencies: 32 linear
+// sub-buckets per power of two, so any reported quantile is within ~3% of
+// the true value. Covers 1 ns to ~18 minutes; longer values land in the
+// last bucket.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr unsigned MAX_EXPONENT = 40;
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    void record(uint64_t ns);
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t minNs() const;
+    uint64_t maxNs() const { return maximum.load(std::memory_order_relaxed); }
+    double meanNs() const;
+    uint64_t sumNs() const { return sum.load(std::memory_order_relaxed); }
+    uint64_t percentileNs(double q) const;     // q in [0, 1]
+
+    struct Bucket {
+        uint64_t lowNs;
+        uint64_t highNs;        // Exclusive
+        uint64_t count;
+    };
+    std::vector<Bucket> nonEmptyBuckets() const;
+
+    static size_t bucketIndex(uint64_t ns);
+    static uint64_t bucketLow(size_t index);
+    static uint64_t bucketHigh(size_t index);
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> minimum{UINT64_MAX};
+    std::atomic<uint64_t> maximum{0};
+};
+
+// Bytes completed per interval since the job started. Starts at one-second
+// resolution; when SERIES_SLOTS intervals are used, adjacent slots are folded
+// and the interval doubles (under a lock, once per doubling). A write racing a
+// fold may be credited to the neighbouring interval.
+class ThroughputSeries {
+public:
+    static constexpr size_t SERIES_SLOTS = 2048;
+
+    ThroughputSeries();
+    void record(uint64_t bytes);
+
+    double intervalSeconds() const;
+    std::vector<uint64_t> bytesPerInterval() const;     // Up to the current interval
+    double recentMBps(double windowSeconds) const;      // Over the last complete intervals
+
+private:
+    void fold(uint64_t neededIndex);
+
+    std::chrono::steady_clock::time_point start;
+    std::atomic<uint64_t> intervalNs;
+    std::atomic<uint64_t> slots[SERIES_SLOTS] = {};
+    std::mutex foldMutex;
+};
+
+struct IoDirectionStats {
+    LatencyHistogram latency;
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+class IoStats {
+public:
+    void recordWrite(uint64_t ns, uint64_t bytes, bool ok);
+    void recordRead(uint64_t ns, uint64_t bytes, bool ok);
+
+    const IoDirectionStats& writes() const { return writeStats; }
+    const IoDirectionStats& reads() const { return readStats; }
+    const ThroughputSeries& throughput() const { return series; }
+
+private:
+    IoDirectionStats writeStats;
+    IoDirectionStats readStats;
+    ThroughputSeries series;    // Written bytes only
+};
+
+// Times one I/O and records it against the current job on completion, and
+// into the job's I/O trace when one is attached (ioTrace.h). Nothing is
+// recorded outside a job. Also fires the chunk__submit/chunk__complete
+// probes (probes.h).
+class IoTimer {
+public:
+    IoTimer(uint64_t offset, uint64_t bytes);
+    void write(bool ok, uint32_t error = 0);
+    void read(bool ok, uint32_t error = 0);
+
+private:
+    void complete(bool read, bool ok, uint32_t error);
+
+    uint64_t offset;
+    uint64_t bytes;
+    std::chrono::steady_clock::time_point start;
+};
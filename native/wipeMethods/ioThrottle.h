@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Write throttling for wipes that share a host with production I/O.
+//
+// Bandwidth: a token bucket per job and one global bucket for every job in
+// the process. A writer takes tokens for each write before submitting it; a
+// write larger than the bucket may still go out and leaves the bucket in
+// debt, so chunk size never has to match the limit. Burst is the most an
+// idle bucket saves up. Both limits can change while writers wait: a waiter
+// re-checks at least every THROTTLE_RECHECK_MS and is woken on every change.
+//
+// I/O priority: a job may ask for the best-effort or idle ioprio class
+// (Linux, honoured by the BFQ and mq-deadline schedulers) or background
+// mode (Windows). Writer threads apply the job's current class before each
+// write, so a change reaches threads that are already running; a thread gets
+// its original priority back when it leaves the job.
+//
+// throttleWrite() is called outside the timed region of a write, so latency
+// histograms and the health monitor only ever see device time.
+
+constexpr unsigned THROTTLE_RECHECK_MS = 100;
+
+class TokenBucket {
+public:
+    TokenBucket();
+    TokenBucket(const TokenBucket&) = delete;
+    TokenBucket& operator=(const TokenBucket&) = delete;
+
+    // 0 bytes/s removes the limit. A burst of 0 defaults to one second at
+    // the new rate.
+    void setLimit(uint64_t bytesPerSecond, uint64_t burstBytes = 0);
+    uint64_t rate() const;
+    uint64_t burst() const;
+
+    // Take `bytes` tokens, waiting while the bucket is in debt. Returns the
+    // time spent waiting in nanoseconds.
+    uint64_t acquire(uint64_t bytes);
+
+private:
+    void refill(std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    uint64_t bytesPerSecond;
+    uint64_t burstBytes;
+    double tokens;              // Negative while in debt
+    std::chrono::steady_clock::time_point last;
+};
+
+// Shared by every job in the process
+TokenBucket& globalBandwidth();
+
+enum class IoPriorityClass : uint8_t {
+    Default,        // Inherited from the process
+    BestEffort,     // Level 0 (highest) to 7 (lowest)
+    Idle            // Only when the device is otherwise idle
+};
+
+struct IoPriority {
+    IoPriorityClass ioClass;
+    uint8_t level;
+};
+
+const char* ioPriorityClassName(IoPriorityClass ioClass);
+// "default", "best-effort", "idle"; false for anything else
+bool parseIoPriorityClass(const char* name, IoPriorityClass& ioClass);
+
+// Apply the current job's priority to the calling thread, then wait for
+// tokens from the job's bucket and the global one. Returns nanoseconds
+// spent waiting.
+uint64_t throttleWrite(uint64_t bytes);
+
+// Back to the priority the thread had before throttleWrite() first changed it
+void restoreThreadIoPriority();
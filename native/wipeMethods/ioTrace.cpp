@@ -0,0 +1,519 @@
+#include "ioTrace.h"
+#include "ioStats.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <thread>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <malloc.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <stdlib.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Replay buffers are aligned for unbuffered I/O on 4Kn drives
+constexpr size_t REPLAY_ALIGNMENT = 4096;
+
+std::atomic<uint16_t> nextStream{0};
+thread_local int threadStream = -1;
+
+uint16_t currentStream() {
+    if (threadStream < 0) threadStream = nextStream++;
+    return static_cast<uint16_t>(threadStream);
+}
+
+uint64_t sinceNs(Clock::time_point from, Clock::time_point to) {
+    return to > from ? std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count() : 0;
+}
+
+void copyName(char* field, size_t size, const std::string& value) {
+    std::memset(field, 0, size);
+    std::memcpy(field, value.data(), value.size() < size - 1 ? value.size() : size - 1);
+}
+
+}
+
+IoTrace::IoTrace(const std::string& path, const std::string& target, const std::string& job, uint64_t deviceSize,
+                 uint32_t logicalSector) :
+    filePath(path),
+    start(Clock::now()),
+    file(nullptr),
+    count(0),
+    writeFailed(false) {
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        openError = "cannot create trace " + path + ": " + std::strerror(errno);
+        return;
+    }
+    IoTraceHeader header = {};
+    std::memcpy(header.magic, IO_TRACE_MAGIC, sizeof(header.magic));
+    header.version = IO_TRACE_VERSION;
+    header.recordSize = sizeof(IoTraceRecord);
+    header.startUnixUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.deviceSize = deviceSize;
+    header.logicalSector = logicalSector;
+    copyName(header.target, sizeof(header.target), target);
+    copyName(header.job, sizeof(header.job), job);
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        openError = "cannot write trace header to " + path;
+        std::fclose(file);
+        file = nullptr;
+        return;
+    }
+    pending.reserve(IO_TRACE_BATCH);
+}
+
+IoTrace::~IoTrace() {
+    flush();
+    if (file) std::fclose(file);
+}
+
+uint64_t IoTrace::records() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+void IoTrace::record(IoTraceOp op, uint64_t offset, uint64_t length, bool ok, uint32_t error,
+                     Clock::time_point submit, Clock::time_point complete) {
+    if (!file) return;
+    IoTraceRecord r = {};
+    r.offset = offset;
+    r.submitNs = sinceNs(start, submit);
+    r.completeNs = sinceNs(start, complete);
+    r.length = static_cast<uint32_t>(length);
+    r.error = ok ? 0 : error;
+    r.stream = currentStream();
+    r.op = op;
+    r.flags = ok ? 0 : IO_TRACE_FAILED;
+
+    std::vector<IoTraceRecord> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(r);
+        count++;
+        if (pending.size() < IO_TRACE_BATCH) return;
+        batch.swap(pending);
+        pending.reserve(IO_TRACE_BATCH);
+    }
+    // Written outside `mutex` so other threads keep appending meanwhile
+    writeBatch(batch);
+}
+
+bool IoTrace::flush() {
+    if (!file) return false;
+    std::vector<IoTraceRecord> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.swap(pending);
+    }
+    writeBatch(batch);
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (std::fflush(file) != 0) writeFailed = true;
+    return !writeFailed;
+}
+
+void IoTrace::writeBatch(std::vector<IoTraceRecord>& batch) {
+    if (batch.empty()) return;
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (writeFailed) return;
+    if (std::fwrite(batch.data(), sizeof(IoTraceRecord), batch.size(), file) != batch.size()) writeFailed = true;
+}
+
+bool readIoTrace(const std::string& path, IoTraceHeader& header, std::vector<IoTraceRecord>& records,
+                 std::string* error) {
+    auto fail = [&](const std::string& message) {
+        if (error) *error = message;
+        return false;
+    };
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return fail("cannot open trace " + path + ": " + std::strerror(errno));
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> closer(f, std::fclose);
+
+    if (std::fread(&header, sizeof(header), 1, f) != 1) return fail(path + " is too short for a trace header");
+    if (std::memcmp(header.magic, IO_TRACE_MAGIC, sizeof(header.magic)) != 0) return fail(path + " is not an I/O trace");
+    if (header.version != IO_TRACE_VERSION) {
+        return fail(path + " is trace version " + std::to_string(header.version) + ", expected " +
+                    std::to_string(IO_TRACE_VERSION));
+    }
+    if (header.recordSize < sizeof(IoTraceRecord)) return fail(path + " has undersized trace records");
+
+    records.clear();
+    std::vector<uint8_t> raw(header.recordSize);
+    while (std::fread(raw.data(), raw.size(), 1, f) == 1) {
+        IoTraceRecord r;
+        std::memcpy(&r, raw.data(), sizeof(r));
+        records.push_back(r);
+    }
+    // A recording cut short (crash, full disk) leaves a partial last record; it is dropped
+    std::stable_sort(records.begin(), records.end(),
+                     [](const IoTraceRecord& a, const IoTraceRecord& b) { return a.submitNs < b.submitNs; });
+    return true;
+}
+
+bool writeIoTrace(const std::string& path, const IoTraceHeader& header, const std::vector<IoTraceRecord>& records,
+                  std::string* error) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        if (error) *error = "cannot create trace " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    IoTraceHeader out = header;
+    out.recordSize = sizeof(IoTraceRecord);     // Fields a newer writer added were dropped on reading
+    bool ok = std::fwrite(&out, sizeof(out), 1, f) == 1 &&
+        (records.empty() || std::fwrite(records.data(), sizeof(IoTraceRecord), records.size(), f) == records.size());
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok && error) *error = "cannot write trace " + path;
+    return ok;
+}
+
+namespace {
+
+struct ReplayBuffer {
+    explicit ReplayBuffer(size_t size) : ptr(nullptr) {
+        if (size == 0) return;
+        size = (size + REPLAY_ALIGNMENT - 1) / REPLAY_ALIGNMENT * REPLAY_ALIGNMENT;
+#ifdef _WIN32
+        ptr = static_cast<uint8_t*>(_aligned_malloc(size, REPLAY_ALIGNMENT));
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, REPLAY_ALIGNMENT, size) == 0) ptr = static_cast<uint8_t*>(p);
+#endif
+        if (ptr) std::memset(ptr, 0, size);
+    }
+    ~ReplayBuffer() {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+    ReplayBuffer(const ReplayBuffer&) = delete;
+    ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+
+    uint8_t* ptr;
+};
+
+// The replay target, one handle per stream: a synchronous Windows handle
+// serialises its I/O, and streams must overlap as they did when recorded
+class ReplayFile {
+public:
+    ReplayFile() {}
+    ~ReplayFile() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+#else
+        if (fd != -1) ::close(fd);
+#endif
+    }
+    ReplayFile(const ReplayFile&) = delete;
+    ReplayFile& operator=(const ReplayFile&) = delete;
+
+    // Unbuffered when asked for and the filesystem allows it, else buffered
+    bool open(const std::string& path, bool direct, uint32_t& error) {
+#ifdef _WIN32
+        DWORD flags = FILE_ATTRIBUTE_NORMAL;
+        if (direct) {
+            handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                 OPEN_ALWAYS, flags | FILE_FLAG_NO_BUFFERING, NULL);
+        }
+        if (handle == INVALID_HANDLE_VALUE) {
+            handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                 OPEN_ALWAYS, flags, NULL);
+        }
+        if (handle == INVALID_HANDLE_VALUE) error = GetLastError();
+        return handle != INVALID_HANDLE_VALUE;
+#else
+#ifdef O_DIRECT
+        if (direct) fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_DIRECT | O_CLOEXEC, 0600);
+#else
+        (void)direct;
+#endif
+        if (fd == -1) fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd == -1) error = errno;
+        return fd != -1;
+#endif
+    }
+
+    // Grow to the recorded device size, sparse, so reads past the end of a
+    // fresh file see zeros instead of EOF
+    bool reserve(uint64_t size, uint32_t& error) {
+#ifdef _WIN32
+        LARGE_INTEGER current;
+        if (!GetFileSizeEx(handle, &current)) {
+            error = GetLastError();
+            return false;
+        }
+        if (static_cast<uint64_t>(current.QuadPart) >= size) return true;
+        DWORD returned = 0;
+        DeviceIoControl(handle, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &returned, NULL);
+        FILE_END_OF_FILE_INFO end;
+        end.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFileInformationByHandle(handle, FileEndOfFileInfo, &end, sizeof(end))) {
+            error = GetLastError();
+            return false;
+        }
+        return true;
+#else
+        off_t current = lseek(fd, 0, SEEK_END);
+        if (current >= 0 && static_cast<uint64_t>(current) >= size) return true;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            error = errno;
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    bool io(IoTraceOp op, uint64_t offset, uint8_t* data, size_t len, uint32_t& error) {
+#ifdef _WIN32
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>(offset);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD done = 0;
+        BOOL ok = op == IoTraceOp::Write ? WriteFile(handle, data, static_cast<DWORD>(len), &done, &ov)
+                                         : ReadFile(handle, data, static_cast<DWORD>(len), &done, &ov);
+        if (ok && done == len) return true;
+        error = ok ? ERROR_HANDLE_EOF : GetLastError();
+        return false;
+#else
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = op == IoTraceOp::Write
+                ? pwrite(fd, data + done, len - done, static_cast<off_t>(offset + done))
+                : pread(fd, data + done, len - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                error = n < 0 ? errno : EIO;
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return true;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+ReplayLatency latencyOf(const LatencyHistogram& histogram) {
+    return ReplayLatency{histogram.percentileNs(0.5), histogram.percentileNs(0.99), histogram.maxNs()};
+}
+
+}
+
+ReplayResult replayIoTrace(const IoTraceHeader& header, const std::vector<IoTraceRecord>& records,
+                           const ReplayOptions& options) {
+    ReplayResult result = {};
+    result.replayed = records;
+    if (records.empty()) {
+        result.completed = true;
+        return result;
+    }
+
+    // Indices of each stream's records, in submit order
+    std::map<uint16_t, std::vector<size_t>> streams;
+    uint64_t firstSubmit = records.front().submitNs;
+    uint64_t lastComplete = 0;
+    uint64_t extent = header.deviceSize;    // 0 for file jobs: sized by the I/O instead
+    for (size_t i = 0; i < records.size(); i++) {
+        const IoTraceRecord& r = records[i];
+        if (r.offset + r.length > extent) extent = r.offset + r.length;
+        streams[r.stream].push_back(i);
+        if (r.submitNs < firstSubmit) firstSubmit = r.submitNs;
+        if (r.completeNs > lastComplete) lastComplete = r.completeNs;
+        result.bytes += r.length;
+        if (r.flags & IO_TRACE_FAILED) result.recordedFailures++;
+    }
+    result.ops = records.size();
+    result.streams = static_cast<unsigned>(streams.size());
+    result.recordedNs = lastComplete - firstSubmit;
+
+    bool emulated = options.target.empty();
+    if (!emulated) {
+        ReplayFile probe;
+        uint32_t error = 0;
+        if (!probe.open(options.target, options.direct, error) || !probe.reserve(extent, error)) {
+            result.error = "cannot prepare " + options.target + " (error " + std::to_string(error) + ")";
+            return result;
+        }
+    }
+
+    std::atomic<uint64_t> failures{0};
+    std::atomic<bool> openFailed{false};
+    Clock::time_point replayStart = Clock::now() + std::chrono::milliseconds(10);
+    std::vector<std::thread> threads;
+    for (auto& stream : streams) {
+        const std::vector<size_t>* indices = &stream.second;
+        threads.emplace_back([&, indices] {
+            ReplayFile file;
+            uint32_t openError = 0;
+            if (!emulated && !file.open(options.target, options.direct, openError)) {
+                openFailed = true;
+                return;
+            }
+            uint32_t largest = 0;
+            for (size_t i : *indices) {
+                if (records[i].length > largest) largest = records[i].length;
+            }
+            ReplayBuffer buffer(emulated ? 0 : largest);
+            if (!emulated && !buffer.ptr) {
+                openFailed = true;
+                return;
+            }
+
+            Clock::time_point due = replayStart;
+            for (size_t i : *indices) {
+                const IoTraceRecord& r = records[i];
+                if (options.speed > 0) {
+                    due = replayStart + std::chrono::nanoseconds(
+                        static_cast<uint64_t>((r.submitNs - firstSubmit) / options.speed));
+                    std::this_thread::sleep_until(due);
+                }
+                Clock::time_point submit = Clock::now();
+                bool ok;
+                uint32_t error = 0;
+                if (emulated) {
+                    // Answer as the recorded device did
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(r.completeNs - r.submitNs));
+                    ok = !(r.flags & IO_TRACE_FAILED);
+                    error = r.error;
+                } else {
+                    ok = file.io(r.op, r.offset, buffer.ptr, r.length, error);
+                }
+                Clock::time_point complete = Clock::now();
+
+                IoTraceRecord& out = result.replayed[i];
+                out.submitNs = sinceNs(replayStart, submit);
+                out.completeNs = sinceNs(replayStart, complete);
+                out.error = ok ? 0 : error;
+                out.flags = ok ? 0 : IO_TRACE_FAILED;
+                if (!ok) failures++;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    if (openFailed) {
+        result.error = "cannot open " + options.target + " for every stream";
+        return result;
+    }
+
+    // Latency distributions of both runs; the histograms are too large for the stack
+    auto recordedWrites = std::make_unique<LatencyHistogram>();
+    auto replayedWrites = std::make_unique<LatencyHistogram>();
+    auto recordedReads = std::make_unique<LatencyHistogram>();
+    auto replayedReads = std::make_unique<LatencyHistogram>();
+    uint64_t replayedEnd = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        const IoTraceRecord& before = records[i];
+        const IoTraceRecord& after = result.replayed[i];
+        bool write = before.op == IoTraceOp::Write;
+        (write ? recordedWrites : recordedReads)->record(before.completeNs - before.submitNs);
+        (write ? replayedWrites : replayedReads)->record(after.completeNs - after.submitNs);
+        if (after.completeNs > replayedEnd) replayedEnd = after.completeNs;
+    }
+    result.failures = failures;
+    result.replayedNs = replayedEnd;
+    result.recordedWrite = latencyOf(*recordedWrites);
+    result.replayedWrite = latencyOf(*replayedWrites);
+    result.recordedRead = latencyOf(*recordedReads);
+    result.replayedRead = latencyOf(*replayedReads);
+    result.completed = true;
+    return result;
+}
+
+// Export for testing: record a synthetic two-thread workload, read it back
+// and replay it against a file and the emulated device
+#ifdef TEST_STANDALONE
+#include <iostream>
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : "/tmp";
+    std::string tracePath = dir + "/iotrace-test.iotrace";
+    constexpr uint32_t CHUNK = 64 * 1024;
+    constexpr int PER_THREAD = 200;
+    {
+        IoTrace trace(tracePath, "/dev/test", "trace-test", 64ULL * 1024 * 1024, 512);
+        if (!trace.ok()) {
+            std::cerr << trace.error() << std::endl;
+            return 1;
+        }
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 2; t++) {
+            writers.emplace_back([&, t] {
+                for (int i = 0; i < PER_THREAD; i++) {
+                    Clock::time_point submit = Clock::now();
+                    std::this_thread::sleep_for(std::chrono::microseconds(t == 0 ? 200 : 500));
+                    uint64_t offset = (static_cast<uint64_t>(t) * PER_THREAD + i) * CHUNK;
+                    bool ok = !(t == 1 && i == 7);
+                    trace.record(i % 10 == 9 ? IoTraceOp::Read : IoTraceOp::Write, offset, CHUNK, ok, ok ? 0 : EIO,
+                                 submit, Clock::now());
+                }
+            });
+        }
+        for (std::thread& t : writers) t.join();
+        std::cout << "Recorded " << trace.records() << " I/Os" << std::endl;
+    }
+
+    IoTraceHeader header;
+    std::vector<IoTraceRecord> records;
+    std::string error;
+    if (!readIoTrace(tracePath, header, records, &error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    bool ok = records.size() == 2 * PER_THREAD && std::string(header.job) == "trace-test";
+    std::cout << (ok ? "OK" : "FAIL") << ": read " << records.size() << " records" << std::endl;
+
+    auto report = [&](const char* name, const ReplayResult& r) {
+        std::cout << name << ": completed=" << r.completed << " " << r.error << " ops=" << r.ops
+                  << " streams=" << r.streams << " failures=" << r.failures << "/" << r.recordedFailures
+                  << " recorded=" << r.recordedNs / 1000000 << "ms replayed=" << r.replayedNs / 1000000 << "ms"
+                  << " write p50 " << r.recordedWrite.p50Ns / 1000 << "us -> " << r.replayedWrite.p50Ns / 1000 << "us"
+                  << std::endl;
+    };
+
+    ReplayOptions emulatedOptions;
+    ReplayResult emulated = replayIoTrace(header, records, emulatedOptions);
+    report("emulated", emulated);
+    // The emulated device keeps the recorded timing and errors
+    bool emulatedOk = emulated.completed && emulated.failures == 1 && emulated.recordedFailures == 1 &&
+        emulated.replayedNs >= emulated.recordedNs * 9 / 10 && emulated.replayedWrite.p50Ns >= emulated.recordedWrite.p50Ns * 9 / 10;
+    std::cout << (emulatedOk ? "OK" : "FAIL") << ": emulated replay" << std::endl;
+
+    ReplayOptions fileOptions;
+    fileOptions.target = dir + "/iotrace-test.img";
+    fileOptions.speed = 0;
+    ReplayResult file = replayIoTrace(header, records, fileOptions);
+    report("file", file);
+    bool fileOk = file.completed && file.failures == 0 && file.streams == 2;
+    std::cout << (fileOk ? "OK" : "FAIL") << ": file replay" << std::endl;
+
+    // The replay written as a trace reads back as one
+    std::string replayPath = dir + "/iotrace-replay.iotrace";
+    IoTraceHeader replayHeader;
+    std::vector<IoTraceRecord> replayRecords;
+    bool writeOk = writeIoTrace(replayPath, header, file.replayed, &error) &&
+        readIoTrace(replayPath, replayHeader, replayRecords, &error) && replayRecords.size() == records.size();
+    std::cout << (writeOk ? "OK" : "FAIL") << ": replay written as a trace " << error << std::endl;
+
+    std::remove(tracePath.c_str());
+    std::remove(replayPath.c_str());
+    std::remove(fileOptions.target.c_str());
+    return ok && emulatedOk && fileOk && writeOk ? 0 : 1;
+}
+#endif
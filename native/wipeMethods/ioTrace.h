@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Binary I/O traces: record every I/O a job issues, replay them later.
+//
+// A slow wipe on a customer's drive can't be reproduced from its log. With a
+// trace attached (WipeJob::setTrace), IoTimer (ioStats.h) appends one
+// 40-byte record per device read and write the job issues: offset, length,
+// submit and complete time, result and the issuing thread. Retries and
+// bisection writes are separate records, as in the latency histograms.
+//
+// replayIoTrace() issues the same I/O again with the recorded timing, each
+// recorded thread on a thread of its own, against a file or an emulated
+// device that answers with the recorded latencies and errors, and compares
+// the latencies and throughput with the recording. Replaying a trace against
+// the same file under two engine versions, or the emulated device against
+// what the engine now does, shows where a regression comes from without the
+// customer's hardware.
+//
+// File layout: one IoTraceHeader, then IoTraceRecords in little-endian order
+// until the end of the file. Records are written in batches and are not
+// sorted across threads; readers sort by submit time.
+
+constexpr char IO_TRACE_MAGIC[8] = {'W', 'I', 'P', 'E', 'T', 'R', 'C', '1'};
+constexpr uint32_t IO_TRACE_VERSION = 1;
+constexpr size_t IO_TRACE_BATCH = 4096;     // Records buffered before a write to the file
+
+enum class IoTraceOp : uint8_t {
+    Write,
+    Read
+};
+
+constexpr uint8_t IO_TRACE_FAILED = 0x01;
+
+struct IoTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;        // sizeof(IoTraceRecord), so newer readers can skip added fields
+    uint64_t startUnixUs;       // Wall clock when recording started
+    uint64_t deviceSize;
+    uint32_t logicalSector;
+    uint32_t reserved;
+    char target[64];            // Device path, truncated, NUL-padded
+    char job[40];
+};
+static_assert(sizeof(IoTraceHeader) == 144, "trace header layout is part of the file format");
+
+struct IoTraceRecord {
+    uint64_t offset;
+    uint64_t submitNs;          // Since recording started
+    uint64_t completeNs;
+    uint32_t length;
+    uint32_t error;             // errno / GetLastError() of a failed I/O when known
+    uint16_t stream;            // Issuing thread (per-process number); its I/Os ran one after another
+    IoTraceOp op;
+    uint8_t flags;              // IO_TRACE_FAILED
+    uint8_t reserved[4];
+};
+static_assert(sizeof(IoTraceRecord) == 40, "trace record layout is part of the file format");
+
+// Trace being recorded to a file. record() is safe from any thread; it takes
+// a short lock to append and, every IO_TRACE_BATCH records, the recording
+// thread writes the batch.
+class IoTrace {
+public:
+    // Creates (truncates) `path`; check ok()
+    IoTrace(const std::string& path, const std::string& target, const std::string& job, uint64_t deviceSize,
+            uint32_t logicalSector);
+    ~IoTrace();             // Flushes and closes
+    IoTrace(const IoTrace&) = delete;
+    IoTrace& operator=(const IoTrace&) = delete;
+
+    bool ok() const { return file != nullptr; }
+    const std::string& error() const { return openError; }
+    const std::string& path() const { return filePath; }
+    uint64_t records() const;
+
+    void record(IoTraceOp op, uint64_t offset, uint64_t length, bool ok, uint32_t error,
+                std::chrono::steady_clock::time_point submit, std::chrono::steady_clock::time_point complete);
+    bool flush();
+
+private:
+    void writeBatch(std::vector<IoTraceRecord>& batch);
+
+    std::string filePath;
+    std::string openError;
+    std::chrono::steady_clock::time_point start;
+    std::FILE* file;
+    mutable std::mutex mutex;
+    std::mutex fileMutex;       // Held while a batch is written; taken after `mutex` is released
+    std::vector<IoTraceRecord> pending;
+    uint64_t count;
+    bool writeFailed;
+};
+
+using IoTraceRef = std::shared_ptr<IoTrace>;
+
+// Read a whole trace; records sorted by submit time. False with `error` set
+// for a missing, truncated or foreign file.
+bool readIoTrace(const std::string& path, IoTraceHeader& header, std::vector<IoTraceRecord>& records,
+                 std::string* error);
+
+// Write `records` under `header` as a trace file, e.g. a replay to compare
+// against its recording
+bool writeIoTrace(const std::string& path, const IoTraceHeader& header, const std::vector<IoTraceRecord>& records,
+                  std::string* error);
+
+struct ReplayOptions {
+    std::string target;         // File to replay against; empty = emulated device
+    double speed = 1;           // Submit times are divided by this; 0 = each stream back to back
+    bool direct = true;         // Unbuffered file I/O (O_DIRECT / FILE_FLAG_NO_BUFFERING) when the file allows it
+};
+
+struct ReplayLatency {
+    uint64_t p50Ns;
+    uint64_t p99Ns;
+    uint64_t maxNs;
+};
+
+struct ReplayResult {
+    bool completed;
+    std::string error;
+    uint64_t ops;
+    uint64_t bytes;
+    unsigned streams;
+    uint64_t recordedFailures;
+    uint64_t failures;          // Replayed I/Os that failed
+    uint64_t recordedNs;        // First submit to last completion
+    uint64_t replayedNs;
+    ReplayLatency recordedWrite, replayedWrite;
+    ReplayLatency recordedRead, replayedRead;
+    std::vector<IoTraceRecord> replayed;    // The replay as a trace, in the order of `records`
+};
+
+ReplayResult replayIoTrace(const IoTraceHeader& header, const std::vector<IoTraceRecord>& records,
+                           const ReplayOptions& options);
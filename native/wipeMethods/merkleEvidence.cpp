@@ -0,0 +1,764 @@
+#include "merkleEvidence.h"
+#include "patternLibrary.h"
+#include "numaPlacement.h"
+#include "ioStats.h"
+#include "wipeJob.h"
+#include "telemetry.h"
+#include "probes.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Progress is reported every 1GB read, as by the writers
+constexpr uint64_t VERIFY_PROGRESS_STEP = 1024ULL * 1024 * 1024;
+// An overlapped read-back looks for newly written regions this often
+constexpr auto OVERLAP_POLL = std::chrono::milliseconds(20);
+constexpr char EVIDENCE_MAGIC[8] = {'W', 'I', 'P', 'E', 'M', 'R', 'K', '1'};
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+Sha256::Sha256() :
+    state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+    buffered(0),
+    length(0) {}
+
+void Sha256::compress(const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = static_cast<uint32_t>(block[i * 4]) << 24 | static_cast<uint32_t>(block[i * 4 + 1]) << 16 |
+               static_cast<uint32_t>(block[i * 4 + 2]) << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256::update(const uint8_t* data, size_t len) {
+    length += len;
+    if (buffered) {
+        size_t take = 64 - buffered < len ? 64 - buffered : len;
+        memcpy(buffer + buffered, data, take);
+        buffered += take;
+        data += take;
+        len -= take;
+        if (buffered < 64) return;
+        compress(buffer);
+        buffered = 0;
+    }
+    for (; len >= 64; data += 64, len -= 64) compress(data);
+    memcpy(buffer, data, len);
+    buffered = len;
+}
+
+Digest Sha256::finish() {
+    uint64_t bits = length * 8;
+    uint8_t pad[72] = {0x80};
+    size_t padLength = (buffered < 56 ? 56 : 120) - buffered;
+    for (int i = 0; i < 8; i++) pad[padLength + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    update(pad, padLength + 8);
+
+    Digest digest;
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+    }
+    return digest;
+}
+
+std::string digestHex(const Digest& digest) {
+    static const char hex[] = "0123456789abcdef";
+    std::string out;
+    for (uint8_t b : digest) {
+        out += hex[b >> 4];
+        out += hex[b & 0xF];
+    }
+    return out;
+}
+
+bool parseDigestHex(const std::string& hex, Digest& digest) {
+    if (hex.size() != DIGEST_SIZE * 2) return false;
+    for (size_t i = 0; i < DIGEST_SIZE; i++) {
+        unsigned value = 0;
+        for (size_t j = 0; j < 2; j++) {
+            char c = hex[i * 2 + j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') value |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') value |= static_cast<unsigned>(c - 'A' + 10);
+            else return false;
+        }
+        digest[i] = static_cast<uint8_t>(value);
+    }
+    return true;
+}
+
+uint64_t merkleRegionSize(uint64_t deviceSize) {
+    uint64_t region = MERKLE_MIN_REGION;
+    while ((deviceSize + region - 1) / region > MERKLE_MAX_LEAVES) region *= 2;
+    return region;
+}
+
+Digest merkleNode(const Digest& left, const Digest& right) {
+    const uint8_t prefix = 0x01;
+    Sha256 hash;
+    hash.update(&prefix, 1);
+    hash.update(left.data(), left.size());
+    hash.update(right.data(), right.size());
+    return hash.finish();
+}
+
+static std::vector<Digest> nextLevel(const std::vector<Digest>& level) {
+    std::vector<Digest> up;
+    for (size_t i = 0; i < level.size(); i += 2) {
+        up.push_back(i + 1 < level.size() ? merkleNode(level[i], level[i + 1]) : level[i]);
+    }
+    return up;
+}
+
+Digest merkleRoot(const std::vector<Digest>& leaves) {
+    if (leaves.empty()) return Sha256().finish();
+    std::vector<Digest> level = leaves;
+    while (level.size() > 1) level = nextLevel(level);
+    return level[0];
+}
+
+std::vector<Digest> merkleProof(const std::vector<Digest>& leaves, size_t index) {
+    std::vector<Digest> proof;
+    std::vector<Digest> level = leaves;
+    while (level.size() > 1) {
+        size_t sibling = index ^ 1;
+        if (sibling < level.size()) proof.push_back(level[sibling]);
+        level = nextLevel(level);
+        index /= 2;
+    }
+    return proof;
+}
+
+bool merkleProofValid(const Digest& leaf, size_t index, size_t leafCount, const std::vector<Digest>& proof,
+                      const Digest& root) {
+    if (index >= leafCount) return false;
+    Digest node = leaf;
+    size_t used = 0;
+    for (size_t width = leafCount; width > 1; width = (width + 1) / 2, index /= 2) {
+        size_t sibling = index ^ 1;
+        if (sibling >= width) continue;         // Carried up
+        if (used == proof.size()) return false;
+        node = index & 1 ? merkleNode(proof[used], node) : merkleNode(node, proof[used]);
+        used++;
+    }
+    return used == proof.size() && node == root;
+}
+
+static void putU64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+static uint64_t getU64(const uint8_t* data) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) value = value << 8 | data[i];
+    return value;
+}
+
+std::vector<uint8_t> serializeEvidence(const MerkleEvidence& evidence) {
+    std::vector<uint8_t> out(EVIDENCE_MAGIC, EVIDENCE_MAGIC + sizeof(EVIDENCE_MAGIC));
+    putU64(out, evidence.deviceSize);
+    putU64(out, evidence.regionSize);
+    putU64(out, evidence.leaves.size());
+    for (const Digest& leaf : evidence.leaves) out.insert(out.end(), leaf.begin(), leaf.end());
+    return out;
+}
+
+bool parseEvidence(const uint8_t* data, size_t len, MerkleEvidence& evidence) {
+    const size_t header = sizeof(EVIDENCE_MAGIC) + 24;
+    if (len < header || memcmp(data, EVIDENCE_MAGIC, sizeof(EVIDENCE_MAGIC)) != 0) return false;
+    uint64_t deviceSize = getU64(data + 8);
+    uint64_t regionSize = getU64(data + 16);
+    uint64_t count = getU64(data + 24);
+    if (regionSize == 0 || count != (deviceSize + regionSize - 1) / regionSize ||
+        count > (len - header) / DIGEST_SIZE || len != header + count * DIGEST_SIZE) {
+        return false;
+    }
+
+    evidence.deviceSize = deviceSize;
+    evidence.regionSize = regionSize;
+    evidence.leaves.resize(static_cast<size_t>(count));
+    for (size_t i = 0; i < evidence.leaves.size(); i++) {
+        memcpy(evidence.leaves[i].data(), data + header + i * DIGEST_SIZE, DIGEST_SIZE);
+    }
+    evidence.root = merkleRoot(evidence.leaves);
+    return true;
+}
+
+namespace {
+
+// Reads regions past the page cache and hashes them into leaves. Shared by
+// the threads of one build or check; each thread has its own buffer (and on
+// Windows its own handle, since a synchronous handle serializes its reads).
+class RegionReader {
+public:
+    RegionReader(DeviceSession& session, uint64_t regionSize) :
+        session(session), regionSize(regionSize), bytesRead(0), aborted(false), error(0) {
+#ifndef _WIN32
+        fd = open(session.path.c_str(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+        ownsFd = fd != -1;
+        if (!ownsFd) {
+            logWarn("verify") << "O_DIRECT open failed (errno " << errno << "), dropping cached pages instead";
+            fd = session.fd;
+#ifdef POSIX_FADV_DONTNEED
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+        }
+#endif
+    }
+
+    ~RegionReader() {
+#ifndef _WIN32
+        if (ownsFd) ::close(fd);
+#endif
+    }
+
+    // Run `visit(index, leaf, matched, unreadable)` for every region `pick`
+    // hands out, on `threads` threads
+    template <typename Pick, typename Visit>
+    bool run(unsigned threads, int expectedByte, Pick pick, Visit visit) {
+        JobRef job = currentJobRef();
+        int numaNode = session.numaNode;
+        passStart = std::chrono::steady_clock::now();
+        std::vector<std::thread> readers;
+        for (unsigned t = 0; t < (threads ? threads : 1); t++) {
+            readers.emplace_back([&] {
+                JobScope scope(job);
+                NumaScope numa(numaNode);
+                Thread self(session);
+                if (!self.buffer) {
+                    stop(ENOMEM);
+                    return;
+                }
+                uint64_t index;
+                while (!aborted && pick(index)) {
+                    Digest leaf;
+                    int result = hashRegion(self, index, expectedByte, leaf);
+                    if (result < 0) return;
+                    visit(index, leaf, result == 1, result == 2);
+                }
+            });
+        }
+        for (std::thread& t : readers) t.join();
+        return !aborted;
+    }
+
+    uint64_t read() const { return bytesRead; }
+    uint32_t lastError() const { return error; }
+
+private:
+    struct Thread {
+        explicit Thread(DeviceSession& session) : buffer(acquireScratchBuffer(MERKLE_READ_CHUNK, currentNumaNode())) {
+#ifdef _WIN32
+            handle = CreateFileA(session.path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                 OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+            if (handle == INVALID_HANDLE_VALUE) buffer.reset();
+#else
+            (void)session;
+#endif
+            if (WipeJob* job = currentJob()) {
+                if (buffer) job->addPrivateBytes(static_cast<int64_t>(buffer->size()));
+            }
+        }
+        ~Thread() {
+            if (WipeJob* job = currentJob()) {
+                if (buffer) job->addPrivateBytes(-static_cast<int64_t>(buffer->size()));
+            }
+#ifdef _WIN32
+            if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+#endif
+        }
+        ScratchRef buffer;
+#ifdef _WIN32
+        HANDLE handle = INVALID_HANDLE_VALUE;
+#endif
+    };
+
+    bool readAt(Thread& self, uint64_t offset, uint8_t* data, size_t len, uint32_t& result) {
+        IoTimer timer(offset, len);
+#ifdef _WIN32
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>(offset);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        bool ok = ReadFile(self.handle, data, static_cast<DWORD>(len), &got, &ov) && got == len;
+        if (!ok) result = got == len ? GetLastError() : ERROR_HANDLE_EOF;
+#else
+        (void)self;
+        bool ok = true;
+        size_t done = 0;
+        while (done < len) {
+            ssize_t got = pread(fd, data + done, len - done, static_cast<off_t>(offset + done));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                result = got < 0 ? errno : EIO;
+                ok = false;
+                break;
+            }
+            done += static_cast<size_t>(got);
+        }
+#endif
+        timer.read(ok, ok ? 0 : result);
+        return ok;
+    }
+
+    // 0: read, 1: read and every byte is expectedByte, 2: unreadable
+    // (all-zero leaf), -1: failed for a reason other than the medium
+    int hashRegion(Thread& self, uint64_t index, int expectedByte, Digest& leaf) {
+        const uint64_t offset = index * regionSize;
+        const uint64_t length = offset + regionSize < session.size ? regionSize : session.size - offset;
+        const uint8_t prefix = 0x00;
+        uint8_t position[16];
+        for (int i = 0; i < 8; i++) {
+            position[i] = static_cast<uint8_t>(offset >> (8 * i));
+            position[8 + i] = static_cast<uint8_t>(length >> (8 * i));
+        }
+        Sha256 hash;
+        hash.update(&prefix, 1);
+        hash.update(position, sizeof(position));
+
+        bool matches = expectedByte >= 0;
+        uint8_t* data = self.buffer->data();
+        for (uint64_t done = 0; done < length && !aborted; ) {
+            size_t n = static_cast<size_t>(length - done < MERKLE_READ_CHUNK ? length - done : MERKLE_READ_CHUNK);
+            uint32_t result = 0;
+            if (!readAt(self, offset + done, data, n, result)) {
+                if (!isMediaError(result)) {
+                    stop(result);
+                    return -1;
+                }
+                emitEvent(TelemetryEvent::BadRange, "verify", "Unreadable region " + std::to_string(index) +
+                          " at offset " + std::to_string(offset + done) + " (error " + std::to_string(result) + ")",
+                          offset, length, result);
+                leaf.fill(0);
+                return 2;
+            }
+            hash.update(data, n);
+            // Equal to its own shift by one byte, and the first byte matches
+            matches = matches && data[0] == static_cast<uint8_t>(expectedByte) && memcmp(data, data + 1, n - 1) == 0;
+            addProgress(n);
+            done += n;
+        }
+        if (aborted) return -1;
+        leaf = hash.finish();
+        return matches ? 1 : 0;
+    }
+
+    void addProgress(uint64_t bytes) {
+        uint64_t before = bytesRead.fetch_add(bytes);
+        uint64_t after = before + bytes;
+        if (before / VERIFY_PROGRESS_STEP == after / VERIFY_PROGRESS_STEP) return;
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+        double readMB = after / 1024.0 / 1024.0;
+        int speed = static_cast<int>(readMB / (elapsed > 0 ? elapsed : 1));
+        std::ostringstream line;
+        line << "Verified " << static_cast<int>(readMB) << " MB - Speed: " << speed << " MB/s";
+        emitEvent(TelemetryEvent::Progress, "verify", line.str(), after, session.size, speed);
+    }
+
+    void stop(uint32_t result) {
+        if (!aborted.exchange(true)) {
+            error = result;
+            logError("verify") << "Read-back failed (error " << result << ")";
+        }
+    }
+
+    DeviceSession& session;
+    const uint64_t regionSize;
+#ifndef _WIN32
+    int fd;
+    bool ownsFd;
+#endif
+    std::atomic<uint64_t> bytesRead;
+    std::atomic<bool> aborted;
+    std::atomic<uint32_t> error;
+    std::chrono::steady_clock::time_point passStart;
+};
+
+}
+
+namespace {
+
+// Leaves of a build being read back: stores each leaf, credits verified
+// bytes to the job and lists the regions that failed
+class LeafCollector {
+public:
+    LeafCollector(const DeviceSession& session, MerkleEvidence& evidence, EvidenceResult& result, int expectedByte) :
+        size(session.size), evidence(evidence), result(result), expectedByte(expectedByte) {
+        evidence.deviceSize = session.size;
+        evidence.regionSize = merkleRegionSize(session.size);
+        evidence.leaves.assign(static_cast<size_t>(count()), Digest{});
+    }
+
+    uint64_t count() const { return (size + evidence.regionSize - 1) / evidence.regionSize; }
+    uint64_t length(uint64_t index) const {
+        uint64_t offset = index * evidence.regionSize;
+        return offset + evidence.regionSize < size ? evidence.regionSize : size - offset;
+    }
+
+    void operator()(uint64_t index, const Digest& leaf, bool matched, bool unreadable) {
+        evidence.leaves[static_cast<size_t>(index)] = leaf;
+        if (matched) {
+            if (WipeJob* job = currentJob()) job->addVerifiedBytes(length(index));
+        }
+        if (unreadable || (expectedByte >= 0 && !matched)) {
+            if (!unreadable) WIPE_PROBE(verify__mismatch, probeJobId(), index * evidence.regionSize, length(index));
+            std::lock_guard<std::mutex> lock(listMutex);
+            (unreadable ? result.unreadable : result.mismatched).push_back(index);
+        }
+    }
+
+    void finish(const RegionReader& reader, std::chrono::steady_clock::time_point start) {
+        result.error = reader.lastError();
+        result.bytesRead = reader.read();
+        result.regionsChecked = result.completed ? count() : 0;
+        std::sort(result.mismatched.begin(), result.mismatched.end());
+        std::sort(result.unreadable.begin(), result.unreadable.end());
+        evidence.root = merkleRoot(evidence.leaves);
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        logInfo("verify") << "Read-back " << (result.completed ? "completed" : "failed") << " in "
+                          << static_cast<int>(elapsed) << " seconds: root " << digestHex(evidence.root) << ", "
+                          << result.mismatched.size() << " mismatched, " << result.unreadable.size() << " unreadable";
+    }
+
+private:
+    const uint64_t size;
+    MerkleEvidence& evidence;
+    EvidenceResult& result;
+    const int expectedByte;
+    std::mutex listMutex;
+};
+
+}
+
+EvidenceResult buildEvidence(DeviceSession& session, MerkleEvidence& evidence, int expectedByte, unsigned threads) {
+    EvidenceResult result;
+    LeafCollector leaves(session, evidence, result, expectedByte);
+    const uint64_t count = leaves.count();
+    logInfo("verify") << "Reading back " << count << " regions of " << (evidence.regionSize >> 20) << " MB on "
+                      << threads << " threads";
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> cursor{0};
+    RegionReader reader(session, evidence.regionSize);
+    result.completed = reader.run(
+        threads, expectedByte,
+        [&](uint64_t& index) { return (index = cursor++) < count; },
+        [&](uint64_t index, const Digest& leaf, bool matched, bool unreadable) { leaves(index, leaf, matched, unreadable); });
+    leaves.finish(reader, start);
+    return result;
+}
+
+struct OverlappedEvidence::State {
+    State(DeviceSession& session, int expectedByte, uint64_t lagBytes) :
+        session(session),
+        expectedByte(expectedByte),
+        lag(lagBytes),
+        job(currentJobRef()),
+        leaves(session, evidence, result, expectedByte),
+        reader(session, evidence.regionSize),
+        start(std::chrono::steady_clock::now()) {}
+
+    // Queue every region of the last pass that is written, together with the
+    // lag window after it; everything once the wipe has returned. Queued
+    // regions are kept as spans whose ends only move forward, so each written
+    // range costs one lookup and only regions past its span's frontier are
+    // tested. Caller holds the mutex.
+    void refresh() {
+        const uint64_t regionSize = evidence.regionSize;
+        const uint64_t count = leaves.count();
+        if (writeDone) {
+            enqueue(0, count);
+            return;
+        }
+        WipeJob* j = job.get();
+        if (!j || j->passCount() == 0 || j->currentPass() != j->passCount()) return;
+        j->visitWrittenRanges([&](const BadRange& range) {
+            // Region i is ready once the range covers it plus the lag, or
+            // reaches the end of the device
+            const uint64_t end = range.offset + range.length;
+            uint64_t last = end >= session.size ? count : end > lag ? (end - lag) / regionSize : 0;
+            if (last > count) last = count;
+            enqueue((range.offset + regionSize - 1) / regionSize, last);
+        });
+    }
+
+    // Queue regions [first, last) that are not queued yet
+    void enqueue(uint64_t first, uint64_t last) {
+        if (first >= last) return;
+        // The span holding or ending at `first`, else a new empty one there
+        auto it = spans.upper_bound(first);
+        if (it == spans.begin() || std::prev(it)->second < first) {
+            it = spans.emplace_hint(it, first, first);
+        } else {
+            --it;
+        }
+        // Advance its frontier to `last`, absorbing the spans it reaches
+        while (it->second < last) {
+            auto next = std::next(it);
+            uint64_t gapEnd = next != spans.end() && next->first < last ? next->first : last;
+            for (uint64_t i = it->second; i < gapEnd; i++) ready.push_back(i);
+            it->second = gapEnd;
+            if (next != spans.end() && next->first == gapEnd) {
+                it->second = next->second;
+                spans.erase(next);
+            }
+        }
+    }
+
+    bool pick(uint64_t& index) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!abandoned) {
+            refresh();
+            if (!ready.empty()) {
+                index = ready.front();
+                ready.pop_front();
+                if (!writeDone) early += leaves.length(index);
+                return true;
+            }
+            if (writeDone) return false;
+            wake.wait_for(lock, OVERLAP_POLL);
+        }
+        return false;
+    }
+
+    DeviceSession& session;
+    const int expectedByte;
+    const uint64_t lag;
+    JobRef job;
+    MerkleEvidence evidence;
+    EvidenceResult result;
+    LeafCollector leaves;
+    std::map<uint64_t, uint64_t> spans;     // Queued regions, first -> end; guarded by mutex
+    std::deque<uint64_t> ready;
+    bool writeDone = false;
+    bool abandoned = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<uint64_t> early{0};
+    RegionReader reader;
+    std::chrono::steady_clock::time_point start;
+    std::thread runner;
+};
+
+OverlappedEvidence::OverlappedEvidence(DeviceSession& session, int expectedByte, unsigned threads, uint64_t lagBytes) :
+    state(new State(session, expectedByte, lagBytes)) {
+    logInfo("verify") << "Reading back " << state->leaves.count() << " regions of " << (state->evidence.regionSize >> 20)
+                      << " MB on " << threads << " threads, " << (lagBytes >> 20) << " MB behind the last pass";
+    State* s = state.get();
+    s->runner = std::thread([s, threads] {
+        JobScope scope(s->job);
+        s->result.completed = s->reader.run(
+            threads, s->expectedByte,
+            [s](uint64_t& index) { return s->pick(index); },
+            [s](uint64_t index, const Digest& leaf, bool matched, bool unreadable) {
+                s->leaves(index, leaf, matched, unreadable);
+            });
+    });
+}
+
+OverlappedEvidence::~OverlappedEvidence() {
+    if (!state->runner.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->abandoned = true;
+    }
+    state->wake.notify_all();
+    state->runner.join();
+    logWarn("verify") << "Overlapped read-back abandoned";
+}
+
+EvidenceResult OverlappedEvidence::finish(MerkleEvidence& evidence) {
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->writeDone = true;
+    }
+    state->wake.notify_all();
+    state->runner.join();
+    state->leaves.finish(state->reader, state->start);
+    logInfo("verify") << (state->early.load() >> 20) << " MB of " << (state->result.bytesRead >> 20)
+                      << " MB read back while the last pass was writing";
+    evidence = std::move(state->evidence);
+    return state->result;
+}
+
+uint64_t OverlappedEvidence::overlappedBytes() const {
+    return state->early;
+}
+
+// Bytes of region `index`; the last region may be short
+static inline uint64_t regionLength(const MerkleEvidence& evidence, uint64_t index) {
+    uint64_t left = evidence.deviceSize - index * evidence.regionSize;
+    return left < evidence.regionSize ? left : evidence.regionSize;
+}
+
+EvidenceResult checkEvidence(DeviceSession& session, const MerkleEvidence& evidence,
+                             const std::vector<uint64_t>& regions, unsigned threads) {
+    EvidenceResult result;
+    if (evidence.deviceSize != session.size) {
+        logError("verify") << "Device is " << session.size << " bytes, the evidence covers " << evidence.deviceSize;
+        result.error = EINVAL;
+        return result;
+    }
+
+    std::atomic<size_t> cursor{0};
+    std::mutex listMutex;
+    RegionReader reader(session, evidence.regionSize);
+    result.completed = reader.run(
+        threads, -1,
+        [&](uint64_t& index) {
+            // Out-of-range indices are skipped
+            for (size_t i = cursor++; i < regions.size(); i = cursor++) {
+                if (regions[i] < evidence.leaves.size()) {
+                    index = regions[i];
+                    return true;
+                }
+            }
+            return false;
+        },
+        [&](uint64_t index, const Digest& leaf, bool, bool unreadable) {
+            std::lock_guard<std::mutex> lock(listMutex);
+            result.regionsChecked++;
+            if (leaf != evidence.leaves[static_cast<size_t>(index)]) {
+                if (!unreadable) {
+                    WIPE_PROBE(verify__mismatch, probeJobId(), index * evidence.regionSize, regionLength(evidence, index));
+                }
+                (unreadable ? result.unreadable : result.mismatched).push_back(index);
+            }
+        });
+    result.error = reader.lastError();
+    result.bytesRead = reader.read();
+    std::sort(result.mismatched.begin(), result.mismatched.end());
+    std::sort(result.unreadable.begin(), result.unreadable.end());
+    return result;
+}
+
+// Export for testing: SHA-256 and proof vectors, then build evidence for a
+// file, change one byte, and check a sample finds the region
+#ifdef TEST_STANDALONE
+#include <iostream>
+#include <fstream>
+#include "passEngine.h"
+
+int main(int argc, char** argv) {
+    Sha256 abc;
+    abc.update(reinterpret_cast<const uint8_t*>("abc"), 3);
+    bool ok = digestHex(abc.finish()) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+    std::cout << "SHA-256(\"abc\"): " << (ok ? "ok" : "wrong") << std::endl;
+
+    std::vector<Digest> leaves(7);
+    for (size_t i = 0; i < leaves.size(); i++) leaves[i].fill(static_cast<uint8_t>(i + 1));
+    Digest root = merkleRoot(leaves);
+    for (size_t i = 0; i < leaves.size(); i++) ok = ok && merkleProofValid(leaves[i], i, leaves.size(), merkleProof(leaves, i), root);
+    ok = ok && !merkleProofValid(leaves[1], 2, leaves.size(), merkleProof(leaves, 2), root);
+    std::cout << "Proofs over 7 leaves: " << (ok ? "ok" : "wrong") << std::endl;
+
+    if (argc < 2) {
+        std::cout << "Usage: merkleEvidence <scratch file>" << std::endl;
+        return ok ? 0 : 1;
+    }
+    const uint64_t size = 40ULL * 1024 * 1024 + 4096;
+    {
+        std::ofstream file(argv[1], std::ios::binary | std::ios::trunc);
+        std::vector<char> zeros(1024 * 1024, 0);
+        for (uint64_t done = 0; done < size; done += zeros.size()) {
+            file.write(zeros.data(), static_cast<std::streamsize>(size - done < zeros.size() ? size - done : zeros.size()));
+        }
+    }
+    std::shared_ptr<DeviceSession> session = openDeviceSession(argv[1]);
+    JobRef job = startJob("verify-test", session->path);
+    JobScope scope(job, true);
+
+    MerkleEvidence evidence;
+    EvidenceResult built = buildEvidence(*session, evidence, 0x00, 4);
+    ok = ok && built.completed && built.mismatched.empty() && evidence.leaves.size() == 41 &&
+         job->verifiedBytes() == size;
+    std::vector<uint8_t> bytes = serializeEvidence(evidence);
+    MerkleEvidence loaded;
+    ok = ok && parseEvidence(bytes.data(), bytes.size(), loaded) && loaded.root == evidence.root;
+    std::cout << "Built " << evidence.leaves.size() << " leaves, root " << digestHex(evidence.root) << std::endl;
+
+    // One flipped byte in region 17 is caught by checking it, and only it
+    uint8_t one = 1;
+    session->writeAt(17 * evidence.regionSize + 12345, &one, 1);
+    fsync(session->fd);
+    std::vector<uint64_t> all;
+    for (uint64_t i = 0; i < loaded.leaves.size(); i++) all.push_back(i);
+    EvidenceResult checked = checkEvidence(*session, loaded, all, 4);
+    ok = ok && checked.completed && checked.regionsChecked == 41 && checked.mismatched.size() == 1 &&
+         checked.mismatched[0] == 17;
+    std::cout << "Re-check: " << checked.mismatched.size() << " mismatched of " << checked.regionsChecked << std::endl;
+
+    // Overlapped: verify a 3-pass DoD clear (ending in random) while it
+    // writes, with a 4 MB lag; its leaves must match a plain build after it
+    {
+        JobRef wipeJob = startJob("overlap-test", session->path);
+        JobScope wipeScope(wipeJob, true);
+        OverlappedEvidence overlapped(*session, -1, 4, 4ULL * 1024 * 1024);
+        DeviceSink sink(*session);
+        bool wiped = runSchemeByName(sink, "dod", 1024 * 1024);
+        MerkleEvidence during;
+        EvidenceResult duringResult = overlapped.finish(during);
+        MerkleEvidence after;
+        buildEvidence(*session, after, -1, 4);
+        ok = ok && wiped && duringResult.completed && during.root == after.root;
+        std::cout << "Overlapped: " << (overlapped.overlappedBytes() >> 20) << " MB read during the last pass, root "
+                  << (during.root == after.root ? "matches" : "differs") << std::endl;
+    }
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "deviceSession.h"
+
+// Verification evidence: a Merkle tree over the read-back device.
+//
+// After the last pass the device is read back in fixed regions and each
+// region is hashed into a leaf; the leaves are combined pairwise up to one
+// root. The root goes into the certificate, the leaves into a file next to
+// it. An auditor can then re-read any subset of regions, in any order and in
+// parallel, and check each against its leaf, and check the leaves against
+// the root without touching the device at all. A sample of a few hundred
+// regions is enough to confirm, with high confidence, that a disk is still in
+// the state that was certified; nothing has to re-read the whole disk.
+//
+// Hashes are SHA-256 with RFC 6962 style domain separation, so a leaf can
+// never be passed off as an interior node:
+//   leaf = SHA-256(0x00 || offset (u64 LE) || length (u64 LE) || region bytes)
+//   node = SHA-256(0x01 || left || right)
+// A node without a sibling at the end of a level is carried up unchanged.
+// A region that cannot be read gets the all-zero leaf.
+//
+// Reads bypass the page cache (O_DIRECT, or the session's unbuffered handle
+// on Windows): hashing what the wipe just wrote from memory proves nothing.
+
+constexpr size_t DIGEST_SIZE = 32;
+using Digest = std::array<uint8_t, DIGEST_SIZE>;
+
+constexpr uint64_t MERKLE_MIN_REGION = 1024 * 1024;
+constexpr size_t MERKLE_MAX_LEAVES = 65536;             // Leaves file stays <= 2 MB
+constexpr size_t MERKLE_READ_CHUNK = 4 * 1024 * 1024;   // Per-thread read buffer
+
+// Streaming SHA-256 (FIPS 180-4)
+class Sha256 {
+public:
+    Sha256();
+    void update(const uint8_t* data, size_t len);
+    Digest finish();
+
+private:
+    void compress(const uint8_t* block);
+
+    uint32_t state[8];
+    uint8_t buffer[64];
+    size_t buffered;
+    uint64_t length;
+};
+
+std::string digestHex(const Digest& digest);
+bool parseDigestHex(const std::string& hex, Digest& digest);
+
+// Smallest power-of-two region >= MERKLE_MIN_REGION that keeps the tree
+// within MERKLE_MAX_LEAVES leaves
+uint64_t merkleRegionSize(uint64_t deviceSize);
+
+Digest merkleNode(const Digest& left, const Digest& right);
+Digest merkleRoot(const std::vector<Digest>& leaves);
+// Sibling hashes from leaf `index` up to the root (none where a node was
+// carried up), and the check an auditor holding only the root runs on them
+std::vector<Digest> merkleProof(const std::vector<Digest>& leaves, size_t index);
+bool merkleProofValid(const Digest& leaf, size_t index, size_t leafCount, const std::vector<Digest>& proof,
+                      const Digest& root);
+
+struct MerkleEvidence {
+    uint64_t deviceSize = 0;
+    uint64_t regionSize = 0;
+    std::vector<Digest> leaves;
+    Digest root{};
+};
+
+// Leaves file: "WIPEMRK1", device size, region size, leaf count (u64 LE),
+// then the leaves. The root is recomputed on load.
+std::vector<uint8_t> serializeEvidence(const MerkleEvidence& evidence);
+bool parseEvidence(const uint8_t* data, size_t len, MerkleEvidence& evidence);
+
+struct EvidenceResult {
+    bool completed = false;             // Every requested region was read or recorded unreadable
+    uint32_t error = 0;
+    uint64_t regionsChecked = 0;
+    uint64_t bytesRead = 0;
+    std::vector<uint64_t> mismatched;   // Regions not holding the expected byte / not matching their leaf
+    std::vector<uint64_t> unreadable;
+};
+
+// Read back the whole session and build its tree. With expectedByte >= 0
+// (a constant last pass) every region is also compared against that byte;
+// regions that hold it count as verified bytes of the current job.
+EvidenceResult buildEvidence(DeviceSession& session, MerkleEvidence& evidence, int expectedByte, unsigned threads);
+
+// Read-back window an overlapped verify keeps behind the writer
+constexpr uint64_t VERIFY_DEFAULT_LAG = 256ULL * 1024 * 1024;
+
+// buildEvidence() overlapped with the last pass, for flash devices where the
+// reads do not have to share a head with the writes. Construct it in the
+// job's scope before the wipe starts. Its readers wait for the job's last
+// pass (WipeJob::currentPass) and hash each region as soon as the region and
+// the `lagBytes` after it are among the pass's written ranges, so region N is
+// read back while region N+k is being written. finish() is called once the
+// wipe has returned and reads what is left (the last window, regions with
+// unwritable sectors), so a verified wipe takes about max(write, read)
+// instead of write + read. Destroying it without finish() abandons the
+// read-back.
+class OverlappedEvidence {
+public:
+    OverlappedEvidence(DeviceSession& session, int expectedByte, unsigned threads, uint64_t lagBytes);
+    ~OverlappedEvidence();
+    OverlappedEvidence(const OverlappedEvidence&) = delete;
+    OverlappedEvidence& operator=(const OverlappedEvidence&) = delete;
+
+    EvidenceResult finish(MerkleEvidence& evidence);
+    uint64_t overlappedBytes() const;       // Read back while the wipe was still writing
+
+private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+// Re-read `regions` (indices into evidence.leaves) and compare them with
+// their leaves. The caller checks evidence.root against the certificate.
+EvidenceResult checkEvidence(DeviceSession& session, const MerkleEvidence& evidence,
+                             const std::vector<uint64_t>& regions, unsigned threads);
@@ -0,0 +1,243 @@
+#include "metricsExporter.h"
+#include "wipeJob.h"
+#include "telemetry.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+// MB/s is averaged over this many seconds of the throughput series, so one
+// slow flush does not read as a stall
+constexpr double THROUGHPUT_WINDOW_SECONDS = 10;
+
+namespace {
+
+struct Exporter {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread thread;
+    std::string path;
+    unsigned intervalMs = METRICS_DEFAULT_INTERVAL_MS;
+    bool running = false;
+    bool stopping = false;
+};
+
+// Never destroyed: a still-running thread must not meet its std::thread's
+// destructor during static teardown
+Exporter& exporter() {
+    static Exporter* instance = new Exporter();
+    return *instance;
+}
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string labels(const WipeJob& job, const char* extra = nullptr) {
+    std::string text = "{wipe_id=\"" + escapeLabel(job.id) + "\",device=\"" + escapeLabel(job.target) + "\"";
+    if (extra) text += std::string(",") + extra;
+    return text + "}";
+}
+
+void family(std::ostringstream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " " << type << "\n";
+}
+
+// One sample per job, all samples of a family together as the format requires
+void perJob(std::ostringstream& out, const std::vector<JobRef>& jobs, const char* name, const char* type,
+            const char* help, const std::function<double(const WipeJob&)>& value) {
+    family(out, name, type, help);
+    for (const JobRef& job : jobs) out << name << labels(*job) << " " << value(*job) << "\n";
+}
+
+void latencySummary(std::ostringstream& out, const std::vector<JobRef>& jobs, const char* name, const char* help,
+                    const std::function<const LatencyHistogram&(const WipeJob&)>& histogram) {
+    family(out, name, "summary", help);
+    for (const JobRef& job : jobs) {
+        const LatencyHistogram& h = histogram(*job);
+        for (const char* q : {"0.5", "0.9", "0.99", "0.999"}) {
+            std::string quantile = std::string("quantile=\"") + q + "\"";
+            out << name << labels(*job, quantile.c_str()) << " " << h.percentileNs(std::stod(q)) / 1e9 << "\n";
+        }
+        out << name << "_sum" << labels(*job) << " " << h.sumNs() / 1e9 << "\n";
+        out << name << "_count" << labels(*job) << " " << h.count() << "\n";
+    }
+}
+
+void exporterLoop() {
+    Exporter& e = exporter();
+    std::unique_lock<std::mutex> lock(e.mutex);
+    while (!e.stopping) {
+        e.wake.wait_for(lock, std::chrono::milliseconds(e.intervalMs));
+        if (e.stopping) break;      // stopMetricsExporter() writes the final file
+        std::string path = e.path;
+        lock.unlock();
+        std::string error;
+        if (!writeMetricsFile(path, &error)) logWarn("metrics") << error;
+        lock.lock();
+    }
+}
+
+}
+
+std::string renderMetrics() {
+    std::vector<JobRef> jobs = listJobs();
+    std::ostringstream out;
+    out << std::setprecision(10);
+
+    perJob(out, jobs, "wipe_running", "gauge", "1 while the wipe job is running, 0 once finished",
+           [](const WipeJob& j) { return j.running() ? 1.0 : 0.0; });
+    perJob(out, jobs, "wipe_elapsed_seconds", "gauge", "Time since the job started, or its duration once finished",
+           [](const WipeJob& j) { return j.elapsedMs() / 1000.0; });
+    perJob(out, jobs, "wipe_target_bytes", "gauge", "Size of the device or data the job overwrites",
+           [](const WipeJob& j) { return static_cast<double>(j.targetBytes()); });
+    perJob(out, jobs, "wipe_bytes_written_total", "counter", "Bytes written, all passes",
+           [](const WipeJob& j) { return static_cast<double>(j.io().writes().bytes.load()); });
+    perJob(out, jobs, "wipe_bytes_verified_total", "counter", "Bytes read back and confirmed to hold the pattern",
+           [](const WipeJob& j) { return static_cast<double>(j.verifiedBytes()); });
+    perJob(out, jobs, "wipe_bytes_read_total", "counter", "Bytes read from the device",
+           [](const WipeJob& j) { return static_cast<double>(j.io().reads().bytes.load()); });
+    perJob(out, jobs, "wipe_throughput_mbps", "gauge", "Write throughput over the last 10 seconds in MB/s",
+           [](const WipeJob& j) { return j.running() ? j.io().throughput().recentMBps(THROUGHPUT_WINDOW_SECONDS) : 0.0; });
+    perJob(out, jobs, "wipe_pass", "gauge", "Pass currently being written (1-based)",
+           [](const WipeJob& j) { return static_cast<double>(j.currentPass()); });
+    perJob(out, jobs, "wipe_passes", "gauge", "Passes in the job's scheme",
+           [](const WipeJob& j) { return static_cast<double>(j.passCount()); });
+    perJob(out, jobs, "wipe_write_errors_total", "counter", "Failed write submissions, including bisection retries",
+           [](const WipeJob& j) { return static_cast<double>(j.io().writes().errors.load()); });
+    perJob(out, jobs, "wipe_read_errors_total", "counter", "Failed read submissions",
+           [](const WipeJob& j) { return static_cast<double>(j.io().reads().errors.load()); });
+    perJob(out, jobs, "wipe_unwritable_bytes", "gauge", "Bytes in sectors no pass could write",
+           [](const WipeJob& j) { return static_cast<double>(j.badRanges().bytes()); });
+    perJob(out, jobs, "wipe_unwritable_ranges", "gauge", "Merged unwritable sector ranges",
+           [](const WipeJob& j) { return static_cast<double>(j.badRanges().ranges().size()); });
+    perJob(out, jobs, "wipe_bandwidth_limit_bytes_per_second", "gauge", "Job write bandwidth limit, 0 when unlimited",
+           [](const WipeJob& j) { return static_cast<double>(j.bandwidth().rate()); });
+    perJob(out, jobs, "wipe_health_events_total", "counter", "Degradation, stall and re-tuning events (healthMonitor.h)",
+           [](const WipeJob& j) { return static_cast<double>(j.healthEvents().size()); });
+    perJob(out, jobs, "wipe_device_flagged", "gauge", "1 once the device stayed degraded after re-tuning and pauses",
+           [](const WipeJob& j) { return j.deviceFlagged() ? 1.0 : 0.0; });
+    latencySummary(out, jobs, "wipe_write_latency_seconds", "Latency of each write submission",
+                   [](const WipeJob& j) -> const LatencyHistogram& { return j.io().writes().latency; });
+    latencySummary(out, jobs, "wipe_read_latency_seconds", "Latency of each read submission",
+                   [](const WipeJob& j) -> const LatencyHistogram& { return j.io().reads().latency; });
+
+    family(out, "wipe_global_bandwidth_limit_bytes_per_second", "gauge", "Write bandwidth limit shared by all jobs, 0 when unlimited");
+    out << "wipe_global_bandwidth_limit_bytes_per_second " << globalBandwidth().rate() << "\n";
+    family(out, "wipe_telemetry_dropped_total", "counter", "Native log records lost because the telemetry ring was full");
+    out << "wipe_telemetry_dropped_total " << telemetryDropped() << "\n";
+    return out.str();
+}
+
+bool writeMetricsFile(const std::string& path, std::string* error) {
+    // Same directory, so the rename cannot cross filesystems; the collector
+    // only reads *.prom and ignores the temporary
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (out) out << renderMetrics();
+        if (!out || !out.flush()) {
+            if (error) *error = "Cannot write metrics file " + temp;
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    bool renamed = MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = std::rename(temp.c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed) {
+        if (error) *error = "Cannot replace metrics file " + path;
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool startMetricsExporter(const std::string& path, unsigned intervalMs, std::string* error) {
+    if (!writeMetricsFile(path, error)) return false;
+
+    Exporter& e = exporter();
+    std::lock_guard<std::mutex> lock(e.mutex);
+    e.path = path;
+    e.intervalMs = intervalMs < METRICS_MIN_INTERVAL_MS ? METRICS_MIN_INTERVAL_MS : intervalMs;
+    if (!e.running) {
+        e.running = true;
+        e.stopping = false;
+        e.thread = std::thread(exporterLoop);
+        logInfo("metrics") << "Exporting metrics to " << path << " every " << e.intervalMs << " ms";
+    }
+    e.wake.notify_one();
+    return true;
+}
+
+void stopMetricsExporter() {
+    Exporter& e = exporter();
+    {
+        std::lock_guard<std::mutex> lock(e.mutex);
+        if (!e.running) return;
+        e.stopping = true;
+    }
+    e.wake.notify_one();
+    e.thread.join();
+
+    std::lock_guard<std::mutex> lock(e.mutex);
+    e.running = false;
+    writeMetricsFile(e.path, nullptr);
+}
+
+// Export for testing: render a job with some I/O recorded and write the file
+#ifdef TEST_STANDALONE
+#include <iostream>
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "wipe_test.prom";
+    JobRef job = startJob("test-1", "/dev/\"quoted\"");
+    {
+        JobScope scope(job);
+        job->setTargetBytes(1ULL << 30);
+        job->setPass(2, 3);
+        for (uint64_t i = 1; i <= 1000; i++) job->io().recordWrite(i * 1000, 1 << 20, i % 500 != 0);
+    }
+
+    std::string error;
+    if (!startMetricsExporter(path, 250, &error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    stopMetricsExporter();
+
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    std::cout << text.str();
+    bool ok = text.str().find("wipe_bytes_written_total{wipe_id=\"test-1\",device=\"/dev/\\\"quoted\\\"\"} 1046478848") != std::string::npos &&
+              text.str().find("wipe_write_errors_total{wipe_id=\"test-1\",device=\"/dev/\\\"quoted\\\"\"} 2") != std::string::npos;
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+
+// Prometheus textfile-collector export.
+//
+// A background thread renders the job registry (wipeJob.h) in the Prometheus
+// text format every interval and replaces the .prom file atomically (write a
+// temporary file in the same directory, then rename over the target), so
+// node_exporter never reads a half-written file. Point the path into the
+// directory node_exporter's --collector.textfile.directory watches.
+//
+// Series are labelled by wipe_id (the job id) and device (the job target);
+// finished jobs stay in the file while the registry keeps them, with
+// wipe_running 0. All values come from the engine's own counters.
+
+constexpr unsigned METRICS_DEFAULT_INTERVAL_MS = 5000;
+constexpr unsigned METRICS_MIN_INTERVAL_MS = 250;
+
+// Current metrics in the Prometheus text exposition format
+std::string renderMetrics();
+
+// Render and atomically replace `path`; false with `error` set on failure
+bool writeMetricsFile(const std::string& path, std::string* error);
+
+// Start (or retarget) the exporter thread. The file is written once before
+// returning, so a bad path is reported to the caller.
+bool startMetricsExporter(const std::string& path, unsigned intervalMs, std::string* error);
+
+// Stop the thread after one final write; no-op when not running
+void stopMetricsExporter();
@@ -1,14 +1,7 @@
-#include <fstream>
 #include <string>
-#include <vector>
-#include <cstdint>
-#include <algorithm>
-#include <cstdlib>
-#include <cstring>
 #include "wipeCommon.h"
 
-
+// Single random pass (NistScheme in wipeSchemes.h)
 bool nistWipe(const std::string& path) {
-    std::vector<std::pair<uint8_t, bool>> passes = { {0x00, true} }; // true = random
-    return wipeTarget(path, passes);
+    return wipeScheme<NistScheme>(path);
 }
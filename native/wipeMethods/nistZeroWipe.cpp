@@ -1,13 +1,7 @@
-#include <fstream>
 #include <string>
-#include <vector>
-#include <cstdint>
-#include <algorithm>
-#include <cstdlib>
-#include <cstring>
 #include "wipeCommon.h"
 
+// Single zero pass (NistZeroScheme in wipeSchemes.h)
 bool nistZeroWipe(const std::string& path) {
-    std::vector<std::pair<uint8_t, bool>> passes = { {0x00, false} }; // false = no random, zeros
-    return wipeTarget(path, passes);
+    return wipeScheme<NistZeroScheme>(path);
 }
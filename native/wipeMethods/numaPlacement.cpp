@@ -0,0 +1,251 @@
+#include "numaPlacement.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <climits>
+    #include <cstdlib>
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <linux/mempolicy.h>
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+namespace {
+
+struct NodeCounters {
+    std::atomic<uint64_t> bytesWritten{0};
+    std::mutex mutex;                   // Guards the busy-time fields
+    uint32_t activeThreads = 0;
+    std::chrono::steady_clock::time_point busySince;
+    std::chrono::steady_clock::duration busy{0};
+};
+
+NodeCounters nodeCounters[MAX_NUMA_NODES];
+
+thread_local int threadNode = -1;
+
+bool validNode(int node) {
+    return node >= 0 && node < MAX_NUMA_NODES && node < numaNodeCount();
+}
+
+#ifdef __linux__
+std::string readLine(const std::string& file) {
+    std::ifstream in(file);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+std::vector<unsigned> parseCpuList(const std::string& list) {
+    std::vector<unsigned> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+        unsigned last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+        for (unsigned cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+#endif
+
+}
+
+int numaNodeCount() {
+    static const int count = [] {
+#ifdef _WIN32
+        ULONG highest = 0;
+        return GetNumaHighestNodeNumber(&highest) ? static_cast<int>(highest) + 1 : 1;
+#elif defined(__linux__)
+        std::vector<unsigned> nodes = parseCpuList(readLine("/sys/devices/system/node/online"));
+        return nodes.empty() ? 1 : static_cast<int>(nodes.back()) + 1;
+#else
+        return 1;
+#endif
+    }();
+    return count;
+}
+
+std::vector<unsigned> numaNodeCpus(int node) {
+    if (!validNode(node)) return {};
+#ifdef _WIN32
+    std::vector<unsigned> cpus;
+    GROUP_AFFINITY affinity;
+    if (GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity)) {
+        for (unsigned bit = 0; bit < sizeof(KAFFINITY) * 8; bit++) {
+            if (affinity.Mask & (static_cast<KAFFINITY>(1) << bit)) cpus.push_back(affinity.Group * 64 + bit);
+        }
+    }
+    return cpus;
+#elif defined(__linux__)
+    return parseCpuList(readLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+#else
+    return {};
+#endif
+}
+
+int deviceNumaNode(const std::string& devicePath) {
+#ifdef __linux__
+    // /dev/X -> /sys/class/block/X -> /sys/devices/pci.../0000:3b:00.0/.../block/X;
+    // the first ancestor with a numa_node file is the controller's bus device
+    char resolved[PATH_MAX];
+    if (!realpath(devicePath.c_str(), resolved)) return -1;
+    if (numaNodeCount() == 1) return 0;
+    std::string name(resolved);
+    name = name.substr(name.find_last_of('/') + 1);
+    std::string classDir = "/sys/class/block/" + name;
+    if (!realpath(classDir.c_str(), resolved)) return -1;
+
+    std::string dir(resolved);
+    while (dir.size() > std::string("/sys/devices").size()) {
+        std::string value = readLine(dir + "/numa_node");
+        if (!value.empty()) {
+            int node = std::atoi(value.c_str());
+            return validNode(node) ? node : -1;
+        }
+        dir = dir.substr(0, dir.find_last_of('/'));
+    }
+    return -1;
+#else
+    // Windows exposes the node only through SetupAPI (DEVPKEY_Numa_Node);
+    // not probed, so jobs run unpinned
+    (void)devicePath;
+    return -1;
+#endif
+}
+
+int currentNumaNode() {
+    return threadNode;
+}
+
+bool bindMemoryToNode(void* ptr, size_t len, int node) {
+#ifdef __linux__
+    if (!validNode(node) || numaNodeCount() < 2) return false;
+    unsigned long mask[MAX_NUMA_NODES / (sizeof(unsigned long) * 8)] = {};
+    mask[node / (sizeof(unsigned long) * 8)] = 1UL << (node % (sizeof(unsigned long) * 8));
+    // Preferred rather than bound: fall back to another node instead of failing when this one is full
+    return syscall(SYS_mbind, ptr, len, MPOL_PREFERRED, mask, sizeof(mask) * 8, 0) == 0;
+#else
+    (void)ptr;
+    (void)len;
+    (void)node;
+    return false;
+#endif
+}
+
+// Pin the calling thread to the node's CPUs, saving the previous affinity
+static bool pinThreadToNode(int node, std::vector<uint8_t>& saved) {
+#ifdef _WIN32
+    GROUP_AFFINITY affinity;
+    GROUP_AFFINITY previous;
+    if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) ||
+        !SetThreadGroupAffinity(GetCurrentThread(), &affinity, &previous)) {
+        return false;
+    }
+    saved.assign(reinterpret_cast<uint8_t*>(&previous), reinterpret_cast<uint8_t*>(&previous) + sizeof(previous));
+    return true;
+#elif defined(__linux__)
+    cpu_set_t previous;
+    CPU_ZERO(&previous);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) != 0) return false;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (unsigned cpu : numaNodeCpus(node)) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpus);
+    }
+    if (CPU_COUNT(&cpus) == 0 || pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) return false;
+    saved.assign(reinterpret_cast<uint8_t*>(&previous), reinterpret_cast<uint8_t*>(&previous) + sizeof(previous));
+    return true;
+#else
+    (void)node;
+    (void)saved;
+    return false;
+#endif
+}
+
+NumaScope::NumaScope(int node) : node(node), previousNode(threadNode), isPinned(false) {
+    if (!validNode(node)) return;
+
+    // A single node is still tracked for stats, but there is nothing to pin
+    if (numaNodeCount() > 1) isPinned = pinThreadToNode(node, savedAffinity);
+
+    threadNode = node;
+    NodeCounters& counters = nodeCounters[node];
+    std::lock_guard<std::mutex> lock(counters.mutex);
+    if (counters.activeThreads++ == 0) counters.busySince = std::chrono::steady_clock::now();
+}
+
+NumaScope::~NumaScope() {
+    if (!validNode(node)) return;
+
+    {
+        NodeCounters& counters = nodeCounters[node];
+        std::lock_guard<std::mutex> lock(counters.mutex);
+        if (--counters.activeThreads == 0) counters.busy += std::chrono::steady_clock::now() - counters.busySince;
+    }
+    threadNode = previousNode;
+
+    if (!isPinned) return;
+#ifdef _WIN32
+    SetThreadGroupAffinity(GetCurrentThread(), reinterpret_cast<const GROUP_AFFINITY*>(savedAffinity.data()), NULL);
+#elif defined(__linux__)
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), reinterpret_cast<const cpu_set_t*>(savedAffinity.data()));
+#endif
+}
+
+void recordNumaWrite(uint64_t bytes) {
+    if (threadNode >= 0) nodeCounters[threadNode].bytesWritten += bytes;
+}
+
+std::vector<NumaNodeStats> numaNodeStats() {
+    std::vector<NumaNodeStats> stats;
+    auto now = std::chrono::steady_clock::now();
+    for (int node = 0; node < numaNodeCount() && node < MAX_NUMA_NODES; node++) {
+        NodeCounters& counters = nodeCounters[node];
+        NumaNodeStats s;
+        s.node = node;
+        s.cpus = numaNodeCpus(node);
+        s.bytesWritten = counters.bytesWritten;
+        {
+            std::lock_guard<std::mutex> lock(counters.mutex);
+            s.activeThreads = counters.activeThreads;
+            auto busy = counters.busy;
+            if (counters.activeThreads > 0) busy += now - counters.busySince;
+            s.busyMs = std::chrono::duration<double, std::milli>(busy).count();
+        }
+        s.averageMBps = s.busyMs > 0 ? (s.bytesWritten / 1024.0 / 1024.0) / (s.busyMs / 1000.0) : 0;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+// Export for testing
+#ifdef TEST_STANDALONE
+#include <iostream>
+
+int main(int argc, char** argv) {
+    std::cout << "NUMA nodes: " << numaNodeCount() << std::endl;
+    for (const NumaNodeStats& s : numaNodeStats()) {
+        std::cout << "  node " << s.node << ": " << s.cpus.size() << " CPUs" << std::endl;
+    }
+    for (int i = 1; i < argc; i++) {
+        int node = deviceNumaNode(argv[i]);
+        std::cout << argv[i] << ": node " << node;
+        NumaScope scope(node);
+        std::cout << (scope.pinned() ? " (pinned)" : " (not pinned)") << std::endl;
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// NUMA placement.
+//
+// On multi-socket hosts each HBA/NVMe controller hangs off one node. A job
+// that knows its device's node (DeviceSession::numaNode, from sysfs) enters a
+// NumaScope: the thread is pinned to that node's CPUs for the duration of the
+// job, and pattern and scratch buffers are allocated on that node, so neither
+// generation nor DMA crosses the interconnect. The thread's original affinity
+// is restored when the scope exits (the caller is a pooled worker thread).
+//
+// Without NUMA (one node, or node unknown) every call here is a no-op.
+
+constexpr int MAX_NUMA_NODES = 64;
+
+int numaNodeCount();                            // Online nodes, 1 on non-NUMA hosts
+std::vector<unsigned> numaNodeCpus(int node);   // Logical CPUs of the node
+
+// NUMA node of a block device's controller, -1 if unknown
+int deviceNumaNode(const std::string& devicePath);
+
+// The calling thread's node while inside a NumaScope, -1 otherwise
+int currentNumaNode();
+
+// Prefer `node` for the pages of [ptr, ptr + len). Must be called before the
+// memory is first touched.
+bool bindMemoryToNode(void* ptr, size_t len, int node);
+
+class NumaScope {
+public:
+    explicit NumaScope(int node);
+    ~NumaScope();
+    NumaScope(const NumaScope&) = delete;
+    NumaScope& operator=(const NumaScope&) = delete;
+
+    bool pinned() const { return isPinned; }
+
+private:
+    int node;
+    int previousNode;
+    bool isPinned;
+    std::vector<uint8_t> savedAffinity;     // Opaque cpu_set_t / GROUP_AFFINITY
+};
+
+// Count bytes written by the calling thread against its node
+void recordNumaWrite(uint64_t bytes);
+
+struct NumaNodeStats {
+    int node;
+    std::vector<unsigned> cpus;
+    uint64_t bytesWritten;
+    uint32_t activeThreads;     // Threads currently inside a NumaScope for the node
+    double busyMs;              // Time with at least one active thread
+    double averageMBps;         // bytesWritten / busy time
+};
+
+std::vector<NumaNodeStats> numaNodeStats();
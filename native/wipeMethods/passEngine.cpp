@@ -0,0 +1,227 @@
+#include "passEngine.h"
+#include "zonedWriter.h"
+#include "stripedWriter.h"
+#include "deviceCache.h"
+#include "ioThrottle.h"
+#include "telemetry.h"
+#include <cerrno>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+// Progress is reported every 1GB to keep console overhead off the write path
+constexpr uint64_t PROGRESS_STEP = 1024ULL * 1024 * 1024;
+
+std::string describePass(size_t pass, size_t passCount, const PassSpec& spec) {
+    std::ostringstream description;
+    description << "Pass " << pass << "/" << passCount << " - Pattern: ";
+    if (spec.kind == PassKind::Random) {
+        description << "random";
+    } else if (spec.period <= 3) {
+        description << "0x" << std::hex << std::uppercase;
+        for (int i = 0; i < spec.period; i++) {
+            description << std::setw(2) << std::setfill('0') << static_cast<int>(spec.bytes[i]);
+        }
+    } else {
+        description << spec.period << "-byte custom";
+    }
+    return description.str();
+}
+
+DeviceSink::DeviceSink(DeviceSession& session) :
+    session(session),
+    passNumber(0),
+    passTotal(0),
+    passWritten(0),
+    totalWritten(0),
+    nextProgress(PROGRESS_STEP),
+    error(0),
+    failures(0) {
+    if (WipeJob* job = currentJob()) job->setTargetBytes(session.size);
+}
+
+bool DeviceSink::beginPass(size_t pass, size_t passCount, const PassSpec& spec) {
+    if (!session.writable) {
+        error = session.openError;
+        logError("pass") << "Device is not open for writing (error " << error << ")";
+        return false;
+    }
+
+    passNumber = pass;
+    passTotal = passCount;
+    passWritten = 0;
+    nextProgress = PROGRESS_STEP;
+    passStart = std::chrono::steady_clock::now();
+    health.resume(passStart);
+    if (WipeJob* job = currentJob()) job->setPass(static_cast<uint32_t>(pass), static_cast<uint32_t>(passCount));
+
+    emitEvent(TelemetryEvent::PassStarted, "pass", describePass(pass, passCount, spec), pass, passCount, session.size);
+    return true;
+}
+
+// Write, or on a media error bisect down to single sectors and record the
+// ones that stay unwritable
+bool DeviceSink::writeRange(uint64_t offset, const uint8_t* data, size_t len) {
+    if (currentJobCancelled()) {
+        error = JOB_CANCELLED_ERROR;
+        return false;
+    }
+    if (session.writeAt(offset, data, len)) return true;
+
+    error = session.ioError;
+    if (!isMediaError(error)) {
+        logError("pass") << "Write failed at offset " << offset << " (error " << error << ")";
+        return false;
+    }
+    if (++failures > MAX_FAILED_WRITES) {
+        logError("pass") << "Too many failed writes (" << failures << "), device is failing; aborting";
+        return false;
+    }
+
+    const size_t sector = session.logicalSectorSize;
+    if (len <= sector) {
+        emitEvent(TelemetryEvent::BadRange, "pass", "Unwritable sector at offset " + std::to_string(offset) +
+                  " (error " + std::to_string(error) + ")", offset, len, static_cast<uint64_t>(error));
+        bad.add(offset, len);
+        if (WipeJob* job = currentJob()) job->recordBadRange(offset, len);
+        return true;
+    }
+    // Halves stay sector-aligned (unbuffered I/O requires it)
+    size_t half = std::max(sector, len / 2 / sector * sector);
+    return writeRange(offset, data, half) && writeRange(offset + half, data + half, len - half);
+}
+
+bool DeviceSink::write(uint64_t offset, const uint8_t* data, size_t len) {
+    for (size_t done = 0; done < len; ) {
+        size_t n = std::min(len - done, health.writeSize());
+        // A throttle wait is not device time: the monitor starts a new window
+        if (throttleWrite(n)) health.resume();
+        auto start = std::chrono::steady_clock::now();
+        if (!writeRange(offset + done, data + done, n)) return false;
+        auto end = std::chrono::steady_clock::now();
+        uint32_t pauseMs = health.record(offset + done, n,
+                                         std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), end);
+        if (pauseMs) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(pauseMs));
+            health.resume();
+        }
+        done += n;
+    }
+
+    passWritten += len;
+    totalWritten += len;
+    recordNumaWrite(len);
+    if (WipeJob* job = currentJob()) job->recordWrittenRange(offset, len);
+
+    if (passWritten >= nextProgress) {
+        nextProgress += PROGRESS_STEP;
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+        double writtenMB = passWritten / 1024.0 / 1024.0;
+        int speed = static_cast<int>(writtenMB / (elapsed > 0 ? elapsed : 1));
+        std::ostringstream line;
+        line << "Progress: " << static_cast<int>((passWritten * 100) / session.size) << "% ("
+             << static_cast<int>(writtenMB) << " MB) - Speed: " << speed << " MB/s";
+        emitEvent(TelemetryEvent::Progress, "pass", line.str(), passWritten, session.size, speed);
+    }
+    return true;
+}
+
+bool DeviceSink::endPass() {
+    // A pass is complete only once it has reached stable media
+#ifdef _WIN32
+    if (!FlushFileBuffers(session.handle)) {
+        error = GetLastError();
+#else
+    if (fsync(session.fd) != 0) {
+        error = errno;
+#endif
+        logError("pass") << "Flush after pass " << passNumber << " failed (error " << error << ")";
+        return false;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+    std::ostringstream line;
+    line << "Pass " << passNumber << "/" << passTotal << " completed in " << static_cast<int>(elapsed)
+         << " seconds (" << static_cast<int>((passWritten / 1024.0 / 1024.0) / (elapsed > 0 ? elapsed : 1))
+         << " MB/s)";
+    emitEvent(TelemetryEvent::PassFinished, "pass", line.str(), passNumber, passTotal,
+              static_cast<uint64_t>(elapsed * 1000));
+    return true;
+}
+
+bool runDeviceScheme(DeviceSession& session, const std::string& method, size_t maxChunk, bool* found) {
+    if (session.zoned != ZonedModel::None) {
+        ZonedSink sink(session);
+        return runSchemeByName(sink, method, maxChunk, found);
+    }
+    TuningPlan tuning = planTuning(session, 0, maxChunk);
+    unsigned streams = tuning.stripes ? tuning.stripes : stripeCount(session);
+    if (streams > 1) {
+        StripedSink sink(session, streams);
+        return runSchemeByName(sink, method, tuning.chunk < STRIPE_MAX_CHUNK ? tuning.chunk : STRIPE_MAX_CHUNK, found);
+    }
+    DeviceSink sink(session);
+    return runSchemeByName(sink, method, tuning.chunk, found);
+}
+
+// Export for testing: compile-time schemes vs the runtime-interpreted path
+#ifdef TEST_STANDALONE
+#include <cstdio>
+#include <vector>
+#include "wipeCommon.h"
+
+// Discards writes; measures generate/dispatch cost alone
+struct NullSink {
+    uint64_t total;
+    uint64_t checksum;
+
+    uint64_t size() const { return total; }
+    bool beginPass(size_t, size_t, const PassSpec&) { return true; }
+    bool write(uint64_t, const uint8_t* data, size_t len) {
+        checksum += data[0] + data[len - 1];
+        return true;
+    }
+    bool endPass() { return true; }
+};
+
+template <typename Fn>
+static double timeMs(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* label, uint64_t bytes, double ms) {
+    std::cout << std::left << std::setw(34) << label << std::right << std::setw(10) << std::fixed
+              << std::setprecision(1) << ms << " ms  " << std::setw(8)
+              << (bytes / 1024.0 / 1024.0) / (ms / 1000.0) << " MB/s" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const uint64_t size = 256ULL * 1024 * 1024;
+    const std::vector<std::pair<uint8_t, bool>> dodPasses = {{0x00, false}, {0xFF, false}, {0x00, true}};
+
+    std::cout << "In-memory (" << (size >> 20) << " MB per pass, DoD 3 passes)" << std::endl;
+    NullSink interpreted{size, 0};
+    report("interpreted, 4KB chunks", size * 3, timeMs([&] { runInterpreted(interpreted, dodPasses, 4096); }));
+    NullSink interpretedLarge{size, 0};
+    report("interpreted, 1MB chunks", size * 3, timeMs([&] { runInterpreted(interpretedLarge, dodPasses, FILE_CHUNK_SIZE); }));
+    NullSink compiled{size, 0};
+    report("runScheme<DoDScheme>, 1MB chunks", size * 3, timeMs([&] { runScheme<DoDScheme>(compiled, FILE_CHUNK_SIZE); }));
+
+    // Optional file target: ./passEngine <existing file>
+    if (argc > 1) {
+        std::string path = argv[1];
+        FileSink probe(path);
+        uint64_t fileSize = probe.size();
+        std::cout << "\nFile " << path << " (" << (fileSize >> 20) << " MB per pass)" << std::endl;
+        report("wipeTarget (interpreted)", fileSize * 3, timeMs([&] { wipeTarget(path, dodPasses); }));
+        report("wipeScheme<DoDScheme>", fileSize * 3, timeMs([&] { wipeScheme<DoDScheme>(path); }));
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <string>
+#include "deviceSession.h"
+#include "wipeSchemes.h"
+#include "healthMonitor.h"
+
+// Pass engine: drives compile-time wipe schemes (wipeSchemes.h) over an open
+// DeviceSession. Writes are positional, so a shared session needs no rewind
+// between steps.
+//
+// A chunk that fails with a media error is bisected down to the logical
+// sector size: the writable parts are rewritten, the sectors that still fail
+// are recorded as bad ranges (on the sink and on the current job) and the
+// pass carries on. Any other error, or more than MAX_FAILED_WRITES failed
+// writes on one sink (all passes of one scheme run), still aborts: that is a
+// failing device, not a bad sector.
+//
+// Every write also feeds a HealthMonitor (healthMonitor.h), which may shrink
+// the writes the sink issues or pause it when the device degrades mid-wipe,
+// and is throttled first to the job's and the global bandwidth limit
+// (ioThrottle.h).
+constexpr uint32_t MAX_FAILED_WRITES = 4096;
+
+class DeviceSink {
+public:
+    explicit DeviceSink(DeviceSession& session);
+
+    uint64_t size() const { return session.size; }
+    bool beginPass(size_t pass, size_t passCount, const PassSpec& spec);
+    bool write(uint64_t offset, const uint8_t* data, size_t len);
+    bool endPass();
+
+    uint64_t bytesWritten() const { return totalWritten; }     // All passes
+    uint32_t lastError() const { return error; }
+    const BadRangeList& badRanges() const { return bad; }      // Merged across passes
+    uint32_t failedWrites() const { return failures; }
+    const HealthMonitor& healthMonitor() const { return health; }
+
+private:
+    bool writeRange(uint64_t offset, const uint8_t* data, size_t len);
+
+    DeviceSession& session;
+    size_t passNumber;
+    size_t passTotal;
+    uint64_t passWritten;
+    uint64_t totalWritten;
+    uint64_t nextProgress;
+    uint32_t error;
+    uint32_t failures;
+    BadRangeList bad;
+    HealthMonitor health;
+    std::chrono::steady_clock::time_point passStart;
+};
+
+// "Pass 2/3 - Pattern: 0xFF", as logged when a pass starts
+std::string describePass(size_t pass, size_t passCount, const PassSpec& spec);
+
+// Run the scheme named `method` over the session (zoned devices through
+// ZonedSink, zonedWriter.h; SSDs through StripedSink, stripedWriter.h), with
+// the stream count and write size cached for the device (deviceCache.h).
+// Returns false with *found = false for an unknown name.
+bool runDeviceScheme(DeviceSession& session, const std::string& method, size_t maxChunk, bool* found = nullptr);
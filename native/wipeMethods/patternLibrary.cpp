@@ -0,0 +1,585 @@
+#include "patternLibrary.h"
+#include "numaPlacement.h"
+#include "probes.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <random>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define PATTERN_SIMD_WIDTH 32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define PATTERN_SIMD_WIDTH 16
+#else
+    #define PATTERN_SIMD_WIDTH 0
+#endif
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <malloc.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+// Keep at most this much idle pattern data cached (in-use buffers are never evicted)
+constexpr size_t PATTERN_CACHE_BUDGET = 512ULL * 1024 * 1024;
+
+// Streaming stores skip the cache; only worth it once the buffer exceeds L2
+constexpr size_t STREAMING_THRESHOLD = 1024 * 1024;
+
+// Register tile limit: lcm(period, width) must fit in this many vector registers
+constexpr size_t MAX_TILE_REGISTERS = 16;
+
+// Idle random-pass scratch buffers kept for the next pass
+constexpr size_t SCRATCH_POOL_IDLE = 4;
+
+// Live bytes per BufferBacking, for patternArenaStats()
+static std::atomic<size_t> backingBytes[7];
+
+static size_t roundUp(size_t value, size_t unit) {
+    return (value + unit - 1) / unit * unit;
+}
+
+#ifndef _WIN32
+// Anonymous mapping aligned to HUGE_PAGE_SIZE, so transparent huge pages can
+// back it from the first byte: over-map by one huge page and trim both ends
+static void* mapHugeAligned(size_t size) {
+    void* p = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+    uintptr_t base = reinterpret_cast<uintptr_t>(p);
+    uintptr_t aligned = roundUp(base, HUGE_PAGE_SIZE);
+    if (aligned > base) munmap(p, aligned - base);
+    if (aligned + size < base + size + HUGE_PAGE_SIZE) {
+        munmap(reinterpret_cast<void*>(aligned + size), base + size + HUGE_PAGE_SIZE - aligned - size);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+AlignedBuffer::AlignedBuffer() :
+    ptr(nullptr), length(0), mapped(0), memory(0), kind(BufferBacking::None), numaNode(-1) {}
+
+AlignedBuffer::AlignedBuffer(size_t size, int numaNode) :
+    ptr(nullptr), length(size), mapped(size), memory(0), kind(BufferBacking::None), numaNode(numaNode) {
+    if (size < HUGE_PAGE_SIZE) {
+#ifdef _WIN32
+        ptr = static_cast<uint8_t*>(_aligned_malloc(size, PATTERN_ALIGNMENT));
+#else
+        void* p = nullptr;
+        if (posix_memalign(&p, PATTERN_ALIGNMENT, size) == 0) {
+            ptr = static_cast<uint8_t*>(p);
+        }
+#endif
+        if (ptr) kind = BufferBacking::Heap;
+    } else {
+#ifdef _WIN32
+        // Large pages need SeLockMemoryPrivilege; without it this fails fast
+        // Node is a preference: VirtualAllocExNuma falls back to other nodes
+        DWORD node = numaNode >= 0 ? static_cast<DWORD>(numaNode) : NUMA_NO_PREFERRED_NODE;
+        SIZE_T largePage = GetLargePageMinimum();
+        if (largePage) {
+            mapped = roundUp(size, largePage);
+            ptr = static_cast<uint8_t*>(VirtualAllocExNuma(GetCurrentProcess(), NULL, mapped,
+                                                           MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE, node));
+            if (ptr) kind = BufferBacking::HugePages;
+        }
+        if (!ptr) {
+            mapped = roundUp(size, PATTERN_ALIGNMENT);
+            ptr = static_cast<uint8_t*>(VirtualAllocExNuma(GetCurrentProcess(), NULL, mapped,
+                                                           MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE, node));
+            if (ptr) kind = BufferBacking::Pages;
+        }
+#else
+        mapped = roundUp(size, HUGE_PAGE_SIZE);
+    #ifdef MAP_HUGETLB
+        // Only succeeds if huge pages are reserved (vm.nr_hugepages)
+        void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            ptr = static_cast<uint8_t*>(p);
+            kind = BufferBacking::HugePages;
+        }
+    #endif
+        if (!ptr) {
+            ptr = static_cast<uint8_t*>(mapHugeAligned(mapped));
+            if (ptr) {
+                kind = BufferBacking::Pages;
+    #ifdef MADV_HUGEPAGE
+                if (madvise(ptr, mapped, MADV_HUGEPAGE) == 0) kind = BufferBacking::Transparent;
+    #endif
+            }
+        }
+        // Nothing has been touched yet, so every page lands on the node
+        if (ptr && numaNode >= 0) bindMemoryToNode(ptr, mapped, numaNode);
+#endif
+    }
+    if (ptr) {
+        memory = mapped;
+        backingBytes[static_cast<size_t>(kind)] += memory;
+    } else {
+        length = 0;
+        mapped = 0;
+    }
+}
+
+std::unique_ptr<AlignedBuffer> AlignedBuffer::repeating(size_t size, const uint8_t* bytes, size_t period, int numaNode) {
+#ifdef _WIN32
+    // Views of one section can be placed back to back only through
+    // placeholder mappings (Windows 10 1803+); keep full buffers there
+    (void)size; (void)bytes; (void)period; (void)numaNode;
+    return nullptr;
+#else
+    bool zero = true;
+    for (size_t i = 0; i < period; i++) zero = zero && bytes[i] == 0;
+    size_t tile = patternBufferSize(PATTERN_TILE_SIZE, period);
+    if (tile == 0 || size <= tile || size % PATTERN_ALIGNMENT != 0) return nullptr;     // Not worth it
+
+    std::unique_ptr<AlignedBuffer> buffer(new AlignedBuffer());
+    if (zero) {
+        // Read faults on a private anonymous page map the zero page; nothing
+        // ever writes here, so no page is ever allocated
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+        buffer->ptr = static_cast<uint8_t*>(p);
+        buffer->kind = BufferBacking::ZeroPages;
+        buffer->memory = 0;
+    } else {
+    #ifdef MFD_CLOEXEC
+        int fd = memfd_create("wipe-pattern", MFD_CLOEXEC);
+        if (fd < 0) return nullptr;
+        void* t = ftruncate(fd, static_cast<off_t>(tile)) == 0
+            ? mmap(nullptr, tile, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (t == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+        if (numaNode >= 0) bindMemoryToNode(t, tile, numaNode);
+        replicatePattern(static_cast<uint8_t*>(t), tile, bytes, period);
+        munmap(t, tile);
+
+        // Reserve the whole range, then map the tile over it piece by piece.
+        // Tile and size are whole numbers of lcm(period, page), so the range
+        // stays periodic and the last, shorter piece is still page-sized.
+        void* base = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        bool ok = base != MAP_FAILED;
+        for (size_t offset = 0; ok && offset < size; offset += tile) {
+            size_t piece = size - offset < tile ? size - offset : tile;
+            ok = mmap(static_cast<uint8_t*>(base) + offset, piece, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+        }
+        ::close(fd);        // The mappings keep the tile alive
+        if (!ok) {
+            if (base != MAP_FAILED) munmap(base, size);
+            return nullptr;
+        }
+        buffer->ptr = static_cast<uint8_t*>(base);
+        buffer->kind = BufferBacking::Mirrored;
+        buffer->memory = tile;
+    #else
+        return nullptr;
+    #endif
+    }
+    buffer->length = size;
+    buffer->mapped = size;
+    buffer->numaNode = numaNode;
+    backingBytes[static_cast<size_t>(buffer->kind)] += buffer->memory;
+    return buffer;
+#endif
+}
+
+AlignedBuffer::~AlignedBuffer() {
+    if (!ptr) return;
+    backingBytes[static_cast<size_t>(kind)] -= memory;
+#ifdef _WIN32
+    if (kind == BufferBacking::Heap) {
+        _aligned_free(ptr);
+    } else {
+        VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+#else
+    if (kind == BufferBacking::Heap) {
+        free(ptr);
+    } else {
+        munmap(ptr, mapped);
+    }
+#endif
+}
+
+bool AlignedBuffer::protect() {
+    // Heap blocks share pages with the allocator's bookkeeping
+    if (!ptr || kind == BufferBacking::Heap) return false;
+#ifdef _WIN32
+    DWORD oldProtect;
+    return VirtualProtect(ptr, mapped, PAGE_READONLY, &oldProtect) != 0;
+#else
+    return mprotect(ptr, mapped, PROT_READ) == 0;
+#endif
+}
+
+static size_t gcd(size_t a, size_t b) {
+    while (b) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static size_t lcm(size_t a, size_t b) {
+    return a / gcd(a, b) * b;
+}
+
+PatternBuffer::PatternBuffer(std::unique_ptr<AlignedBuffer> storage, size_t period, const std::string& bytes) :
+    data(storage->data()),
+    size(storage->size() - lcm(period, PATTERN_ALIGNMENT)),
+    span(lcm(period, PATTERN_ALIGNMENT)),
+    resident(storage->resident()),
+    period(period),
+    bytes(bytes),
+    storage(std::move(storage)) {}
+
+size_t patternBufferSize(size_t maxSize, size_t period) {
+    if (period == 0 || period > MAX_PATTERN_PERIOD) return 0;
+    size_t unit = lcm(period, PATTERN_ALIGNMENT);
+    return (maxSize / unit) * unit;
+}
+
+// Doubling copy: each memcpy duplicates the already-periodic prefix
+static void replicateByDoubling(uint8_t* dst, size_t size, const uint8_t* bytes, size_t period) {
+    size_t filled = period < size ? period : size;
+    memcpy(dst, bytes, filled);
+    while (filled < size) {
+        size_t chunk = filled < size - filled ? filled : size - filled;
+        memcpy(dst + filled, dst, chunk);
+        filled += chunk;
+    }
+}
+
+void replicatePattern(uint8_t* dst, size_t size, const uint8_t* bytes, size_t period) {
+    if (size == 0 || period == 0) return;
+    if (period == 1) {
+        memset(dst, bytes[0], size);
+        return;
+    }
+
+#if PATTERN_SIMD_WIDTH
+    const size_t width = PATTERN_SIMD_WIDTH;
+    const size_t tileLen = lcm(period, width);
+    const size_t registers = tileLen / width;
+    if (registers > MAX_TILE_REGISTERS || size < tileLen) {
+        replicateByDoubling(dst, size, bytes, period);
+        return;
+    }
+
+    alignas(64) uint8_t tile[PATTERN_SIMD_WIDTH * MAX_TILE_REGISTERS];
+    for (size_t i = 0; i < tileLen; i++) {
+        tile[i] = bytes[i % period];
+    }
+
+    const bool aligned = (reinterpret_cast<uintptr_t>(dst) % width) == 0;
+    const bool streaming = aligned && size >= STREAMING_THRESHOLD;
+    const size_t tiles = size / tileLen;
+
+#if PATTERN_SIMD_WIDTH == 32
+    __m256i regs[MAX_TILE_REGISTERS];
+    for (size_t r = 0; r < registers; r++) {
+        regs[r] = _mm256_load_si256(reinterpret_cast<const __m256i*>(tile + r * width));
+    }
+    for (size_t t = 0; t < tiles; t++) {
+        __m256i* out = reinterpret_cast<__m256i*>(dst + t * tileLen);
+        if (streaming) {
+            for (size_t r = 0; r < registers; r++) _mm256_stream_si256(out + r, regs[r]);
+        } else {
+            for (size_t r = 0; r < registers; r++) _mm256_storeu_si256(out + r, regs[r]);
+        }
+    }
+#else
+    __m128i regs[MAX_TILE_REGISTERS];
+    for (size_t r = 0; r < registers; r++) {
+        regs[r] = _mm_load_si128(reinterpret_cast<const __m128i*>(tile + r * width));
+    }
+    for (size_t t = 0; t < tiles; t++) {
+        __m128i* out = reinterpret_cast<__m128i*>(dst + t * tileLen);
+        if (streaming) {
+            for (size_t r = 0; r < registers; r++) _mm_stream_si128(out + r, regs[r]);
+        } else {
+            for (size_t r = 0; r < registers; r++) _mm_storeu_si128(out + r, regs[r]);
+        }
+    }
+#endif
+    if (streaming) {
+        _mm_sfence();
+    }
+
+    // Tail starts at a multiple of tileLen, i.e. at phase 0
+    size_t done = tiles * tileLen;
+    memcpy(dst + done, tile, size - done);
+#else
+    replicateByDoubling(dst, size, bytes, period);
+#endif
+}
+
+// xoshiro256** (Blackman & Vigna), one generator per thread
+namespace {
+struct Xoshiro256 {
+    uint64_t s[4];
+
+    Xoshiro256() {
+        std::random_device rd;
+        for (int i = 0; i < 4; i++) {
+            s[i] = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+        }
+        if ((s[0] | s[1] | s[2] | s[3]) == 0) s[0] = 0x9E3779B97F4A7C15ULL;
+    }
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+}
+
+void fillRandomBytes(uint8_t* dst, size_t size) {
+    thread_local Xoshiro256 rng;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t v = rng.next();
+        memcpy(dst + i, &v, 8);
+    }
+    if (i < size) {
+        uint64_t v = rng.next();
+        memcpy(dst + i, &v, size - i);
+    }
+}
+
+// Process-wide cache: most recently used at the front
+namespace {
+struct CacheEntry {
+    std::string key;
+    PatternRef pattern;
+};
+
+std::mutex cacheMutex;
+std::list<CacheEntry> cacheEntries;
+size_t cacheBytes = 0;
+
+void evictIdleLocked() {
+    auto it = cacheEntries.end();
+    while (cacheBytes > PATTERN_CACHE_BUDGET && it != cacheEntries.begin()) {
+        --it;
+        if (it->pattern.use_count() == 1) {
+            cacheBytes -= it->pattern->resident;
+            it = cacheEntries.erase(it);
+        }
+    }
+}
+}
+
+PatternRef acquirePattern(const uint8_t* bytes, size_t period, size_t maxSize, int numaNode) {
+    size_t size = patternBufferSize(maxSize, period);
+    if (size == 0 || bytes == nullptr) return nullptr;
+
+    std::string patternBytes(reinterpret_cast<const char*>(bytes), period);
+    std::string key = patternBytes + '#' + std::to_string(size) + '@' + std::to_string(numaNode);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (auto it = cacheEntries.begin(); it != cacheEntries.end(); ++it) {
+        if (it->key == key) {
+            cacheEntries.splice(cacheEntries.begin(), cacheEntries, it);
+            return it->pattern;
+        }
+    }
+
+    // One period span past `size`, so a chunk can start at any phase
+    size_t stored = size + lcm(period, PATTERN_ALIGNMENT);
+
+    // Fill a plain buffer only when the pattern cannot be repeated from a tile
+    WIPE_PROBE(pattern__start, probeJobId(), stored);
+    std::unique_ptr<AlignedBuffer> storage = AlignedBuffer::repeating(stored, bytes, period, numaNode);
+    if (!storage) {
+        storage.reset(new AlignedBuffer(stored, numaNode));
+        if (storage->valid()) {
+            replicatePattern(storage->data(), stored, bytes, period);
+            storage->protect();
+        }
+    }
+    WIPE_PROBE(pattern__end, probeJobId(), stored);
+    if (!storage->valid()) return nullptr;
+
+    PatternRef pattern = std::make_shared<const PatternBuffer>(std::move(storage), period, patternBytes);
+    cacheEntries.push_front(CacheEntry{key, pattern});
+    cacheBytes += pattern->resident;
+    evictIdleLocked();
+    return pattern;
+}
+
+PatternRef acquireConstantPattern(uint8_t value, size_t maxSize, int numaNode) {
+    return acquirePattern(&value, 1, maxSize, numaNode);
+}
+
+size_t patternCacheBytes() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return cacheBytes;
+}
+
+void clearPatternCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheEntries.clear();
+    cacheBytes = 0;
+}
+
+// Scratch pool: idle buffers are reused by size, the rest are freed
+namespace {
+std::mutex scratchMutex;
+std::vector<std::unique_ptr<AlignedBuffer>> idleScratch;
+std::atomic<size_t> scratchCount{0};
+std::atomic<size_t> scratchBytes{0};
+
+void releaseScratch(AlignedBuffer* buffer) {
+    std::unique_ptr<AlignedBuffer> owned(buffer);
+    std::lock_guard<std::mutex> lock(scratchMutex);
+    if (idleScratch.size() < SCRATCH_POOL_IDLE) {
+        idleScratch.push_back(std::move(owned));
+        return;
+    }
+    scratchCount--;
+    scratchBytes -= owned->size();
+}
+}
+
+ScratchRef acquireScratchBuffer(size_t size, int numaNode) {
+    std::unique_ptr<AlignedBuffer> buffer;
+    {
+        std::lock_guard<std::mutex> lock(scratchMutex);
+        for (auto it = idleScratch.begin(); it != idleScratch.end(); ++it) {
+            if ((*it)->size() == size && (*it)->node() == numaNode) {
+                buffer = std::move(*it);
+                idleScratch.erase(it);
+                break;
+            }
+        }
+    }
+    if (!buffer) {
+        buffer.reset(new AlignedBuffer(size, numaNode));
+        if (!buffer->valid()) return nullptr;
+        scratchCount++;
+        scratchBytes += size;
+    }
+    return ScratchRef(buffer.release(), releaseScratch);
+}
+
+PatternArenaStats patternArenaStats() {
+    PatternArenaStats stats = {};
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (const CacheEntry& entry : cacheEntries) {
+            stats.patterns++;
+            stats.patternBytes += entry.pattern->resident;
+            if (entry.pattern->resident < entry.pattern->size) stats.repeatedBytes += entry.pattern->size;
+            if (entry.pattern.use_count() > 1) {
+                stats.inUsePatterns++;
+                stats.inUsePatternBytes += entry.pattern->resident;
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(scratchMutex);
+        for (const auto& buffer : idleScratch) stats.idleScratchBytes += buffer->size();
+    }
+    stats.scratchBuffers = scratchCount;
+    stats.scratchBytes = scratchBytes;
+    stats.hugePageBytes = backingBytes[static_cast<size_t>(BufferBacking::HugePages)];
+    stats.transparentBytes = backingBytes[static_cast<size_t>(BufferBacking::Transparent)];
+    for (const auto& bytes : backingBytes) stats.totalBytes += bytes;
+    return stats;
+}
+
+// Export for testing
+#ifdef TEST_STANDALONE
+#include "wipeSchemes.h"
+#include <iostream>
+#include <chrono>
+
+int main() {
+    const uint8_t gutmann[3] = {0x92, 0x49, 0x24};
+    const size_t size = 32 * 1024 * 1024;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    PatternRef pattern = acquirePattern(gutmann, 3, size);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    bool ok = pattern && pattern->size % 3 == 0 && pattern->size % PATTERN_ALIGNMENT == 0;
+    for (size_t i = 0; ok && i < pattern->size; i++) {
+        ok = pattern->data[i] == gutmann[i % 3];
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::cout << "Pattern 92 49 24: " << (ok ? "OK" : "MISMATCH")
+              << " (" << pattern->size << " bytes in " << ms << " ms, "
+              << (pattern->size / 1024.0 / 1024.0) / (ms / 1000.0) << " MB/s)" << std::endl;
+    std::cout << "Cache hit returns same buffer: "
+              << (acquirePattern(gutmann, 3, size) == pattern ? "OK" : "FAIL") << std::endl;
+
+    // 128 MB buffers as a wipe pass uses them: zeros and a 3-byte pattern
+    const uint8_t zero = 0;
+    PatternRef zeros = acquirePattern(&zero, 1, 128 * 1024 * 1024);
+    PatternRef large = acquirePattern(gutmann, 3, 128 * 1024 * 1024);
+    bool repeated = zeros && large;
+    for (size_t i = 0; repeated && i < zeros->size; i += 512) repeated = zeros->data[i] == 0;
+    for (size_t i = 0; repeated && i < large->size; i++) repeated = large->data[i] == gutmann[i % 3];
+    std::cout << "Repeated 128 MB buffers: " << (repeated ? "OK" : "MISMATCH");
+    if (zeros && large) {
+        std::cout << " (zeros " << (zeros->resident >> 10) << " KB, pattern " << (large->resident >> 10)
+                  << " KB resident)";
+    }
+    std::cout << std::endl;
+    ok = ok && repeated;
+
+    // A job reading them is charged their resident memory, not their span
+    if (zeros && large) {
+        JobRef job = startJob("pattern-test", "memory");
+        JobScope scope(job);
+        bool charged;
+        {
+            PatternSource zeroSource(zeros);
+            PatternSource largeSource(large);
+            charged = job->memory().sharedBytes == zeros->resident + large->resident &&
+                      job->memory().sharedBytes < large->size;
+        }
+        charged = charged && job->memory().sharedBytes == 0;
+        std::cout << "Job charged resident pattern bytes: " << (charged ? "OK" : "FAIL") << " (peak "
+                  << (job->memory().peakSharedBytes >> 10) << " KB for " << ((zeros->size + large->size) >> 20)
+                  << " MB mapped)" << std::endl;
+        ok = ok && charged;
+    }
+
+    ScratchRef first = acquireScratchBuffer(RANDOM_CHUNK_SIZE);
+    AlignedBuffer* firstPtr = first.get();
+    first.reset();
+    std::cout << "Scratch buffer reused from pool: "
+              << (acquireScratchBuffer(RANDOM_CHUNK_SIZE).get() == firstPtr ? "OK" : "FAIL") << std::endl;
+
+    PatternArenaStats stats = patternArenaStats();
+    std::cout << "Arena: " << stats.patterns << " patterns (" << stats.inUsePatterns << " in use), "
+              << stats.scratchBuffers << " scratch, " << (stats.totalBytes >> 20) << " MB total, "
+              << (stats.hugePageBytes >> 20) << " MB hugetlb, " << (stats.transparentBytes >> 20) << " MB THP, "
+              << (stats.repeatedBytes >> 20) << " MB repeated" << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
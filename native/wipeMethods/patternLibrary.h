@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Overwrite pattern library.
+//
+// A pattern is `period` bytes repeated across the whole target, so byte N of
+// the device is pattern[N % period]. A chunk bound for device offset N must
+// therefore start at phase N % period, not at the start of a buffer: writers
+// that split the target (stripes, zones, file extents) start mid-period.
+// Address buffers through PatternBuffer::at(N), which returns data + N % span
+// with span = lcm(period, PATTERN_ALIGNMENT). A buffer holds `size` bytes
+// past any such start, and the pointer is as aligned as N is, up to
+// PATTERN_ALIGNMENT, so unbuffered writes keep working.
+//
+// Pattern buffers are immutable once built and are cached process-wide, so a
+// 35-pass Gutmann run (or the next job, or twenty concurrent jobs) shares one
+// read-only copy instead of re-filling. Random passes draw their scratch from
+// a small pool instead of allocating per pass.
+//
+// Buffers of HUGE_PAGE_SIZE and up are backed by huge pages where the OS
+// allows it (MAP_HUGETLB, then transparent huge pages; MEM_LARGE_PAGES on
+// Windows), which cuts TLB misses both while filling and during DMA. A NUMA
+// node can be requested (numaPlacement.h); buffers for different nodes are
+// cached separately so a job never streams from a remote node's memory.
+//
+// Large buffers of a short pattern do not need their full size in memory
+// (Unix): a zero pattern is a read-only mapping that is never written, so
+// every page is the kernel's shared zero page, and any other pattern maps
+// one PATTERN_TILE_SIZE tile over and over into a contiguous range. Writes
+// stay as large as the buffer while each pattern costs at most one tile.
+
+constexpr size_t PATTERN_ALIGNMENT = 4096;       // Sector/page alignment for unbuffered I/O
+constexpr size_t MAX_PATTERN_PERIOD = 4096;      // Longest user-supplied pattern
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+constexpr size_t RANDOM_CHUNK_SIZE = 16 * 1024 * 1024;   // Cap on a random pass's scratch buffer
+constexpr size_t PATTERN_TILE_SIZE = 1024 * 1024;         // Memory behind a repeated pattern buffer
+
+enum class BufferBacking : uint8_t {
+    None,           // Allocation failed
+    Heap,           // Small block, aligned heap allocation
+    Pages,          // Anonymous mapping, normal pages
+    Transparent,    // Anonymous mapping advised for transparent huge pages
+    HugePages,      // MAP_HUGETLB / MEM_LARGE_PAGES
+    ZeroPages,      // Read-only, never written: all reads hit the shared zero page
+    Mirrored        // One tile mapped repeatedly (memfd)
+};
+
+// Page-aligned block (pattern storage and scratch buffers for random passes)
+class AlignedBuffer {
+public:
+    explicit AlignedBuffer(size_t size, int numaNode = -1);
+    ~AlignedBuffer();
+
+    // Read-only `size` bytes of the periodic pattern, backed by the zero
+    // page (all-zero patterns) or by one tile mapped `size / tile` times.
+    // Null on Windows, when `size` is not a whole number of tiles, or when
+    // the mappings fail; callers then fill a plain buffer.
+    static std::unique_ptr<AlignedBuffer> repeating(size_t size, const uint8_t* bytes, size_t period, int numaNode = -1);
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    uint8_t* data() const { return ptr; }
+    size_t size() const { return length; }
+    size_t resident() const { return memory; }     // Memory actually behind the buffer
+    bool valid() const { return ptr != nullptr; }
+    BufferBacking backing() const { return kind; }
+    int node() const { return numaNode; }     // Requested NUMA node, -1 for any
+
+    // Make the block read-only; a stray write into a shared pattern faults
+    // instead of silently corrupting every job that uses it
+    bool protect();
+
+private:
+    AlignedBuffer();
+
+    uint8_t* ptr;
+    size_t length;
+    size_t mapped;          // Mapping length (length rounded up to the page size)
+    size_t memory;          // `mapped`, except for ZeroPages (0) and Mirrored (one tile)
+    BufferBacking kind;
+    int numaNode;
+};
+
+struct PatternBuffer {
+    const uint8_t* data;
+    size_t size;            // Multiple of lcm(period, PATTERN_ALIGNMENT)
+    size_t span;            // lcm(period, PATTERN_ALIGNMENT); `data` holds size + span bytes
+    size_t resident;        // Memory behind it; below `size` for zero-page and tiled buffers
+    size_t period;
+    std::string bytes;      // The `period` pattern bytes
+
+    // `size` bytes at the pattern's phase for device offset `offset`. As
+    // aligned as the offset, up to PATTERN_ALIGNMENT, for unbuffered writes.
+    const uint8_t* at(uint64_t offset) const { return data + offset % span; }
+
+    PatternBuffer(std::unique_ptr<AlignedBuffer> storage, size_t period, const std::string& bytes);
+
+private:
+    std::unique_ptr<AlignedBuffer> storage;
+};
+
+using PatternRef = std::shared_ptr<const PatternBuffer>;
+
+// Largest buffer size <= maxSize that is a whole number of pattern periods and
+// of PATTERN_ALIGNMENT (0 if the period is too long to fit).
+size_t patternBufferSize(size_t maxSize, size_t period);
+
+// Cached, immutable pattern buffers, placed on `numaNode` when one is given.
+// Return null on bad input or allocation failure.
+PatternRef acquirePattern(const uint8_t* bytes, size_t period, size_t maxSize, int numaNode = -1);
+PatternRef acquireConstantPattern(uint8_t value, size_t maxSize, int numaNode = -1);
+
+// Fill dst with the periodic pattern starting at phase 0. Replicates a SIMD
+// register tile of lcm(period, vector width) bytes with streaming stores.
+void replicatePattern(uint8_t* dst, size_t size, const uint8_t* bytes, size_t period);
+
+// Pooled scratch buffer for random passes. Returned to the pool when the last
+// reference goes away; at most a few idle buffers are kept.
+using ScratchRef = std::shared_ptr<AlignedBuffer>;
+ScratchRef acquireScratchBuffer(size_t size, int numaNode = -1);
+
+// Fast non-deterministic fill (xoshiro256** per thread, seeded from std::random_device)
+void fillRandomBytes(uint8_t* dst, size_t size);
+
+// Cache bookkeeping
+size_t patternCacheBytes();
+void clearPatternCache();
+
+struct PatternArenaStats {
+    size_t patterns;            // Cached pattern buffers
+    size_t patternBytes;        // Resident
+    size_t inUsePatterns;       // Referenced by at least one running pass
+    size_t inUsePatternBytes;
+    size_t repeatedBytes;       // Buffer bytes served by the zero page or a repeated tile
+    size_t scratchBuffers;      // Random-pass scratch, pooled and in use
+    size_t scratchBytes;
+    size_t idleScratchBytes;
+    size_t hugePageBytes;       // Of all live buffers, backed by MAP_HUGETLB / large pages
+    size_t transparentBytes;    // Advised for transparent huge pages
+    size_t totalBytes;          // Every live AlignedBuffer, including small heap blocks
+};
+
+PatternArenaStats patternArenaStats();
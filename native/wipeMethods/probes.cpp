@@ -0,0 +1,8 @@
+#include "probes.h"
+
+// The probe semaphores, in the section tracers look them up in
+#ifdef WIPE_PROBES
+#define WIPE_DEFINE_PROBE_SEMAPHORE(name) \
+    volatile unsigned short WIPE_PROBE_SEMAPHORE(name) __attribute__((section(".probes"))) = 0;
+WIPE_PROBE_LIST(WIPE_DEFINE_PROBE_SEMAPHORE)
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#include "wipeJob.h"
+
+// USDT probes (sys/sdt.h) at the engine's hot points, for bpftrace and perf
+// on production wipes without a rebuild or log noise.
+//
+// Provider "dropdrive"; the first argument of every probe is the job id
+// ("" outside a job):
+//
+//   wipe__start       job, path, size              optimizedWipe
+//   wipe__end         job, ok, bytes written
+//   pass__start       job, pass, passes, size      every scheme and pattern pass
+//   pass__end         job, pass, ok
+//   chunk__submit     job, offset, size            every device read and write (IoTimer)
+//   chunk__complete   job, offset, size, error, latency ns, is read
+//   pattern__start    job, size                    random fill of one chunk (the
+//   pattern__end      job, size                    writer picks its offset later), or
+//                                                  a pattern buffer built on a cache miss
+//   verify__mismatch  job, offset, size            read-back region not holding the pattern,
+//                                                  or no longer matching its evidence
+//   sanitize__poll    job, operation, progress (basis points, -1 unknown), finished
+//
+// Each probe has a semaphore the tracer raises while attached. Unattached, a
+// probe is a never-taken branch on it plus a nop: its arguments (the job
+// lookup included) are not evaluated. Built without sys/sdt.h (the
+// systemtap-sdt-dev package), on other platforms or with WIPE_NO_PROBES,
+// probes compile to nothing.
+//
+//   bpftrace -e 'usdt:./native/build/Release/wipeAddon.node:dropdrive:chunk__complete
+//                { @us[str(arg0)] = hist(arg4 / 1000); }'
+
+#if defined(__linux__) && !defined(WIPE_NO_PROBES) && defined(__has_include)
+    #if __has_include(<sys/sdt.h>)
+        #define WIPE_PROBES 1
+    #endif
+#endif
+
+#define WIPE_PROBE_LIST(X) \
+    X(wipe__start) X(wipe__end) X(pass__start) X(pass__end) X(chunk__submit) X(chunk__complete) \
+    X(pattern__start) X(pattern__end) X(verify__mismatch) X(sanitize__poll)
+
+#ifdef WIPE_PROBES
+    #define _SDT_HAS_SEMAPHORES 1
+    #include <sys/sdt.h>
+
+    // Named as sys/sdt.h expects: <provider>_<probe>_semaphore
+    #define WIPE_PROBE_SEMAPHORE(name) dropdrive_##name##_semaphore
+    #define WIPE_DECLARE_PROBE_SEMAPHORE(name) extern "C" volatile unsigned short WIPE_PROBE_SEMAPHORE(name);
+WIPE_PROBE_LIST(WIPE_DECLARE_PROBE_SEMAPHORE)
+
+    #define WIPE_PROBE_ENABLED(name) __builtin_expect(WIPE_PROBE_SEMAPHORE(name) != 0, 0)
+    #define WIPE_PROBE(name, ...) \
+        do { if (WIPE_PROBE_ENABLED(name)) STAP_PROBEV(dropdrive, name, __VA_ARGS__); } while (0)
+#else
+    // The arguments only appear in an unevaluated operand, so values computed
+    // for a probe alone still count as used
+    template <typename... Args> int wipeProbeArgs(const Args&...);
+    #define WIPE_PROBE_ENABLED(name) false
+    #define WIPE_PROBE(name, ...) do { (void)sizeof(wipeProbeArgs(__VA_ARGS__)); } while (0)
+#endif
+
+// Job id argument of the probes; only evaluated with a tracer attached
+inline const char* probeJobId() {
+    WipeJob* job = currentJob();
+    return job ? job->id.c_str() : "";
+}
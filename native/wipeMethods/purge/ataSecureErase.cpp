@@ -6,190 +6,31 @@
 #include <chrono>
 #include <thread>
 #include "purgeCommon.h"
+#include "../deviceSession.h"
+#include "../telemetry.h"
 
 // ATA command definitions
-#define ATA_CMD_IDENTIFY_DEVICE       0xEC
 #define ATA_CMD_SECURITY_SET_PASSWORD 0xF1
 #define ATA_CMD_SECURITY_ERASE_PREPARE 0xF3
 #define ATA_CMD_SECURITY_ERASE_UNIT    0xF4
 
-// ATA IDENTIFY DEVICE offsets
-#define ATA_ID_SECURITY_STATUS    128  // Word 128: Security status
-
-// Security status bits
-#define ATA_SECURITY_SUPPORTED    0x0001
-#define ATA_SECURITY_ENABLED      0x0002
-#define ATA_SECURITY_LOCKED       0x0004
-#define ATA_SECURITY_FROZEN       0x0008
-#define ATA_SECURITY_COUNT_EXPIRED 0x0010
-#define ATA_SECURITY_ENHANCED_ERASE 0x0020
-
-struct ATASecurityInfo {
-    bool supported;
-    bool enabled;
-    bool locked;
-    bool frozen;
-    bool enhancedEraseSupported;
-    uint16_t securityWord;
-};
-
-// Detect device type from storage properties
-static DeviceType detectDeviceType(const std::string& drivePath) {
-    HANDLE hDevice = CreateFileA(
-        drivePath.c_str(),
-        GENERIC_READ,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hDevice == INVALID_HANDLE_VALUE) {
-        return DeviceType::UNKNOWN;
-    }
-
-    DeviceType result = DeviceType::UNKNOWN;
-
-    // Query adapter properties for bus type
-    STORAGE_PROPERTY_QUERY query;
-    ZeroMemory(&query, sizeof(query));
-    query.PropertyId = StorageAdapterProperty;
-    query.QueryType = PropertyStandardQuery;
-
-    BYTE adapterBuffer[1024];
-    DWORD bytesReturned = 0;
-
-    if (DeviceIoControl(hDevice,
-                        IOCTL_STORAGE_QUERY_PROPERTY,
-                        &query,
-                        sizeof(query),
-                        adapterBuffer,
-                        sizeof(adapterBuffer),
-                        &bytesReturned,
-                        NULL)) {
-        STORAGE_ADAPTER_DESCRIPTOR* adapter = (STORAGE_ADAPTER_DESCRIPTOR*)adapterBuffer;
-        
-        switch (adapter->BusType) {
-            case BusTypeUsb:
-                result = DeviceType::USB;
-                break;
-            case BusTypeNvme:
-                result = DeviceType::NVME;
-                break;
-            case BusTypeAta:
-            case BusTypeSata:
-            case BusTypeAtapi:
-                // Need to determine if SSD or HDD
-                result = DeviceType::SATA_HDD;  // Default, will refine below
-                break;
-            case BusTypeScsi:
-            case BusTypeSas:
-                result = DeviceType::SCSI;
-                break;
-            default:
-                result = DeviceType::UNKNOWN;
-                break;
-        }
-    }
-
-    // Try to detect SSD vs HDD for SATA devices
-    if (result == DeviceType::SATA_HDD) {
-        ZeroMemory(&query, sizeof(query));
-        query.PropertyId = StorageDeviceSeekPenaltyProperty;
-        query.QueryType = PropertyStandardQuery;
-
-        DEVICE_SEEK_PENALTY_DESCRIPTOR seekPenalty;
-        if (DeviceIoControl(hDevice,
-                            IOCTL_STORAGE_QUERY_PROPERTY,
-                            &query,
-                            sizeof(query),
-                            &seekPenalty,
-                            sizeof(seekPenalty),
-                            &bytesReturned,
-                            NULL)) {
-            if (!seekPenalty.IncursSeekPenalty) {
-                result = DeviceType::SATA_SSD;
-            }
-        }
-    }
-
-    CloseHandle(hDevice);
-    return result;
-}
-
-// Get ATA security information (non-destructive query)
-static ATASecurityInfo getATASecurityInfo(const std::string& drivePath) {
-    ATASecurityInfo info = {false, false, false, false, false, 0};
-    
-    HANDLE hDevice = CreateFileA(
-        drivePath.c_str(),
-        GENERIC_READ | GENERIC_WRITE,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hDevice == INVALID_HANDLE_VALUE) {
-        std::cerr << "Error opening drive for security info: " << GetLastError() << std::endl;
-        return info;
-    }
-
-    // Prepare ATA IDENTIFY DEVICE command (this is a read-only query)
-    struct {
-        ATA_PASS_THROUGH_EX apt;
-        BYTE buffer[512];
-    } identifyData;
-
-    ZeroMemory(&identifyData, sizeof(identifyData));
-    identifyData.apt.Length = sizeof(ATA_PASS_THROUGH_EX);
-    identifyData.apt.AtaFlags = ATA_FLAGS_DATA_IN;
-    identifyData.apt.DataTransferLength = 512;
-    identifyData.apt.TimeOutValue = 10;
-    identifyData.apt.DataBufferOffset = sizeof(ATA_PASS_THROUGH_EX);
-    identifyData.apt.CurrentTaskFile[6] = ATA_CMD_IDENTIFY_DEVICE;
-
-    DWORD bytesReturned = 0;
-    if (DeviceIoControl(hDevice,
-                        IOCTL_ATA_PASS_THROUGH,
-                        &identifyData,
-                        sizeof(identifyData),
-                        &identifyData,
-                        sizeof(identifyData),
-                        &bytesReturned,
-                        NULL)) {
-        
-        // Extract security word (word 128)
-        uint16_t* identifyWords = (uint16_t*)identifyData.buffer;
-        info.securityWord = identifyWords[ATA_ID_SECURITY_STATUS];
-        
-        info.supported = (info.securityWord & ATA_SECURITY_SUPPORTED) != 0;
-        info.enabled = (info.securityWord & ATA_SECURITY_ENABLED) != 0;
-        info.locked = (info.securityWord & ATA_SECURITY_LOCKED) != 0;
-        info.frozen = (info.securityWord & ATA_SECURITY_FROZEN) != 0;
-        info.enhancedEraseSupported = (info.securityWord & ATA_SECURITY_ENHANCED_ERASE) != 0;
-    }
-
-    CloseHandle(hDevice);
-    return info;
-}
-
-// Main ATA Secure Erase function with dryRun support
-PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool dryRun) {
-    PurgeResult result;
+// Validate, then SECURITY SET PASSWORD and SECURITY ERASE PREPARE. True
+// when the drive expects SECURITY ERASE UNIT next; otherwise `result` is
+// final. `useEnhanced` falls back to normal erase when unsupported.
+static bool prepareErase(DeviceSession& session, bool& useEnhanced, bool dryRun, PurgeResult& result,
+                         uint64_t& estimateMs) {
+    const std::string& drivePath = session.path;
     result.devicePath = drivePath;
     result.method = useEnhanced ? PurgeMethod::ATA_SECURE_ERASE_ENHANCED : PurgeMethod::ATA_SECURE_ERASE;
     
-    std::cout << "=== ATA Secure Erase ===" << std::endl;
-    std::cout << "Drive: " << drivePath << std::endl;
-    std::cout << "Mode: " << (useEnhanced ? "Enhanced" : "Normal") << std::endl;
-    std::cout << "Dry Run: " << (dryRun ? "YES (no data will be erased)" : "NO (DESTRUCTIVE)") << std::endl;
+    logInfo("ata") << "=== ATA Secure Erase ===";
+    logInfo("ata") << "Drive: " << drivePath;
+    logInfo("ata") << "Mode: " << (useEnhanced ? "Enhanced" : "Normal");
+    logInfo("ata") << "Dry Run: " << (dryRun ? "YES (no data will be erased)" : "NO (DESTRUCTIVE)");
 
-    // Step 1: Detect device type
-    result.deviceType = detectDeviceType(drivePath);
-    std::cout << "Detected device type: " << deviceTypeToString(result.deviceType) << std::endl;
+    // Step 1: Device type (probed once when the session was opened)
+    result.deviceType = session.deviceType;
+    logInfo("ata") << "Detected device type: " << deviceTypeToString(result.deviceType);
 
     // Step 2: Check if purge is supported for this device type
     if (!isPurgeSupported(result.deviceType)) {
@@ -199,20 +40,20 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
         result.status = "unsupported";
         result.message = "ATA Secure Erase not supported for " + deviceTypeToString(result.deviceType) + " devices";
         result.reason = getUnsupportedReason(result.deviceType);
-        std::cerr << "ERROR: " << result.message << std::endl;
-        std::cerr << "Reason: " << result.reason << std::endl;
-        return result;
+        logError("ata") << result.message;
+        logError("ata") << "Reason: " << result.reason;
+        return false;
     }
 
     // Step 3: Check ATA security capabilities (this is a non-destructive read)
-    ATASecurityInfo secInfo = getATASecurityInfo(drivePath);
+    const ATASecurityInfo& secInfo = session.ataSecurity();
     
-    std::cout << "Security Status:" << std::endl;
-    std::cout << "  ATA Security Supported: " << secInfo.supported << std::endl;
-    std::cout << "  Security Enabled: " << secInfo.enabled << std::endl;
-    std::cout << "  Locked: " << secInfo.locked << std::endl;
-    std::cout << "  Frozen: " << secInfo.frozen << std::endl;
-    std::cout << "  Enhanced Erase Supported: " << secInfo.enhancedEraseSupported << std::endl;
+    logInfo("ata") << "Security Status:";
+    logInfo("ata") << "  ATA Security Supported: " << secInfo.supported;
+    logInfo("ata") << "  Security Enabled: " << secInfo.enabled;
+    logInfo("ata") << "  Locked: " << secInfo.locked;
+    logInfo("ata") << "  Frozen: " << secInfo.frozen;
+    logInfo("ata") << "  Enhanced Erase Supported: " << secInfo.enhancedEraseSupported;
     
     if (!secInfo.supported) {
         result.success = false;
@@ -221,8 +62,8 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
         result.status = "unsupported";
         result.message = "Drive does not support ATA Secure Erase";
         result.reason = "ATA IDENTIFY DEVICE indicates security features are not supported";
-        std::cerr << "ERROR: " << result.message << std::endl;
-        return result;
+        logError("ata") << result.message;
+        return false;
     }
 
     // Check for blocking conditions
@@ -233,8 +74,8 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
         result.status = "blocked";
         result.message = "Drive is security frozen";
         result.reason = "Drive security is frozen by BIOS. Reboot or power cycle the drive to unfreeze.";
-        std::cerr << "ERROR: " << result.message << std::endl;
-        return result;
+        logError("ata") << result.message;
+        return false;
     }
 
     if (secInfo.locked) {
@@ -244,12 +85,12 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
         result.status = "blocked";
         result.message = "Drive is locked";
         result.reason = "Drive has an active security password and is locked.";
-        std::cerr << "ERROR: " << result.message << std::endl;
-        return result;
+        logError("ata") << result.message;
+        return false;
     }
 
     if (useEnhanced && !secInfo.enhancedEraseSupported) {
-        std::cout << "WARNING: Enhanced erase not supported. Using normal erase." << std::endl;
+        logWarn("ata") << "Enhanced erase not supported. Using normal erase.";
         useEnhanced = false;
         result.method = PurgeMethod::ATA_SECURE_ERASE;
     }
@@ -263,44 +104,35 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
         result.message = "ATA Secure Erase is SUPPORTED for this device (dry run - no data erased)";
         result.reason = "Dry run mode: Device capability verified. No destructive commands sent.";
         
-        std::cout << "\n=== DRY RUN COMPLETE ===" << std::endl;
-        std::cout << "Result: " << result.message << std::endl;
-        std::cout << "Device Type: " << deviceTypeToString(result.deviceType) << std::endl;
-        std::cout << "Method: " << purgeMethodToString(result.method) << std::endl;
-        std::cout << "Enhanced Erase Available: " << secInfo.enhancedEraseSupported << std::endl;
-        std::cout << "NO DATA WAS ERASED - This was a simulation." << std::endl;
+        logInfo("ata") << "=== DRY RUN COMPLETE ===";
+        logInfo("ata") << "Result: " << result.message;
+        logInfo("ata") << "Device Type: " << deviceTypeToString(result.deviceType);
+        logInfo("ata") << "Method: " << purgeMethodToString(result.method);
+        logInfo("ata") << "Enhanced Erase Available: " << secInfo.enhancedEraseSupported;
+        logInfo("ata") << "NO DATA WAS ERASED - This was a simulation.";
         
-        return result;
+        return false;
     }
 
     // ============================================
     // DESTRUCTIVE OPERATIONS BELOW - NOT DRY RUN
     // ============================================
     
-    std::cout << "\n!!! EXECUTING DESTRUCTIVE OPERATION !!!" << std::endl;
-
-    // Open device for writing
-    HANDLE hDevice = CreateFileA(
-        drivePath.c_str(),
-        GENERIC_READ | GENERIC_WRITE,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hDevice == INVALID_HANDLE_VALUE) {
+    logWarn("ata") << "!!! EXECUTING DESTRUCTIVE OPERATION !!!";
+
+    // The session handle must be read-write for pass-through data-out commands
+    if (!session.writable) {
         result.success = false;
         result.supported = true;
         result.executed = false;
         result.status = "error";
-        result.errorCode = GetLastError();
+        result.errorCode = session.openError;
         result.message = "Failed to open drive";
         result.reason = "CreateFile failed with error code " + std::to_string(result.errorCode);
-        std::cerr << "ERROR: " << result.message << std::endl;
-        return result;
+        logError("ata") << result.message;
+        return false;
     }
+    HANDLE hDevice = session.handle;
 
     // Password buffer (all zeros for initial secure erase)
     BYTE passwordBuffer[512] = {0};
@@ -314,7 +146,7 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
     DWORD bytesReturned = 0;
 
     // Step 1: SECURITY SET PASSWORD
-    std::cout << "Step 1: Setting security password..." << std::endl;
+    logInfo("ata") << "Step 1: Setting security password...";
     ZeroMemory(&commandData, sizeof(commandData));
     memcpy(commandData.buffer, passwordBuffer, 512);
     
@@ -336,12 +168,11 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
         result.errorCode = GetLastError();
         result.message = "SECURITY SET PASSWORD failed";
         result.reason = "Error code " + std::to_string(result.errorCode);
-        CloseHandle(hDevice);
-        return result;
+        return false;
     }
 
     // Step 2: SECURITY ERASE PREPARE
-    std::cout << "Step 2: Erase prepare..." << std::endl;
+    logInfo("ata") << "Step 2: Erase prepare...";
     ZeroMemory(&commandData, sizeof(commandData));
     
     commandData.apt.Length = sizeof(ATA_PASS_THROUGH_EX);
@@ -362,17 +193,26 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
         result.errorCode = GetLastError();
         result.message = "SECURITY ERASE PREPARE failed";
         result.reason = "Error code " + std::to_string(result.errorCode);
-        CloseHandle(hDevice);
-        return result;
+        return false;
     }
 
-    // Step 3: SECURITY ERASE UNIT
-    std::cout << "Step 3: Executing secure erase..." << std::endl;
-    std::cout << "WARNING: This may take hours. DO NOT interrupt!" << std::endl;
+    estimateMs = (useEnhanced ? secInfo.enhancedEraseMinutes : secInfo.eraseMinutes) * 60000ULL;
+    if (estimateMs) logInfo("ata") << "Drive estimate: " << (estimateMs / 60000) << " minutes";
+    return true;
+}
+
+// Step 3: SECURITY ERASE UNIT. Blocks until the drive has finished.
+static bool eraseUnit(HANDLE hDevice, bool useEnhanced, uint32_t& errorCode) {
+    logInfo("ata") << "Step 3: Executing secure erase...";
+    logWarn("ata") << "This may take hours. DO NOT interrupt!";
 
+    struct {
+        ATA_PASS_THROUGH_EX apt;
+        BYTE buffer[512];
+    } commandData;
+
+    // Password buffer (all zeros, as set in step 1)
     ZeroMemory(&commandData, sizeof(commandData));
-    memcpy(commandData.buffer, passwordBuffer, 512);
-    
     if (useEnhanced) {
         commandData.buffer[0] = 0x02;  // Enhanced erase
     }
@@ -384,41 +224,104 @@ PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool
     commandData.apt.DataBufferOffset = sizeof(ATA_PASS_THROUGH_EX);
     commandData.apt.CurrentTaskFile[6] = ATA_CMD_SECURITY_ERASE_UNIT;
 
-    auto startTime = std::chrono::high_resolution_clock::now();
-
+    DWORD bytesReturned = 0;
     if (!DeviceIoControl(hDevice, IOCTL_ATA_PASS_THROUGH,
                          &commandData, sizeof(commandData),
                          &commandData, sizeof(commandData),
                          &bytesReturned, NULL)) {
-        result.success = false;
-        result.supported = true;
-        result.executed = true;  // We attempted execution
-        result.status = "error";
-        result.errorCode = GetLastError();
-        result.message = "SECURITY ERASE UNIT failed";
-        result.reason = "Error code " + std::to_string(result.errorCode);
-        CloseHandle(hDevice);
-        return result;
+        errorCode = GetLastError();
+        return false;
     }
+    return true;
+}
 
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime).count();
-
-    CloseHandle(hDevice);
+// ERASE UNIT runs on a thread of the sanitize monitor's, which reports
+// progress from the drive's estimate. The command must immediately follow
+// ERASE PREPARE, so nothing else is sent to the drive in between.
+static SanitizeRequest eraseRequest(const PurgeResult& result, uint64_t estimateMs, HANDLE hDevice, bool useEnhanced,
+                                    std::shared_ptr<uint32_t> errorCode) {
+    SanitizeRequest request = {};
+    request.path = result.devicePath;
+    request.method = purgeMethodToString(result.method);
+    request.estimateMs = estimateMs;
+    request.command = [hDevice, useEnhanced, errorCode](std::string& message) {
+        if (eraseUnit(hDevice, useEnhanced, *errorCode)) return true;
+        message = "SECURITY ERASE UNIT failed (error " + std::to_string(*errorCode) + ")";
+        return false;
+    };
+    return request;
+}
 
-    result.success = true;
+// Final result from the monitor's outcome
+static void finishResult(PurgeResult& result, const SanitizeProgress& outcome, uint32_t errorCode) {
     result.supported = true;
-    result.executed = true;
+    result.executed = true;  // We attempted execution
+    result.success = outcome.state == SanitizeState::Succeeded;
+    if (!result.success) {
+        result.status = "error";
+        result.errorCode = errorCode;
+        result.message = "SECURITY ERASE UNIT failed";
+        result.reason = "Error code " + std::to_string(errorCode);
+        return;
+    }
+
+    uint64_t duration = outcome.elapsedMs / 1000;
     result.status = "success";
     result.message = "ATA Secure Erase completed successfully";
     result.reason = "Completed in " + std::to_string(duration) + " seconds";
 
-    std::cout << "\n=== SECURE ERASE COMPLETE ===" << std::endl;
-    std::cout << "Time taken: " << duration << " seconds (" << (duration / 60) << " minutes)" << std::endl;
+    logInfo("ata") << "=== SECURE ERASE COMPLETE ===";
+    logInfo("ata") << "Time taken: " << duration << " seconds (" << (duration / 60) << " minutes)";
+}
+
+// Main ATA Secure Erase function with dryRun support
+PurgeResult ataSecureErase(DeviceSession& session, bool useEnhanced, bool dryRun) {
+    PurgeResult result;
+    uint64_t estimateMs = 0;
+    if (!prepareErase(session, useEnhanced, dryRun, result, estimateMs)) return result;
+
+    auto errorCode = std::make_shared<uint32_t>(0);
+    SanitizeProgress outcome = waitSanitize(monitorSanitize(
+        eraseRequest(result, estimateMs, session.handle, useEnhanced, errorCode)));
+    finishResult(result, outcome, *errorCode);
+    return result;
+}
+
+// Prepare the drive and return once SECURITY ERASE UNIT is under way; the
+// monitor keeps the session open and reports progress and the final result
+// to `listener`. status "started" on success, and *operation is the
+// monitor's id.
+PurgeResult startAtaSecureErase(std::shared_ptr<DeviceSession> session, bool useEnhanced, PurgeListener listener,
+                                uint64_t* operation) {
+    PurgeResult result;
+    uint64_t estimateMs = 0;
+    if (!prepareErase(*session, useEnhanced, false, result, estimateMs)) return result;
+
+    auto errorCode = std::make_shared<uint32_t>(0);
+    SanitizeRequest request = eraseRequest(result, estimateMs, session->handle, useEnhanced, errorCode);
+    request.listener = [session, result, errorCode, listener](const SanitizeProgress& progress) {
+        PurgeResult final = result;
+        if (progress.state != SanitizeState::Running) finishResult(final, progress, *errorCode);
+        if (listener) listener(progress, final);
+    };
+    request.finishJob = true;
+    *operation = monitorSanitize(std::move(request));
 
+    result.success = true;
+    result.supported = true;
+    result.executed = true;
+    result.status = "started";
+    result.message = "ATA Secure Erase started";
+    result.reason = estimateMs ? "Drive estimates " + std::to_string(estimateMs / 60000) + " minutes" : "No estimate from the drive";
     return result;
 }
 
+// Path-based entry point: opens a one-shot session
+PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool dryRun) {
+    std::shared_ptr<DeviceSession> session = openDeviceSession(drivePath);
+    return ataSecureErase(*session, useEnhanced, dryRun);
+}
+
 // Backward compatibility wrapper (returns bool)
 bool ataSecureEraseLegacy(const std::string& drivePath, bool useEnhanced) {
     PurgeResult result = ataSecureErase(drivePath, useEnhanced, false);
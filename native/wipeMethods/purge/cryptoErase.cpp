@@ -5,10 +5,12 @@
 #include <string>
 #include <iostream>
 #include "purgeCommon.h"
+#include "../deviceSession.h"
+#include "../telemetry.h"
 
 // Forward declarations for external purge functions
-extern PurgeResult ataSecureErase(const std::string& drivePath, bool useEnhanced, bool dryRun);
-extern PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action, bool dryRun);
+extern PurgeResult ataSecureErase(DeviceSession& session, bool useEnhanced, bool dryRun);
+extern PurgeResult nvmeSanitize(DeviceSession& session, const std::string& action, bool dryRun);
 
 // Crypto erase strategies
 enum CryptoEraseStrategy {
@@ -19,143 +21,6 @@ enum CryptoEraseStrategy {
     STRATEGY_NOT_SUPPORTED
 };
 
-// Detect device type
-static DeviceType detectDeviceType(const std::string& drivePath) {
-    HANDLE hDevice = CreateFileA(
-        drivePath.c_str(),
-        GENERIC_READ,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hDevice == INVALID_HANDLE_VALUE) {
-        return DeviceType::UNKNOWN;
-    }
-
-    DeviceType result = DeviceType::UNKNOWN;
-
-    STORAGE_PROPERTY_QUERY query;
-    ZeroMemory(&query, sizeof(query));
-    query.PropertyId = StorageAdapterProperty;
-    query.QueryType = PropertyStandardQuery;
-
-    BYTE adapterBuffer[1024];
-    DWORD bytesReturned = 0;
-
-    if (DeviceIoControl(hDevice,
-                        IOCTL_STORAGE_QUERY_PROPERTY,
-                        &query,
-                        sizeof(query),
-                        adapterBuffer,
-                        sizeof(adapterBuffer),
-                        &bytesReturned,
-                        NULL)) {
-        STORAGE_ADAPTER_DESCRIPTOR* adapter = (STORAGE_ADAPTER_DESCRIPTOR*)adapterBuffer;
-        
-        switch (adapter->BusType) {
-            case BusTypeUsb:
-                result = DeviceType::USB;
-                break;
-            case BusTypeNvme:
-                result = DeviceType::NVME;
-                break;
-            case BusTypeAta:
-            case BusTypeSata:
-            case BusTypeAtapi:
-                result = DeviceType::SATA_HDD;
-                break;
-            case BusTypeScsi:
-            case BusTypeSas:
-                result = DeviceType::SCSI;
-                break;
-            default:
-                result = DeviceType::UNKNOWN;
-                break;
-        }
-    }
-
-    // Detect SSD for SATA
-    if (result == DeviceType::SATA_HDD) {
-        ZeroMemory(&query, sizeof(query));
-        query.PropertyId = StorageDeviceSeekPenaltyProperty;
-        query.QueryType = PropertyStandardQuery;
-
-        DEVICE_SEEK_PENALTY_DESCRIPTOR seekPenalty;
-        if (DeviceIoControl(hDevice,
-                            IOCTL_STORAGE_QUERY_PROPERTY,
-                            &query,
-                            sizeof(query),
-                            &seekPenalty,
-                            sizeof(seekPenalty),
-                            &bytesReturned,
-                            NULL)) {
-            if (!seekPenalty.IncursSeekPenalty) {
-                result = DeviceType::SATA_SSD;
-            }
-        }
-    }
-
-    CloseHandle(hDevice);
-    return result;
-}
-
-// Check if device has hardware encryption (non-destructive)
-static bool hasHardwareEncryption(const std::string& drivePath) {
-    HANDLE hDevice = CreateFileA(
-        drivePath.c_str(),
-        GENERIC_READ,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hDevice == INVALID_HANDLE_VALUE) {
-        return false;
-    }
-
-    bool hasEncryption = false;
-
-    STORAGE_PROPERTY_QUERY query;
-    ZeroMemory(&query, sizeof(query));
-    query.PropertyId = StorageDeviceProperty;
-    query.QueryType = PropertyStandardQuery;
-
-    BYTE buffer[4096];
-    DWORD bytesReturned = 0;
-
-    if (DeviceIoControl(hDevice,
-                        IOCTL_STORAGE_QUERY_PROPERTY,
-                        &query,
-                        sizeof(query),
-                        buffer,
-                        sizeof(buffer),
-                        &bytesReturned,
-                        NULL)) {
-        STORAGE_DEVICE_DESCRIPTOR* descriptor = (STORAGE_DEVICE_DESCRIPTOR*)buffer;
-        
-        if (descriptor->ProductIdOffset > 0) {
-            char* productId = (char*)(buffer + descriptor->ProductIdOffset);
-            std::string product(productId);
-            
-            // Check for encryption indicators
-            if (product.find("SED") != std::string::npos ||
-                product.find("Opal") != std::string::npos ||
-                product.find("TCG") != std::string::npos ||
-                product.find("Encrypted") != std::string::npos) {
-                hasEncryption = true;
-            }
-        }
-    }
-
-    CloseHandle(hDevice);
-    return hasEncryption;
-}
-
 // Detect the best crypto erase strategy
 static CryptoEraseStrategy detectStrategy(DeviceType deviceType, bool hasEncryption) {
     switch (deviceType) {
@@ -178,18 +43,19 @@ static CryptoEraseStrategy detectStrategy(DeviceType deviceType, bool hasEncrypt
 }
 
 // Main Crypto Erase function with dryRun support
-PurgeResult cryptoErase(const std::string& drivePath, bool dryRun) {
+PurgeResult cryptoErase(DeviceSession& session, bool dryRun) {
+    const std::string& drivePath = session.path;
     PurgeResult result;
     result.devicePath = drivePath;
     result.method = PurgeMethod::CRYPTO_ERASE;
     
-    std::cout << "=== Cryptographic Erase ===" << std::endl;
-    std::cout << "Drive: " << drivePath << std::endl;
-    std::cout << "Dry Run: " << (dryRun ? "YES (no data will be erased)" : "NO (DESTRUCTIVE)") << std::endl;
+    logInfo("crypto") << "=== Cryptographic Erase ===";
+    logInfo("crypto") << "Drive: " << drivePath;
+    logInfo("crypto") << "Dry Run: " << (dryRun ? "YES (no data will be erased)" : "NO (DESTRUCTIVE)");
 
-    // Step 1: Detect device type
-    result.deviceType = detectDeviceType(drivePath);
-    std::cout << "Detected device type: " << deviceTypeToString(result.deviceType) << std::endl;
+    // Step 1: Device type (probed once when the session was opened)
+    result.deviceType = session.deviceType;
+    logInfo("crypto") << "Detected device type: " << deviceTypeToString(result.deviceType);
 
     // Step 2: Check if purge is supported for this device type
     if (!isPurgeSupported(result.deviceType)) {
@@ -199,14 +65,14 @@ PurgeResult cryptoErase(const std::string& drivePath, bool dryRun) {
         result.status = "unsupported";
         result.message = "Crypto Erase not supported for " + deviceTypeToString(result.deviceType) + " devices";
         result.reason = getUnsupportedReason(result.deviceType);
-        std::cerr << "ERROR: " << result.message << std::endl;
-        std::cerr << "Reason: " << result.reason << std::endl;
+        logError("crypto") << result.message;
+        logError("crypto") << "Reason: " << result.reason;
         return result;
     }
 
-    // Step 3: Check for hardware encryption (non-destructive)
-    bool hasEncryption = hasHardwareEncryption(drivePath);
-    std::cout << "Hardware Encryption Detected: " << (hasEncryption ? "Yes" : "No") << std::endl;
+    // Step 3: Check for hardware encryption (from the cached device descriptor)
+    bool hasEncryption = session.hardwareEncryption;
+    logInfo("crypto") << "Hardware Encryption Detected: " << (hasEncryption ? "Yes" : "No");
 
     // Step 4: Determine best strategy
     CryptoEraseStrategy strategy = detectStrategy(result.deviceType, hasEncryption);
@@ -239,7 +105,7 @@ PurgeResult cryptoErase(const std::string& drivePath, bool dryRun) {
             return result;
     }
     
-    std::cout << "Selected Strategy: " << strategyName << std::endl;
+    logInfo("crypto") << "Selected Strategy: " << strategyName;
 
     // DRY RUN: Return capability information without executing
     if (dryRun) {
@@ -250,11 +116,11 @@ PurgeResult cryptoErase(const std::string& drivePath, bool dryRun) {
         result.message = "Crypto Erase is SUPPORTED using " + strategyName + " (dry run)";
         result.reason = "Dry run mode: Device capability verified. No destructive commands sent.";
         
-        std::cout << "\n=== DRY RUN COMPLETE ===" << std::endl;
-        std::cout << "Result: " << result.message << std::endl;
-        std::cout << "Device Type: " << deviceTypeToString(result.deviceType) << std::endl;
-        std::cout << "Method: " << purgeMethodToString(result.method) << std::endl;
-        std::cout << "NO DATA WAS ERASED - This was a simulation." << std::endl;
+        logInfo("crypto") << "=== DRY RUN COMPLETE ===";
+        logInfo("crypto") << "Result: " << result.message;
+        logInfo("crypto") << "Device Type: " << deviceTypeToString(result.deviceType);
+        logInfo("crypto") << "Method: " << purgeMethodToString(result.method);
+        logInfo("crypto") << "NO DATA WAS ERASED - This was a simulation.";
         
         return result;
     }
@@ -263,22 +129,22 @@ PurgeResult cryptoErase(const std::string& drivePath, bool dryRun) {
     // DESTRUCTIVE OPERATIONS BELOW - NOT DRY RUN
     // ============================================
     
-    std::cout << "\n!!! EXECUTING DESTRUCTIVE OPERATION !!!" << std::endl;
+    logWarn("crypto") << "!!! EXECUTING DESTRUCTIVE OPERATION !!!";
 
     // Execute based on strategy
     switch (strategy) {
         case STRATEGY_NVME_SANITIZE:
             // Delegate to NVMe sanitize
-            return nvmeSanitize(drivePath, "crypto", false);
+            return nvmeSanitize(session, "crypto", false);
         
         case STRATEGY_ATA_SECURE_ERASE:
             // Delegate to ATA secure erase
-            return ataSecureErase(drivePath, false, false);
+            return ataSecureErase(session, false, false);
         
         case STRATEGY_TCG_OPAL:
             // TCG Opal not fully implemented - fall back to ATA
-            std::cout << "Note: TCG Opal not fully implemented. Using ATA Secure Erase." << std::endl;
-            return ataSecureErase(drivePath, false, false);
+            logInfo("crypto") << "Note: TCG Opal not fully implemented. Using ATA Secure Erase.";
+            return ataSecureErase(session, false, false);
         
         default:
             result.success = false;
@@ -291,6 +157,12 @@ PurgeResult cryptoErase(const std::string& drivePath, bool dryRun) {
     }
 }
 
+// Path-based entry point: opens a one-shot session
+PurgeResult cryptoErase(const std::string& drivePath, bool dryRun) {
+    std::shared_ptr<DeviceSession> session = openDeviceSession(drivePath);
+    return cryptoErase(*session, dryRun);
+}
+
 // Backward compatibility wrapper
 bool cryptoEraseLegacy(const std::string& drivePath) {
     PurgeResult result = cryptoErase(drivePath, false);
@@ -6,6 +6,8 @@
 #include <chrono>
 #include <thread>
 #include "purgeCommon.h"
+#include "../deviceSession.h"
+#include "../telemetry.h"
 
 // NVMe Sanitize Actions
 #define NVME_SANITIZE_ACTION_EXIT               0
@@ -20,138 +22,30 @@
 // Log Page IDs
 #define NVME_LOG_PAGE_SANITIZE_STATUS           0x81
 
+// SSTAT bits 2:0
+#define NVME_SANITIZE_STATUS_NEVER              0
+#define NVME_SANITIZE_STATUS_COMPLETED          1
+#define NVME_SANITIZE_STATUS_IN_PROGRESS        2
+#define NVME_SANITIZE_STATUS_FAILED             3
+#define NVME_SANITIZE_STATUS_COMPLETED_NO_DEALLOC 4
+
+#define NVME_SANITIZE_NO_ESTIMATE               0xFFFFFFFF
+#define NVME_SANITIZE_TIMEOUT_MS                (4ULL * 3600 * 1000)
+
 #pragma pack(push, 1)
 
 struct NVMeSanitizeStatus {
-    uint16_t sanitize_progress;
-    uint16_t sanitize_status;
-    uint32_t global_data_erased;
-    uint32_t reserved[6];
+    uint16_t sanitize_progress;         // SPROG: fraction done, n/65536
+    uint16_t sanitize_status;           // SSTAT
+    uint32_t sanitize_cdw10;            // SCDW10 of the last sanitize
+    uint32_t estimated_overwrite;       // Seconds, NVME_SANITIZE_NO_ESTIMATE if unknown
+    uint32_t estimated_block_erase;
+    uint32_t estimated_crypto_erase;
+    uint32_t reserved[3];
 };
 
 #pragma pack(pop)
 
-// Detect device type from storage properties
-static DeviceType detectDeviceType(const std::string& drivePath) {
-    HANDLE hDevice = CreateFileA(
-        drivePath.c_str(),
-        GENERIC_READ,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hDevice == INVALID_HANDLE_VALUE) {
-        return DeviceType::UNKNOWN;
-    }
-
-    DeviceType result = DeviceType::UNKNOWN;
-
-    STORAGE_PROPERTY_QUERY query;
-    ZeroMemory(&query, sizeof(query));
-    query.PropertyId = StorageAdapterProperty;
-    query.QueryType = PropertyStandardQuery;
-
-    BYTE adapterBuffer[1024];
-    DWORD bytesReturned = 0;
-
-    if (DeviceIoControl(hDevice,
-                        IOCTL_STORAGE_QUERY_PROPERTY,
-                        &query,
-                        sizeof(query),
-                        adapterBuffer,
-                        sizeof(adapterBuffer),
-                        &bytesReturned,
-                        NULL)) {
-        STORAGE_ADAPTER_DESCRIPTOR* adapter = (STORAGE_ADAPTER_DESCRIPTOR*)adapterBuffer;
-        
-        switch (adapter->BusType) {
-            case BusTypeUsb:
-                result = DeviceType::USB;
-                break;
-            case BusTypeNvme:
-                result = DeviceType::NVME;
-                break;
-            case BusTypeAta:
-            case BusTypeSata:
-            case BusTypeAtapi:
-                result = DeviceType::SATA_HDD;
-                break;
-            case BusTypeScsi:
-            case BusTypeSas:
-                result = DeviceType::SCSI;
-                break;
-            default:
-                result = DeviceType::UNKNOWN;
-                break;
-        }
-    }
-
-    // Detect SSD for SATA
-    if (result == DeviceType::SATA_HDD) {
-        ZeroMemory(&query, sizeof(query));
-        query.PropertyId = StorageDeviceSeekPenaltyProperty;
-        query.QueryType = PropertyStandardQuery;
-
-        DEVICE_SEEK_PENALTY_DESCRIPTOR seekPenalty;
-        if (DeviceIoControl(hDevice,
-                            IOCTL_STORAGE_QUERY_PROPERTY,
-                            &query,
-                            sizeof(query),
-                            &seekPenalty,
-                            sizeof(seekPenalty),
-                            &bytesReturned,
-                            NULL)) {
-            if (!seekPenalty.IncursSeekPenalty) {
-                result = DeviceType::SATA_SSD;
-            }
-        }
-    }
-
-    CloseHandle(hDevice);
-    return result;
-}
-
-// Check if NVMe sanitize is supported (non-destructive query)
-static bool checkNVMeSanitizeSupport(const std::string& drivePath, bool& cryptoSupported, bool& blockSupported, bool& overwriteSupported) {
-    cryptoSupported = false;
-    blockSupported = false;
-    overwriteSupported = false;
-
-    HANDLE hDevice = CreateFileA(
-        drivePath.c_str(),
-        GENERIC_READ,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hDevice == INVALID_HANDLE_VALUE) {
-        return false;
-    }
-
-    // Query NVMe Identify Controller to check sanitize capabilities
-    STORAGE_PROPERTY_QUERY query;
-    ZeroMemory(&query, sizeof(query));
-    query.PropertyId = StorageAdapterProtocolSpecificProperty;
-    query.QueryType = PropertyStandardQuery;
-
-    // For now, assume NVMe devices support crypto sanitize
-    // Full implementation would query IDENTIFY CONTROLLER for SANICAP
-    CloseHandle(hDevice);
-    
-    // Most NVMe SSDs support crypto erase at minimum
-    cryptoSupported = true;
-    blockSupported = true;
-    overwriteSupported = true;
-    
-    return true;
-}
-
 // Get sanitize status (non-destructive)
 static bool getSanitizeStatus(HANDLE hDevice, NVMeSanitizeStatus& status) {
     STORAGE_PROTOCOL_COMMAND cmd;
@@ -196,9 +90,39 @@ static bool getSanitizeStatus(HANDLE hDevice, NVMeSanitizeStatus& status) {
     return false;
 }
 
-// Main NVMe Sanitize function with dryRun support
-PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action, bool dryRun) {
-    PurgeResult result;
+// One status read for the sanitize monitor. SPROG is only meaningful while
+// the sanitize is in progress.
+static SanitizePoll pollSanitize(HANDLE hDevice) {
+    SanitizePoll poll = {};
+    poll.progress = -1;
+    NVMeSanitizeStatus status;
+    poll.read = getSanitizeStatus(hDevice, status);
+    if (!poll.read) return poll;
+
+    uint16_t state = status.sanitize_status & 0x07;
+    poll.finished = state == NVME_SANITIZE_STATUS_COMPLETED || state == NVME_SANITIZE_STATUS_COMPLETED_NO_DEALLOC ||
+                    state == NVME_SANITIZE_STATUS_FAILED;
+    poll.failed = state == NVME_SANITIZE_STATUS_FAILED;
+    if (state == NVME_SANITIZE_STATUS_IN_PROGRESS) poll.progress = status.sanitize_progress / 65536.0;
+    if (poll.failed) poll.message = "Controller reports the sanitize failed";
+    return poll;
+}
+
+// The controller's estimate for `sanitizeAction`, from the status log page
+static uint64_t sanitizeEstimateMs(HANDLE hDevice, uint8_t sanitizeAction) {
+    NVMeSanitizeStatus status;
+    if (!getSanitizeStatus(hDevice, status)) return 0;
+    uint32_t seconds = sanitizeAction == NVME_SANITIZE_ACTION_CRYPTO_ERASE ? status.estimated_crypto_erase
+                     : sanitizeAction == NVME_SANITIZE_ACTION_BLOCK_ERASE ? status.estimated_block_erase
+                     : status.estimated_overwrite;
+    return seconds == NVME_SANITIZE_NO_ESTIMATE ? 0 : seconds * 1000ULL;
+}
+
+// Validate, then issue the sanitize. True when the controller accepted it
+// and it is now running in the background; otherwise `result` is final.
+static bool issueSanitize(DeviceSession& session, const std::string& action, bool dryRun, PurgeResult& result,
+                          uint64_t& estimateMs) {
+    const std::string& drivePath = session.path;
     result.devicePath = drivePath;
     
     // Determine method from action
@@ -215,17 +139,17 @@ PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action
         result.status = "error";
         result.message = "Invalid action. Use 'crypto', 'block', or 'overwrite'";
         result.reason = "Unrecognized sanitize action: " + action;
-        return result;
+        return false;
     }
     
-    std::cout << "=== NVMe Sanitize ===" << std::endl;
-    std::cout << "Drive: " << drivePath << std::endl;
-    std::cout << "Action: " << action << std::endl;
-    std::cout << "Dry Run: " << (dryRun ? "YES (no data will be erased)" : "NO (DESTRUCTIVE)") << std::endl;
+    logInfo("nvme") << "=== NVMe Sanitize ===";
+    logInfo("nvme") << "Drive: " << drivePath;
+    logInfo("nvme") << "Action: " << action;
+    logInfo("nvme") << "Dry Run: " << (dryRun ? "YES (no data will be erased)" : "NO (DESTRUCTIVE)");
 
-    // Step 1: Detect device type
-    result.deviceType = detectDeviceType(drivePath);
-    std::cout << "Detected device type: " << deviceTypeToString(result.deviceType) << std::endl;
+    // Step 1: Device type (probed once when the session was opened)
+    result.deviceType = session.deviceType;
+    logInfo("nvme") << "Detected device type: " << deviceTypeToString(result.deviceType);
 
     // Step 2: Check if this is an NVMe device
     if (result.deviceType != DeviceType::NVME) {
@@ -239,27 +163,21 @@ PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action
                        (result.deviceType == DeviceType::USB 
                            ? "USB devices cannot use NVMe Sanitize - use software overwrite instead."
                            : "Use ATA Secure Erase for SATA devices.");
-        std::cerr << "ERROR: " << result.message << std::endl;
-        std::cerr << "Reason: " << result.reason << std::endl;
-        return result;
+        logError("nvme") << result.message;
+        logError("nvme") << "Reason: " << result.reason;
+        return false;
     }
 
-    // Step 3: Check NVMe sanitize capabilities (non-destructive)
-    bool cryptoSupported, blockSupported, overwriteSupported;
-    if (!checkNVMeSanitizeSupport(drivePath, cryptoSupported, blockSupported, overwriteSupported)) {
-        result.success = false;
-        result.supported = false;
-        result.executed = false;
-        result.status = "error";
-        result.message = "Could not query NVMe sanitize capabilities";
-        result.reason = "Failed to read IDENTIFY CONTROLLER data";
-        return result;
-    }
+    // Step 3: Check NVMe sanitize capabilities (IDENTIFY CONTROLLER SANICAP, cached per session)
+    const NVMeSanitizeCaps& caps = session.nvmeSanitizeCaps();
+    bool cryptoSupported = caps.cryptoSupported;
+    bool blockSupported = caps.blockSupported;
+    bool overwriteSupported = caps.overwriteSupported;
 
-    std::cout << "NVMe Sanitize Capabilities:" << std::endl;
-    std::cout << "  Crypto Erase: " << (cryptoSupported ? "Yes" : "No") << std::endl;
-    std::cout << "  Block Erase: " << (blockSupported ? "Yes" : "No") << std::endl;
-    std::cout << "  Overwrite: " << (overwriteSupported ? "Yes" : "No") << std::endl;
+    logInfo("nvme") << "NVMe Sanitize Capabilities" << (caps.queried ? "" : " (assumed, IDENTIFY unavailable)") << ":";
+    logInfo("nvme") << "  Crypto Erase: " << (cryptoSupported ? "Yes" : "No");
+    logInfo("nvme") << "  Block Erase: " << (blockSupported ? "Yes" : "No");
+    logInfo("nvme") << "  Overwrite: " << (overwriteSupported ? "Yes" : "No");
 
     // Check if requested action is supported
     bool actionSupported = false;
@@ -274,7 +192,7 @@ PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action
         result.status = "unsupported";
         result.message = action + " sanitize not supported by this NVMe device";
         result.reason = "Device does not report support for " + action + " sanitize action";
-        return result;
+        return false;
     }
 
     // DRY RUN: Return success without executing destructive commands
@@ -286,20 +204,20 @@ PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action
         result.message = "NVMe Sanitize (" + action + ") is SUPPORTED for this device (dry run)";
         result.reason = "Dry run mode: Device capability verified. No destructive commands sent.";
         
-        std::cout << "\n=== DRY RUN COMPLETE ===" << std::endl;
-        std::cout << "Result: " << result.message << std::endl;
-        std::cout << "Device Type: " << deviceTypeToString(result.deviceType) << std::endl;
-        std::cout << "Method: " << purgeMethodToString(result.method) << std::endl;
-        std::cout << "NO DATA WAS ERASED - This was a simulation." << std::endl;
+        logInfo("nvme") << "=== DRY RUN COMPLETE ===";
+        logInfo("nvme") << "Result: " << result.message;
+        logInfo("nvme") << "Device Type: " << deviceTypeToString(result.deviceType);
+        logInfo("nvme") << "Method: " << purgeMethodToString(result.method);
+        logInfo("nvme") << "NO DATA WAS ERASED - This was a simulation.";
         
-        return result;
+        return false;
     }
 
     // ============================================
     // DESTRUCTIVE OPERATIONS BELOW - NOT DRY RUN
     // ============================================
     
-    std::cout << "\n!!! EXECUTING DESTRUCTIVE OPERATION !!!" << std::endl;
+    logWarn("nvme") << "!!! EXECUTING DESTRUCTIVE OPERATION !!!";
 
     uint8_t sanitizeAction;
     if (action == "crypto") {
@@ -310,26 +228,17 @@ PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action
         sanitizeAction = NVME_SANITIZE_ACTION_OVERWRITE;
     }
 
-    HANDLE hDevice = CreateFileA(
-        drivePath.c_str(),
-        GENERIC_READ | GENERIC_WRITE,
-        FILE_SHARE_READ | FILE_SHARE_WRITE,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hDevice == INVALID_HANDLE_VALUE) {
+    if (!session.writable) {
         result.success = false;
         result.supported = true;
         result.executed = false;
         result.status = "error";
-        result.errorCode = GetLastError();
+        result.errorCode = session.openError;
         result.message = "Failed to open drive";
         result.reason = "CreateFile failed with error code " + std::to_string(result.errorCode);
-        return result;
+        return false;
     }
+    HANDLE hDevice = session.handle;
 
     // Prepare sanitize command
     STORAGE_PROTOCOL_COMMAND cmd;
@@ -357,11 +266,12 @@ PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action
     nvmeCmd->NSID = 0xFFFFFFFF;
     nvmeCmd->u.GENERAL.CDW10 = (sanitizeAction & 0x07);
 
-    std::cout << "Starting NVMe Sanitize operation..." << std::endl;
-    std::cout << "WARNING: This cannot be stopped!" << std::endl;
+    estimateMs = sanitizeEstimateMs(hDevice, sanitizeAction);
+    logInfo("nvme") << "Starting NVMe Sanitize operation...";
+    if (estimateMs) logInfo("nvme") << "Controller estimate: " << (estimateMs / 1000) << " seconds";
+    logWarn("nvme") << "This cannot be stopped!";
 
     DWORD bytesReturned = 0;
-    auto startTime = std::chrono::high_resolution_clock::now();
 
     if (!DeviceIoControl(hDevice, IOCTL_STORAGE_PROTOCOL_COMMAND,
                          &cmdBuffer, sizeof(cmdBuffer),
@@ -374,58 +284,93 @@ PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action
         result.errorCode = GetLastError();
         result.message = "Sanitize command failed";
         result.reason = "DeviceIoControl failed with error " + std::to_string(result.errorCode);
-        CloseHandle(hDevice);
-        return result;
-    }
-
-    std::cout << "Sanitize command issued. Polling for completion..." << std::endl;
-
-    // Poll for completion
-    bool completed = false;
-    int pollCount = 0;
-    while (!completed && pollCount < 2880) {  // 4 hours max
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-        pollCount++;
-
-        NVMeSanitizeStatus status;
-        if (getSanitizeStatus(hDevice, status)) {
-            if ((status.sanitize_status & 0x07) == 0) {
-                completed = true;
-            } else {
-                double progressPct = (status.sanitize_progress / 65535.0) * 100.0;
-                std::cout << "Progress: " << (int)progressPct << "%" << std::endl;
-            }
-        }
+        return false;
     }
 
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime).count();
+    logInfo("nvme") << "Sanitize command issued; the sanitize monitor follows it";
+    return true;
+}
 
-    CloseHandle(hDevice);
+static SanitizeRequest sanitizeRequest(const PurgeResult& result, uint64_t estimateMs) {
+    SanitizeRequest request = {};
+    request.path = result.devicePath;
+    request.method = purgeMethodToString(result.method);
+    request.estimateMs = estimateMs;
+    request.timeoutMs = NVME_SANITIZE_TIMEOUT_MS;
+    return request;
+}
 
-    if (!completed) {
-        result.success = false;
-        result.supported = true;
-        result.executed = true;
+// Final result from the monitor's outcome
+static void finishResult(PurgeResult& result, const SanitizeProgress& outcome) {
+    result.supported = true;
+    result.executed = true;
+    result.success = outcome.state == SanitizeState::Succeeded;
+    std::string seconds = std::to_string(outcome.elapsedMs / 1000);
+    if (result.success) {
+        result.status = "success";
+        result.message = "NVMe Sanitize completed successfully";
+        result.reason = "Completed in " + seconds + " seconds";
+        logInfo("nvme") << "=== SANITIZE COMPLETE ===";
+        logInfo("nvme") << "Time: " << seconds << " seconds";
+    } else if (outcome.state == SanitizeState::TimedOut) {
         result.status = "timeout";
         result.message = "Sanitize operation timed out";
         result.reason = "Operation did not complete within 4 hours";
-        return result;
+    } else {
+        result.status = "error";
+        result.message = "Sanitize operation failed";
+        result.reason = outcome.message + " after " + seconds + " seconds";
     }
+}
+
+// Main NVMe Sanitize function with dryRun support. Waits for the sanitize
+// monitor to see the sanitize finish.
+PurgeResult nvmeSanitize(DeviceSession& session, const std::string& action, bool dryRun) {
+    PurgeResult result;
+    uint64_t estimateMs = 0;
+    if (!issueSanitize(session, action, dryRun, result, estimateMs)) return result;
+
+    SanitizeRequest request = sanitizeRequest(result, estimateMs);
+    HANDLE hDevice = session.handle;
+    request.status = [hDevice]() { return pollSanitize(hDevice); };
+    finishResult(result, waitSanitize(monitorSanitize(std::move(request))));
+    return result;
+}
+
+// Issue the sanitize and return at once; the monitor keeps the session open
+// and reports progress and the final result to `listener`. status "started"
+// on success, and *operation is the monitor's id.
+PurgeResult startNvmeSanitize(std::shared_ptr<DeviceSession> session, const std::string& action,
+                              PurgeListener listener, uint64_t* operation) {
+    PurgeResult result;
+    uint64_t estimateMs = 0;
+    if (!issueSanitize(*session, action, false, result, estimateMs)) return result;
+
+    SanitizeRequest request = sanitizeRequest(result, estimateMs);
+    request.status = [session]() { return pollSanitize(session->handle); };
+    request.listener = [result, listener](const SanitizeProgress& progress) {
+        PurgeResult final = result;
+        if (progress.state != SanitizeState::Running) finishResult(final, progress);
+        if (listener) listener(progress, final);
+    };
+    request.finishJob = true;
+    *operation = monitorSanitize(std::move(request));
 
     result.success = true;
     result.supported = true;
     result.executed = true;
-    result.status = "success";
-    result.message = "NVMe Sanitize completed successfully";
-    result.reason = "Completed in " + std::to_string(duration) + " seconds";
-
-    std::cout << "\n=== SANITIZE COMPLETE ===" << std::endl;
-    std::cout << "Time: " << duration << " seconds" << std::endl;
-
+    result.status = "started";
+    result.message = "NVMe Sanitize started";
+    result.reason = estimateMs ? "Controller estimates " + std::to_string(estimateMs / 1000) + " seconds" : "No estimate from the controller";
     return result;
 }
 
+// Path-based entry point: opens a one-shot session
+PurgeResult nvmeSanitize(const std::string& drivePath, const std::string& action, bool dryRun) {
+    std::shared_ptr<DeviceSession> session = openDeviceSession(drivePath);
+    return nvmeSanitize(*session, action, dryRun);
+}
+
 // Backward compatibility wrapper
 bool nvmeSanitizeLegacy(const std::string& drivePath, const std::string& action) {
     PurgeResult result = nvmeSanitize(drivePath, action, false);
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <functional>
+#include "../sanitizeMonitor.h"
 
 // Device types for purge operations
 enum class DeviceType {
@@ -52,6 +54,10 @@ struct PurgeResult {
         errorCode(0) {}
 };
 
+// Progress of a purge the sanitize monitor follows (startNvmeSanitize,
+// startAtaSecureErase); `result` is final once progress.state is not Running
+using PurgeListener = std::function<void(const SanitizeProgress& progress, const PurgeResult& result)>;
+
 // Helper functions for device type detection
 inline std::string deviceTypeToString(DeviceType type) {
     switch (type) {
@@ -0,0 +1,459 @@
+#include "quickInvalidate.h"
+#include "patternLibrary.h"
+#include "telemetry.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <initializer_list>
+
+#ifdef _WIN32
+    #include <winioctl.h>
+#else
+    #include <sys/ioctl.h>
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <linux/fs.h>
+    #endif
+#endif
+
+// Reads and writes are done in whole 4K blocks so they stay valid on an
+// unbuffered (NO_BUFFERING / 4Kn) handle
+constexpr uint64_t IO_ALIGN = PATTERN_ALIGNMENT;
+
+constexpr int MAX_EBR_CHAIN = 128;
+constexpr uint64_t MAX_GPT_ENTRY_BYTES = 1024 * 1024;
+constexpr uint32_t MAX_XFS_AG_COUNT = 1u << 20;
+
+namespace {
+
+uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t le32(const uint8_t* p) { return le16(p) | (static_cast<uint32_t>(le16(p + 2)) << 16); }
+uint64_t le64(const uint8_t* p) { return le32(p) | (static_cast<uint64_t>(le32(p + 4)) << 32); }
+uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+uint32_t be32(const uint8_t* p) { return (static_cast<uint32_t>(be16(p)) << 16) | be16(p + 2); }
+
+bool isPowerOfTwo(uint64_t v) { return v && (v & (v - 1)) == 0; }
+
+struct Partition {
+    uint64_t start;
+    uint64_t length;
+    std::string label;
+};
+
+struct GptHeader {
+    bool valid;
+    uint64_t alternateLba;
+    uint64_t entriesLba;
+    uint32_t entryCount;
+    uint32_t entrySize;
+};
+
+class Scanner {
+public:
+    explicit Scanner(DeviceSession& session) :
+        session(session),
+        sector(session.logicalSectorSize ? session.logicalSectorSize : 512) {}
+
+    std::vector<InvalidatedRegion> regions;
+
+    void scan() {
+        std::vector<Partition> partitions;
+        scanPartitionTables(partitions);
+
+        if (partitions.empty()) {
+            scanFilesystem(Partition{0, session.size, "whole device"});
+        }
+        for (const Partition& p : partitions) {
+            scanFilesystem(p);
+        }
+    }
+
+private:
+    DeviceSession& session;
+    uint64_t sector;
+
+    bool read(uint64_t offset, size_t len, std::vector<uint8_t>& out) {
+        if (len == 0 || offset + len > session.size) return false;
+        uint64_t start = offset & ~(IO_ALIGN - 1);
+        uint64_t end = std::min((offset + len + IO_ALIGN - 1) & ~(IO_ALIGN - 1), session.size);
+        AlignedBuffer buffer(static_cast<size_t>(end - start));
+        if (!buffer.valid() || !session.readAt(start, buffer.data(), buffer.size())) return false;
+        out.assign(buffer.data() + (offset - start), buffer.data() + (offset - start) + len);
+        return true;
+    }
+
+    void add(uint64_t offset, uint64_t length, const std::string& label) {
+        if (length == 0 || offset >= session.size) return;
+        length = std::min(length, session.size - offset);
+        regions.push_back(InvalidatedRegion{offset, length, label});
+    }
+
+    // ---- Partition tables ----
+
+    static bool isExtendedType(uint8_t type) {
+        return type == 0x05 || type == 0x0F || type == 0x85;
+    }
+
+    static bool isBootSector(const uint8_t* s) {
+        return memcmp(s + 3, "NTFS    ", 8) == 0 ||
+               memcmp(s + 3, "EXFAT   ", 8) == 0 ||
+               memcmp(s + 0x36, "FAT", 3) == 0 ||
+               memcmp(s + 0x52, "FAT32", 5) == 0;
+    }
+
+    GptHeader readGptHeader(uint64_t lba) {
+        GptHeader h = {false, 0, 0, 0, 0};
+        std::vector<uint8_t> buf;
+        if (!read(lba * sector, 92, buf) || memcmp(buf.data(), "EFI PART", 8) != 0) return h;
+        h.alternateLba = le64(&buf[32]);
+        h.entriesLba = le64(&buf[72]);
+        h.entryCount = le32(&buf[80]);
+        h.entrySize = le32(&buf[84]);
+        h.valid = h.entrySize >= 128 && isPowerOfTwo(h.entrySize) &&
+                  static_cast<uint64_t>(h.entryCount) * h.entrySize <= MAX_GPT_ENTRY_BYTES;
+        return h;
+    }
+
+    void readGptPartitions(const GptHeader& h, std::vector<Partition>& partitions) {
+        std::vector<uint8_t> entries;
+        uint64_t bytes = static_cast<uint64_t>(h.entryCount) * h.entrySize;
+        if (!read(h.entriesLba * sector, static_cast<size_t>(bytes), entries)) return;
+
+        static const uint8_t unused[16] = {0};
+        for (uint32_t i = 0; i < h.entryCount; i++) {
+            const uint8_t* e = &entries[static_cast<size_t>(i) * h.entrySize];
+            if (memcmp(e, unused, 16) == 0) continue;
+            uint64_t first = le64(e + 32);
+            uint64_t last = le64(e + 40);
+            if (last < first) continue;
+            partitions.push_back(Partition{first * sector, (last - first + 1) * sector,
+                                           "GPT partition " + std::to_string(i + 1)});
+        }
+    }
+
+    bool scanGpt(std::vector<Partition>& partitions) {
+        const uint64_t lastLba = session.size / sector - 1;
+        GptHeader primary = readGptHeader(1);
+        uint64_t backupLba = (primary.valid && primary.alternateLba && primary.alternateLba <= lastLba)
+            ? primary.alternateLba : lastLba;
+        GptHeader backup = readGptHeader(backupLba);
+        if (!primary.valid && !backup.valid) return false;
+
+        const GptHeader& layout = primary.valid ? primary : backup;
+        uint64_t entryBytes = static_cast<uint64_t>(layout.entryCount) * layout.entrySize;
+        uint64_t entrySectors = (entryBytes + sector - 1) / sector;
+
+        add(1 * sector, sector, "GPT primary header");
+        add((primary.valid ? primary.entriesLba : 2) * sector, entryBytes, "GPT primary partition entries");
+        add(backupLba * sector, sector, "GPT backup header");
+        add((backup.valid ? backup.entriesLba : backupLba - entrySectors) * sector, entryBytes,
+            "GPT backup partition entries");
+
+        readGptPartitions(layout, partitions);
+        return true;
+    }
+
+    void scanEbrChain(uint64_t extendedLba, std::vector<Partition>& partitions) {
+        uint64_t ebrLba = extendedLba;
+        for (int n = 0; n < MAX_EBR_CHAIN; n++) {
+            std::vector<uint8_t> ebr;
+            if (!read(ebrLba * sector, 512, ebr) || ebr[510] != 0x55 || ebr[511] != 0xAA) return;
+            add(ebrLba * sector, sector, "EBR " + std::to_string(n + 1));
+
+            const uint8_t* logical = &ebr[446];
+            const uint8_t* next = &ebr[462];
+            if (logical[4] != 0 && le32(logical + 12) != 0) {
+                partitions.push_back(Partition{(ebrLba + le32(logical + 8)) * sector,
+                                               static_cast<uint64_t>(le32(logical + 12)) * sector,
+                                               "logical partition " + std::to_string(n + 5)});
+            }
+            if (next[4] == 0 || le32(next + 8) == 0) return;
+            ebrLba = extendedLba + le32(next + 8);
+        }
+    }
+
+    void scanPartitionTables(std::vector<Partition>& partitions) {
+        std::vector<uint8_t> mbr;
+        if (!read(0, 512, mbr)) return;
+
+        bool hasMbr = mbr[510] == 0x55 && mbr[511] == 0xAA && !isBootSector(mbr.data());
+        for (int i = 0; hasMbr && i < 4; i++) {
+            uint8_t status = mbr[446 + 16 * i];
+            hasMbr = status == 0x00 || status == 0x80;
+        }
+
+        if (scanGpt(partitions)) {
+            add(0, sector, "Protective MBR");
+            return;
+        }
+        if (!hasMbr) return;
+
+        add(0, sector, "MBR");
+        for (int i = 0; i < 4; i++) {
+            const uint8_t* e = &mbr[446 + 16 * i];
+            uint8_t type = e[4];
+            uint32_t lba = le32(e + 8);
+            uint32_t count = le32(e + 12);
+            if (type == 0 || count == 0) continue;
+            if (isExtendedType(type)) {
+                scanEbrChain(lba, partitions);
+            } else {
+                partitions.push_back(Partition{static_cast<uint64_t>(lba) * sector,
+                                               static_cast<uint64_t>(count) * sector,
+                                               "MBR partition " + std::to_string(i + 1)});
+            }
+        }
+    }
+
+    // ---- Filesystems ----
+
+    void scanFilesystem(const Partition& p) {
+        std::vector<uint8_t> head;
+        if (!read(p.start, static_cast<size_t>(std::min<uint64_t>(4096, p.length)), head) || head.size() < 2048) return;
+
+        if (memcmp(&head[3], "NTFS    ", 8) == 0) {
+            scanNtfs(p, head);
+        } else if (memcmp(&head[3], "EXFAT   ", 8) == 0) {
+            scanExfat(p, head);
+        } else if (head[510] == 0x55 && head[511] == 0xAA &&
+                   (memcmp(&head[0x36], "FAT", 3) == 0 || memcmp(&head[0x52], "FAT32", 5) == 0)) {
+            scanFat(p, head);
+        } else if (memcmp(&head[0], "XFSB", 4) == 0) {
+            scanXfs(p, head);
+        } else if (le16(&head[1024 + 56]) == 0xEF53) {
+            scanExt(p, head);
+        }
+    }
+
+    void scanExt(const Partition& p, const std::vector<uint8_t>& head) {
+        const uint8_t* sb = &head[1024];
+        uint32_t logBlock = le32(sb + 24);
+        uint32_t blocksPerGroup = le32(sb + 32);
+        uint32_t firstDataBlock = le32(sb + 20);
+        uint32_t compat = le32(sb + 92);
+        uint32_t incompat = le32(sb + 96);
+        uint32_t roCompat = le32(sb + 100);
+        if (logBlock > 6 || blocksPerGroup == 0 || le32(sb + 4) <= firstDataBlock) return;
+
+        uint64_t blockSize = 1024ULL << logBlock;
+        uint64_t blocks = le32(sb + 4);
+        if (incompat & 0x80) blocks |= static_cast<uint64_t>(le32(sb + 0x150)) << 32;  // 64bit
+        uint64_t groups = (blocks - firstDataBlock + blocksPerGroup - 1) / blocksPerGroup;
+
+        const char* name = (incompat & 0x40) ? "ext4" : (compat & 0x4) ? "ext3" : "ext2";
+        add(p.start + 1024, 1024, std::string(name) + " superblock (" + p.label + ")");
+
+        auto addBackup = [&](uint64_t group) {
+            if (group == 0 || group >= groups) return;
+            uint64_t offset = (group * blocksPerGroup + firstDataBlock) * blockSize;
+            if (offset >= p.length) return;
+            add(p.start + offset, 1024, std::string(name) + " backup superblock (group " + std::to_string(group) + ")");
+        };
+
+        if (compat & 0x200) {
+            // sparse_super2: at most two backups, listed in the superblock
+            addBackup(le32(sb + 0x24C));
+            addBackup(le32(sb + 0x250));
+        } else if (roCompat & 0x1) {
+            // sparse_super: groups 1 and powers of 3, 5, 7
+            addBackup(1);
+            for (uint64_t base : {3ULL, 5ULL, 7ULL}) {
+                for (uint64_t g = base; g < groups; g *= base) addBackup(g);
+            }
+        } else {
+            for (uint64_t g = 1; g < groups; g++) addBackup(g);
+        }
+    }
+
+    void scanNtfs(const Partition& p, const std::vector<uint8_t>& head) {
+        uint64_t bytesPerSector = le16(&head[0x0B]);
+        uint8_t spc = head[0x0D];
+        uint64_t sectorsPerCluster = spc <= 0x80 ? spc : (1ULL << (256 - spc));
+        uint64_t totalSectors = le64(&head[0x28]);
+        uint64_t mftLcn = le64(&head[0x30]);
+        uint64_t mftMirrLcn = le64(&head[0x38]);
+        int8_t recordField = static_cast<int8_t>(head[0x40]);
+        if (!isPowerOfTwo(bytesPerSector) || bytesPerSector < 512 || bytesPerSector > 4096 || sectorsPerCluster == 0) return;
+
+        uint64_t clusterSize = bytesPerSector * sectorsPerCluster;
+        uint64_t recordSize = recordField < 0 ? (1ULL << -recordField) : recordField * clusterSize;
+
+        add(p.start, bytesPerSector, "NTFS boot sector (" + p.label + ")");
+        // The backup sits in the volume's last sector; a partition too small
+        // to hold a second sector has none (and must not wrap the offset)
+        if (p.length >= 2 * bytesPerSector) {
+            uint64_t backup = totalSectors < p.length / bytesPerSector ? totalSectors * bytesPerSector
+                                                                       : p.length - bytesPerSector;
+            add(p.start + backup, bytesPerSector, "NTFS backup boot sector");
+        }
+
+        // $MFT, $MFTMirr, $LogFile, $Volume records
+        if (mftLcn * clusterSize < p.length) add(p.start + mftLcn * clusterSize, 4 * recordSize, "NTFS $MFT");
+        if (mftMirrLcn * clusterSize < p.length) add(p.start + mftMirrLcn * clusterSize, 4 * recordSize, "NTFS $MFTMirr");
+    }
+
+    void scanXfs(const Partition& p, const std::vector<uint8_t>& head) {
+        uint64_t blockSize = be32(&head[4]);
+        uint64_t agBlocks = be32(&head[84]);
+        uint32_t agCount = be32(&head[88]);
+        uint64_t sectSize = be16(&head[102]);
+        if (!isPowerOfTwo(blockSize) || !isPowerOfTwo(sectSize) || agBlocks == 0 || agCount > MAX_XFS_AG_COUNT) return;
+
+        // Superblock, AGF, AGI, AGFL: the first four sectors of every AG
+        for (uint32_t ag = 0; ag < agCount; ag++) {
+            uint64_t offset = ag * agBlocks * blockSize;
+            if (offset >= p.length) break;
+            add(p.start + offset, 4 * sectSize,
+                ag == 0 ? "XFS superblock + AG 0 headers (" + p.label + ")" : "XFS AG " + std::to_string(ag) + " headers");
+        }
+    }
+
+    void scanFat(const Partition& p, const std::vector<uint8_t>& head) {
+        uint64_t bytesPerSector = le16(&head[0x0B]);
+        uint64_t reserved = le16(&head[0x0E]);
+        if (!isPowerOfTwo(bytesPerSector) || bytesPerSector < 512) return;
+
+        bool fat32 = memcmp(&head[0x52], "FAT32", 5) == 0;
+        add(p.start, bytesPerSector, std::string(fat32 ? "FAT32" : "FAT") + " boot sector (" + p.label + ")");
+        if (fat32) {
+            uint64_t fsInfo = le16(&head[0x30]);
+            uint64_t backupBoot = le16(&head[0x32]);
+            if (fsInfo != 0 && fsInfo != 0xFFFF) add(p.start + fsInfo * bytesPerSector, bytesPerSector, "FAT32 FSInfo sector");
+            if (backupBoot != 0 && backupBoot != 0xFFFF) {
+                add(p.start + backupBoot * bytesPerSector, 3 * bytesPerSector, "FAT32 backup boot sectors");
+            }
+        }
+        if (reserved != 0) add(p.start + reserved * bytesPerSector, bytesPerSector, "FAT first allocation table sector");
+    }
+
+    void scanExfat(const Partition& p, const std::vector<uint8_t>& head) {
+        uint8_t shift = head[108];
+        if (shift < 9 || shift > 12) return;
+        uint64_t bytesPerSector = 1ULL << shift;
+
+        // Main and backup boot regions are 12 sectors each
+        add(p.start, 12 * bytesPerSector, "exFAT main boot region (" + p.label + ")");
+        add(p.start + 12 * bytesPerSector, 12 * bytesPerSector, "exFAT backup boot region");
+    }
+};
+
+struct Extent {
+    uint64_t start;
+    uint64_t end;
+};
+
+// Widen to whole 4K blocks and merge overlaps
+std::vector<Extent> alignedExtents(const std::vector<InvalidatedRegion>& regions, uint64_t deviceSize) {
+    std::vector<Extent> extents;
+    for (const InvalidatedRegion& r : regions) {
+        uint64_t start = r.offset & ~(IO_ALIGN - 1);
+        uint64_t end = std::min((r.offset + r.length + IO_ALIGN - 1) & ~(IO_ALIGN - 1), deviceSize);
+        extents.push_back(Extent{start, end});
+    }
+    std::sort(extents.begin(), extents.end(), [](const Extent& a, const Extent& b) { return a.start < b.start; });
+
+    std::vector<Extent> merged;
+    for (const Extent& e : extents) {
+        if (!merged.empty() && e.start <= merged.back().end) {
+            merged.back().end = std::max(merged.back().end, e.end);
+        } else {
+            merged.push_back(e);
+        }
+    }
+    return merged;
+}
+
+}
+
+InvalidateResult quickInvalidate(DeviceSession& session, bool dryRun) {
+    InvalidateResult result;
+    result.success = false;
+    result.executed = false;
+    result.bytesWritten = 0;
+    result.durationMs = 0;
+    result.errorCode = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (!session.isOpen() || session.size == 0) {
+        result.errorCode = session.openError;
+        result.message = "Device not open or size unknown";
+        return result;
+    }
+
+    Scanner scanner(session);
+    scanner.scan();
+    result.regions = scanner.regions;
+    std::vector<Extent> extents = alignedExtents(result.regions, session.size);
+
+    logInfo("invalidate") << "Quick invalidate: " << result.regions.size() << " metadata regions on " << session.path;
+    for (const InvalidatedRegion& r : result.regions) {
+        logInfo("invalidate") << "  " << r.label << " @ " << r.offset << " (" << r.length << " bytes)";
+    }
+
+    if (dryRun) {
+        for (const Extent& e : extents) result.bytesWritten += e.end - e.start;
+        result.success = true;
+        result.message = "Dry run: " + std::to_string(result.regions.size()) + " regions would be overwritten";
+    } else if (!session.writable) {
+        result.errorCode = session.openError;
+        result.message = "Device is not open for writing";
+    } else {
+        result.executed = true;
+        result.success = true;
+        for (const Extent& e : extents) {
+            AlignedBuffer buffer(static_cast<size_t>(e.end - e.start));
+            if (!buffer.valid()) {
+                result.success = false;
+                result.message = "Memory allocation failed";
+                break;
+            }
+            fillRandomBytes(buffer.data(), buffer.size());
+            if (!session.writeAt(e.start, buffer.data(), buffer.size())) {
+                result.success = false;
+                result.errorCode = session.ioError;
+                result.message = "Write failed at offset " + std::to_string(e.start);
+                break;
+            }
+            result.bytesWritten += buffer.size();
+        }
+
+#ifdef _WIN32
+        FlushFileBuffers(session.handle);
+        // Drop the cached partition layout
+        DWORD bytesReturned;
+        DeviceIoControl(session.handle, IOCTL_DISK_UPDATE_PROPERTIES, NULL, 0, NULL, 0, &bytesReturned, NULL);
+#else
+        fsync(session.fd);
+    #ifdef __linux__
+        if (session.isBlockDevice) {
+            ioctl(session.fd, BLKRRPART);   // Fails harmlessly while partitions are in use
+        }
+    #endif
+#endif
+        if (result.success) {
+            result.message = "Overwrote " + std::to_string(result.regions.size()) + " metadata regions";
+        }
+    }
+
+    result.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    logInfo("invalidate") << "Quick invalidate " << (result.success ? "done" : "FAILED") << " in " << result.durationMs
+                          << " ms (" << result.bytesWritten << " bytes): " << result.message;
+    return result;
+}
+
+// Export for testing (point it at a disk image, never a live device)
+#ifdef TEST_STANDALONE
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: quickInvalidate <image> [--write]" << std::endl;
+        return 1;
+    }
+    std::shared_ptr<DeviceSession> session = openDeviceSession(argv[1]);
+    bool write = argc > 2 && std::string(argv[2]) == "--write";
+    InvalidateResult result = quickInvalidate(*session, !write);
+    return result.success ? 0 : 1;
+}
+#endif
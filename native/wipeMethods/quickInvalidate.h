@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "deviceSession.h"
+
+// Quick-invalidate pre-pass.
+//
+// Parses the partition tables (MBR + EBR chain, primary and backup GPT) and
+// the superblocks of every filesystem found on them, including their backups
+// (ext2/3/4 backup groups, NTFS boot sector mirror + $MFT/$MFTMirr, XFS AG
+// headers, FAT/FAT32 backup boot sector, exFAT main + backup boot regions),
+// then overwrites exactly those locations with random data. The drive stops
+// being mountable or recoverable by fsck/testdisk within milliseconds,
+// before any long overwrite pass begins.
+
+struct InvalidatedRegion {
+    uint64_t offset;
+    uint64_t length;
+    std::string label;      // e.g. "GPT primary header", "ext4 backup superblock (group 3)"
+};
+
+struct InvalidateResult {
+    bool success;
+    bool executed;          // false for dry runs
+    std::vector<InvalidatedRegion> regions;
+    uint64_t bytesWritten;  // After 4K alignment and merging
+    double durationMs;
+    std::string message;
+    uint32_t errorCode;
+};
+
+InvalidateResult quickInvalidate(DeviceSession& session, bool dryRun);
@@ -0,0 +1,365 @@
+#include "sanitizeMonitor.h"
+#include "wipeJob.h"
+#include "telemetry.h"
+#include "probes.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+const char* sanitizeStateName(SanitizeState state) {
+    switch (state) {
+        case SanitizeState::Running: return "running";
+        case SanitizeState::Succeeded: return "succeeded";
+        case SanitizeState::Failed: return "failed";
+        case SanitizeState::TimedOut: return "timed_out";
+    }
+    return "unknown";
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Operation {
+    SanitizeRequest request;
+    SanitizeProgress progress;      // Guarded by the monitor mutex
+    JobRef job;
+    Clock::time_point started;
+    Clock::time_point nextPoll;
+    double reported = -1;           // Progress last passed to the listener (monitor thread only)
+
+    // Blocking operations: the command's thread and what it returned
+    std::thread command;
+    bool commandDone = false;
+    bool commandPurged = false;
+    std::string commandMessage;
+};
+
+using OperationRef = std::shared_ptr<Operation>;
+
+struct Monitor {
+    std::mutex mutex;
+    std::condition_variable wake;       // New operation, or a blocking command returned
+    std::condition_variable finished;
+    std::vector<OperationRef> running;
+    std::deque<SanitizeProgress> history;
+    std::thread thread;
+    bool active = false;
+    uint64_t nextId = 1;
+};
+
+// Never destroyed, as the hotplug watcher: a running monitor must not meet
+// its std::thread's destructor during static teardown
+Monitor& monitor() {
+    static Monitor* instance = new Monitor();
+    return *instance;
+}
+
+uint64_t msBetween(Clock::time_point from, Clock::time_point to) {
+    return to > from ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count()) : 0;
+}
+
+// Time to the next status read: a tenth of the predicted remainder, or the
+// old fixed interval while there is nothing to predict from
+uint64_t pollInterval(uint64_t remainingMs) {
+    if (!remainingMs) return SANITIZE_DEFAULT_POLL_MS;
+    uint64_t interval = remainingMs / SANITIZE_POLLS_PER_REMAINDER;
+    return std::min(SANITIZE_MAX_POLL_MS, std::max(SANITIZE_MIN_POLL_MS, interval));
+}
+
+// Remaining time from the progress rate so far, else from the drive's estimate
+uint64_t predictRemaining(double progress, uint64_t elapsedMs, uint64_t estimateMs) {
+    if (progress > 0 && progress < 1) return static_cast<uint64_t>(elapsedMs * (1 - progress) / progress);
+    return estimateMs > elapsedMs ? estimateMs - elapsedMs : 0;
+}
+
+// Advance one due operation: read its status (outside the lock, a status
+// read can take seconds) and decide when to look again. Returns the new
+// record; the caller stores it.
+SanitizeProgress step(Operation& op, SanitizeProgress p, Clock::time_point& nextPoll) {
+    Clock::time_point now = Clock::now();
+    p.elapsedMs = msBetween(op.started, now);
+
+    if (op.request.command) {
+        std::unique_lock<std::mutex> lock(monitor().mutex);
+        if (op.commandDone) {
+            p.state = op.commandPurged ? SanitizeState::Succeeded : SanitizeState::Failed;
+            p.message = op.commandMessage;
+            if (op.commandPurged) p.progress = 1;
+            p.remainingMs = 0;
+            return p;
+        }
+        lock.unlock();
+        if (op.request.estimateMs) {
+            p.progress = std::min(0.99, static_cast<double>(p.elapsedMs) / op.request.estimateMs);
+            p.estimated = true;
+        }
+        p.remainingMs = predictRemaining(-1, p.elapsedMs, op.request.estimateMs);
+        // Without an estimate there is nothing to report before the command returns
+        nextPoll = now + std::chrono::milliseconds(op.request.estimateMs ? pollInterval(p.remainingMs) : SANITIZE_MAX_POLL_MS);
+        return p;
+    }
+
+    SanitizePoll poll = op.request.status();
+    p.polls++;
+    WIPE_PROBE(sanitize__poll, op.job ? op.job->id.c_str() : "", p.id,
+               static_cast<int64_t>(poll.read && poll.progress >= 0 ? poll.progress * 10000 : -1),
+               poll.read && poll.finished ? 1 : 0);
+    if (poll.read && poll.finished) {
+        p.state = poll.failed ? SanitizeState::Failed : SanitizeState::Succeeded;
+        if (!poll.failed) p.progress = 1;
+        p.message = poll.message;
+        p.remainingMs = 0;
+        return p;
+    }
+    if (poll.read) {
+        p.estimated = poll.progress < 0 && op.request.estimateMs;
+        p.progress = poll.progress >= 0 ? poll.progress
+                   : p.estimated ? std::min(0.99, static_cast<double>(p.elapsedMs) / op.request.estimateMs) : -1;
+    }
+    p.remainingMs = predictRemaining(poll.progress, p.elapsedMs, op.request.estimateMs);
+    if (op.request.timeoutMs && p.elapsedMs >= op.request.timeoutMs) {
+        p.state = SanitizeState::TimedOut;
+        p.message = "Did not complete within " + std::to_string(op.request.timeoutMs / 1000) + " seconds";
+        return p;
+    }
+    nextPoll = now + std::chrono::milliseconds(pollInterval(p.remainingMs));
+    if (op.request.timeoutMs) nextPoll = std::min(nextPoll, op.started + std::chrono::milliseconds(op.request.timeoutMs));
+    return p;
+}
+
+// Listener and telemetry, under the operation's job; progress only when it
+// moved by SANITIZE_PROGRESS_STEP
+void report(Operation& op, const SanitizeProgress& p) {
+    bool done = p.state != SanitizeState::Running;
+    if (!done && (p.progress < 0 || (op.reported >= 0 && p.progress - op.reported < SANITIZE_PROGRESS_STEP))) return;
+    op.reported = p.progress;
+
+    JobScope scope(op.job);
+    if (done) {
+        std::ostringstream line;
+        line << p.method << " on " << p.path << " " << sanitizeStateName(p.state) << " after " << (p.elapsedMs / 1000)
+             << " seconds (" << p.polls << " status reads)" << (p.message.empty() ? "" : ": ") << p.message;
+        emitEvent(TelemetryEvent::SanitizeFinished, "sanitize", line.str(), static_cast<uint64_t>(p.state), p.elapsedMs,
+                  p.polls);
+    } else {
+        std::ostringstream line;
+        line << p.method << " on " << p.path << ": " << static_cast<int>(p.progress * 100) << "%"
+             << (p.estimated ? " (estimated)" : "");
+        if (p.remainingMs) line << ", about " << (p.remainingMs / 1000) << " seconds left";
+        emitEvent(TelemetryEvent::SanitizeProgress, "sanitize", line.str(), static_cast<uint64_t>(p.progress * 10000),
+                  p.elapsedMs, p.remainingMs);
+    }
+    if (op.request.listener) op.request.listener(p);
+    if (done && op.request.finishJob && op.job) {
+        op.job->finish();
+        emitEvent(TelemetryEvent::JobFinished, "job", "Job finished: " + op.job->target,
+                  static_cast<uint64_t>(op.job->elapsedMs()));
+    }
+}
+
+void run() {
+    Monitor& m = monitor();
+    std::unique_lock<std::mutex> lock(m.mutex);
+    while (!m.running.empty()) {
+        Clock::time_point now = Clock::now();
+        Clock::time_point next = now + std::chrono::milliseconds(SANITIZE_MAX_POLL_MS);
+        std::vector<OperationRef> due;
+        for (const OperationRef& op : m.running) {
+            if (op->commandDone || op->nextPoll <= now) {
+                due.push_back(op);
+            } else {
+                next = std::min(next, op->nextPoll);
+            }
+        }
+        if (due.empty()) {
+            m.wake.wait_until(lock, next);
+            continue;
+        }
+
+        for (const OperationRef& op : due) {
+            SanitizeProgress before = op->progress;
+            Clock::time_point nextPoll = op->nextPoll;
+            lock.unlock();
+            SanitizeProgress after = step(*op, before, nextPoll);
+            lock.lock();
+            op->progress = after;
+            op->nextPoll = nextPoll;
+            if (after.state != SanitizeState::Running) {
+                m.running.erase(std::find(m.running.begin(), m.running.end(), op));
+                m.history.push_front(after);
+                if (m.history.size() > SANITIZE_HISTORY) m.history.pop_back();
+            }
+            lock.unlock();
+            if (after.state != SanitizeState::Running && op->command.joinable()) op->command.join();
+            report(*op, after);
+            lock.lock();
+            if (after.state != SanitizeState::Running) m.finished.notify_all();
+        }
+    }
+    m.active = false;
+}
+
+}
+
+uint64_t monitorSanitize(SanitizeRequest request) {
+    Monitor& m = monitor();
+    OperationRef op = std::make_shared<Operation>();
+    op->job = currentJobRef();
+    op->started = Clock::now();
+    op->nextPoll = op->started + std::chrono::milliseconds(
+        request.estimateMs ? pollInterval(request.estimateMs) : SANITIZE_MIN_POLL_MS);
+
+    SanitizeProgress& p = op->progress;
+    p.path = request.path;
+    p.method = request.method;
+    p.job = op->job ? op->job->id : "";
+    p.state = SanitizeState::Running;
+    p.progress = -1;
+    p.estimated = false;
+    p.elapsedMs = 0;
+    p.remainingMs = request.estimateMs;
+    p.polls = 0;
+    op->request = std::move(request);
+
+    std::lock_guard<std::mutex> lock(m.mutex);
+    p.id = m.nextId++;
+    logInfo("sanitize") << "Monitoring " << p.method << " on " << p.path << " (operation " << p.id << ", "
+                        << (op->request.command ? "blocking" : "polled")
+                        << (op->request.estimateMs ? ", drive estimates " + std::to_string(op->request.estimateMs / 1000) + " seconds)" : ")");
+    if (op->request.command) {
+        Operation* raw = op.get();
+        op->command = std::thread([raw] {
+            std::string message;
+            bool purged = raw->request.command(message);
+            std::lock_guard<std::mutex> guard(monitor().mutex);
+            raw->commandDone = true;
+            raw->commandPurged = purged;
+            raw->commandMessage = message;
+            monitor().wake.notify_all();
+        });
+    }
+    m.running.push_back(op);
+    if (!m.active) {
+        // The previous thread has left its loop; it only has to return
+        if (m.thread.joinable()) m.thread.join();
+        m.active = true;
+        m.thread = std::thread(run);
+    }
+    m.wake.notify_all();
+    return p.id;
+}
+
+SanitizeProgress waitSanitize(uint64_t id) {
+    Monitor& m = monitor();
+    std::unique_lock<std::mutex> lock(m.mutex);
+    for (;;) {
+        for (const SanitizeProgress& p : m.history) {
+            if (p.id == id) return p;
+        }
+        bool running = false;
+        for (const OperationRef& op : m.running) running = running || op->progress.id == id;
+        if (!running) break;
+        m.finished.wait(lock);
+    }
+    SanitizeProgress unknown = {};
+    unknown.id = id;
+    unknown.state = SanitizeState::Failed;
+    unknown.progress = -1;
+    unknown.message = "Unknown sanitize operation";
+    return unknown;
+}
+
+std::vector<SanitizeProgress> sanitizeOperations() {
+    Monitor& m = monitor();
+    std::lock_guard<std::mutex> lock(m.mutex);
+    std::vector<SanitizeProgress> result;
+    for (auto it = m.running.rbegin(); it != m.running.rend(); ++it) {
+        SanitizeProgress p = (*it)->progress;
+        p.elapsedMs = msBetween((*it)->started, Clock::now());
+        result.push_back(p);
+    }
+    result.insert(result.end(), m.history.begin(), m.history.end());
+    return result;
+}
+
+// Export for testing: simulated devices, no hardware
+#ifdef TEST_STANDALONE
+#include <atomic>
+#include <iostream>
+
+int main() {
+    bool ok = pollInterval(0) == SANITIZE_DEFAULT_POLL_MS && pollInterval(1000) == SANITIZE_MIN_POLL_MS &&
+              pollInterval(3600 * 1000) == SANITIZE_MAX_POLL_MS && pollInterval(60 * 1000) == 6000 &&
+              predictRemaining(0.25, 1000, 0) == 3000 && predictRemaining(-1, 1000, 5000) == 4000;
+    std::cout << "Schedule: " << (ok ? "ok" : "wrong") << std::endl;
+
+    JobRef job = startJob("sanitize-test", "/dev/nvme9n1");
+    JobScope scope(job);
+
+    // Polled, finishing after ~2 s: the reported rate brings polls close to the end
+    auto began = Clock::now();
+    std::atomic<int> reads{0};
+    SanitizeRequest polled = {};
+    polled.path = "/dev/nvme9n1";
+    polled.method = "NVME_SANITIZE_BLOCK";
+    polled.timeoutMs = 60000;
+    polled.status = [&] {
+        reads++;
+        double p = std::chrono::duration<double>(Clock::now() - began).count() / 2.0;
+        SanitizePoll poll = {};
+        poll.read = true;
+        poll.finished = p >= 1;
+        poll.progress = p >= 1 ? -1 : p;
+        return poll;
+    };
+    std::atomic<int> events{0};
+    polled.listener = [&](const SanitizeProgress&) { events++; };
+
+    // Blocking, 1.5 s, failing; the drive estimates 1 s
+    SanitizeRequest blocking = {};
+    blocking.path = "/dev/sdz";
+    blocking.method = "ATA_SECURE_ERASE";
+    blocking.estimateMs = 1000;
+    blocking.command = [](std::string& message) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        message = "SECURITY ERASE UNIT failed (error 121)";
+        return false;
+    };
+
+    // Polled, never finishing: times out
+    SanitizeRequest stuck = {};
+    stuck.path = "/dev/nvme8n1";
+    stuck.method = "NVME_SANITIZE_OVERWRITE";
+    stuck.timeoutMs = 1200;
+    stuck.status = [] {
+        SanitizePoll poll = {};
+        return poll;
+    };
+
+    uint64_t a = monitorSanitize(polled);
+    uint64_t b = monitorSanitize(blocking);
+    uint64_t c = monitorSanitize(stuck);
+    ok = ok && sanitizeOperations().size() == 3;
+    SanitizeProgress pa = waitSanitize(a);
+    SanitizeProgress pb = waitSanitize(b);
+    SanitizeProgress pc = waitSanitize(c);
+    double lateMs = static_cast<double>(pa.elapsedMs) - 2000;
+    std::cout << "Polled: " << sanitizeStateName(pa.state) << " after " << pa.elapsedMs << " ms, " << pa.polls
+              << " status reads, " << events.load() << " events" << std::endl;
+    std::cout << "Blocking: " << sanitizeStateName(pb.state) << " (" << pb.message << ")" << std::endl;
+    std::cout << "Stuck: " << sanitizeStateName(pc.state) << " after " << pc.polls << " status reads" << std::endl;
+    ok = ok && pa.state == SanitizeState::Succeeded && pa.job == "sanitize-test" && lateMs < SANITIZE_MIN_POLL_MS + 100 &&
+         pa.polls < 12 && events >= 2;
+    ok = ok && pb.state == SanitizeState::Failed && pb.message.find("121") != std::string::npos;
+    ok = ok && pc.state == SanitizeState::TimedOut && waitSanitize(999).state == SanitizeState::Failed;
+    ok = ok && sanitizeOperations().size() == 3 && sanitizeOperations()[0].id == a;
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One thread for every hardware purge in flight.
+//
+// NVMe Sanitize returns as soon as the controller accepts it and then runs in
+// the background for seconds (crypto erase) to hours (overwrite); ATA SECURITY
+// ERASE UNIT holds its IOCTL until the drive is done. Both used to park the
+// calling thread, and with it a JS Worker, per drive until the end, NVMe
+// polling every 5 s whatever the operation.
+//
+// Instead the purge routines register the running operation here and one
+// monitor thread watches all of them:
+//
+//  - A polled operation (NVMe) is asked for its status on a schedule fitted
+//    to it. From the progress rate the device reports (SPROG), else from the
+//    drive's own time estimate, the monitor predicts how long is left and
+//    polls about SANITIZE_POLLS_PER_REMAINDER times over it, within
+//    SANITIZE_MIN_POLL_MS..SANITIZE_MAX_POLL_MS. A crypto erase is seen
+//    finished within a second of the end; an overwrite costs one poll every
+//    half minute.
+//  - A blocking operation (ATA) runs its command on a thread of its own. The
+//    monitor reports progress from the drive's time estimate and the outcome
+//    as soon as the command returns.
+//
+// Progress (each change of at least SANITIZE_PROGRESS_STEP) and the final
+// outcome go to the operation's listener, called on the monitor thread, and
+// to telemetry (SanitizeProgress, SanitizeFinished) under the job that was
+// current when the operation was registered.
+
+constexpr uint64_t SANITIZE_MIN_POLL_MS = 500;
+constexpr uint64_t SANITIZE_MAX_POLL_MS = 30000;
+constexpr uint64_t SANITIZE_DEFAULT_POLL_MS = 5000;     // Nothing to predict from yet
+constexpr unsigned SANITIZE_POLLS_PER_REMAINDER = 10;
+constexpr double SANITIZE_PROGRESS_STEP = 0.01;
+constexpr size_t SANITIZE_HISTORY = 64;                 // Finished operations kept for sanitizeOperations()
+
+enum class SanitizeState : uint8_t {
+    Running,
+    Succeeded,
+    Failed,
+    TimedOut
+};
+
+const char* sanitizeStateName(SanitizeState state);
+
+// One status read of a polled operation
+struct SanitizePoll {
+    bool read;                  // False: the status could not be read this time
+    bool finished;
+    bool failed;                // Finished, and the device reports the purge failed
+    double progress;            // 0-1; negative when the device does not report it
+    std::string message;
+};
+
+struct SanitizeProgress {
+    uint64_t id;
+    std::string path;
+    std::string method;         // purgeMethodToString()
+    std::string job;
+    SanitizeState state;
+    double progress;            // 0-1; negative = unknown
+    bool estimated;             // Progress is elapsed / drive estimate, not reported by the device
+    uint64_t elapsedMs;
+    uint64_t remainingMs;       // Predicted; 0 = unknown
+    uint32_t polls;
+    std::string message;        // Outcome once finished
+};
+
+using SanitizeStatusFn = std::function<SanitizePoll()>;             // Runs on the monitor thread
+using SanitizeCommandFn = std::function<bool(std::string& message)>; // Runs on its own thread; true = purged
+using SanitizeListener = std::function<void(const SanitizeProgress&)>;
+
+struct SanitizeRequest {
+    std::string path;
+    std::string method;
+    uint64_t estimateMs;        // The drive's own estimate; 0 = none
+    uint64_t timeoutMs;         // Polled operations: give up after this long
+    SanitizeStatusFn status;    // Either poll the device with this,
+    SanitizeCommandFn command;  // or run this command that blocks until the purge is done
+    SanitizeListener listener;  // Optional
+    bool finishJob;             // Mark the registering thread's job finished with the operation
+};
+
+// Start watching; returns the operation id
+uint64_t monitorSanitize(SanitizeRequest request);
+
+// Block until the operation has finished and return its outcome. For the
+// synchronous purge entry points; an unknown id returns a Failed record.
+SanitizeProgress waitSanitize(uint64_t id);
+
+// Running operations, then the last SANITIZE_HISTORY finished ones, newest first
+std::vector<SanitizeProgress> sanitizeOperations();
@@ -0,0 +1,375 @@
+#include "stripedWriter.h"
+#include "passEngine.h"
+#include "ioThrottle.h"
+#include "telemetry.h"
+#include <cerrno>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Progress is reported every 1GB, as by DeviceSink
+constexpr uint64_t STRIPE_PROGRESS_STEP = 1024ULL * 1024 * 1024;
+// Stripe boundaries fall on this, so every chunk stays aligned for O_DIRECT
+constexpr uint64_t STRIPE_ALIGNMENT = 1024 * 1024;
+
+unsigned stripeCount(const DeviceSession& session) {
+    if (!session.isBlockDevice || session.rotational || session.deviceType == DeviceType::USB) return 1;
+
+    unsigned stripes;
+    switch (session.deviceType) {
+        case DeviceType::NVME: stripes = STRIPES_NVME; break;
+        case DeviceType::SATA_SSD: stripes = STRIPES_SSD; break;
+        default: stripes = STRIPES_OTHER_SSD; break;
+    }
+    uint64_t bySize = session.size / MIN_STRIPE_BYTES;
+    if (bySize < stripes) stripes = static_cast<unsigned>(bySize);
+    return stripes ? stripes : 1;
+}
+
+StripedSink::StripedSink(DeviceSession& session, unsigned stripes) :
+    session(session),
+    stripeTotal(stripes ? stripes : stripeCount(session)),
+#ifndef _WIN32
+    fd(-1),
+    ownsFd(false),
+#endif
+    passNumber(0),
+    passTotal(0),
+    passWritten(0),
+    totalWritten(0),
+    stolenChunks(0),
+    error(0),
+    failures(0),
+    aborted(false) {
+    if (stripeTotal > MAX_STRIPES) stripeTotal = MAX_STRIPES;
+    uint64_t share = session.size / stripeTotal / STRIPE_ALIGNMENT * STRIPE_ALIGNMENT;
+    if (share == 0) stripeTotal = 1;
+
+    stripeList.reset(new Stripe[stripeTotal]);
+    for (unsigned i = 0; i < stripeTotal; i++) {
+        stripeList[i].begin = i * share;
+        stripeList[i].end = i + 1 == stripeTotal ? session.size : (i + 1) * share;
+    }
+
+    for (unsigned i = 0; i < stripeTotal; i++) writers.emplace_back(new Writer());
+    if (session.writable) {
+#ifdef _WIN32
+        // A synchronous handle serializes its I/O: every writer needs its own
+        for (auto& writer : writers) {
+            writer->handle = CreateFileA(session.path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                         FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                                         FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, NULL);
+            if (writer->handle == INVALID_HANDLE_VALUE) writer->openError = GetLastError();
+        }
+#else
+        fd = open(session.path.c_str(), O_RDWR | O_DIRECT | O_CLOEXEC);
+        ownsFd = fd != -1;
+        if (!ownsFd) {
+            logWarn("stripe") << "O_DIRECT open failed (errno " << errno << "), writing through the session handle";
+            fd = session.fd;
+        }
+#endif
+    }
+    if (WipeJob* job = currentJob()) job->setTargetBytes(session.size);
+}
+
+size_t StripedSink::writeSize() const {
+    size_t size = SIZE_MAX;
+    for (const std::unique_ptr<Writer>& writer : writers) {
+        if (writer->health.writeSize() < size) size = writer->health.writeSize();
+    }
+    return size;
+}
+
+StripedSink::~StripedSink() {
+#ifdef _WIN32
+    for (auto& writer : writers) {
+        if (writer->handle != INVALID_HANDLE_VALUE) CloseHandle(writer->handle);
+    }
+#else
+    if (ownsFd) ::close(fd);
+#endif
+}
+
+bool StripedSink::beginPass(size_t pass, size_t passCount, const PassSpec& spec) {
+    if (!session.writable) {
+        error = session.openError;
+        logError("stripe") << "Device is not open for writing (error " << error << ")";
+        return false;
+    }
+#ifdef _WIN32
+    for (auto& writer : writers) {
+        if (writer->handle == INVALID_HANDLE_VALUE) {
+            error = writer->openError;
+            logError("stripe") << "Could not open a writer handle (error " << error << ")";
+            return false;
+        }
+    }
+#endif
+
+    passNumber = pass;
+    passTotal = passCount;
+    passWritten = 0;
+    stolenChunks = 0;
+    aborted = false;
+    for (unsigned i = 0; i < stripeTotal; i++) {
+        stripeList[i].next = stripeList[i].begin;
+        stripeList[i].written = 0;
+    }
+    passStart = std::chrono::steady_clock::now();
+    for (auto& writer : writers) writer->health.resume(passStart);
+    if (WipeJob* job = currentJob()) job->setPass(static_cast<uint32_t>(pass), static_cast<uint32_t>(passCount));
+
+    if (pass == 1) {
+        logInfo("stripe") << "Writing " << stripeTotal << " stripes of "
+                          << ((stripeList[0].end - stripeList[0].begin) >> 20) << " MB concurrently";
+    }
+    emitEvent(TelemetryEvent::PassStarted, "pass", describePass(pass, passCount, spec), pass, passCount, session.size);
+    return true;
+}
+
+// Next chunk for `writer`: from its own stripe, else from the stripe with the
+// most bytes left. Claims are a single fetch_add; an overshoot past the
+// stripe's end just means the stripe is done.
+bool StripedSink::claim(unsigned writer, size_t chunk, uint64_t& offset, size_t& len) {
+    Stripe& own = stripeList[writer];
+    if (own.next.load(std::memory_order_relaxed) < own.end) {
+        uint64_t at = own.next.fetch_add(chunk);
+        if (at < own.end) {
+            offset = at;
+            len = static_cast<size_t>(own.end - at < chunk ? own.end - at : chunk);
+            return true;
+        }
+    }
+    for (;;) {
+        Stripe* victim = nullptr;
+        uint64_t most = 0;
+        for (unsigned i = 0; i < stripeTotal; i++) {
+            uint64_t next = stripeList[i].next.load(std::memory_order_relaxed);
+            uint64_t left = next < stripeList[i].end ? stripeList[i].end - next : 0;
+            if (left > most) {
+                most = left;
+                victim = &stripeList[i];
+            }
+        }
+        if (!victim) return false;
+        uint64_t at = victim->next.fetch_add(chunk);
+        if (at < victim->end) {
+            offset = at;
+            len = static_cast<size_t>(victim->end - at < chunk ? victim->end - at : chunk);
+            stolenChunks++;
+            return true;
+        }
+    }
+}
+
+bool StripedSink::writeStripes(size_t chunk, const std::function<ChunkFn()>& makeChunks) {
+    // Writers charge their buffers to the caller's job and run on its NUMA node
+    JobRef job = currentJobRef();
+    int numaNode = currentNumaNode();
+    std::vector<std::thread> threads;
+    for (unsigned w = 0; w < stripeTotal; w++) {
+        threads.emplace_back([&, w] {
+            JobScope scope(job);
+            NumaScope numa(numaNode);
+            ChunkFn next = makeChunks();
+            if (!next) {
+                fail(ENOMEM);
+                return;
+            }
+            uint64_t offset;
+            size_t len;
+            while (!aborted && claim(w, chunk, offset, len)) {
+                if (!writeChunk(*writers[w], offset, next(offset, len), len)) return;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    return !aborted;
+}
+
+// As DeviceSink::write: throttled, split to the health monitor's write size,
+// paused when the monitor asks for it
+bool StripedSink::writeChunk(Writer& writer, uint64_t offset, const uint8_t* data, size_t len) {
+    HealthMonitor& health = writer.health;
+    size_t done = 0;
+    while (done < len && !aborted) {
+        size_t n = len - done < health.writeSize() ? len - done : health.writeSize();
+        if (throttleWrite(n)) health.resume();
+        auto start = std::chrono::steady_clock::now();
+        if (!writeRange(writer, offset + done, data + done, n)) return false;
+        auto end = std::chrono::steady_clock::now();
+        uint32_t pauseMs = health.record(offset + done, n,
+                                         std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), end);
+        if (pauseMs) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(pauseMs));
+            health.resume();
+        }
+        done += n;
+    }
+    // Stopped by another writer's failure: the chunk was not all written
+    if (done != len) return false;
+    addProgress(offset, len);
+    return true;
+}
+
+// Write, or on a media error bisect down to single sectors and record the
+// ones that stay unwritable
+bool StripedSink::writeRange(Writer& writer, uint64_t offset, const uint8_t* data, size_t len) {
+    if (currentJobCancelled()) return fail(JOB_CANCELLED_ERROR);
+    uint32_t result = 0;
+    if (writeAt(writer, offset, data, len, result)) return true;
+    if (!isMediaError(result)) return fail(result);
+    if (++failures > MAX_FAILED_WRITES) {
+        logError("stripe") << "Too many failed writes (" << failures << "), device is failing; aborting";
+        return fail(result);
+    }
+
+    const size_t sector = session.logicalSectorSize;
+    if (len <= sector) {
+        recordBad(offset, len, result);
+        return true;
+    }
+    size_t half = len / 2 / sector * sector;
+    if (half < sector) half = sector;
+    return writeRange(writer, offset, data, half) && writeRange(writer, offset + half, data + half, len - half);
+}
+
+bool StripedSink::writeAt(Writer& writer, uint64_t offset, const uint8_t* data, size_t len, uint32_t& result) {
+    IoTimer timer(offset, len);
+#ifdef _WIN32
+    OVERLAPPED ov = {};
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD bytesWritten = 0;
+    bool ok = WriteFile(writer.handle, data, static_cast<DWORD>(len), &bytesWritten, &ov) && bytesWritten == len;
+    if (!ok) result = bytesWritten == len ? GetLastError() : ERROR_WRITE_FAULT;
+#else
+    (void)writer;
+    bool ok = true;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t written = pwrite(fd, data + done, len - done, static_cast<off_t>(offset + done));
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            result = written < 0 ? errno : EIO;
+            ok = false;
+            break;
+        }
+        done += static_cast<size_t>(written);
+    }
+#endif
+    timer.write(ok, ok ? 0 : result);
+    if (ok) recordNumaWrite(len);
+    return ok;
+}
+
+bool StripedSink::fail(uint32_t result) {
+    if (!aborted.exchange(true)) {
+        error = result;
+        logError("stripe") << "Striped write failed (error " << result << ")";
+    }
+    return false;
+}
+
+void StripedSink::recordBad(uint64_t offset, uint64_t length, uint32_t result) {
+    emitEvent(TelemetryEvent::BadRange, "stripe", "Unwritable sector at offset " + std::to_string(offset) +
+              " (error " + std::to_string(result) + ")", offset, length, result);
+    {
+        std::lock_guard<std::mutex> lock(badMutex);
+        bad.add(offset, length);
+    }
+    if (WipeJob* job = currentJob()) job->recordBadRange(offset, length);
+}
+
+void StripedSink::addProgress(uint64_t offset, uint64_t bytes) {
+    totalWritten += bytes;
+    for (unsigned i = 0; i < stripeTotal; i++) {
+        if (offset >= stripeList[i].begin && offset < stripeList[i].end) stripeList[i].written += bytes;
+    }
+    if (WipeJob* job = currentJob()) job->recordWrittenRange(offset, bytes);
+
+    uint64_t before = passWritten.fetch_add(bytes);
+    uint64_t after = before + bytes;
+    if (before / STRIPE_PROGRESS_STEP == after / STRIPE_PROGRESS_STEP) return;
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+    double writtenMB = after / 1024.0 / 1024.0;
+    int speed = static_cast<int>(writtenMB / (elapsed > 0 ? elapsed : 1));
+    std::ostringstream line;
+    line << "Progress: " << static_cast<int>((after * 100) / session.size) << "% (" << static_cast<int>(writtenMB)
+         << " MB) - Speed: " << speed << " MB/s";
+    emitEvent(TelemetryEvent::Progress, "pass", line.str(), after, session.size, speed);
+}
+
+bool StripedSink::endPass() {
+    // As DeviceSink::endPass: a pass is complete only once it is on stable media
+#ifdef _WIN32
+    for (auto& writer : writers) {
+        if (!FlushFileBuffers(writer->handle)) {
+            error = GetLastError();
+            logError("stripe") << "Flush after pass " << passNumber << " failed (error " << error << ")";
+            return false;
+        }
+    }
+#else
+    if (fsync(fd) != 0) {
+        error = errno;
+        logError("stripe") << "Flush after pass " << passNumber << " failed (error " << error << ")";
+        return false;
+    }
+#endif
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+    std::ostringstream line;
+    line << "Pass " << passNumber << "/" << passTotal << " completed in " << static_cast<int>(elapsed)
+         << " seconds (" << static_cast<int>((passWritten / 1024.0 / 1024.0) / (elapsed > 0 ? elapsed : 1))
+         << " MB/s, " << stripeTotal << " stripes, " << stolenChunks << " chunks rebalanced)";
+    emitEvent(TelemetryEvent::PassFinished, "pass", line.str(), passNumber, passTotal,
+              static_cast<uint64_t>(elapsed * 1000));
+    return true;
+}
+
+// Export for testing: stripe a file (or device) with K writers and check the
+// written ranges cover it exactly once per pass
+#ifdef TEST_STANDALONE
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: stripedWriter <file or device> [stripes] [method]" << std::endl;
+        return 1;
+    }
+    std::shared_ptr<DeviceSession> session = openDeviceSession(argv[1]);
+    if (!session->writable || session->size == 0) {
+        std::cerr << "Cannot write " << argv[1] << std::endl;
+        return 1;
+    }
+    unsigned stripes = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 0;
+    std::cout << "Auto stripe count for " << argv[1] << ": " << stripeCount(*session) << std::endl;
+
+    JobRef job = startJob("stripe-test", session->path);
+    JobScope scope(job, true);
+    StripedSink sink(*session, stripes ? stripes : 4);
+    auto start = std::chrono::steady_clock::now();
+    bool found = false;
+    bool ok = runSchemeByName(sink, argc > 3 ? argv[3] : "dod", 4 * 1024 * 1024, &found);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    BadRangeList written = job->writtenRanges();
+    ok = ok && found && written.ranges().size() == 1 && written.bytes() == session->size;
+    std::cout << (sink.bytesWritten() >> 20) << " MB in " << seconds << " s, " << sink.stripes() << " stripes, "
+              << sink.steals() << " chunks rebalanced, last pass covered " << written.bytes() << " of "
+              << session->size << " bytes" << std::endl;
+
+    // Stripe boundaries are not a multiple of a 3-byte period
+    ok = checkPatternPhase(sink, argv[1], {BadRange{0, session->size}}, 4 * 1024 * 1024) && ok;
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "deviceSession.h"
+#include "wipeSchemes.h"
+#include "healthMonitor.h"
+
+// Striped writer: several concurrent write streams over one device.
+//
+// Enterprise NVMe drives only reach their rated write bandwidth with many
+// commands in flight; one synchronous stream from offset 0 leaves most of
+// their queues idle. StripedSink splits the LBA range into K contiguous
+// stripes, one writer thread each. Every writer has its own handle, health
+// monitor and chunk source, and claims chunks from its stripe through an
+// atomic cursor. A writer whose stripe is done claims from the stripe with
+// the most left, so fast stripes take work from slow ones without a lock.
+//
+// The bytes each pass has written are recorded on the job as merged ranges
+// (WipeJob::writtenRanges), the same for every device sink, so progress and
+// resume state stay exact whatever order the stripes finish in.
+//
+// K comes from the probed device type (stripeCount): 1 for rotational and USB
+// devices, which only lose from seeking between streams, more for SSDs and
+// most for NVMe. With K = 1 the flat DeviceSink is used.
+
+constexpr unsigned STRIPES_NVME = 8;
+constexpr unsigned STRIPES_SSD = 4;
+constexpr unsigned STRIPES_OTHER_SSD = 2;       // Non-rotational SCSI / unknown
+constexpr unsigned MAX_STRIPES = 32;
+constexpr uint64_t MIN_STRIPE_BYTES = 1024ULL * 1024 * 1024;
+constexpr size_t STRIPE_MAX_CHUNK = 16 * 1024 * 1024;   // Claim size; random passes buffer one per writer
+
+// Stripes to use for the session; 1 means a single sequential stream
+unsigned stripeCount(const DeviceSession& session);
+
+// One contiguous share of the device
+struct Stripe {
+    uint64_t begin;
+    uint64_t end;
+    std::atomic<uint64_t> next{0};      // First unclaimed offset; may overshoot end
+    std::atomic<uint64_t> written{0};
+};
+
+class StripedSink {
+public:
+    static constexpr bool writesOwnPass = true;
+
+    // `stripes` 0 picks stripeCount(session)
+    explicit StripedSink(DeviceSession& session, unsigned stripes = 0);
+    ~StripedSink();
+    StripedSink(const StripedSink&) = delete;
+    StripedSink& operator=(const StripedSink&) = delete;
+
+    uint64_t size() const { return session.size; }
+    bool beginPass(size_t pass, size_t passCount, const PassSpec& spec);
+    template <typename Source>
+    bool writePass(Source& source);
+    bool endPass();
+
+    uint64_t bytesWritten() const { return totalWritten; }     // All passes
+    uint32_t lastError() const { return error; }
+    const BadRangeList& badRanges() const { return bad; }      // Merged across passes
+    unsigned stripes() const { return stripeTotal; }
+    size_t writeSize() const;                                  // Smallest write size the writers' health monitors allow
+    uint64_t steals() const { return stolenChunks; }           // Chunks written outside their writer's stripe, this pass
+
+private:
+    // Per-writer chunk generator: returns the `len` bytes to write at `offset`
+    using ChunkFn = std::function<const uint8_t*(uint64_t offset, size_t len)>;
+
+    struct Writer {
+#ifdef _WIN32
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        DWORD openError = 0;        // GetLastError() of a failed CreateFileA
+#endif
+        HealthMonitor health;
+    };
+
+    bool writeStripes(size_t chunk, const std::function<ChunkFn()>& makeChunks);
+    bool claim(unsigned writer, size_t chunk, uint64_t& offset, size_t& len);
+    bool writeChunk(Writer& writer, uint64_t offset, const uint8_t* data, size_t len);
+    bool writeRange(Writer& writer, uint64_t offset, const uint8_t* data, size_t len);
+    bool writeAt(Writer& writer, uint64_t offset, const uint8_t* data, size_t len, uint32_t& result);
+    bool fail(uint32_t result);
+    void recordBad(uint64_t offset, uint64_t length, uint32_t result);
+    void addProgress(uint64_t offset, uint64_t bytes);
+
+    DeviceSession& session;
+    unsigned stripeTotal;
+    std::unique_ptr<Stripe[]> stripeList;
+    std::vector<std::unique_ptr<Writer>> writers;
+#ifndef _WIN32
+    int fd;                 // O_DIRECT handle shared by the writers, or the session's own
+    bool ownsFd;
+#endif
+    size_t passNumber;
+    size_t passTotal;
+    std::atomic<uint64_t> passWritten;
+    std::atomic<uint64_t> totalWritten;
+    std::atomic<uint64_t> stolenChunks;
+    std::atomic<uint32_t> error;
+    std::atomic<uint32_t> failures;
+    std::atomic<bool> aborted;
+    std::mutex badMutex;
+    BadRangeList bad;
+    std::chrono::steady_clock::time_point passStart;
+};
+
+template <typename Source>
+bool StripedSink::writePass(Source& source) {
+    const size_t chunk = source.chunkSize();
+    if constexpr (std::is_same<Source, RandomSource>::value) {
+        // A random source refills one scratch buffer: each writer gets its
+        // own, allocated on the writer's thread and NUMA node
+        return writeStripes(chunk, [chunk] {
+            auto own = std::make_shared<RandomSource>(chunk);
+            return own->valid() ? ChunkFn([own](uint64_t offset, size_t len) { return own->next(offset, len); }) : ChunkFn();
+        });
+    } else {
+        // Pattern chunks are immutable and shared by every writer
+        return writeStripes(chunk, [&source] {
+            return ChunkFn([&source](uint64_t offset, size_t len) { return source.next(offset, len); });
+        });
+    }
+}
@@ -0,0 +1,213 @@
+#include "telemetry.h"
+#include "wipeJob.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+// Bounded MPMC queue after Vyukov: each slot's sequence says whose turn it is.
+// A producer owns slot `pos` once it wins the CAS on `tail`, fills it and
+// publishes with sequence = pos + 1; the consumer frees it with pos + capacity.
+struct Slot {
+    std::atomic<uint64_t> sequence;
+    TelemetryRecord record;
+};
+
+struct Ring {
+    Slot slots[TELEMETRY_CAPACITY];
+    alignas(64) std::atomic<uint64_t> tail{0};
+    alignas(64) uint64_t head = 0;      // Guarded by drainMutex
+    std::atomic<uint64_t> dropped{0};
+    std::mutex drainMutex;
+
+    Ring() {
+        for (size_t i = 0; i < TELEMETRY_CAPACITY; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+};
+
+static_assert((TELEMETRY_CAPACITY & (TELEMETRY_CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+Ring& ring() {
+    static Ring instance;
+    return instance;
+}
+
+// Records are echoed to the console until someone drains the ring, so
+// standalone tools and an addon without a JS consumer still show output
+std::atomic<bool> echo{true};
+std::atomic<bool> echoPinned{false};    // setTelemetryEcho() overrides the default
+std::mutex echoMutex;
+
+std::atomic<uint32_t> nextThread{1};
+thread_local uint32_t threadNumber = 0;
+
+void copyField(char* dst, size_t size, const char* src, size_t length) {
+    length = std::min(length, size - 1);
+    std::memcpy(dst, src, length);
+    dst[length] = '\0';
+}
+
+bool push(LogLevel level, TelemetryEvent event, const char* category, const std::string& text,
+          uint64_t a, uint64_t b, uint64_t c) {
+    Ring& r = ring();
+    uint64_t pos = r.tail.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &r.slots[pos & (TELEMETRY_CAPACITY - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (r.tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            r.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = r.tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Line breaks from converted std::cout output carry no meaning in a record
+    size_t first = text.find_first_not_of('\n');
+    size_t last = text.find_last_not_of('\n');
+    size_t length = first == std::string::npos ? 0 : last - first + 1;
+
+    TelemetryRecord& rec = slot->record;
+    rec.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    rec.values[0] = a;
+    rec.values[1] = b;
+    rec.values[2] = c;
+    if (threadNumber == 0) threadNumber = nextThread.fetch_add(1, std::memory_order_relaxed);
+    rec.thread = threadNumber;
+    rec.level = level;
+    rec.event = event;
+    copyField(rec.category, sizeof(rec.category), category, std::strlen(category));
+    WipeJob* job = currentJob();
+    copyField(rec.job, sizeof(rec.job), job ? job->id.data() : "", job ? job->id.size() : 0);
+    copyField(rec.text, sizeof(rec.text), length ? text.data() + first : "", length);
+    rec.textLength = static_cast<uint16_t>(std::strlen(rec.text));
+
+    if (echo.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(echoMutex);
+        (level >= LogLevel::Warn ? std::cerr : std::cout) << rec.text << std::endl;
+    }
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+}
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warn: return "WARN";
+        case LogLevel::Error: return "ERROR";
+    }
+    return "INFO";
+}
+
+const char* telemetryEventName(TelemetryEvent event) {
+    switch (event) {
+        case TelemetryEvent::Log: return "log";
+        case TelemetryEvent::JobStarted: return "job_started";
+        case TelemetryEvent::JobFinished: return "job_finished";
+        case TelemetryEvent::PassStarted: return "pass_started";
+        case TelemetryEvent::PassFinished: return "pass_finished";
+        case TelemetryEvent::Progress: return "progress";
+        case TelemetryEvent::BadRange: return "bad_range";
+        case TelemetryEvent::DeviceHealth: return "device_health";
+        case TelemetryEvent::SanitizeProgress: return "sanitize_progress";
+        case TelemetryEvent::SanitizeFinished: return "sanitize_finished";
+    }
+    return "log";
+}
+
+bool logMessage(LogLevel level, const char* category, const std::string& text) {
+    return push(level, TelemetryEvent::Log, category, text, 0, 0, 0);
+}
+
+bool emitEvent(TelemetryEvent event, const char* category, const std::string& text,
+               uint64_t a, uint64_t b, uint64_t c) {
+    LogLevel level = event == TelemetryEvent::BadRange || event == TelemetryEvent::DeviceHealth ? LogLevel::Warn :
+                     event == TelemetryEvent::Progress || event == TelemetryEvent::SanitizeProgress ? LogLevel::Debug : LogLevel::Info;
+    return push(level, event, category, text, a, b, c);
+}
+
+size_t drainTelemetry(std::vector<TelemetryRecord>& out, size_t max) {
+    Ring& r = ring();
+    std::lock_guard<std::mutex> lock(r.drainMutex);
+    if (!echoPinned.load(std::memory_order_relaxed)) echo.store(false, std::memory_order_relaxed);
+    size_t drained = 0;
+    while (drained < max) {
+        Slot& slot = r.slots[r.head & (TELEMETRY_CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != r.head + 1) break;     // Empty, or still being filled
+        out.push_back(slot.record);
+        slot.sequence.store(r.head + TELEMETRY_CAPACITY, std::memory_order_release);
+        r.head++;
+        drained++;
+    }
+    return drained;
+}
+
+uint64_t telemetryDropped() {
+    return ring().dropped.load(std::memory_order_relaxed);
+}
+
+void setTelemetryEcho(bool on) {
+    echoPinned.store(true, std::memory_order_relaxed);
+    echo.store(on, std::memory_order_relaxed);
+}
+
+// Export for testing: producers racing a consumer lose nothing they were told
+// was queued, and each producer's records arrive in order
+#ifdef TEST_STANDALONE
+#include <thread>
+
+int main() {
+    setTelemetryEcho(false);
+    constexpr int PRODUCERS = 8;
+    constexpr uint64_t PER_PRODUCER = 200000;
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<int> running{PRODUCERS};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&, p] {
+            for (uint64_t i = 0; i < PER_PRODUCER; i++) {
+                if (emitEvent(TelemetryEvent::Progress, "test", "", p, i)) accepted++;
+            }
+            running--;
+        });
+    }
+
+    std::vector<uint64_t> nextExpected(PRODUCERS, 0);
+    std::vector<TelemetryRecord> batch;
+    uint64_t received = 0;
+    bool ordered = true;
+    for (;;) {
+        bool done = running.load() == 0;
+        batch.clear();
+        drainTelemetry(batch, 1024);
+        for (const TelemetryRecord& rec : batch) {
+            uint64_t& expected = nextExpected[rec.values[0]];
+            ordered = ordered && rec.values[1] >= expected;
+            expected = rec.values[1] + 1;
+        }
+        received += batch.size();
+        if (done && batch.empty()) break;
+    }
+    for (std::thread& t : producers) t.join();
+
+    bool ok = ordered && received == accepted && accepted + telemetryDropped() == PRODUCERS * PER_PRODUCER;
+    std::cout << "Records: " << received << " received, " << telemetryDropped() << " dropped (ring full), "
+              << (ordered ? "per-producer order kept" : "OUT OF ORDER") << std::endl;
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
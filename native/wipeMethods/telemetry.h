@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Native telemetry.
+//
+// Log lines and engine events from any native thread go into one fixed-size,
+// lock-free multi-producer ring of 256-byte records instead of std::cout.
+// Producers never block: a full ring drops the record and counts it. The
+// Electron side drains the ring in batches (drainTelemetry() in the addon,
+// polled by wipeController.js) and forwards the records to wipeLogger.js.
+//
+// Each record carries the calling thread's job id (wipeJob.h), so log lines
+// from concurrent jobs can be told apart.
+
+constexpr size_t TELEMETRY_CAPACITY = 8192;    // Records; power of two
+constexpr size_t TELEMETRY_TEXT_SIZE = 160;    // Longer messages are truncated
+
+enum class LogLevel : uint8_t {
+    Debug,
+    Info,
+    Warn,
+    Error
+};
+
+// Structured events; `values` holds the listed fields, unused ones are 0
+enum class TelemetryEvent : uint8_t {
+    Log,            // Plain log line
+    JobStarted,     // -
+    JobFinished,    // elapsed ms
+    PassStarted,    // pass, passes, bytes per pass
+    PassFinished,   // pass, passes, elapsed ms
+    Progress,       // bytes written this pass, bytes per pass, MB/s
+    BadRange,       // offset, length, error code
+    DeviceHealth,   // HealthEventKind, MB/s, baseline MB/s (healthMonitor.h)
+    SanitizeProgress,   // progress in 1/10000, elapsed ms, predicted remaining ms (sanitizeMonitor.h)
+    SanitizeFinished    // SanitizeState, elapsed ms, status reads
+};
+
+struct TelemetryRecord {
+    uint64_t timeUs;            // System clock, microseconds since the epoch
+    uint64_t values[3];
+    uint32_t thread;            // Small per-process thread number
+    LogLevel level;
+    TelemetryEvent event;
+    uint16_t textLength;
+    char category[16];
+    char job[40];
+    char text[TELEMETRY_TEXT_SIZE];
+};
+static_assert(sizeof(TelemetryRecord) == 256, "telemetry records are fixed-size");
+
+const char* logLevelName(LogLevel level);
+const char* telemetryEventName(TelemetryEvent event);
+
+// Append a record; false if the ring was full and the record was dropped
+bool logMessage(LogLevel level, const char* category, const std::string& text);
+bool emitEvent(TelemetryEvent event, const char* category, const std::string& text,
+               uint64_t a = 0, uint64_t b = 0, uint64_t c = 0);
+
+// Move up to `max` records into `out` (oldest first); returns the count.
+// Drains from several threads are serialized; producers are never blocked.
+size_t drainTelemetry(std::vector<TelemetryRecord>& out, size_t max);
+uint64_t telemetryDropped();    // Records lost to a full ring since start
+
+// Also print each record to stdout/stderr as it is queued (serialized). On by
+// default until the first drainTelemetry() call, so standalone builds keep
+// their console output.
+void setTelemetryEcho(bool on);
+
+// Stream-style log line, emitted when the statement ends:
+//     logInfo("pass") << "Pass " << pass << "/" << passes;
+class LogLine {
+public:
+    LogLine(LogLevel level, const char* category) : level(level), category(category) {}
+    ~LogLine() { logMessage(level, category, stream.str()); }
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    template<typename T>
+    LogLine& operator<<(const T& value) {
+        stream << value;
+        return *this;
+    }
+    // std::endl and friends; the line break itself is dropped
+    LogLine& operator<<(std::ostream& (*manipulator)(std::ostream&)) {
+        stream << manipulator;
+        return *this;
+    }
+
+private:
+    LogLevel level;
+    const char* category;
+    std::ostringstream stream;
+};
+
+inline LogLine logDebug(const char* category) { return LogLine(LogLevel::Debug, category); }
+inline LogLine logInfo(const char* category) { return LogLine(LogLevel::Info, category); }
+inline LogLine logWarn(const char* category) { return LogLine(LogLevel::Warn, category); }
+inline LogLine logError(const char* category) { return LogLine(LogLevel::Error, category); }
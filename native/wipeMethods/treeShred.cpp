@@ -0,0 +1,297 @@
+#include "treeShred.h"
+#include "fileShred.h"
+#include "wipeJob.h"
+#include "telemetry.h"
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+constexpr unsigned MAX_TREE_THREADS = 8;
+
+namespace {
+
+struct FileEntry {
+    std::string path;
+    uint64_t size;
+    std::atomic<bool> failed{false};
+    std::string error;          // Set by the failing task, under failureMutex
+};
+
+// Either one mapped range of a large file or a batch of small files
+struct ShredTask {
+    size_t file;                // Range task: index into files
+    uint64_t begin;
+    uint64_t end;
+    std::vector<size_t> batch;  // Batch task: indices into files
+};
+
+class WorkStealingQueues {
+public:
+    explicit WorkStealingQueues(size_t workers) {
+        for (size_t i = 0; i < workers; i++) queues.emplace_back(new Queue());
+    }
+
+    void push(size_t worker, ShredTask task) {
+        std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+        queues[worker]->tasks.push_back(std::move(task));
+    }
+
+    // Own deque from the back (most recently pushed), others from the front.
+    // No task is ever pushed after the workers start, so an empty sweep means
+    // there is nothing left to do.
+    bool next(size_t worker, ShredTask& task) {
+        {
+            Queue& own = *queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues.size(); k++) {
+            Queue& victim = *queues[(worker + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::atomic<uint64_t> steals{0};
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<ShredTask> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+};
+
+// Split a large file at extent boundaries into ~TREE_TASK_BYTES ranges
+void splitLargeFile(size_t index, const ExtentSink& sink, std::vector<ShredTask>& tasks) {
+    uint64_t begin = 0;
+    uint64_t mapped = 0;
+    for (const FileExtent& e : sink.extents()) {
+        uint64_t extentEnd = mapped + e.length;
+        // Oversized extents are cut into TREE_TASK_BYTES pieces
+        while (extentEnd - begin >= 2 * TREE_TASK_BYTES) {
+            tasks.push_back(ShredTask{index, begin, begin + TREE_TASK_BYTES, {}});
+            begin += TREE_TASK_BYTES;
+        }
+        if (extentEnd - begin >= TREE_TASK_BYTES) {
+            tasks.push_back(ShredTask{index, begin, extentEnd, {}});
+            begin = extentEnd;
+        }
+        mapped = extentEnd;
+    }
+    if (mapped > begin) {
+        tasks.push_back(ShredTask{index, begin, mapped, {}});
+    }
+}
+
+}
+
+TreeShredResult shredTree(const std::string& root, const std::string& method, unsigned threads, bool removeAfter) {
+    TreeShredResult result;
+    result.success = false;
+    result.root = root;
+    result.method = method;
+    result.files = 0;
+    result.directories = 0;
+    result.bytesWritten = 0;
+    result.holeBytes = 0;
+    result.threads = 0;
+    result.tasks = 0;
+    result.steals = 0;
+    result.removed = false;
+    result.durationMs = 0;
+    result.throughputMBps = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // 1. Walk the tree (no symlink following)
+    std::error_code ec;
+    if (!fs::is_directory(fs::symlink_status(root, ec))) {
+        result.message = "Not a directory: " + root;
+        return result;
+    }
+
+    std::vector<std::unique_ptr<FileEntry>> files;
+    std::vector<fs::path> others;       // Symlinks, FIFOs, sockets: removed, not overwritten
+    std::vector<fs::path> directories;
+    for (fs::recursive_directory_iterator it(root, fs::directory_options::none, ec), end; !ec && it != end; it.increment(ec)) {
+        fs::file_status status = it->symlink_status(ec);
+        if (ec) break;
+        if (fs::is_directory(status)) {
+            directories.push_back(it->path());
+        } else if (fs::is_regular_file(status)) {
+            std::unique_ptr<FileEntry> entry(new FileEntry());
+            entry->path = it->path().string();
+            entry->size = it->file_size(ec);
+            files.push_back(std::move(entry));
+        } else {
+            others.push_back(it->path());
+        }
+    }
+    if (ec) {
+        result.message = "Directory walk failed: " + ec.message();
+        return result;
+    }
+    result.files = files.size();
+    result.directories = directories.size() + 1;
+
+    // 2. Plan tasks: split large files, batch small ones
+    std::vector<ShredTask> tasks;
+    uint64_t splitHoleBytes = 0;
+    ShredTask batch{0, 0, 0, {}};
+    uint64_t batchBytes = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (files[i]->size >= TREE_SPLIT_THRESHOLD) {
+            ExtentSink sink;
+            if (sink.open(files[i]->path)) {
+                splitLargeFile(i, sink, tasks);
+                splitHoleBytes += sink.fileSize() - sink.mappedSize();
+                continue;
+            }
+            // Cannot map it here; let a worker retry and report the error
+        }
+        batch.batch.push_back(i);
+        batchBytes += files[i]->size;
+        if (batch.batch.size() >= TREE_BATCH_FILES || batchBytes >= TREE_BATCH_BYTES) {
+            tasks.push_back(std::move(batch));
+            batch = ShredTask{0, 0, 0, {}};
+            batchBytes = 0;
+        }
+    }
+    if (!batch.batch.empty()) tasks.push_back(std::move(batch));
+    result.tasks = tasks.size();
+
+    unsigned workerCount = threads ? threads : std::min(MAX_TREE_THREADS, std::max(1u, std::thread::hardware_concurrency()));
+    workerCount = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(workerCount, tasks.size())));
+    result.threads = workerCount;
+
+    WorkStealingQueues queues(workerCount);
+    for (size_t i = 0; i < tasks.size(); i++) {
+        queues.push(i % workerCount, std::move(tasks[i]));
+    }
+
+    // 3. Overwrite
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<uint64_t> holeBytes{splitHoleBytes};
+    std::mutex failureMutex;
+    bool unknownMethod = false;
+
+    auto fail = [&](FileEntry& file, const std::string& why) {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        if (!file.failed.exchange(true)) file.error = why;
+    };
+
+    auto shredRange = [&](FileEntry& file, bool ranged, uint64_t begin, uint64_t end) {
+        if (file.failed) return;
+        ExtentSink sink;
+        if (!sink.open(file.path)) {
+            fail(file, "open failed (error " + std::to_string(sink.lastError()) + ")");
+            return;
+        }
+        if (ranged) {
+            sink.setRange(begin, end);
+        } else {
+            holeBytes += sink.fileSize() - sink.mappedSize();
+        }
+        bool found = true;
+        bool ok = sink.size() == 0 || runSchemeByName(sink, method, SHRED_CHUNK_SIZE, &found);
+        bytesWritten += sink.bytesWritten();
+        if (!found) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            unknownMethod = true;
+        } else if (!ok) {
+            fail(file, "write failed (error " + std::to_string(sink.lastError()) + ")");
+        }
+    };
+
+    // Workers charge their buffers to the caller's job and run on its NUMA node
+    JobRef job = currentJobRef();
+    int numaNode = currentNumaNode();
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < workerCount; w++) {
+        workers.emplace_back([&, w] {
+            JobScope scope(job);
+            NumaScope numa(numaNode);
+            ShredTask task;
+            while (queues.next(w, task)) {
+                if (task.batch.empty()) {
+                    shredRange(*files[task.file], true, task.begin, task.end);
+                } else {
+                    for (size_t index : task.batch) shredRange(*files[index], false, 0, 0);
+                }
+            }
+        });
+    }
+    for (std::thread& t : workers) t.join();
+
+    result.bytesWritten = bytesWritten;
+    result.holeBytes = holeBytes;
+    result.steals = queues.steals;
+    for (const auto& file : files) {
+        if (file->failed) result.failures.push_back(file->path + ": " + file->error);
+    }
+
+    // 4. Remove, only if every file is overwritten and flushed
+    if (unknownMethod) {
+        result.message = "Unknown method: " + method;
+    } else if (!result.failures.empty()) {
+        result.message = std::to_string(result.failures.size()) + " of " + std::to_string(files.size()) +
+                         " files failed; tree left in place";
+    } else {
+        result.success = true;
+        result.message = "Overwrote " + std::to_string(files.size()) + " files";
+        if (removeAfter) {
+            bool removed = true;
+            for (const auto& file : files) removed = removeShreddedFile(file->path) && removed;
+            for (const fs::path& p : others) removed = fs::remove(p, ec) && removed;
+            // Deepest directories first
+            std::sort(directories.begin(), directories.end(), [](const fs::path& a, const fs::path& b) {
+                return a.string().size() > b.string().size();
+            });
+            for (const fs::path& d : directories) removed = fs::remove(d, ec) && removed;
+            removed = fs::remove(root, ec) && removed;
+            result.removed = removed;
+            result.message += removed ? " and removed the tree" : "; some entries could not be removed";
+        }
+    }
+
+    result.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.throughputMBps = (result.bytesWritten / 1024.0 / 1024.0) / (result.durationMs > 0 ? result.durationMs / 1000.0 : 1);
+    logInfo("shred") << "Tree shred " << root << " (" << method << "): " << result.files << " files, "
+                     << result.tasks << " tasks on " << result.threads << " threads (" << result.steals << " steals), "
+                     << static_cast<int>(result.throughputMBps) << " MB/s - " << result.message;
+    return result;
+}
+
+// Export for testing
+#ifdef TEST_STANDALONE
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: treeShred <dir> [method] [threads] [--remove]" << std::endl;
+        return 1;
+    }
+    TreeShredResult result = shredTree(argv[1], argc > 2 ? argv[2] : "zero",
+                                       argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 0,
+                                       argc > 4 && std::string(argv[4]) == "--remove");
+    for (const std::string& f : result.failures) std::cout << "  FAILED " << f << std::endl;
+    return result.success ? 0 : 1;
+}
+#endif
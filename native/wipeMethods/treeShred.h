@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Parallel directory-tree shredding.
+//
+// The tree is walked once (symlinks are removed, never followed) and turned
+// into tasks: files larger than TREE_SPLIT_THRESHOLD are split at extent
+// boundaries into ~TREE_TASK_BYTES ranges, smaller files are batched. Tasks
+// are dealt round-robin onto per-worker deques; a worker pops from the back
+// of its own deque and, when it runs dry, steals from the front of another.
+//
+// Nothing is removed until every file has been overwritten and flushed. If
+// any file fails, the whole tree is left in place and the failures reported.
+
+constexpr uint64_t TREE_SPLIT_THRESHOLD = 64ULL * 1024 * 1024;
+constexpr uint64_t TREE_TASK_BYTES = 64ULL * 1024 * 1024;
+constexpr uint64_t TREE_BATCH_BYTES = 16ULL * 1024 * 1024;
+constexpr size_t TREE_BATCH_FILES = 64;
+
+struct TreeShredResult {
+    bool success;
+    std::string root;
+    std::string method;
+    uint64_t files;
+    uint64_t directories;
+    uint64_t bytesWritten;      // All passes, all files
+    uint64_t holeBytes;
+    uint32_t threads;
+    uint64_t tasks;
+    uint64_t steals;
+    bool removed;
+    double durationMs;
+    double throughputMBps;      // bytesWritten / wall time
+    std::vector<std::string> failures;
+    std::string message;
+};
+
+// threads = 0 picks min(hardware threads, 8)
+TreeShredResult shredTree(const std::string& root, const std::string& method, unsigned threads, bool removeAfter);
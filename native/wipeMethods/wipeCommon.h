@@ -6,40 +6,88 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
+#include "wipeSchemes.h"
+#include "fileShred.h"
 
-// Helper to fill buffer with zeros, ones, or random
+// Helper to fill buffer with zeros, ones, or random (the same xoshiro fill
+// RandomSource uses, so benchmarks compare dispatch and not generators)
 inline void fillBuffer(char* buffer, size_t size, uint8_t pattern, bool random) {
     if (!random) {
         memset(buffer, pattern, size);
     } else {
-        for (size_t i = 0; i < size; ++i)
-            buffer[i] = rand() % 256;
+        fillRandomBytes(reinterpret_cast<uint8_t*>(buffer), size);
     }
 }
 
-// General wipe function
-inline bool wipeTarget(const std::string& path, const std::vector<std::pair<uint8_t, bool>>& passes) {
-    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
-    if (!file.is_open()) return false;
+// Chunk size for file-based schemes
+constexpr size_t FILE_CHUNK_SIZE = 1024 * 1024;
 
-    file.seekg(0, std::ios::end);
-    std::streamoff filesize = file.tellg();
-    file.seekp(0, std::ios::beg);
+// Sequential fstream sink for file targets (see the sink interface in wipeSchemes.h)
+class FileSink {
+public:
+    explicit FileSink(const std::string& path) : file(path, std::ios::in | std::ios::out | std::ios::binary), filesize(0) {
+        if (file.is_open()) {
+            file.seekg(0, std::ios::end);
+            filesize = static_cast<uint64_t>(file.tellg());
+        }
+    }
 
-    const size_t BUF_SIZE = 4096;
-    char buffer[BUF_SIZE];
+    bool isOpen() const { return file.is_open(); }
+    uint64_t size() const { return filesize; }
 
-    for (const auto& pass : passes) {
+    bool beginPass(size_t, size_t, const PassSpec&) {
         file.seekp(0, std::ios::beg);
-        std::streamoff written = 0;
-        while (written < filesize) {
-            size_t toWrite = std::min(static_cast<std::streamoff>(BUF_SIZE), filesize - written);
-            fillBuffer(buffer, toWrite, pass.first, pass.second);
-            file.write(buffer, toWrite);
-            written += toWrite;
-        }
+        return file.good();
+    }
+
+    bool write(uint64_t, const uint8_t* data, size_t len) {
+        file.write(reinterpret_cast<const char*>(data), len);
+        return file.good();
+    }
+
+    bool endPass() {
         file.flush();
+        return file.good();
+    }
+
+private:
+    std::fstream file;
+    uint64_t filesize;
+};
+
+// Runtime-interpreted passes: the pattern/random decision is made per chunk
+// and every chunk is refilled, even for a constant pass. Kept as the
+// reference path that the compile-time schemes are benchmarked against.
+template <typename Sink>
+inline bool runInterpreted(Sink& sink, const std::vector<std::pair<uint8_t, bool>>& passes, size_t chunkSize) {
+    std::vector<char> buffer(chunkSize);
+    size_t passNumber = 0;
+    for (const auto& pass : passes) {
+        PassSpec spec = pass.second ? randomPass() : constantPass(pass.first);
+        if (!sink.beginPass(++passNumber, passes.size(), spec)) return false;
+        const uint64_t total = sink.size();
+        for (uint64_t offset = 0; offset < total; ) {
+            size_t len = static_cast<size_t>(std::min<uint64_t>(chunkSize, total - offset));
+            fillBuffer(buffer.data(), len, pass.first, pass.second);
+            if (!sink.write(offset, reinterpret_cast<const uint8_t*>(buffer.data()), len)) return false;
+            offset += len;
+        }
+        if (!sink.endPass()) return false;
     }
-    file.close();
     return true;
+}
+
+// General wipe function (runtime pass list)
+inline bool wipeTarget(const std::string& path, const std::vector<std::pair<uint8_t, bool>>& passes) {
+    FileSink sink(path);
+    if (!sink.isOpen()) return false;
+    return runInterpreted(sink, passes, 4096);
+}
+
+// Compile-time scheme over a file's allocated extents, e.g. wipeScheme<DoDScheme>(path)
+template <typename Scheme>
+inline bool wipeScheme(const std::string& path) {
+    ExtentSink sink;
+    if (!sink.open(path)) return false;
+    return runScheme<Scheme>(sink, SHRED_CHUNK_SIZE);
 }
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "wipeJob.h"
+#include "telemetry.h"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+std::mutex registryMutex;
+std::vector<JobRef> registry;       // Oldest first
+uint64_t nextJobNumber = 1;
+
+thread_local JobRef threadJob;
+
+void raisePeak(std::atomic<uint64_t>& peak, uint64_t value) {
+    uint64_t seen = peak.load();
+    while (value > seen && !peak.compare_exchange_weak(seen, value)) {}
+}
+
+// Drop the oldest finished jobs beyond MAX_FINISHED_JOBS
+void pruneLocked() {
+    size_t finished = std::count_if(registry.begin(), registry.end(), [](const JobRef& j) { return !j->running(); });
+    for (auto it = registry.begin(); finished > MAX_FINISHED_JOBS && it != registry.end(); ) {
+        if (!(*it)->running()) {
+            it = registry.erase(it);
+            finished--;
+        } else {
+            ++it;
+        }
+    }
+}
+
+}
+
+void BadRangeList::add(uint64_t offset, uint64_t length) {
+    if (length == 0) return;
+    uint64_t end = offset + length;
+    // First range that ends at or after `offset`: it may touch the new one
+    auto it = std::lower_bound(list.begin(), list.end(), offset,
+                               [](const BadRange& r, uint64_t value) { return r.offset + r.length < value; });
+    auto last = it;
+    while (last != list.end() && last->offset <= end) {
+        offset = std::min(offset, last->offset);
+        end = std::max(end, last->offset + last->length);
+        total -= last->length;
+        ++last;
+    }
+    it = list.erase(it, last);
+    list.insert(it, BadRange{offset, end - offset});
+    total += end - offset;
+}
+
+void BadRangeList::merge(const BadRangeList& other) {
+    for (const BadRange& r : other.list) add(r.offset, r.length);
+}
+
+WipeJob::WipeJob(const std::string& id, const std::string& target) :
+    id(id),
+    target(target),
+    started(std::chrono::steady_clock::now()) {}
+
+void WipeJob::addSharedBytes(int64_t delta) {
+    uint64_t now = sharedBytes += static_cast<uint64_t>(delta);
+    raisePeak(peakSharedBytes, now);
+}
+
+void WipeJob::addPrivateBytes(int64_t delta) {
+    uint64_t now = privateBytes += static_cast<uint64_t>(delta);
+    raisePeak(peakPrivateBytes, now);
+}
+
+JobMemory WipeJob::memory() const {
+    return JobMemory{sharedBytes, privateBytes, peakSharedBytes, peakPrivateBytes};
+}
+
+void WipeJob::setTargetBytes(uint64_t bytes) {
+    targetSize = bytes;
+}
+
+void WipeJob::setPass(uint32_t pass, uint32_t passes) {
+    // Ranges go first: whoever sees the new pass number (an overlapped
+    // verify) must not see the previous pass's ranges
+    {
+        std::lock_guard<std::mutex> lock(badMutex);
+        written = BadRangeList();
+    }
+    passTotal = passes;
+    passNumber = pass;
+}
+
+void WipeJob::recordWrittenRange(uint64_t offset, uint64_t length) {
+    std::lock_guard<std::mutex> lock(badMutex);
+    written.add(offset, length);
+}
+
+BadRangeList WipeJob::writtenRanges() const {
+    std::lock_guard<std::mutex> lock(badMutex);
+    return written;
+}
+
+void WipeJob::recordHealthEvent(const HealthEvent& event) {
+    std::lock_guard<std::mutex> lock(badMutex);
+    health.push_back(event);
+    if (event.kind == HealthEventKind::Flagged) flagged = true;
+}
+
+std::vector<HealthEvent> WipeJob::healthEvents() const {
+    std::lock_guard<std::mutex> lock(badMutex);
+    return health;
+}
+
+void WipeJob::recordBadRange(uint64_t offset, uint64_t length) {
+    std::lock_guard<std::mutex> lock(badMutex);
+    bad.add(offset, length);
+}
+
+BadRangeList WipeJob::badRanges() const {
+    std::lock_guard<std::mutex> lock(badMutex);
+    return bad;
+}
+
+double WipeJob::sanitizedPercent() const {
+    uint64_t total = targetSize;
+    if (total == 0) return 0;
+    std::lock_guard<std::mutex> lock(badMutex);
+    return 100.0 * static_cast<double>(total - std::min(total, bad.bytes())) / static_cast<double>(total);
+}
+
+void WipeJob::setIoPriority(IoPriority value) {
+    priority = static_cast<uint16_t>(static_cast<uint16_t>(value.ioClass) << 8 | value.level);
+}
+
+IoPriority WipeJob::ioPriority() const {
+    uint16_t value = priority;
+    return IoPriority{static_cast<IoPriorityClass>(value >> 8), static_cast<uint8_t>(value & 0xFF)};
+}
+
+void WipeJob::cancel(const std::string& reason) {
+    {
+        std::lock_guard<std::mutex> lock(badMutex);
+        if (cancelRequested) return;
+        cancelText = reason;
+        cancelRequested = true;
+    }
+    logWarn("job") << "Job " << id << " cancelled: " << reason;
+}
+
+std::string WipeJob::cancelReason() const {
+    std::lock_guard<std::mutex> lock(badMutex);
+    return cancelText;
+}
+
+double WipeJob::elapsedMs() const {
+    int64_t ns = durationNs;
+    if (ns < 0) {
+        ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+    }
+    return ns / 1e6;
+}
+
+void WipeJob::finish() {
+    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+    int64_t unfinished = -1;
+    // The trace file stays open until the job is pruned; what it holds is on disk now
+    if (durationNs.compare_exchange_strong(unfinished, ns) && traceFile) traceFile->flush();
+}
+
+JobRef startJob(const std::string& id, const std::string& target) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::string jobId = id.empty() ? "job-" + std::to_string(nextJobNumber++) : id;
+    registry.erase(std::remove_if(registry.begin(), registry.end(), [&](const JobRef& j) { return j->id == jobId; }),
+                   registry.end());
+    JobRef job = std::make_shared<WipeJob>(jobId, target);
+    registry.push_back(job);
+    pruneLocked();
+    return job;
+}
+
+JobRef findJob(const std::string& id) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const JobRef& job : registry) {
+        if (job->id == id) return job;
+    }
+    return nullptr;
+}
+
+std::vector<JobRef> listJobs() {
+    std::vector<JobRef> jobs;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        jobs.assign(registry.rbegin(), registry.rend());
+    }
+    std::stable_partition(jobs.begin(), jobs.end(), [](const JobRef& j) { return j->running(); });
+    return jobs;
+}
+
+WipeJob* currentJob() {
+    return threadJob.get();
+}
+
+JobRef currentJobRef() {
+    return threadJob;
+}
+
+bool currentJobCancelled() {
+    return threadJob && threadJob->cancelled();
+}
+
+bool cancelJob(const std::string& id, const std::string& reason) {
+    JobRef job = findJob(id);
+    if (!job || !job->running()) return false;
+    job->cancel(reason);
+    return true;
+}
+
+JobScope::JobScope(JobRef job, bool finishOnExit) :
+    job(job),
+    previous(threadJob),
+    finishOnExit(finishOnExit) {
+    threadJob = this->job;
+    if (finishOnExit && this->job) emitEvent(TelemetryEvent::JobStarted, "job", "Job started: " + this->job->target);
+}
+
+JobScope::~JobScope() {
+    if (finishOnExit && job) {
+        job->finish();
+        emitEvent(TelemetryEvent::JobFinished, "job", "Job finished: " + job->target,
+                  static_cast<uint64_t>(job->elapsedMs()));
+    }
+    threadJob = std::move(previous);
+    // Leaving the outermost job: drop any I/O priority its writes applied
+    if (!threadJob) restoreThreadIoPriority();
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ioStats.h"
+#include "healthMonitor.h"
+#include "ioThrottle.h"
+#include "ioTrace.h"
+
+// Wipe job registry.
+//
+// A job is one wipeFile/shredFile/shredTree/destroyDrive call, named by the
+// caller's jobId (the controller passes its wipeId) or numbered automatically.
+// The engine finds the running job through a thread-local set by JobScope, so
+// sinks and sources need no job parameter; worker threads a job spawns enter
+// the same scope. Finished jobs stay queryable until MAX_FINISHED_JOBS newer
+// ones have finished.
+
+constexpr size_t MAX_FINISHED_JOBS = 64;
+
+// Error a writer reports when it stopped because its job was cancelled
+#ifdef _WIN32
+constexpr uint32_t JOB_CANCELLED_ERROR = 995;       // ERROR_OPERATION_ABORTED
+#else
+constexpr uint32_t JOB_CANCELLED_ERROR = ECANCELED;
+#endif
+
+// Unwritable byte range found by the bad-sector-tolerant writer (passEngine.h)
+struct BadRange {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Sorted, merged set of byte ranges; adjacent or overlapping ranges (e.g. the
+// same sector failing on every pass) collapse into one entry. Also holds the
+// ranges a pass has written.
+class BadRangeList {
+public:
+    void add(uint64_t offset, uint64_t length);
+    void merge(const BadRangeList& other);
+    const std::vector<BadRange>& ranges() const { return list; }
+    uint64_t bytes() const { return total; }
+    bool empty() const { return list.empty(); }
+
+private:
+    std::vector<BadRange> list;
+    uint64_t total = 0;
+};
+
+struct JobMemory {
+    uint64_t sharedBytes;       // Resident arena pattern bytes the job is reading (other jobs may share them)
+    uint64_t privateBytes;      // Scratch buffers only this job uses
+    uint64_t peakSharedBytes;
+    uint64_t peakPrivateBytes;
+};
+
+class WipeJob {
+public:
+    WipeJob(const std::string& id, const std::string& target);
+    WipeJob(const WipeJob&) = delete;
+    WipeJob& operator=(const WipeJob&) = delete;
+
+    const std::string id;
+    const std::string target;
+
+    void addSharedBytes(int64_t delta);
+    void addPrivateBytes(int64_t delta);
+    JobMemory memory() const;
+
+    // Media coverage: bytes the job targets and the ranges it could not write
+    // on at least one pass. sanitizedPercent() counts only bytes every pass wrote.
+    void setTargetBytes(uint64_t bytes);
+    void recordBadRange(uint64_t offset, uint64_t length);
+    uint64_t targetBytes() const { return targetSize; }
+    BadRangeList badRanges() const;
+    double sanitizedPercent() const;
+
+    // Pass of the running scheme (set by the sinks' beginPass) and bytes
+    // confirmed by read-back verification
+    void setPass(uint32_t pass, uint32_t passes);
+    uint32_t currentPass() const { return passNumber; }
+    // Bytes the current pass has written, in whatever order the writers
+    // finished them; cleared by setPass
+    void recordWrittenRange(uint64_t offset, uint64_t length);
+    BadRangeList writtenRanges() const;
+    // The same ranges without a copy; `fn` runs under the job's lock and
+    // must not call back into the job
+    template <typename Fn>
+    void visitWrittenRanges(Fn fn) const {
+        std::lock_guard<std::mutex> lock(badMutex);
+        for (const BadRange& range : written.ranges()) fn(range);
+    }
+    uint32_t passCount() const { return passTotal; }
+    void addVerifiedBytes(uint64_t bytes) { verified += bytes; }
+    uint64_t verifiedBytes() const { return verified; }
+
+    // Stalls, degradation and the engine's reactions (healthMonitor.h)
+    void recordHealthEvent(const HealthEvent& event);
+    std::vector<HealthEvent> healthEvents() const;
+    bool deviceFlagged() const { return flagged; }
+
+    // Bandwidth limit and I/O priority class of the job's writers
+    // (ioThrottle.h); both may change while the job runs
+    TokenBucket& bandwidth() { return bucket; }
+    const TokenBucket& bandwidth() const { return bucket; }
+    void setIoPriority(IoPriority priority);
+    IoPriority ioPriority() const;
+
+    // Latency histograms and throughput series (ioStats.h)
+    IoStats& io() { return ioStats; }
+    const IoStats& io() const { return ioStats; }
+
+    // Binary trace of every I/O (ioTrace.h); attach before the job's first
+    // I/O, it is read without a lock
+    void setTrace(IoTraceRef trace) { traceFile = std::move(trace); }
+    IoTrace* trace() const { return traceFile.get(); }
+
+    // Cooperative cancellation (cancelJob, or the hotplug watcher when the
+    // device disappears): writers stop before their next write with
+    // JOB_CANCELLED_ERROR. The first reason given is kept.
+    void cancel(const std::string& reason);
+    bool cancelled() const { return cancelRequested; }
+    std::string cancelReason() const;
+
+    bool running() const { return durationNs < 0; }
+    double elapsedMs() const;
+    void finish();
+
+private:
+    std::atomic<uint64_t> sharedBytes{0};
+    std::atomic<uint64_t> privateBytes{0};
+    std::atomic<uint64_t> peakSharedBytes{0};
+    std::atomic<uint64_t> peakPrivateBytes{0};
+    std::atomic<uint64_t> targetSize{0};
+    std::atomic<uint32_t> passNumber{0};
+    std::atomic<uint32_t> passTotal{0};
+    std::atomic<uint64_t> verified{0};
+    mutable std::mutex badMutex;
+    BadRangeList bad;
+    BadRangeList written;                   // Guarded by badMutex
+    std::vector<HealthEvent> health;        // Guarded by badMutex
+    std::atomic<bool> flagged{false};
+    std::atomic<bool> cancelRequested{false};
+    std::string cancelText;                 // Guarded by badMutex
+    TokenBucket bucket;
+    std::atomic<uint16_t> priority{0};      // IoPriorityClass << 8 | level
+    IoStats ioStats;
+    IoTraceRef traceFile;
+    std::chrono::steady_clock::time_point started;
+    std::atomic<int64_t> durationNs{-1};
+};
+
+using JobRef = std::shared_ptr<WipeJob>;
+
+// Register a running job. An empty id is replaced by "job-<n>"; an id already
+// in the registry is replaced by the new job.
+JobRef startJob(const std::string& id, const std::string& target);
+JobRef findJob(const std::string& id);
+std::vector<JobRef> listJobs();     // Running jobs first, then most recently started
+
+// The calling thread's job, or null outside any JobScope
+WipeJob* currentJob();
+JobRef currentJobRef();
+
+// True once the calling thread's job has been cancelled; writers poll this
+// before every write
+bool currentJobCancelled();
+
+// Cancel the running job `id`; false when no such job is running
+bool cancelJob(const std::string& id, const std::string& reason);
+
+// Make `job` the calling thread's job until the scope exits. The scope that
+// started the job passes finishOnExit so the job is marked finished even when
+// the call throws.
+class JobScope {
+public:
+    explicit JobScope(JobRef job, bool finishOnExit = false);
+    ~JobScope();
+    JobScope(const JobScope&) = delete;
+    JobScope& operator=(const JobScope&) = delete;
+
+private:
+    JobRef job;
+    JobRef previous;
+    bool finishOnExit;
+};
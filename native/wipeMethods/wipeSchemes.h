@@ -0,0 +1,282 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include "patternLibrary.h"
+#include "wipeJob.h"
+#include "probes.h"
+#include "numaPlacement.h"
+
+// Compile-time wipe schemes.
+//
+// A scheme is a constexpr table of passes. runScheme<Scheme>() unrolls the
+// table at compile time into one pass kernel per entry, so each pass knows
+// whether it is deterministic (written straight from a cached pattern buffer,
+// nothing generated per chunk) or random (one xoshiro fill per chunk). The
+// chunk loop itself has no pattern/random branch and no indirect call.
+// Measured against the interpreted path with the same xoshiro fill
+// (passEngine.cpp standalone), that buys no measurable throughput: the
+// tables are for adding schemes in one line, not for speed.
+//
+// To add a scheme, add one WIPE_SCHEME line to WIPE_SCHEME_TABLE below; it is
+// then selectable by name through runSchemeByName() and the wipeFile method.
+
+enum class PassKind : uint8_t {
+    Pattern,    // `period` bytes repeated across the target
+    Random
+};
+
+struct PassSpec {
+    PassKind kind;
+    uint16_t period;        // Bytes of `bytes` used (tables use 1 or 3)
+    uint8_t bytes[3];
+};
+
+constexpr PassSpec constantPass(uint8_t value) {
+    return PassSpec{PassKind::Pattern, 1, {value, 0, 0}};
+}
+
+constexpr PassSpec periodicPass(uint8_t b0, uint8_t b1, uint8_t b2) {
+    return PassSpec{PassKind::Pattern, 3, {b0, b1, b2}};
+}
+
+constexpr PassSpec randomPass() {
+    return PassSpec{PassKind::Random, 0, {0, 0, 0}};
+}
+
+#define WIPE_SCHEME_TABLE(WIPE_SCHEME) \
+    WIPE_SCHEME(ZeroScheme,     "zero",     constantPass(0x00)) \
+    WIPE_SCHEME(RandomScheme,   "random",   randomPass()) \
+    WIPE_SCHEME(NistScheme,     "nist",     randomPass()) \
+    WIPE_SCHEME(NistZeroScheme, "nistzero", constantPass(0x00)) \
+    WIPE_SCHEME(DoDScheme,      "dod",      constantPass(0x00), constantPass(0xFF), randomPass()) \
+    WIPE_SCHEME(GutmannScheme,  "gutmann", \
+        randomPass(), randomPass(), randomPass(), randomPass(), \
+        constantPass(0x55), constantPass(0xAA), \
+        periodicPass(0x92, 0x49, 0x24), periodicPass(0x49, 0x24, 0x92), periodicPass(0x24, 0x92, 0x49), \
+        constantPass(0x00), constantPass(0x11), constantPass(0x22), constantPass(0x33), \
+        constantPass(0x44), constantPass(0x55), constantPass(0x66), constantPass(0x77), \
+        constantPass(0x88), constantPass(0x99), constantPass(0xAA), constantPass(0xBB), \
+        constantPass(0xCC), constantPass(0xDD), constantPass(0xEE), constantPass(0xFF), \
+        periodicPass(0x92, 0x49, 0x24), periodicPass(0x49, 0x24, 0x92), periodicPass(0x24, 0x92, 0x49), \
+        periodicPass(0x6D, 0xB6, 0xDB), periodicPass(0xB6, 0xDB, 0x6D), periodicPass(0xDB, 0x6D, 0xB6), \
+        randomPass(), randomPass(), randomPass(), randomPass())
+
+#define DECLARE_WIPE_SCHEME(Type, schemeName, ...) \
+    struct Type { \
+        static constexpr const char* name = schemeName; \
+        static constexpr PassSpec passes[] = { __VA_ARGS__ }; \
+        static constexpr size_t passCount = sizeof(passes) / sizeof(passes[0]); \
+    };
+
+WIPE_SCHEME_TABLE(DECLARE_WIPE_SCHEME)
+
+#undef DECLARE_WIPE_SCHEME
+
+static_assert(GutmannScheme::passCount == 35, "Gutmann is 35 passes");
+
+// Chunk sources. next(offset, len) returns the `len` bytes to write at device
+// offset `offset`; both are trivially inlined into the pass loop. While a
+// source is alive its buffer is charged to the current job (wipeJob.h).
+
+// Deterministic pass: every chunk starts at its offset's phase of the cached
+// buffer, so stripes, zones and extents written apart line up
+class PatternSource {
+public:
+    explicit PatternSource(PatternRef pattern) : pattern(std::move(pattern)), job(currentJob()) {
+        if (job && this->pattern) job->addSharedBytes(static_cast<int64_t>(this->pattern->resident));
+    }
+    ~PatternSource() {
+        if (job && pattern) job->addSharedBytes(-static_cast<int64_t>(pattern->resident));
+    }
+    PatternSource(const PatternSource&) = delete;
+    PatternSource& operator=(const PatternSource&) = delete;
+
+    bool valid() const { return pattern != nullptr; }
+    size_t chunkSize() const { return pattern->size; }
+    const uint8_t* next(uint64_t offset, size_t) { return pattern->at(offset); }
+
+private:
+    PatternRef pattern;
+    WipeJob* job;
+};
+
+// Random pass: regenerate a pooled scratch buffer (at most RANDOM_CHUNK_SIZE,
+// on the thread's NUMA node) for every chunk
+class RandomSource {
+public:
+    explicit RandomSource(size_t size) :
+        buffer(acquireScratchBuffer(std::min(size, RANDOM_CHUNK_SIZE), currentNumaNode())), job(currentJob()) {
+        if (job && buffer) job->addPrivateBytes(static_cast<int64_t>(buffer->size()));
+    }
+    ~RandomSource() {
+        if (job && buffer) job->addPrivateBytes(-static_cast<int64_t>(buffer->size()));
+    }
+    RandomSource(const RandomSource&) = delete;
+    RandomSource& operator=(const RandomSource&) = delete;
+
+    bool valid() const { return buffer != nullptr; }
+    size_t chunkSize() const { return buffer->size(); }
+    const uint8_t* next(uint64_t, size_t len) {
+        WIPE_PROBE(pattern__start, probeJobId(), len);
+        fillRandomBytes(buffer->data(), len);
+        WIPE_PROBE(pattern__end, probeJobId(), len);
+        return buffer->data();
+    }
+
+private:
+    ScratchRef buffer;
+    WipeJob* job;
+};
+
+// Sink interface (static, no virtuals):
+//   uint64_t size() const;
+//   bool beginPass(size_t pass, size_t passCount, const PassSpec& spec);
+//   bool write(uint64_t offset, const uint8_t* data, size_t len);
+//   bool endPass();
+//
+// A sink that schedules its own writes (zoned devices write several zones at
+// once, zonedWriter.h) declares `static constexpr bool writesOwnPass = true`
+// and provides `template <typename Source> bool writePass(Source&)` instead
+// of write(); runPass then hands it the whole pass.
+
+template <typename Sink, typename = void>
+struct WritesOwnPass : std::false_type {};
+
+template <typename Sink>
+struct WritesOwnPass<Sink, std::void_t<decltype(Sink::writesOwnPass)>> : std::bool_constant<Sink::writesOwnPass> {};
+
+template <typename Source, typename Sink>
+bool runPass(Sink& sink, Source& source) {
+    if constexpr (WritesOwnPass<Sink>::value) {
+        return sink.writePass(source) && sink.endPass();
+    } else {
+        const uint64_t total = sink.size();
+        const size_t chunk = source.chunkSize();
+        for (uint64_t offset = 0; offset < total; ) {
+            size_t len = static_cast<size_t>(std::min<uint64_t>(chunk, total - offset));
+            if (!sink.write(offset, source.next(offset, len), len)) return false;
+            offset += len;
+        }
+        return sink.endPass();
+    }
+}
+
+// runPass between the pass__start and pass__end probes (probes.h)
+template <typename Source, typename Sink>
+bool runProbedPass(Sink& sink, Source& source, size_t pass, size_t passCount) {
+    WIPE_PROBE(pass__start, probeJobId(), pass, passCount, sink.size());
+    bool ok = runPass(sink, source);
+    WIPE_PROBE(pass__end, probeJobId(), pass, ok ? 1 : 0);
+    return ok;
+}
+
+// Kernel for pass I of Scheme; the source type is fixed at compile time
+template <typename Scheme, size_t I, typename Sink>
+bool runSchemePass(Sink& sink, size_t maxChunk) {
+    constexpr PassSpec spec = Scheme::passes[I];
+    if (!sink.beginPass(I + 1, Scheme::passCount, spec)) return false;
+
+    if constexpr (spec.kind == PassKind::Random) {
+        RandomSource source(maxChunk);
+        return source.valid() && runProbedPass(sink, source, I + 1, Scheme::passCount);
+    } else {
+        PatternSource source(acquirePattern(spec.bytes, spec.period, maxChunk, currentNumaNode()));
+        return source.valid() && runProbedPass(sink, source, I + 1, Scheme::passCount);
+    }
+}
+
+template <typename Scheme, typename Sink, size_t... I>
+bool runSchemePasses(Sink& sink, size_t maxChunk, std::index_sequence<I...>) {
+    return (runSchemePass<Scheme, I>(sink, maxChunk) && ...);
+}
+
+template <typename Scheme, typename Sink>
+bool runScheme(Sink& sink, size_t maxChunk) {
+    return runSchemePasses<Scheme>(sink, maxChunk, std::make_index_sequence<Scheme::passCount>());
+}
+
+// Single pass from a runtime (user-supplied) pattern
+template <typename Sink>
+bool runPatternPass(Sink& sink, PatternRef pattern) {
+    if (!pattern) return false;
+    PassSpec spec = PassSpec{PassKind::Pattern, static_cast<uint16_t>(pattern->period), {0, 0, 0}};
+    if (!sink.beginPass(1, 1, spec)) return false;
+    PatternSource source(std::move(pattern));
+    return runProbedPass(sink, source, 1, 1);
+}
+
+// Canonical scheme name ("nist-800" and "dod-5220" are accepted aliases)
+inline std::string schemeKey(const std::string& name) {
+    if (name == "nist-800") return "nist";
+    if (name == "dod-5220") return "dod";
+    return name;
+}
+
+// Look a scheme up by name and run it. Returns false with *found = false for
+// an unknown name.
+template <typename Sink>
+bool runSchemeByName(Sink& sink, const std::string& name, size_t maxChunk, bool* found = nullptr) {
+    const std::string key = schemeKey(name);
+
+#define DISPATCH_WIPE_SCHEME(Type, schemeName, ...) \
+    if (key == Type::name) { \
+        if (found) *found = true; \
+        return runScheme<Type>(sink, maxChunk); \
+    }
+    WIPE_SCHEME_TABLE(DISPATCH_WIPE_SCHEME)
+#undef DISPATCH_WIPE_SCHEME
+
+    if (found) *found = false;
+    return false;
+}
+
+// Last pass of the named scheme: what the device holds once it has run.
+// False for an unknown name.
+inline bool finalPassOf(const std::string& name, PassSpec& spec) {
+    const std::string key = schemeKey(name);
+#define FINAL_WIPE_PASS(Type, schemeName, ...) \
+    if (key == Type::name) { \
+        spec = Type::passes[Type::passCount - 1]; \
+        return true; \
+    }
+    WIPE_SCHEME_TABLE(FINAL_WIPE_PASS)
+#undef FINAL_WIPE_PASS
+    return false;
+}
+
+#ifdef TEST_STANDALONE
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Standalone tests of sinks that split their target (stripes, zones,
+// extents): write one Gutmann 92 49 24 pass through `sink`, read `ranges` of
+// `path` back and count the bytes not at their own offset's phase.
+template <typename Sink>
+bool checkPatternPhase(Sink& sink, const std::string& path, const std::vector<BadRange>& ranges, size_t maxChunk) {
+    const uint8_t gutmann[3] = {0x92, 0x49, 0x24};
+    bool ok = runPatternPass(sink, acquirePattern(gutmann, 3, maxChunk));
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> data(1 << 20);
+    uint64_t offPhase = 0;
+    for (const BadRange& range : ranges) {
+        const uint64_t end = range.offset + range.length;
+        in.seekg(static_cast<std::streamoff>(range.offset));
+        for (uint64_t offset = range.offset; ok && offset < end; ) {
+            size_t n = static_cast<size_t>(end - offset < data.size() ? end - offset : data.size());
+            ok = static_cast<bool>(in.read(data.data(), static_cast<std::streamsize>(n)));
+            for (size_t i = 0; ok && i < n; i++) {
+                if (static_cast<uint8_t>(data[i]) != gutmann[(offset + i) % 3]) offPhase++;
+            }
+            offset += n;
+        }
+    }
+    std::cout << "Gutmann 92 49 24 pass: " << offPhase << " off-phase bytes" << std::endl;
+    return ok && offPhase == 0;
+}
+#endif
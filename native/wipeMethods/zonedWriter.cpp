@@ -0,0 +1,431 @@
+#include "zonedWriter.h"
+#include "passEngine.h"
+#include "ioThrottle.h"
+#include "telemetry.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+    #include <linux/blkzoned.h>
+#endif
+
+// Progress is reported every 1GB, as by DeviceSink
+constexpr uint64_t ZONED_PROGRESS_STEP = 1024ULL * 1024 * 1024;
+
+const char* zonedModelName(ZonedModel model) {
+    switch (model) {
+        case ZonedModel::None: return "none";
+        case ZonedModel::HostAware: return "host-aware";
+        case ZonedModel::HostManaged: return "host-managed";
+    }
+    return "none";
+}
+
+#ifdef __linux__
+static Zone decodeZone(const blk_zone& z, bool hasCapacity) {
+    Zone zone;
+    zone.start = z.start << 9;
+    zone.length = z.len << 9;
+    zone.capacity = hasCapacity && z.capacity ? z.capacity << 9 : zone.length;
+    zone.writePointer = z.wp << 9;
+    switch (z.type) {
+        case BLK_ZONE_TYPE_CONVENTIONAL: zone.type = ZoneType::Conventional; break;
+        case BLK_ZONE_TYPE_SEQWRITE_PREF: zone.type = ZoneType::SequentialPreferred; break;
+        default: zone.type = ZoneType::SequentialRequired; break;
+    }
+    switch (z.cond) {
+        case BLK_ZONE_COND_NOT_WP: zone.condition = ZoneCondition::NotWritePointer; break;
+        case BLK_ZONE_COND_EMPTY: zone.condition = ZoneCondition::Empty; break;
+        case BLK_ZONE_COND_IMP_OPEN:
+        case BLK_ZONE_COND_EXP_OPEN: zone.condition = ZoneCondition::Open; break;
+        case BLK_ZONE_COND_CLOSED: zone.condition = ZoneCondition::Closed; break;
+        case BLK_ZONE_COND_READONLY: zone.condition = ZoneCondition::ReadOnly; break;
+        case BLK_ZONE_COND_OFFLINE: zone.condition = ZoneCondition::Offline; break;
+        default: zone.condition = ZoneCondition::Full; break;
+    }
+    return zone;
+}
+
+static bool zoneRangeIoctl(const DeviceSession& session, unsigned long request, uint64_t start, uint64_t length,
+                           uint32_t* error) {
+    blk_zone_range range;
+    range.sector = start >> 9;
+    range.nr_sectors = length >> 9;
+    if (ioctl(session.fd, request, &range) != 0) {
+        if (error) *error = errno;
+        return false;
+    }
+    return true;
+}
+#endif
+
+bool reportZones(const DeviceSession& session, uint64_t from, uint32_t maxZones, std::vector<Zone>& zones,
+                 uint32_t* error) {
+#ifdef __linux__
+    std::vector<uint8_t> buffer(sizeof(blk_zone_report) + ZONE_REPORT_BATCH * sizeof(blk_zone));
+    blk_zone_report* report = reinterpret_cast<blk_zone_report*>(buffer.data());
+    uint64_t sector = from >> 9;
+    while (maxZones > 0 && (sector << 9) < session.size) {
+        memset(buffer.data(), 0, buffer.size());
+        report->sector = sector;
+        report->nr_zones = maxZones < ZONE_REPORT_BATCH ? maxZones : ZONE_REPORT_BATCH;
+        if (ioctl(session.fd, BLKREPORTZONE, report) != 0) {
+            if (error) *error = errno;
+            return false;
+        }
+        if (report->nr_zones == 0) break;
+
+        bool hasCapacity = (report->flags & BLK_ZONE_REP_CAPACITY) != 0;
+        for (uint32_t i = 0; i < report->nr_zones; i++) zones.push_back(decodeZone(report->zones[i], hasCapacity));
+        const blk_zone& last = report->zones[report->nr_zones - 1];
+        sector = last.start + last.len;
+        maxZones -= report->nr_zones;
+    }
+    return true;
+#else
+    (void)session; (void)from; (void)maxZones; (void)zones;
+    if (error) *error = ENOTSUP;
+    return false;
+#endif
+}
+
+bool resetZones(const DeviceSession& session, uint64_t start, uint64_t length, uint32_t* error) {
+#ifdef __linux__
+    return zoneRangeIoctl(session, BLKRESETZONE, start, length, error);
+#else
+    (void)session; (void)start; (void)length;
+    if (error) *error = ENOTSUP;
+    return false;
+#endif
+}
+
+bool finishZones(const DeviceSession& session, uint64_t start, uint64_t length, uint32_t* error) {
+#ifdef __linux__
+    return zoneRangeIoctl(session, BLKFINISHZONE, start, length, error);
+#else
+    (void)session; (void)start; (void)length;
+    if (error) *error = ENOTSUP;
+    return false;
+#endif
+}
+
+unsigned zonedWriterCount(const DeviceSession& session, size_t zones) {
+    uint32_t limit = session.maxOpenZones ? session.maxOpenZones : ZONED_DEFAULT_WRITERS;
+    if (session.maxActiveZones && session.maxActiveZones < limit) limit = session.maxActiveZones;
+    if (limit > ZONED_MAX_WRITERS) limit = ZONED_MAX_WRITERS;
+    if (zones < limit) limit = static_cast<uint32_t>(zones);
+    return limit ? limit : 1;
+}
+
+ZonedSink::ZonedSink(DeviceSession& session) :
+    session(session),
+    fd(-1),
+    ownsFd(false),
+    writerCount(1),
+    passNumber(0),
+    passTotal(0),
+    passWritten(0),
+    totalWritten(0),
+    error(0),
+    failures(0),
+    aborted(false) {
+#ifdef __linux__
+    if (session.writable) {
+        fd = open(session.path.c_str(), O_RDWR | O_DIRECT | O_CLOEXEC);
+        ownsFd = fd != -1;
+        if (!ownsFd) {
+            logWarn("zoned") << "O_DIRECT open failed (errno " << errno << "), writing through the session handle";
+            fd = session.fd;
+        }
+    }
+#endif
+    if (WipeJob* job = currentJob()) job->setTargetBytes(session.size);
+}
+
+ZonedSink::~ZonedSink() {
+#ifdef __linux__
+    if (ownsFd) ::close(fd);
+#endif
+}
+
+bool ZonedSink::beginPass(size_t pass, size_t passCount, const PassSpec& spec) {
+    if (!session.writable) {
+        error = session.openError;
+        logError("zoned") << "Device is not open for writing (error " << error << ")";
+        return false;
+    }
+
+    uint32_t result = 0;
+    zones.clear();
+    if (!reportZones(session, 0, UINT32_MAX, zones, &result)) {
+        error = result;
+        logError("zoned") << "Zone report failed (error " << result << ")";
+        return false;
+    }
+
+    // One reset-all puts every write pointer back to its zone start; if the
+    // device refuses it, writeZone() resets zones one at a time instead
+    bool needsReset = false;
+    for (const Zone& zone : zones) {
+        needsReset |= zone.type != ZoneType::Conventional && zone.condition != ZoneCondition::Empty &&
+                      zone.condition != ZoneCondition::ReadOnly && zone.condition != ZoneCondition::Offline;
+    }
+    if (needsReset) {
+        if (resetZones(session, 0, session.size, &result)) {
+            zones.clear();
+            if (!reportZones(session, 0, UINT32_MAX, zones, &result)) {
+                error = result;
+                logError("zoned") << "Zone report failed after reset (error " << result << ")";
+                return false;
+            }
+        } else {
+            logWarn("zoned") << "Reset of all zones failed (error " << result << "), resetting per zone";
+        }
+    }
+
+    passNumber = pass;
+    passTotal = passCount;
+    passWritten = 0;
+    aborted = false;
+    writerCount = zonedWriterCount(session, zones.size());
+    passStart = std::chrono::steady_clock::now();
+    if (WipeJob* job = currentJob()) job->setPass(static_cast<uint32_t>(pass), static_cast<uint32_t>(passCount));
+
+    if (pass == 1) {
+        logInfo("zoned") << zonedModelName(session.zoned) << " device: " << zones.size() << " zones of "
+                         << (session.zoneSize >> 20) << " MB, " << writerCount << " concurrent writers";
+    }
+    emitEvent(TelemetryEvent::PassStarted, "pass", describePass(pass, passCount, spec), pass, passCount, session.size);
+    return true;
+}
+
+bool ZonedSink::writeZones(size_t chunk, const std::function<ChunkFn()>& makeChunks) {
+    std::atomic<size_t> cursor{0};
+
+    // Writers charge their buffers to the caller's job and run on its NUMA node
+    JobRef job = currentJobRef();
+    int numaNode = currentNumaNode();
+    std::vector<std::thread> writers;
+    for (unsigned w = 0; w < writerCount; w++) {
+        writers.emplace_back([&] {
+            JobScope scope(job);
+            NumaScope numa(numaNode);
+            ChunkFn next = makeChunks();
+            if (!next) {
+                fail(ENOMEM);
+                return;
+            }
+            for (size_t i = cursor++; i < zones.size() && !aborted; i = cursor++) {
+                if (!writeZone(zones[i], chunk, next)) return;
+            }
+        });
+    }
+    for (std::thread& t : writers) t.join();
+    return !aborted;
+}
+
+bool ZonedSink::writeZone(const Zone& zone, size_t chunk, const ChunkFn& next) {
+    const uint64_t end = zone.start + zone.capacity;
+    if (zone.condition == ZoneCondition::ReadOnly || zone.condition == ZoneCondition::Offline) {
+        recordBad(zone.start, zone.capacity, EROFS);
+        return true;
+    }
+
+    uint32_t result = 0;
+    const bool sequential = zone.type == ZoneType::SequentialRequired;
+    if (zone.type != ZoneType::Conventional && zone.condition != ZoneCondition::Empty &&
+        !resetZones(session, zone.start, zone.length, &result)) {
+        if (!isMediaError(result)) return fail(result);
+        recordBad(zone.start, zone.capacity, result);
+        return true;
+    }
+
+    for (uint64_t offset = zone.start; offset < end && !aborted; ) {
+        if (currentJobCancelled()) return fail(JOB_CANCELLED_ERROR);
+        size_t len = static_cast<size_t>(end - offset < chunk ? end - offset : chunk);
+        const uint8_t* data = next(offset, len);
+        if (!sequential) {
+            if (!writeRange(offset, data, len)) return false;
+        } else if (!writeAt(offset, data, len, result)) {
+            if (!isMediaError(result)) return fail(result);
+            if (++failures > MAX_FAILED_WRITES) {
+                logError("zoned") << "Too many failed writes (" << failures << "), device is failing; aborting";
+                return fail(result);
+            }
+            // Nothing past the write pointer can be written until the zone is
+            // reset: give up the rest of the zone and release its open slot
+            uint64_t from = offset;
+            std::vector<Zone> now;
+            if (reportZones(session, zone.start, 1, now, nullptr) && !now.empty() &&
+                now[0].writePointer > offset && now[0].writePointer < end) {
+                from = now[0].writePointer;
+            }
+            recordBad(from, end - from, result);
+            finishZones(session, zone.start, zone.length, nullptr);
+            return true;
+        }
+        addProgress(offset, len);
+        offset += len;
+    }
+    return true;
+}
+
+// Write, or on a media error bisect down to single sectors and record the
+// ones that stay unwritable (zones that accept random writes only)
+bool ZonedSink::writeRange(uint64_t offset, const uint8_t* data, size_t len) {
+    if (currentJobCancelled()) return fail(JOB_CANCELLED_ERROR);
+    uint32_t result = 0;
+    if (writeAt(offset, data, len, result)) return true;
+    if (!isMediaError(result)) return fail(result);
+    if (++failures > MAX_FAILED_WRITES) {
+        logError("zoned") << "Too many failed writes (" << failures << "), device is failing; aborting";
+        return fail(result);
+    }
+
+    const size_t sector = session.logicalSectorSize;
+    if (len <= sector) {
+        recordBad(offset, len, result);
+        return true;
+    }
+    size_t half = len / 2 / sector * sector;
+    if (half < sector) half = sector;
+    return writeRange(offset, data, half) && writeRange(offset + half, data + half, len - half);
+}
+
+bool ZonedSink::writeAt(uint64_t offset, const uint8_t* data, size_t len, uint32_t& result) {
+    throttleWrite(len);
+    IoTimer timer(offset, len);
+#ifdef __linux__
+    size_t done = 0;
+    while (done < len) {
+        ssize_t written = pwrite(fd, data + done, len - done, static_cast<off_t>(offset + done));
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            result = written < 0 ? errno : EIO;
+            timer.write(false, result);
+            return false;
+        }
+        done += static_cast<size_t>(written);
+    }
+    timer.write(true);
+    recordNumaWrite(len);
+    return true;
+#else
+    (void)offset; (void)data;
+    result = ENOTSUP;
+    timer.write(false, result);
+    return false;
+#endif
+}
+
+bool ZonedSink::fail(uint32_t result) {
+    if (!aborted.exchange(true)) {
+        error = result;
+        logError("zoned") << "Zoned write failed (error " << result << ")";
+    }
+    return false;
+}
+
+void ZonedSink::recordBad(uint64_t offset, uint64_t length, uint32_t result) {
+    emitEvent(TelemetryEvent::BadRange, "zoned", "Unwritable range at offset " + std::to_string(offset) + ", " +
+              std::to_string(length) + " bytes (error " + std::to_string(result) + ")", offset, length, result);
+    {
+        std::lock_guard<std::mutex> lock(badMutex);
+        bad.add(offset, length);
+    }
+    if (WipeJob* job = currentJob()) job->recordBadRange(offset, length);
+}
+
+void ZonedSink::addProgress(uint64_t offset, uint64_t bytes) {
+    totalWritten += bytes;
+    if (WipeJob* job = currentJob()) job->recordWrittenRange(offset, bytes);
+    uint64_t before = passWritten.fetch_add(bytes);
+    uint64_t after = before + bytes;
+    if (before / ZONED_PROGRESS_STEP == after / ZONED_PROGRESS_STEP) return;
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+    double writtenMB = after / 1024.0 / 1024.0;
+    int speed = static_cast<int>(writtenMB / (elapsed > 0 ? elapsed : 1));
+    std::ostringstream line;
+    line << "Progress: " << static_cast<int>((after * 100) / session.size) << "% (" << static_cast<int>(writtenMB)
+         << " MB) - Speed: " << speed << " MB/s";
+    emitEvent(TelemetryEvent::Progress, "pass", line.str(), after, session.size, speed);
+}
+
+bool ZonedSink::endPass() {
+    // As DeviceSink::endPass: a pass is complete only once it is on stable media
+#ifdef __linux__
+    if (fsync(fd) != 0) {
+        error = errno;
+        logError("zoned") << "Flush after pass " << passNumber << " failed (error " << error << ")";
+        return false;
+    }
+#endif
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+    std::ostringstream line;
+    line << "Pass " << passNumber << "/" << passTotal << " completed in " << static_cast<int>(elapsed)
+         << " seconds (" << static_cast<int>((passWritten / 1024.0 / 1024.0) / (elapsed > 0 ? elapsed : 1))
+         << " MB/s, " << writerCount << " zones at a time)";
+    emitEvent(TelemetryEvent::PassFinished, "pass", line.str(), passNumber, passTotal,
+              static_cast<uint64_t>(elapsed * 1000));
+    return true;
+}
+
+// Export for testing: wipe an emulated zoned device (see zonedWriter.h) and
+// check every sequential zone ends up full
+#ifdef TEST_STANDALONE
+#include <iostream>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: zonedWriter <zoned block device> [method]" << std::endl;
+        return 1;
+    }
+    std::shared_ptr<DeviceSession> session = openDeviceSession(argv[1]);
+    if (!session->writable || session->zoned == ZonedModel::None) {
+        std::cerr << argv[1] << " is not a writable zoned block device" << std::endl;
+        return 1;
+    }
+    std::cout << zonedModelName(session->zoned) << ", " << session->zoneCount << " zones of "
+              << (session->zoneSize >> 20) << " MB, max open " << session->maxOpenZones << ", max active "
+              << session->maxActiveZones << std::endl;
+
+    JobRef job = startJob("zoned-test", session->path);
+    JobScope scope(job, true);
+    ZonedSink sink(*session);
+    auto start = std::chrono::steady_clock::now();
+    bool found = false;
+    bool ok = runSchemeByName(sink, argc > 2 ? argv[2] : "zero", 16 * 1024 * 1024, &found);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (sink.bytesWritten() >> 20) << " MB in " << seconds << " s with " << sink.writers()
+              << " writers, " << sink.badRanges().ranges().size() << " bad ranges" << std::endl;
+
+    std::vector<Zone> zones;
+    ok = ok && found && reportZones(*session, 0, UINT32_MAX, zones, nullptr);
+    size_t unfinished = 0;
+    for (const Zone& zone : zones) {
+        if (zone.type != ZoneType::Conventional && zone.condition != ZoneCondition::Full &&
+            zone.writePointer != zone.start + zone.capacity) {
+            unfinished++;
+        }
+    }
+    ok = ok && unfinished == 0;
+    std::cout << (ok ? "OK" : "FAIL") << " (" << unfinished << " sequential zones not full)" << std::endl;
+
+    // Zones are not a multiple of a 3-byte period
+    std::vector<BadRange> writable;
+    for (const Zone& zone : zones) {
+        if (zone.condition != ZoneCondition::ReadOnly && zone.condition != ZoneCondition::Offline) {
+            writable.push_back(BadRange{zone.start, zone.capacity});
+        }
+    }
+    ok = checkPatternPhase(sink, argv[1], writable, 16 * 1024 * 1024) && ok;
+    std::cout << (ok ? "OK" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+#endif
@@ -0,0 +1,145 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "deviceSession.h"
+#include "wipeSchemes.h"
+
+// Zoned block devices (host-managed / host-aware SMR, NVMe ZNS).
+//
+// Sequential-write-required zones only accept writes at their write pointer,
+// so the flat offset-order writer of passEngine.h cannot drive them. ZonedSink
+// resets the device's zones when a pass begins (a single reset-all where the
+// kernel can do that), then writes every zone sequentially from its write
+// pointer up to its capacity. Zones are handed out in order through an atomic
+// cursor to several writer threads, never more than the device's open or
+// active zone limit, so that many zones fill at once. The gap between a
+// zone's capacity and its size holds no data and is skipped.
+//
+// A media error inside a sequential-write-required zone cannot be stepped
+// over: the zone is finished and the rest of it, from the write pointer on,
+// is recorded as a bad range. Conventional and sequential-preferred zones
+// are bisected down to single sectors like DeviceSink does.
+//
+// Writes go through an O_DIRECT handle of their own, so the page cache never
+// reorders them inside a zone. Linux only; elsewhere no session reports a
+// zoned model.
+//
+// Testable without SMR hardware on an emulated device, e.g.
+//   modprobe null_blk nr_devices=1 zoned=1 zone_size=64 zone_nr_conv=4 zone_max_open=6 memory_backed=1 gb=2
+// and then the standalone build of zonedWriter.cpp on /dev/nullb0.
+
+constexpr unsigned ZONED_MAX_WRITERS = 8;
+constexpr unsigned ZONED_DEFAULT_WRITERS = 4;   // Device reports no open-zone limit
+constexpr uint32_t ZONE_REPORT_BATCH = 4096;
+
+enum class ZoneType : uint8_t {
+    Conventional,
+    SequentialRequired,
+    SequentialPreferred
+};
+
+enum class ZoneCondition : uint8_t {
+    NotWritePointer,    // Conventional zone
+    Empty,
+    Open,
+    Closed,
+    Full,
+    ReadOnly,
+    Offline
+};
+
+struct Zone {
+    uint64_t start;         // Bytes
+    uint64_t length;
+    uint64_t capacity;      // Writable bytes from start; below length on ZNS
+    uint64_t writePointer;
+    ZoneType type;
+    ZoneCondition condition;
+};
+
+const char* zonedModelName(ZonedModel model);
+
+// Zone management ioctls (BLKREPORTZONE, BLKRESETZONE, BLKFINISHZONE).
+// Offsets and lengths in bytes; false with *error = errno on failure.
+bool reportZones(const DeviceSession& session, uint64_t from, uint32_t maxZones, std::vector<Zone>& zones,
+                 uint32_t* error);
+bool resetZones(const DeviceSession& session, uint64_t start, uint64_t length, uint32_t* error);
+bool finishZones(const DeviceSession& session, uint64_t start, uint64_t length, uint32_t* error);
+
+// Writer threads for `zones` zones: the open/active zone limit, capped
+unsigned zonedWriterCount(const DeviceSession& session, size_t zones);
+
+class ZonedSink {
+public:
+    static constexpr bool writesOwnPass = true;
+
+    explicit ZonedSink(DeviceSession& session);
+    ~ZonedSink();
+    ZonedSink(const ZonedSink&) = delete;
+    ZonedSink& operator=(const ZonedSink&) = delete;
+
+    uint64_t size() const { return session.size; }
+    bool beginPass(size_t pass, size_t passCount, const PassSpec& spec);
+    template <typename Source>
+    bool writePass(Source& source);
+    bool endPass();
+
+    uint64_t bytesWritten() const { return totalWritten; }     // All passes
+    uint32_t lastError() const { return error; }
+    const BadRangeList& badRanges() const { return bad; }      // Merged across passes
+    unsigned writers() const { return writerCount; }
+    const std::vector<Zone>& zoneList() const { return zones; }
+
+private:
+    // Per-writer chunk generator: returns the `len` bytes to write at `offset`
+    using ChunkFn = std::function<const uint8_t*(uint64_t offset, size_t len)>;
+
+    bool writeZones(size_t chunk, const std::function<ChunkFn()>& makeChunks);
+    bool writeZone(const Zone& zone, size_t chunk, const ChunkFn& next);
+    bool writeRange(uint64_t offset, const uint8_t* data, size_t len);
+    bool writeAt(uint64_t offset, const uint8_t* data, size_t len, uint32_t& result);
+    bool fail(uint32_t result);
+    void recordBad(uint64_t offset, uint64_t length, uint32_t result);
+    void addProgress(uint64_t offset, uint64_t bytes);
+
+    DeviceSession& session;
+    int fd;                 // O_DIRECT handle, or the session's own if that failed
+    bool ownsFd;
+    std::vector<Zone> zones;
+    unsigned writerCount;
+    size_t passNumber;
+    size_t passTotal;
+    std::atomic<uint64_t> passWritten;
+    std::atomic<uint64_t> totalWritten;
+    std::atomic<uint32_t> error;
+    std::atomic<uint32_t> failures;
+    std::atomic<bool> aborted;
+    std::mutex badMutex;
+    BadRangeList bad;
+    std::chrono::steady_clock::time_point passStart;
+};
+
+template <typename Source>
+bool ZonedSink::writePass(Source& source) {
+    const size_t chunk = source.chunkSize();
+    if constexpr (std::is_same<Source, RandomSource>::value) {
+        // A random source refills one scratch buffer: each writer gets its
+        // own, allocated on the writer's thread and NUMA node
+        return writeZones(chunk, [chunk] {
+            auto own = std::make_shared<RandomSource>(chunk);
+            return own->valid() ? ChunkFn([own](uint64_t offset, size_t len) { return own->next(offset, len); }) : ChunkFn();
+        });
+    } else {
+        // Pattern chunks are immutable and shared by every writer
+        return writeZones(chunk, [&source] {
+            return ChunkFn([&source](uint64_t offset, size_t len) { return source.next(offset, len); });
+        });
+    }
+}
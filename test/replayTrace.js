@@ -0,0 +1,98 @@
+/**
+ * I/O Trace Replay
+ *
+ * Replays a trace recorded with WIPE_IO_TRACE (or the addon's ioTrace option)
+ * and prints the recorded and replayed latencies side by side.
+ *
+ * Usage:
+ *   node test/replayTrace.js <trace> [--target <file>] [--speed <x>] [--buffered] [--output <trace>]
+ *
+ *   --target    file to replay against (created sparse if missing); without
+ *               it the I/O goes to an emulated device that answers with the
+ *               recorded latencies and errors
+ *   --speed     submit times are divided by this; 0 issues each recorded
+ *               thread's I/O back to back
+ *   --buffered  go through the page cache instead of O_DIRECT / NO_BUFFERING
+ *   --output    save the replay as a trace, e.g. to replay it again later
+ *
+ * Never point --target at a drive: the replay writes zeros wherever the
+ * recorded job wrote.
+ *
+ * Requirements:
+ *   - Native addon must be built: cd native && npx node-gyp rebuild
+ */
+
+const path = require('path');
+
+let addon;
+try {
+    const addonPath = path.join(__dirname, '..', 'native', 'build', 'Release', 'wipeAddon.node');
+    addon = require(addonPath);
+} catch (error) {
+    console.error('✗ Failed to load native addon:', error.message);
+    console.error('\nMake sure to build the addon first:');
+    console.error('  cd native && npx node-gyp rebuild\n');
+    process.exit(1);
+}
+
+const args = process.argv.slice(2);
+const tracePath = args.find((a, i) => !a.startsWith('--') && (i === 0 || !['--target', '--speed', '--output'].includes(args[i - 1])));
+if (!tracePath) {
+    console.error('Usage: node test/replayTrace.js <trace> [--target <file>] [--speed <x>] [--buffered] [--output <trace>]');
+    process.exit(1);
+}
+
+function argValue(name) {
+    const i = args.indexOf(name);
+    return i >= 0 ? args[i + 1] : undefined;
+}
+
+if (argValue('--target') && argValue('--target').startsWith('/dev/')) {
+    console.error('✗ Refusing to replay against a device; use a file');
+    process.exit(1);
+}
+
+const options = { direct: !args.includes('--buffered') };
+if (argValue('--target')) options.target = argValue('--target');
+if (argValue('--speed') !== undefined) options.speed = Number(argValue('--speed'));
+if (argValue('--output')) options.output = argValue('--output');
+
+console.log('='.repeat(60));
+console.log('I/O TRACE REPLAY');
+console.log('='.repeat(60));
+console.log(`Trace:  ${tracePath}`);
+console.log(`Target: ${options.target || 'emulated device'}`);
+console.log('');
+
+let r;
+try {
+    r = addon.replayIoTrace(tracePath, options);
+} catch (error) {
+    console.error('✗ Replay failed:', error.message);
+    process.exit(1);
+}
+if (!r.completed) {
+    console.error('✗ Replay failed:', r.error);
+    process.exit(1);
+}
+
+const row = (label, recorded, replayed) =>
+    console.log(`${label.padEnd(22)}${String(recorded).padStart(14)}${String(replayed).padStart(14)}`);
+const us = v => v.toFixed(1);
+
+console.log(`Recorded job ${r.recorded_job} on ${r.recorded_target}`);
+console.log(`${r.ops} I/Os, ${(r.bytes / 1048576).toFixed(1)} MB, ${r.streams} threads`);
+console.log('');
+row('', 'recorded', 'replayed');
+row('duration (ms)', r.recorded_ms.toFixed(1), r.replayed_ms.toFixed(1));
+row('throughput (MB/s)', r.recorded_mbps.toFixed(1), r.replayed_mbps.toFixed(1));
+row('failed I/Os', r.recorded_failures, r.failures);
+for (const dir of ['write', 'read']) {
+    const d = r[dir];
+    if (!d.recorded.max_us) continue;
+    row(`${dir} p50 (us)`, us(d.recorded.p50_us), us(d.replayed.p50_us));
+    row(`${dir} p99 (us)`, us(d.recorded.p99_us), us(d.replayed.p99_us));
+    row(`${dir} max (us)`, us(d.recorded.max_us), us(d.replayed.max_us));
+}
+if (r.error) console.error(`\n✗ ${r.error}`);
+if (options.output && !r.error) console.log(`\nReplay saved to ${options.output}`);